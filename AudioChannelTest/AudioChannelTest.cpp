@@ -0,0 +1,152 @@
+#include "ActionQueue.hpp"
+#include "AudioChannel.hpp"
+#include "AudioSynth.hpp"
+#include "TimerCore.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Lazy audio channel test.
+//Runs free running channels once lazily, catching up underflows in bulk with 12 shift jump tables, and once with the timer
+//firing and the shift register stepped at every underflow. Channels are synced after skips of 1 to 997 underflows around
+//multiples of 12, and feedback taps change between rounds of skips. Shift register, output and rendered audio must match.
+
+namespace
+{
+
+static constexpr int TIMER = 0x8;
+static constexpr int SPS = 48000;
+static constexpr size_t SAMPLES = 4096;
+
+static constexpr uint8_t FEEDBACK_7 = 0b1000'0000;
+static constexpr uint8_t ENABLE_RELOAD = 0b0001'0000;
+static constexpr uint8_t ENABLE_COUNT = 0b0000'1000;
+
+//underflows skipped between syncs
+static constexpr std::array<uint64_t, 12> SKIPS = { 1, 2, 5, 11, 12, 13, 23, 24, 25, 36, 100, 997 };
+
+struct Case
+{
+  //feedback registers used in turn for rounds of SKIPS
+  std::vector<uint8_t> feedbacks;
+  bool feedback7;
+  uint8_t backup;
+  uint8_t clock;
+  uint16_t seed;
+};
+
+struct Result
+{
+  std::vector<AudioSample> audio;
+  uint8_t shift;
+  uint8_t other;
+  int8_t output;
+  bool lazy;
+};
+
+bool same( Result const& left, Result const& right )
+{
+  return left.shift == right.shift && left.other == right.other && left.output == right.output &&
+    std::ranges::equal( left.audio, right.audio, []( AudioSample l, AudioSample r ) { return l.left == r.left && l.right == r.right; } );
+}
+
+//same order of syncs and updates as VGMPlayer. The channel is lazy only when lazy is set
+Result run( Case const& c, bool lazy )
+{
+  TimerCore timers;
+  AudioSynth synth;
+  AudioChannel channel{ timers, TIMER, synth };
+  ActionQueue actions;
+
+  uint64_t const end = synth.endTick( 0, SPS, SAMPLES );
+
+  auto fire = [&]( uint64_t tick )
+  {
+    while ( !actions.empty() && actions.headTick() <= tick )
+    {
+      auto const seqAction = actions.pop();
+      auto underflows = timers.fire( ( int )seqAction.getAction() - ( int )Action::FIRE_TIMER0, seqAction.getTick() );
+      for ( int i = underflows.count - 1; i >= 0; --i )
+      {
+        if ( underflows.timers[i] == TIMER )
+          channel.trigger( seqAction.getTick() );
+      }
+      if ( underflows.action )
+        actions.push( underflows.action );
+    }
+  };
+
+  auto sync = [&]( uint64_t tick )
+  {
+    fire( tick );
+    channel.sync( tick );
+    timers.sync( tick );
+  };
+
+  auto update = [&]( SequencedAction action )
+  {
+    if ( action )
+      actions.push( action );
+    if ( auto lazyAction = channel.updateLazy( !lazy ) )
+      actions.push( lazyAction );
+    if ( auto timerAction = timers.updateAction( TIMER ) )
+      actions.push( timerAction );
+  };
+
+  channel.setGains( 0, 64, -64 );
+  update( channel.setVolume( 37 ) );
+  update( channel.setFeedback( c.feedbacks[0] ) );
+  update( channel.setShift( (uint8_t)c.seed ) );
+  update( channel.setOther( 0, (uint8_t)( ( c.seed >> 4 ) & 0xf0 ) ) );
+  update( channel.setBackup( 0, c.backup ) );
+  update( channel.setControl( 0, ( c.feedback7 ? FEEDBACK_7 : 0 ) | ENABLE_RELOAD | ENABLE_COUNT | c.clock ) );
+
+  uint64_t const period = timers.period( TIMER );
+  uint64_t tick = 0;
+  for ( size_t round = 1; tick < end; ++round )
+  {
+    for ( uint64_t skip : SKIPS )
+    {
+      //syncs land between underflows at varying offsets
+      tick = std::min( end, tick + skip * period + round % period );
+      sync( tick );
+    }
+
+    update( channel.setFeedback( c.feedbacks[round % c.feedbacks.size()] ) );
+  }
+
+  sync( end );
+
+  Result result{ std::vector<AudioSample>( SAMPLES ), channel.getShift(), channel.getOther( end ), channel.getOutput(), timers.lazy( TIMER ) };
+  result.audio.resize( synth.render( end, result.audio ) );
+  return result;
+}
+
+}
+
+int main()
+{
+  std::array<Case, 4> const cases{ {
+    { { 0x01, 0x2d, 0xff, 0x00 }, false, 3, 0, 0x0001 },
+    { { 0x41, 0x17, 0xb6 }, true, 0, 0, 0x0a5a },
+    { { 0xc5, 0x3f, 0x80 }, true, 17, 2, 0x0fff },
+    { { 0x12, 0x09 }, false, 250, 0, 0x0123 }
+  } };
+
+  int failures = 0;
+  fmt::print( "{:<12} {:>8} {:>6} {:>8}\n", "feedbacks", "backup", "clock", "samples" );
+  for ( auto const& c : cases )
+  {
+    auto const lazy = run( c, true );
+    auto const stepped = run( c, false );
+    bool const ok = lazy.lazy && !stepped.lazy && lazy.audio.size() == SAMPLES && same( lazy, stepped );
+    failures += ok ? 0 : 1;
+    std::string feedbacks;
+    for ( uint8_t feedback : c.feedbacks )
+    {
+      feedbacks += fmt::format( "{:02x}", feedback );
+    }
+    fmt::print( "{:<12} {:>8} {:>6} {:>8} {}\n", feedbacks, c.backup, c.clock, lazy.audio.size(), ok ? "OK" : "MISMATCH" );
+  }
+
+  return failures == 0 ? 0 : 1;
+}
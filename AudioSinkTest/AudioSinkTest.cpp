@@ -0,0 +1,213 @@
+#include "AudioSink.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Audio sink test and benchmark.
+//Streams numbered samples through AudioRing between two threads in chunks of varying sizes and checks that they arrive in order,
+//simulates emulation and audio device running on drifting clocks to check that rate control keeps RingAudioSink at target fill,
+//and checks samples written by WavAudioSink and counted by NullAudioSink.
+
+namespace
+{
+
+AudioSample numbered( uint32_t i )
+{
+  return { ( int16_t )( i & 0xffff ), ( int16_t )( i >> 16 ) };
+}
+
+uint32_t number( AudioSample sample )
+{
+  return ( uint32_t )( uint16_t )sample.left | ( uint32_t )( uint16_t )sample.right << 16;
+}
+
+//chunk sizes from a fixed sequence so that runs are comparable
+size_t chunk( uint32_t& seed, size_t limit )
+{
+  seed = seed * 1664525u + 1013904223u;
+  return 1 + ( seed >> 16 ) % limit;
+}
+
+int testRing( uint32_t samples )
+{
+  AudioRing ring{ 4096 };
+  std::atomic<uint32_t> errors{};
+
+  auto const start = std::chrono::steady_clock::now();
+
+  std::thread producer{ [&]
+  {
+    std::vector<AudioSample> buffer( 1024 );
+    uint32_t seed = 1;
+    for ( uint32_t i = 0; i < samples; )
+    {
+      size_t const size = std::min<size_t>( chunk( seed, buffer.size() ), samples - i );
+      for ( size_t j = 0; j < size; ++j )
+      {
+        buffer[j] = numbered( i + ( uint32_t )j );
+      }
+
+      std::span<AudioSample const> rest{ buffer.data(), size };
+      while ( !rest.empty() )
+      {
+        rest = rest.subspan( ring.write( rest ) );
+        if ( !rest.empty() )
+          std::this_thread::yield();
+      }
+      i += ( uint32_t )size;
+    }
+  } };
+
+  std::vector<AudioSample> buffer( 1024 );
+  uint32_t seed = 2;
+  for ( uint32_t expected = 0; expected < samples; )
+  {
+    size_t const count = ring.read( { buffer.data(), chunk( seed, buffer.size() ) } );
+    if ( count == 0 )
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    for ( size_t j = 0; j < count; ++j )
+    {
+      if ( number( buffer[j] ) != expected++ )
+        errors += 1;
+    }
+  }
+
+  producer.join();
+
+  double const seconds = std::max( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count(), 1e-9 );
+  bool const ok = errors == 0 && ring.size() == 0;
+  fmt::print( "ring: {} samples {:.1f} Msamples/s errors {} {}\n", samples, samples / seconds / 1e6, errors.load(), ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+//Emulation thread is paced by simulated wall clock every millisecond, device takes a period of samples on a clock
+//that drifts by given relative amount. After settling fill must stay around target without underruns.
+int testRateControl( double drift )
+{
+  static constexpr int SPS = 48000;
+  static constexpr size_t PERIOD = 480;
+  static constexpr int SECONDS = 600;
+
+  RingAudioSink sink{ SPS, 2 * PERIOD };
+  std::vector<AudioSample> buffer( SPS );
+  double produced = 0;
+  double devicePhase = 0;
+  size_t minFill = std::numeric_limits<size_t>::max();
+  size_t maxFill = 0;
+  uint64_t settledUnderruns = 0;
+
+  for ( int ms = 0; ms < SECONDS * 1000; ++ms )
+  {
+    //emulation renders a millisecond of samples at current rate
+    produced += sink.rate() / 1000.0;
+    size_t const count = std::min( ( size_t )produced, sink.space() );
+    produced -= ( double )( size_t )produced;
+    sink.push( { buffer.data(), count } );
+
+    //device takes a period whenever its clock reaches it
+    devicePhase += SPS * ( 1.0 + drift ) / 1000.0;
+    while ( devicePhase >= PERIOD )
+    {
+      devicePhase -= PERIOD;
+      uint64_t const underruns = sink.underruns();
+      sink.pull( { buffer.data(), PERIOD } );
+      if ( ms >= SECONDS * 1000 / 2 )
+      {
+        settledUnderruns += sink.underruns() - underruns;
+        minFill = std::min( minFill, sink.fill() );
+        maxFill = std::max( maxFill, sink.fill() );
+      }
+    }
+  }
+
+  //Device takes a period at once, so fill swings by a period around a level that rate control holds near target.
+  //Proportional control leaves an offset of drift / MAX_DELTA of target, the ring never runs dry nor full
+  bool const ok = settledUnderruns == 0 && minFill > 0 && maxFill < 2 * sink.target();
+  fmt::print( "rate control drift {:+.4f}: fill {}..{} target {} underruns {} {}\n", drift, minFill, maxFill, sink.target(), settledUnderruns, ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+int testWav()
+{
+  static constexpr int SPS = 22050;
+  static constexpr uint32_t SAMPLES = 10000;
+
+  auto const path = std::filesystem::temp_directory_path() / "AudioSinkTest.wav";
+  {
+    WavAudioSink sink{ path, SPS };
+    std::vector<AudioSample> samples( SAMPLES );
+    for ( uint32_t i = 0; i < SAMPLES; ++i )
+    {
+      samples[i] = numbered( i * 0x10001u );
+    }
+    sink.push( samples );
+  }
+
+  std::ifstream fin{ path, std::ios::binary };
+  std::vector<uint8_t> data{ std::istreambuf_iterator<char>{ fin }, std::istreambuf_iterator<char>{} };
+  fin.close();
+  std::filesystem::remove( path );
+
+  auto u32 = [&]( size_t pos )
+  {
+    return pos + 4 <= data.size() ? ( uint32_t )data[pos] | ( uint32_t )data[pos + 1] << 8 | ( uint32_t )data[pos + 2] << 16 | ( uint32_t )data[pos + 3] << 24 : 0;
+  };
+  auto tag = [&]( size_t pos, std::string_view expected )
+  {
+    return pos + 4 <= data.size() && std::equal( expected.begin(), expected.end(), data.begin() + pos );
+  };
+
+  bool ok = data.size() == 44 + SAMPLES * 4;
+  ok &= tag( 0, "RIFF" ) && u32( 4 ) == data.size() - 8 && tag( 8, "WAVE" ) && tag( 12, "fmt " );
+  ok &= u32( 24 ) == SPS && u32( 28 ) == SPS * 4 && tag( 36, "data" ) && u32( 40 ) == SAMPLES * 4;
+  for ( uint32_t i = 0; ok && i < SAMPLES; ++i )
+  {
+    ok &= u32( 44 + i * 4 ) == i * 0x10001u;
+  }
+
+  fmt::print( "wav: {} bytes {}\n", data.size(), ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+int testNull()
+{
+  NullAudioSink sink{ 48000 };
+  std::vector<AudioSample> samples( 1000 );
+  for ( int i = 0; i < 10; ++i )
+  {
+    sink.push( samples );
+  }
+
+  bool const ok = sink.samples() == 10000 && sink.rate() == 48000 && sink.space() >= samples.size();
+  fmt::print( "null: {} samples {}\n", sink.samples(), ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  uint32_t samples = 50'000'000;
+  if ( argc == 3 && std::string_view{ argv[1] } == "--samples" )
+  {
+    samples = ( uint32_t )std::max( 1, std::atoi( argv[2] ) );
+  }
+  else if ( argc != 1 )
+  {
+    fmt::print( stderr, "Usage: {} [--samples N]\n", argv[0] );
+    return 2;
+  }
+
+  int failures = 0;
+  failures += testRing( samples );
+  failures += testRateControl( 0.0 );
+  failures += testRateControl( 0.001 );
+  failures += testRateControl( -0.001 );
+  failures += testWav();
+  failures += testNull();
+
+  fmt::print( "{}\n", failures == 0 ? "OK" : "FAILED" );
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#include "AudioSynth.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Band limited step synthesis test.
+//Renders single steps at several phases within a sample and checks them against the step response of the Blackman windowed
+//sinc integrated here independently of the synthesizer's kernels. Checks that silence renders as silence and that steps
+//returning to zero leave no residue.
+
+namespace
+{
+
+//a sample is 64 ticks, so a tick is exactly one phase of the synthesizer
+static constexpr int SPS = 250000;
+static constexpr uint64_t TICKS_PER_SAMPLE = 64;
+static_assert( TICKS_PER_SAMPLE == AudioSynth::PHASES );
+static constexpr size_t SAMPLES = 64;
+static constexpr uint64_t STEP_SAMPLE = 10;
+static constexpr int AMPLITUDE = 10000;
+
+//step response of windowed sinc with cutoff at 90% of Nyquist frequency, x samples after the step, with Simpson's rule
+double stepResponse( double x )
+{
+  static constexpr int HALF_WIDTH = AudioSynth::HALF_WIDTH;
+  static constexpr int INTERVALS = 1000;
+
+  auto impulse = []( double x )
+  {
+    double const sinc = x == 0.0 ? 1.0 : std::sin( std::numbers::pi * 0.9 * x ) / ( std::numbers::pi * 0.9 * x );
+    double const window = 0.42 + 0.5 * std::cos( std::numbers::pi * x / HALF_WIDTH ) + 0.08 * std::cos( 2.0 * std::numbers::pi * x / HALF_WIDTH );
+    return sinc * window;
+  };
+
+  auto integral = [&]( double from, double to )
+  {
+    int const n = std::max( 2, (int)( ( to - from ) * INTERVALS ) & ~1 );
+    double const h = ( to - from ) / n;
+    double sum = impulse( from ) + impulse( to );
+    for ( int i = 1; i < n; ++i )
+    {
+      sum += impulse( from + i * h ) * ( i % 2 ? 4 : 2 );
+    }
+    return sum * h / 3.0;
+  };
+
+  if ( x <= -HALF_WIDTH )
+    return 0.0;
+  if ( x >= HALF_WIDTH )
+    return 1.0;
+  return integral( -HALF_WIDTH, x ) / integral( -HALF_WIDTH, HALF_WIDTH );
+}
+
+std::vector<AudioSample> render( AudioSynth& synth )
+{
+  std::vector<AudioSample> out( SAMPLES );
+  out.resize( synth.render( SAMPLES * TICKS_PER_SAMPLE, out ) );
+  return out;
+}
+
+int check( std::string_view name, int error, bool ok )
+{
+  fmt::print( "{:<12} {:>6} {}\n", name, error, ok ? "OK" : "MISMATCH" );
+  return ok ? 0 : 1;
+}
+
+//step of AMPLITUDE in left and -AMPLITUDE in right channel at given phase of STEP_SAMPLE.
+//Output is delayed by HALF_WIDTH samples, and rounding of kernels and output may be off by one
+int checkStep( int phase )
+{
+  AudioSynth synth;
+  synth.endTick( 0, SPS, SAMPLES );
+  synth.step( STEP_SAMPLE * TICKS_PER_SAMPLE + phase, AMPLITUDE, -AMPLITUDE );
+  auto const out = render( synth );
+
+  int error = 0;
+  for ( size_t i = 0; i < out.size(); ++i )
+  {
+    double const x = (double)i - STEP_SAMPLE - phase / (double)AudioSynth::PHASES - AudioSynth::HALF_WIDTH;
+    int const expected = (int)std::lround( AMPLITUDE * stepResponse( x ) );
+    error = std::max( { error, std::abs( out[i].left - expected ), std::abs( out[i].right + expected ) } );
+  }
+
+  return check( fmt::format( "step {}/{}", phase, AudioSynth::PHASES ), error, out.size() == SAMPLES && error <= 1 && out.back().left == AMPLITUDE );
+}
+
+int checkSilence()
+{
+  AudioSynth synth;
+  synth.endTick( 0, SPS, SAMPLES );
+  for ( uint64_t tick = 0; tick < SAMPLES * TICKS_PER_SAMPLE; tick += 37 )
+  {
+    synth.step( tick, 0, 0 );
+  }
+  auto const out = render( synth );
+
+  bool const silent = std::ranges::all_of( out, []( AudioSample sample ) { return sample.left == 0 && sample.right == 0; } );
+  return check( "silence", 0, out.size() == SAMPLES && silent );
+}
+
+//steps up and down at odd phases within a few samples return exactly to zero after the response
+int checkSettle()
+{
+  AudioSynth synth;
+  synth.endTick( 0, SPS, SAMPLES );
+  for ( int i = 0; i < 8; ++i )
+  {
+    int const sign = i % 2 ? -1 : 1;
+    synth.step( STEP_SAMPLE * TICKS_PER_SAMPLE + i * 13, sign * AMPLITUDE, -sign * AMPLITUDE );
+  }
+  auto const out = render( synth );
+
+  size_t const settled = STEP_SAMPLE + 2 + AudioSynth::WIDTH;
+  bool const silent = std::all_of( out.begin() + settled, out.end(), []( AudioSample sample ) { return sample.left == 0 && sample.right == 0; } );
+  return check( "settle", 0, out.size() == SAMPLES && silent );
+}
+
+}
+
+int main()
+{
+  int failures = 0;
+  for ( int phase : { 0, 1, 17, 32, 63 } )
+  {
+    failures += checkStep( phase );
+  }
+  failures += checkSilence();
+  failures += checkSettle();
+
+  return failures == 0 ? 0 : 1;
+}
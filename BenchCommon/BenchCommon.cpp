@@ -0,0 +1,121 @@
+#include "BenchCommon.hpp"
+#include "Core.hpp"
+#include "ComLynxWire.hpp"
+#include "EEPROM.hpp"
+#include "ImageProperties.hpp"
+#include "InputFile.hpp"
+#include "ScriptDebuggerEscapes.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+std::unique_ptr<Core> makeCore( std::filesystem::path const& image )
+{
+  ImageProperties imageProperties{ std::filesystem::path{} };
+  std::shared_ptr<ImageProperties> inputProperties;
+  InputFile inputFile{ image, inputProperties };
+  return std::make_unique<Core>( imageProperties, std::make_shared<ComLynxWire>(), std::make_shared<NullVideoSink>(), std::make_shared<NullInputSource>(),
+    inputFile, std::shared_ptr<ImageROM const>{}, std::make_shared<ScriptDebuggerEscapes>() );
+}
+
+uint32_t eepromCommand( EEPROM& eeprom, uint64_t& tick, uint32_t opcode, int opcodeBits, uint32_t data, int dataBits )
+{
+  //start bit selects the chip
+  eeprom.tick( ++tick, true, true );
+  for ( int i = opcodeBits - 1; i >= 0; --i )
+  {
+    eeprom.tick( ++tick, true, ( opcode >> i ) & 1 );
+  }
+
+  uint32_t result = 0;
+  for ( int i = dataBits - 1; i >= 0; --i )
+  {
+    eeprom.tick( ++tick, true, ( data >> i ) & 1 );
+    result = ( result << 1 ) | ( eeprom.output( tick ).value_or( false ) ? 1 : 0 );
+  }
+
+  eeprom.tick( ++tick, false, false );
+  //longer than any programming cycle
+  tick += 0x1000;
+  return result;
+}
+
+uint64_t fnv( uint64_t hash, std::span<uint8_t const> data )
+{
+  for ( uint8_t value : data )
+  {
+    hash = fnv( hash, value );
+  }
+  return hash;
+}
+
+uint64_t fnv( uint64_t hash, std::span<AudioSample const> samples )
+{
+  for ( auto const& sample : samples )
+  {
+    hash = fnv( fnv( fnv( fnv( hash, ( uint8_t )sample.left ), ( uint8_t )( sample.left >> 8 ) ), ( uint8_t )sample.right ), ( uint8_t )( sample.right >> 8 ) );
+  }
+  return hash;
+}
+
+CommandLine::CommandLine( int argc, char const* argv[] ) : mProgram{ argv[0] }, mArgs{ argv + 1, argv + argc }, mUsed( mArgs.size() ), mValid{ true }
+{
+}
+
+int CommandLine::value( std::string_view name, int defaultValue, int min, int max )
+{
+  for ( size_t i = 0; i < mArgs.size(); ++i )
+  {
+    if ( mUsed[i] || mArgs[i] != name )
+      continue;
+
+    mUsed[i] = true;
+    if ( i + 1 == mArgs.size() )
+    {
+      mValid = false;
+      return defaultValue;
+    }
+
+    mUsed[i + 1] = true;
+    int result{};
+    auto const arg = mArgs[i + 1];
+    auto const [ptr, ec] = std::from_chars( arg.data(), arg.data() + arg.size(), result );
+    mValid &= ec == std::errc{} && ptr == arg.data() + arg.size();
+    return std::clamp( result, min, max );
+  }
+
+  return defaultValue;
+}
+
+bool CommandLine::flag( std::string_view name )
+{
+  bool result = false;
+  for ( size_t i = 0; i < mArgs.size(); ++i )
+  {
+    if ( !mUsed[i] && mArgs[i] == name )
+    {
+      mUsed[i] = true;
+      result = true;
+    }
+  }
+  return result;
+}
+
+std::vector<std::string_view> CommandLine::arguments()
+{
+  std::vector<std::string_view> result;
+  for ( size_t i = 0; i < mArgs.size(); ++i )
+  {
+    if ( !mUsed[i] && !mArgs[i].starts_with( "--" ) )
+    {
+      mUsed[i] = true;
+      result.push_back( mArgs[i] );
+    }
+  }
+  return result;
+}
+
+void CommandLine::done( std::string_view usage ) const
+{
+  if ( !mValid || std::ranges::find( mUsed, false ) != mUsed.end() )
+    throw std::runtime_error{ fmt::format( "Usage: {} {}", mProgram, usage ) };
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "IInputSource.hpp"
+#include "IVideoSink.hpp"
+#include "Utility.hpp"
+
+class Core;
+class EEPROM;
+
+//Helpers shared by benchmark and test targets.
+
+class NullVideoSink : public IVideoSink
+{
+public:
+  void newFrame() override {}
+  Doublet* getRow( int ) override { return mRow.data(); }
+
+private:
+  std::array<Doublet, ROW_BYTES> mRow{};
+};
+
+class NullInputSource : public IInputSource
+{
+public:
+  KeyInput getInput( bool ) const override { return {}; }
+};
+
+//Core without boot ROM and cartridge running BS93 image from given path, if any
+std::unique_ptr<Core> makeCore( std::filesystem::path const& image = {} );
+
+//FNV-1a
+static constexpr uint64_t FNV_BASIS = 0xcbf29ce484222325ull;
+
+constexpr uint64_t fnv( uint64_t hash, uint8_t value )
+{
+  return ( hash ^ value ) * 0x100000001b3ull;
+}
+
+//Clocks start bit and opcodeBits of opcode into EEPROM like the cartridge does, then clocks in dataBits of data
+//and returns bits shifted out meanwhile, both MSB first. Deselects EEPROM and lets programming finish before returning
+uint32_t eepromCommand( EEPROM& eeprom, uint64_t& tick, uint32_t opcode, int opcodeBits, uint32_t data = 0, int dataBits = 0 );
+
+uint64_t fnv( uint64_t hash, std::span<uint8_t const> data );
+//hashes both channels of samples as little endian 16-bit values
+uint64_t fnv( uint64_t hash, std::span<AudioSample const> samples );
+
+//Command line of "--name value" options, "--name" flags and plain arguments.
+//Each option is queried once and done() throws usage message if anything was not recognized
+class CommandLine
+{
+public:
+  CommandLine( int argc, char const* argv[] );
+
+  int value( std::string_view name, int defaultValue, int min = 1, int max = std::numeric_limits<int>::max() );
+  bool flag( std::string_view name );
+  //arguments not starting with "--"
+  std::vector<std::string_view> arguments();
+
+  void done( std::string_view usage ) const;
+
+private:
+  std::string_view mProgram;
+  std::vector<std::string_view> mArgs;
+  std::vector<bool> mUsed;
+  bool mValid;
+};
@@ -0,0 +1,246 @@
+#include "BenchCommon.hpp"
+#include "BootROMTraps.hpp"
+#include "Core.hpp"
+#include "ComLynxWire.hpp"
+#include "ImageProperties.hpp"
+#include "ImageROM.hpp"
+#include "InputFile.hpp"
+#include "ScriptDebuggerEscapes.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Fast boot benchmark and regression check.
+//Boots a cartridge whose loader selects cartridge pages and pulls them to RAM byte by byte in a loop the way game loaders do,
+//then waits for the next frame. Measures time to that first frame with fast boot off and on and checks that both load the same data.
+
+namespace
+{
+
+static constexpr int SPS = 48000;
+//emulated time is checked after each millisecond of audio
+static constexpr size_t BUFFER_SAMPLES = 48;
+static constexpr uint64_t TICKS_PER_SECOND = 16000000;
+static constexpr int PAGE_SIZE = 1024;
+static constexpr int PAGES = 40;
+static constexpr uint16_t LOADER = 0x0200;
+static constexpr uint16_t DESTINATION = 0x1000;
+//zero page variables
+static constexpr uint8_t DONE = 0x0f;
+static constexpr uint8_t POINTER = 0x10;
+static constexpr uint8_t PAGE = 0x12;
+
+class FrameCounter : public IVideoSink
+{
+public:
+  void newFrame() override { ++mFrames; }
+  Doublet* getRow( int ) override { return mRow.data(); }
+
+  int frames() const { return mFrames; }
+
+private:
+  std::array<Doublet, ROW_BYTES> mRow{};
+  int mFrames{};
+};
+
+std::vector<uint8_t> cartridgeData()
+{
+  std::mt19937 rng{ 1 };
+  std::vector<uint8_t> result( PAGES * PAGE_SIZE );
+  for ( auto& byte : result )
+  {
+    byte = ( uint8_t )rng();
+  }
+  return result;
+}
+
+//loader selects each page by shifting its number to the cartridge address register and reads it in 256 byte runs
+std::vector<uint8_t> loader()
+{
+  std::vector<uint8_t> code;
+  auto emit = [&]( std::initializer_list<uint8_t> bytes )
+  {
+    code.insert( code.end(), bytes );
+  };
+  auto here = [&]()
+  {
+    return ( uint16_t )( LOADER + code.size() );
+  };
+  auto branch = [&]( uint8_t opcode, uint16_t target )
+  {
+    emit( { opcode, ( uint8_t )( target - here() - 2 ) } );
+  };
+
+  emit( { 0xa9, DESTINATION & 0xff, 0x85, POINTER } );          //LDA #<DESTINATION ; STA POINTER
+  emit( { 0xa9, DESTINATION >> 8, 0x85, POINTER + 1 } );        //LDA #>DESTINATION ; STA POINTER+1
+  emit( { 0xa9, 0x00, 0x85, PAGE } );                           //LDA #0 ; STA PAGE
+  uint16_t const page = here();
+  emit( { 0xa5, PAGE } );                                       //LDA PAGE
+  size_t const call = code.size();
+  emit( { 0x20, 0x00, 0x00 } );                                 //JSR select
+  emit( { 0xa2, PAGE_SIZE / 256 } );                            //LDX #runs
+  uint16_t const run = here();
+  emit( { 0xa0, 0x00 } );                                       //LDY #0
+  uint16_t const loop = here();
+  emit( { 0xad, 0xb2, 0xfc } );                                 //LDA RCART0
+  emit( { 0x91, POINTER } );                                    //STA (POINTER),Y
+  emit( { 0xc8 } );                                             //INY
+  branch( 0xd0, loop );                                         //BNE loop
+  emit( { 0xe6, POINTER + 1 } );                                //INC POINTER+1
+  emit( { 0xca } );                                             //DEX
+  branch( 0xd0, run );                                          //BNE run
+  emit( { 0xe6, PAGE, 0xa5, PAGE, 0xc9, PAGES } );              //INC PAGE ; LDA PAGE ; CMP #PAGES
+  branch( 0xd0, page );                                         //BNE page
+  emit( { 0xa9, 0x01, 0x85, DONE } );                           //LDA #1 ; STA DONE
+  uint16_t const done = here();
+  emit( { 0x4c, ( uint8_t )done, ( uint8_t )( done >> 8 ) } );  //JMP done
+
+  uint16_t const select = here();
+  code[call + 1] = ( uint8_t )select;
+  code[call + 2] = ( uint8_t )( select >> 8 );
+  emit( { 0xa2, 0x08 } );                                       //LDX #8
+  uint16_t const bit = here();
+  emit( { 0x0a, 0x48 } );                                       //ASL A ; PHA
+  emit( { 0xa9, 0x00, 0x90, 0x02, 0xa9, 0x02 } );               //LDA #0 ; BCC +2 ; LDA #2
+  emit( { 0x8d, 0x8b, 0xfd } );                                 //STA IODAT
+  emit( { 0xa9, 0x03, 0x8d, 0x87, 0xfd } );                     //LDA #3 ; STA SYSCTL1
+  emit( { 0xa9, 0x02, 0x8d, 0x87, 0xfd } );                     //LDA #2 ; STA SYSCTL1
+  emit( { 0x68, 0xca } );                                       //PLA ; DEX
+  branch( 0xd0, bit );                                          //BNE bit
+  emit( { 0x60 } );                                             //RTS
+
+  return code;
+}
+
+void writeFile( std::filesystem::path const& path, std::span<uint8_t const> data )
+{
+  std::ofstream fout{ path, std::ios::binary };
+  fout.write( ( char const* )data.data(), data.size() );
+  if ( !fout )
+    throw std::runtime_error{ fmt::format( "Can't write {}", path.string() ) };
+}
+
+//boot ROM jumping straight to the loader, which is written to RAM in place of the one the real ROM decrypts
+std::filesystem::path writeROM()
+{
+  std::vector<uint8_t> rom( 512 );
+  rom[0] = 0x4c;
+  rom[1] = LOADER & 0xff;
+  rom[2] = LOADER >> 8;
+  for ( size_t vector = 0x1fa; vector < 0x200; vector += 2 )
+  {
+    rom[vector] = 0x00;
+    rom[vector + 1] = 0xfe;
+  }
+
+  auto path = std::filesystem::temp_directory_path() / "BootBench.img";
+  writeFile( path, rom );
+  return path;
+}
+
+std::filesystem::path writeCartridge( std::span<uint8_t const> data )
+{
+  std::vector<uint8_t> image( 64 );
+  image[0] = 'L';
+  image[1] = 'Y';
+  image[2] = 'N';
+  image[3] = 'X';
+  image[4] = PAGE_SIZE & 0xff;
+  image[5] = PAGE_SIZE >> 8;
+  image[8] = 1;
+  image.insert( image.end(), data.begin(), data.end() );
+
+  auto path = std::filesystem::temp_directory_path() / "BootBench.lnx";
+  writeFile( path, image );
+  return path;
+}
+
+struct Result
+{
+  std::chrono::steady_clock::duration elapsed;
+  uint64_t loadTicks;
+  uint64_t ticks;
+  int frames;
+  bool loaded;
+};
+
+Result boot( std::filesystem::path const& cartridge, std::filesystem::path const& rom, std::span<uint8_t const> data, bool fastBoot )
+{
+  ImageProperties imageProperties{ std::filesystem::path{} };
+  std::shared_ptr<ImageProperties> inputProperties;
+  InputFile inputFile{ cartridge, inputProperties };
+  auto frameCounter = std::make_shared<FrameCounter>();
+  auto core = std::make_unique<Core>( imageProperties, std::make_shared<ComLynxWire>(), frameCounter, std::make_shared<NullInputSource>(),
+    inputFile, ImageROM::create( rom ), std::make_shared<ScriptDebuggerEscapes>() );
+  if ( fastBoot )
+    core->enableFastBoot();
+
+  core->debugWriteRAM( LOADER, loader() );
+  //registers the real boot ROM leaves to the loader
+  initMikeyRegisters( *core );
+  core->debugWriteMikey( 0x8a, 3 );  //IODIR
+
+  std::vector<AudioSample> samples( BUFFER_SAMPLES );
+  std::optional<int> loadedFrame;
+  uint64_t loadTicks{};
+
+  auto const start = std::chrono::steady_clock::now();
+  while ( !loadedFrame || frameCounter->frames() <= *loadedFrame )
+  {
+    core->advanceAudio( SPS, samples, RunMode::RUN );
+    if ( !loadedFrame && core->debugReadRAM( DONE ) != 0 )
+    {
+      loadedFrame = frameCounter->frames();
+      loadTicks = core->tick();
+    }
+  }
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+
+  bool loaded = true;
+  for ( size_t i = 0; i < data.size(); ++i )
+  {
+    loaded &= core->debugReadRAM( ( uint16_t )( DESTINATION + i ) ) == data[i];
+  }
+
+  return { elapsed, loadTicks, core->tick(), frameCounter->frames(), loaded };
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  try
+  {
+    CommandLine commandLine{ argc, argv };
+    int const iterations = commandLine.value( "--iterations", 10 );
+    commandLine.done( "[--iterations N]" );
+
+    auto const data = cartridgeData();
+    auto const cartridge = writeCartridge( data );
+    auto const rom = writeROM();
+    int failures = 0;
+
+    fmt::print( "{:<10} {:>16} {:>16} {:>16} {:>8}\n", "fast boot", "first frame ms", "emulated load ms", "emulated frame ms", "frames" );
+
+    for ( bool fastBoot : { false, true } )
+    {
+      Result best{ std::chrono::steady_clock::duration::max() };
+      for ( int i = 0; i < iterations; ++i )
+      {
+        auto const result = boot( cartridge, rom, data, fastBoot );
+        failures += result.loaded ? 0 : 1;
+        if ( result.elapsed < best.elapsed )
+          best = result;
+      }
+
+      fmt::print( "{:<10} {:>16.2f} {:>16.2f} {:>16.2f} {:>8} {}\n", fastBoot ? "on" : "off", std::chrono::duration<double, std::milli>( best.elapsed ).count(),
+        best.loadTicks * 1000.0 / TICKS_PER_SECOND, best.ticks * 1000.0 / TICKS_PER_SECOND, best.frames, best.loaded ? "OK" : "MISMATCH" );
+    }
+
+    return failures == 0 ? 0 : 1;
+  }
+  catch ( std::exception const& ex )
+  {
+    fmt::print( stderr, "{}\n", ex.what() );
+    return 2;
+  }
+}
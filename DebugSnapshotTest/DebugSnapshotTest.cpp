@@ -0,0 +1,164 @@
+#include "BenchCommon.hpp"
+#include "Core.hpp"
+#include "DebugSnapshot.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//DebugSnapshots stress test.
+//Producer thread fills and publishes snapshots like the emulator at vertical blank while consumer thread takes them like debug windows.
+//Consumer checks that every snapshot it gets is whole and newer than the previous one, and queues edits that producer must apply in order.
+//In the first half producer waits for the consumer to get every snapshot, in the second half it runs freely so snapshots are skipped.
+
+namespace
+{
+
+uint8_t content( uint64_t tick, size_t address )
+{
+  return ( uint8_t )( ( tick * 0x9e3779b9u ) ^ ( address * 13 ) ^ ( address >> 8 ) );
+}
+
+int produce( DebugSnapshots& snapshots, Core& core, int count, std::atomic<uint64_t> const& received )
+{
+  int requests = 0;
+
+  for ( uint64_t tick = 1; tick <= ( uint64_t )count; ++tick )
+  {
+    while ( tick <= ( uint64_t )count / 2 && received.load() < tick - 1 )
+    {
+      std::this_thread::yield();
+    }
+
+    if ( snapshots.requested() )
+    {
+      requests += 1;
+      snapshots.applyEdits( core );
+    }
+
+    auto& snapshot = snapshots.back();
+    for ( size_t address = 0; address < snapshot.ram.size(); ++address )
+    {
+      snapshot.ram[address] = content( tick, address );
+    }
+    snapshot.rom.fill( ( uint8_t )tick );
+    snapshot.palette.fill( ( uint8_t )( tick >> 8 ) );
+    snapshot.dispAdr = snapshot.vidBas = snapshot.collBas = ( uint16_t )tick;
+    snapshot.tick = tick;
+    snapshots.publish();
+  }
+
+  return requests;
+}
+
+struct ConsumerResult
+{
+  int received;
+  int skipped;
+  int requested;
+  int errors;
+};
+
+//counts edits applied in order on producer thread
+struct Edits
+{
+  std::thread::id producer;
+  int applied;
+  int errors;
+};
+
+ConsumerResult consume( DebugSnapshots& snapshots, int count, std::atomic<uint64_t>& received, Edits& edits )
+{
+  ConsumerResult result{};
+  uint64_t tick = 0;
+
+  while ( tick < ( uint64_t )count )
+  {
+    auto snapshot = snapshots.nextSnapshot();
+    if ( !snapshot )
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    if ( snapshot->tick <= tick || &snapshots.currentSnapshot() != snapshot )
+    {
+      result.errors += 1;
+      break;
+    }
+
+    result.received += 1;
+    result.skipped += ( int )( snapshot->tick - tick - 1 );
+    tick = snapshot->tick;
+
+    bool whole = snapshot->dispAdr == ( uint16_t )tick && snapshot->vidBas == ( uint16_t )tick && snapshot->collBas == ( uint16_t )tick;
+    whole &= std::ranges::all_of( snapshot->rom, [=]( uint8_t value ) { return value == ( uint8_t )tick; } );
+    whole &= std::ranges::all_of( snapshot->palette, [=]( uint8_t value ) { return value == ( uint8_t )( tick >> 8 ); } );
+    for ( size_t address = 0; address < snapshot->ram.size(); ++address )
+    {
+      whole &= snapshot->ram[address] == content( tick, address );
+    }
+
+    if ( !whole )
+    {
+      fmt::print( "snapshot {} is torn\n", tick );
+      result.errors += 1;
+      break;
+    }
+
+    //edits once in a while, the way debug windows do
+    if ( result.received % 64 == 1 )
+    {
+      snapshots.edit( [&edits, sequence = result.requested]( Core& )
+      {
+        edits.errors += edits.applied == sequence && std::this_thread::get_id() == edits.producer ? 0 : 1;
+        edits.applied += 1;
+      } );
+      result.requested += 1;
+    }
+
+    received.store( tick );
+  }
+
+  //releases waiting producer also on error
+  received.store( std::numeric_limits<uint64_t>::max() );
+  return result;
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  int count = 5000;
+  if ( argc == 3 && std::string_view{ argv[1] } == "--snapshots" )
+  {
+    count = std::max( 1, std::atoi( argv[2] ) );
+  }
+  else if ( argc != 1 )
+  {
+    fmt::print( stderr, "Usage: {} [--snapshots N]\n", argv[0] );
+    return 2;
+  }
+
+  auto snapshots = std::make_unique<DebugSnapshots>();
+  auto core = makeCore();
+  ConsumerResult result{};
+  Edits edits{ std::this_thread::get_id() };
+  std::atomic<uint64_t> received{};
+
+  std::thread consumer{ [&]
+  {
+    result = consume( *snapshots, count, received, edits );
+  } };
+
+  int const requests = produce( *snapshots, *core, count, received );
+  consumer.join();
+  //edit queued after the last snapshot was published is still pending
+  int const pending = snapshots->requested() ? 1 : 0;
+  snapshots->applyEdits( *core );
+
+  fmt::print( "snapshots {} received {} skipped {} edited {} seen {} applied {} errors {}\n", count, result.received, result.skipped, result.requested,
+    requests + pending, edits.applied, result.errors + edits.errors );
+  bool const ok = result.errors == 0 && result.received + result.skipped == count && requests + pending >= 1 && requests + pending <= result.requested &&
+    edits.applied == result.requested && edits.errors == 0;
+  fmt::print( "{}\n", ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
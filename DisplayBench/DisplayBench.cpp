@@ -0,0 +1,333 @@
+#include "BenchCommon.hpp"
+#include "DisplayGenerator.hpp"
+#include "IVideoSink.hpp"
+#include "Simd.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//DisplayGenerator row conversion benchmark.
+//Compares DisplayGenerator::convert against byte by byte conversion through a table of pixel pairs
+//for whole rows and for DMA sized segments, and checks that both give the same pixels, also with palette changes mid-line.
+//Then drives whole frames through DisplayGenerator with pixel and pen output and checks that expanded pens give the same frames.
+
+namespace
+{
+
+class PixelVideoSink : public IVideoSink
+{
+public:
+  void newFrame() override {}
+  Doublet* getRow( int row ) override { return mFrame.data() + row * ROW_BYTES; }
+
+  std::span<Doublet const> frame() const { return mFrame; }
+
+private:
+  std::array<Doublet, ROW_BYTES * SCREEN_HEIGHT> mFrame{};
+};
+
+//keeps pens and color register writes of last frame and expands them on demand like a consumer on another thread would
+class PenVideoSink : public IVideoSink
+{
+public:
+  Format format() const override { return Format::PENS; }
+
+  void newFrame() override
+  {
+    mFrameStartPalette = mStartPalette;
+    mStartPalette = mPalette;
+    mFrameLog.swap( mLog );
+    mLog.clear();
+  }
+
+  //pen sinks get pen rows only
+  Doublet* getRow( int ) override { return nullptr; }
+  uint8_t* getPenRow( int row ) override { return mPens.data() + row * ROW_BYTES; }
+
+  void colorReg( int row, int pixel, uint8_t reg, uint8_t value ) override
+  {
+    mPalette[reg] = value;
+    mLog.push_back( { row, pixel, reg, value } );
+  }
+
+  //expands last frame finished by newFrame
+  void expand( Doublet* out ) const
+  {
+    PenPalette palette;
+    for ( int reg = 0; reg < 32; ++reg )
+    {
+      palette.setColorReg( ( uint8_t )reg, mFrameStartPalette[reg] );
+    }
+
+    size_t next = 0;
+    for ( int row = 0; row < SCREEN_HEIGHT; ++row )
+    {
+      std::span<uint8_t const> pens{ mPens.data() + row * ROW_BYTES, ROW_BYTES };
+      size_t begin = 0;
+      for ( ; next < mFrameLog.size() && mFrameLog[next].row <= row; ++next )
+      {
+        ColorWrite const& write = mFrameLog[next];
+        if ( write.row == row )
+        {
+          size_t end = write.pixel / 2;
+          palette.expand( pens.subspan( begin, end - begin ), out + begin );
+          begin = end;
+        }
+        palette.setColorReg( write.reg, write.value );
+      }
+      palette.expand( pens.subspan( begin ), out + begin );
+      out += ROW_BYTES;
+    }
+  }
+
+private:
+  struct ColorWrite
+  {
+    int row;
+    int pixel;
+    uint8_t reg;
+    uint8_t value;
+  };
+
+  std::array<uint8_t, ROW_BYTES * SCREEN_HEIGHT> mPens{};
+  std::array<uint8_t, 32> mPalette{};
+  std::array<uint8_t, 32> mStartPalette{};
+  std::array<uint8_t, 32> mFrameStartPalette{};
+  std::vector<ColorWrite> mLog;
+  std::vector<ColorWrite> mFrameLog;
+};
+
+//table of pixel pairs for each screen byte built from color registers the way DisplayGenerator used to
+class ReferenceConverter
+{
+public:
+  ReferenceConverter( DisplayGenerator const& generator )
+  {
+    for ( int i = 0; i < 256; ++i )
+    {
+      mDoublets[i] = { color( generator, i >> 4 ), color( generator, i & 0x0f ) };
+    }
+  }
+
+  void convert( std::span<uint8_t const> data, Doublet* out ) const
+  {
+    for ( uint8_t byte : data )
+    {
+      *out++ = mDoublets[byte];
+    }
+  }
+
+private:
+  static Pixel color( DisplayGenerator const& generator, int pen )
+  {
+    uint8_t green = generator.getColorReg( ( uint8_t )pen );
+    uint8_t blueRed = generator.getColorReg( ( uint8_t )( 0x10 + pen ) );
+    Pixel pixel{};
+    pixel.b = ( blueRed >> 4 ) | ( blueRed & 0xf0 );
+    pixel.g = ( green << 4 ) | ( green & 0x0f );
+    pixel.r = ( blueRed << 4 ) | ( blueRed & 0x0f );
+    return pixel;
+  }
+
+  std::array<Doublet, 256> mDoublets;
+};
+
+bool same( std::span<Doublet const> left, std::span<Doublet const> right )
+{
+  return left.size() == right.size() && std::memcmp( left.data(), right.data(), left.size_bytes() ) == 0;
+}
+
+template<typename CONVERT>
+double pixelsPerSecond( std::vector<uint8_t> const& frame, std::vector<Doublet>& out, size_t segment, int iterations, CONVERT convert )
+{
+  auto const start = std::chrono::steady_clock::now();
+  for ( int i = 0; i < iterations; ++i )
+  {
+    for ( size_t offset = 0; offset < frame.size(); offset += segment )
+    {
+      convert( std::span<uint8_t const>{ frame.data() + offset, segment }, out.data() + offset );
+    }
+  }
+  double const seconds = std::max( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count(), 1e-9 );
+  return 2.0 * frame.size() * iterations / seconds;
+}
+
+//drives frames through display generator like Mikey does with display DMA and random color register writes
+template<typename FRAME_END>
+void runFrames( DisplayGenerator& generator, int frames, FRAME_END frameEnd )
+{
+  //line length of default timer setup and display DMA starting 608 ticks after hblank
+  static constexpr uint64_t LINE_TICKS = 159 * 16;
+  static constexpr uint8_t PBKUP = 0x29;
+
+  std::mt19937 rng{ 2 };
+  generator.dispCtl( false, false, true );
+  generator.setPBKUP( PBKUP );
+
+  std::vector<uint64_t> writes;
+  uint64_t tick = LINE_TICKS;
+  for ( int frame = 0; frame < frames; ++frame )
+  {
+    for ( int cnt = 104; cnt >= 0; --cnt, tick += LINE_TICKS )
+    {
+      writes.resize( rng() % 4 );
+      std::ranges::generate( writes, [&] { return tick + 1 + rng() % ( LINE_TICKS - 1 ); } );
+      std::ranges::sort( writes );
+      auto write = writes.cbegin();
+      auto writeColorReg = [&]
+      {
+        generator.setColorReg( *write++, ( uint8_t )( rng() % 32 ), ( uint8_t )rng() );
+      };
+
+      auto dma = generator.hblank( tick, cnt );
+      while ( dma )
+      {
+        while ( write != writes.cend() && *write < dma.tick )
+        {
+          writeColorReg();
+        }
+        dma = generator.pushData( dma.tick, ( ( uint64_t )rng() << 32 ) | rng() );
+      }
+      while ( write != writes.cend() )
+      {
+        writeColorReg();
+      }
+    }
+    generator.vblank( tick );
+    frameEnd();
+  }
+}
+
+//converts rows in random segments changing a random color register between them
+bool checkPaletteChanges( DisplayGenerator& generator, std::mt19937& rng )
+{
+  std::array<uint8_t, ROW_BYTES> row;
+  std::array<Doublet, ROW_BYTES> converted;
+  std::array<Doublet, ROW_BYTES> expected;
+
+  for ( int i = 0; i < 1000; ++i )
+  {
+    std::ranges::generate( row, [&] { return ( uint8_t )rng(); } );
+
+    for ( size_t begin = 0; begin < ROW_BYTES; )
+    {
+      size_t const end = std::min<size_t>( ROW_BYTES, begin + 1 + rng() % 24 );
+      std::span<uint8_t const> segment{ row.data() + begin, end - begin };
+      generator.convert( segment, converted.data() + begin );
+      ReferenceConverter{ generator }.convert( segment, expected.data() + begin );
+      generator.setColorReg( 0, ( uint8_t )( rng() % 32 ), ( uint8_t )rng() );
+      begin = end;
+    }
+
+    if ( !same( converted, expected ) )
+      return false;
+  }
+
+  return true;
+}
+
+int run( int iterations )
+{
+  std::mt19937 rng{ 1 };
+  DisplayGenerator generator{ std::make_shared<NullVideoSink>() };
+  for ( int reg = 0; reg < 32; ++reg )
+  {
+    generator.setColorReg( 0, ( uint8_t )reg, ( uint8_t )rng() );
+  }
+
+  std::vector<uint8_t> frame( ROW_BYTES * SCREEN_HEIGHT );
+  std::ranges::generate( frame, [&] { return ( uint8_t )rng(); } );
+  std::vector<Doublet> converted( frame.size() );
+  std::vector<Doublet> expected( frame.size() );
+
+  ReferenceConverter const reference{ generator };
+  bool ok = true;
+
+#if defined( FELIX_SSE2 )
+  fmt::print( "pixels converted with {}\n", simd::ssse3() ? "SSSE3" : "table of pixel pairs" );
+#else
+  fmt::print( "pixels converted with table of pixel pairs\n" );
+#endif
+  fmt::print( "{:<10} {:>16} {:>16} {:>8}\n", "segment", "bytewise px/s", "convert px/s", "gain" );
+
+  //whole rows and segments fetched by single display DMA
+  for ( size_t segment : { ( size_t )ROW_BYTES, ( size_t )8 } )
+  {
+    double const bytewise = pixelsPerSecond( frame, expected, segment, iterations, [&]( std::span<uint8_t const> data, Doublet* out )
+    {
+      reference.convert( data, out );
+    } );
+    double const converter = pixelsPerSecond( frame, converted, segment, iterations, [&]( std::span<uint8_t const> data, Doublet* out )
+    {
+      generator.convert( data, out );
+    } );
+
+    ok &= same( converted, expected );
+    fmt::print( "{:<10} {:>16.0f} {:>16.0f} {:>7.2f}x\n", fmt::format( "{} bytes", segment ), bytewise, converter, converter / bytewise );
+  }
+
+  ok &= checkPaletteChanges( generator, rng );
+
+  {
+    auto pixelSink = std::make_shared<PixelVideoSink>();
+    auto penSink = std::make_shared<PenVideoSink>();
+    DisplayGenerator pixelGenerator{ pixelSink };
+    DisplayGenerator penGenerator{ penSink };
+    std::vector<Doublet> expanded( ROW_BYTES * SCREEN_HEIGHT );
+    int const frames = std::max( 1, iterations / 10 );
+
+    auto framesPerSecond = [&]( DisplayGenerator& generator )
+    {
+      auto const start = std::chrono::steady_clock::now();
+      runFrames( generator, frames, [] {} );
+      return frames / std::max( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count(), 1e-9 );
+    };
+
+    double const pixelOutput = framesPerSecond( pixelGenerator );
+    double const penOutput = framesPerSecond( penGenerator );
+
+    auto const start = std::chrono::steady_clock::now();
+    for ( int i = 0; i < frames; ++i )
+    {
+      penSink->expand( expanded.data() );
+    }
+    double const expansion = frames / std::max( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count(), 1e-9 );
+
+    fmt::print( "\n{:<10} {:>16} {:>16} {:>16}\n", "frames", "pixels fps", "pens fps", "expand fps" );
+    fmt::print( "{:<10} {:>16.0f} {:>16.0f} {:>16.0f}\n", frames, pixelOutput, penOutput, expansion );
+
+    //fresh generators so both sinks see the same frames from the start
+    pixelSink = std::make_shared<PixelVideoSink>();
+    penSink = std::make_shared<PenVideoSink>();
+    DisplayGenerator pixelChecker{ pixelSink };
+    DisplayGenerator penChecker{ penSink };
+    std::vector<std::vector<Doublet>> pixelFrames;
+    runFrames( pixelChecker, 8, [&] { pixelFrames.emplace_back( pixelSink->frame().begin(), pixelSink->frame().end() ); } );
+    size_t frame = 0;
+    runFrames( penChecker, 8, [&]
+    {
+      penSink->expand( expanded.data() );
+      ok &= same( expanded, pixelFrames[frame++] );
+    } );
+  }
+
+  fmt::print( "{}\n", ok ? "OK" : "MISMATCH" );
+  return ok ? 0 : 1;
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  try
+  {
+    CommandLine commandLine{ argc, argv };
+    int const iterations = commandLine.value( "--iterations", 2000 );
+    commandLine.done( "[--iterations N]" );
+    return run( iterations );
+  }
+  catch ( std::exception const& ex )
+  {
+    fmt::print( stderr, "{}\n", ex.what() );
+    return 2;
+  }
+}
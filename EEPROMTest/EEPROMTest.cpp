@@ -0,0 +1,281 @@
+#include "BenchCommon.hpp"
+#include "EEPROM.hpp"
+#include "EEPROMFlusher.hpp"
+#include "TraceHelper.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//EEPROM flusher test.
+//Hammers EEPROMFlusher with word writes while its store is stalled to check that the emulation thread never waits on it,
+//checks that the final image is stored after the stall with writes coalesced, that destroying the flusher does not wait
+//for a stalled store for long, and that file store replaces the file through a temporary one.
+//Also clocks WRITE, ERASE, WRAL and ERAL commands into EEPROM and checks that the stored image follows them.
+
+namespace
+{
+
+static constexpr size_t IMAGE_SIZE = 2048;
+
+//stand-in for a file system that does not respond until released
+class StalledStore
+{
+public:
+  bool operator()( std::span<uint8_t const> image )
+  {
+    std::unique_lock lock{ mMutex };
+    mEntered = true;
+    mCondition.notify_all();
+    mCondition.wait( lock, [this]
+    {
+      return mReleased;
+    } );
+    mLast.assign( image.begin(), image.end() );
+    mCount += 1;
+    return true;
+  }
+
+  void waitEntered()
+  {
+    std::unique_lock lock{ mMutex };
+    mCondition.wait( lock, [this]
+    {
+      return mEntered;
+    } );
+  }
+
+  void release()
+  {
+    std::unique_lock lock{ mMutex };
+    mReleased = true;
+    mCondition.notify_all();
+  }
+
+  std::vector<uint8_t> last()
+  {
+    std::unique_lock lock{ mMutex };
+    return mLast;
+  }
+
+  int count()
+  {
+    std::unique_lock lock{ mMutex };
+    return mCount;
+  }
+
+private:
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  bool mEntered = false;
+  bool mReleased = false;
+  int mCount = 0;
+  std::vector<uint8_t> mLast;
+};
+
+int testStalled( uint32_t writes )
+{
+  auto store = std::make_shared<StalledStore>();
+  std::vector<uint8_t> image( IMAGE_SIZE, 0xff );
+  double maxMicros{};
+  bool finished{};
+
+  {
+    EEPROMFlusher flusher{ [store]( std::span<uint8_t const> data )
+    {
+      return ( *store )( data );
+    }, image, false };
+
+    //first write gets the flusher stuck in the store
+    image[0] = 0;
+    flusher.update( image, 0, 1 );
+    store->waitEntered();
+
+    auto hammer = std::async( std::launch::async, [&]
+    {
+      uint32_t seed = 1;
+      for ( uint32_t i = 0; i < writes; ++i )
+      {
+        seed = seed * 1664525u + 1013904223u;
+        size_t const address = ( seed >> 8 ) % ( IMAGE_SIZE / 2 ) * 2;
+        image[address] = ( uint8_t )( seed >> 16 );
+        image[address + 1] = ( uint8_t )( seed >> 24 );
+
+        auto const start = std::chrono::steady_clock::now();
+        flusher.update( image, address, 2 );
+        maxMicros = std::max( maxMicros, std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - start ).count() );
+      }
+    } );
+
+    //writes must all finish while the store is still stalled
+    finished = hammer.wait_for( std::chrono::seconds{ 30 } ) == std::future_status::ready;
+    store->release();
+    hammer.wait();
+  }
+
+  //stalled store and one store of all hammered writes coalesced
+  bool const ok = finished && store->last() == image && store->count() == 2;
+  fmt::print( "stalled: {} writes, max update {:.1f} us, {} stores {}\n", writes, maxMicros, store->count(), ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+int testDetached()
+{
+  auto store = std::make_shared<StalledStore>();
+  std::vector<uint8_t> image( IMAGE_SIZE, 0xff );
+  std::optional<EEPROMFlusher> flusher;
+  flusher.emplace( [store]( std::span<uint8_t const> data )
+  {
+    return ( *store )( data );
+  }, image, false );
+
+  image[0] = 0;
+  flusher->update( image, 0, 1 );
+  store->waitEntered();
+
+  auto const start = std::chrono::steady_clock::now();
+  flusher.reset();
+  auto const destruction = std::chrono::steady_clock::now() - start;
+
+  //store left to the detached thread completes once the file system responds
+  store->release();
+  while ( store->count() == 0 )
+  {
+    std::this_thread::sleep_for( std::chrono::milliseconds{ 1 } );
+  }
+
+  bool const ok = destruction < EEPROMFlusher::STOP_TIMEOUT * 2 && store->last() == image;
+  fmt::print( "detached: destroyed in {:.0f} ms {}\n", std::chrono::duration<double, std::milli>( destruction ).count(), ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+int testCommands()
+{
+  //93C46 organized in 16-bit words takes 2 bits of command and 6 bits of address
+  static constexpr int OPCODE_BITS = 8;
+  static constexpr int DATA_BITS = 16;
+  static constexpr int WORDS = 64;
+  static constexpr uint32_t EWEN = 0b00110000;
+  static constexpr uint32_t EWDS = 0b00000000;
+  static constexpr uint32_t WRAL = 0b00010000;
+  static constexpr uint32_t ERAL = 0b00100000;
+  static constexpr uint32_t WRITE = 0b01000000;
+  static constexpr uint32_t ERASE = 0b11000000;
+
+  auto const path = std::filesystem::temp_directory_path() / "EEPROMTest.e2p";
+  std::filesystem::remove( path );
+
+  //runs commands on EEPROM opened from path, destroys it to store pending changes and compares the file with expected words
+  auto session = [&]( std::string_view name, auto commands, std::array<uint16_t, WORDS> const& expected )
+  {
+    {
+      EEPROM eeprom{ path, 1, true, std::make_shared<TraceHelper>() };
+      uint64_t tick = 0;
+      commands( [&]( uint32_t opcode, uint32_t data = 0, int dataBits = 0 )
+      {
+        eepromCommand( eeprom, tick, opcode, OPCODE_BITS, data, dataBits );
+      } );
+    }
+
+    std::ifstream fin{ path, std::ios::binary };
+    std::vector<uint8_t> data{ std::istreambuf_iterator<char>{ fin }, std::istreambuf_iterator<char>{} };
+    bool ok = data.size() == WORDS * 2;
+    for ( size_t i = 0; ok && i < WORDS; ++i )
+    {
+      ok = ( data[i * 2] | ( data[i * 2 + 1] << 8 ) ) == expected[i];
+    }
+    fmt::print( "{}: {}\n", name, ok ? "OK" : "FAILED" );
+    return ok ? 0 : 1;
+  };
+
+  std::array<uint16_t, WORDS> words;
+  words.fill( 0xffff );
+  int failures = 0;
+
+  words[3] = 0x1234;
+  words[62] = 0xbeef;
+  failures += session( "write", [&]( auto command )
+  {
+    command( EWEN );
+    command( WRITE | 3, 0x1234, DATA_BITS );
+    command( WRITE | 62, 0xbeef, DATA_BITS );
+  }, words );
+
+  words[3] = 0xffff;
+  words[40] = 0x0001;
+  failures += session( "erase", [&]( auto command )
+  {
+    command( EWEN );
+    command( ERASE | 3 );
+    command( WRITE | 40, 0x0001, DATA_BITS );
+    command( EWDS );
+    command( WRITE | 41, 0x5555, DATA_BITS );
+  }, words );
+
+  words.fill( 0xa55a );
+  failures += session( "wral", [&]( auto command )
+  {
+    command( EWEN );
+    command( WRAL, 0xa55a, DATA_BITS );
+  }, words );
+
+  words.fill( 0xffff );
+  failures += session( "eral", [&]( auto command )
+  {
+    command( EWEN );
+    command( ERAL );
+  }, words );
+
+  std::filesystem::remove( path );
+  return failures;
+}
+
+int testFile()
+{
+  auto const path = std::filesystem::temp_directory_path() / "EEPROMTest.e2p";
+  auto tmp = path;
+  tmp += ".tmp";
+
+  std::vector<uint8_t> image( IMAGE_SIZE, 0xff );
+  {
+    EEPROMFlusher flusher{ path, image, true };
+    for ( size_t i = 0; i < 16; ++i )
+    {
+      image[i * 3] = ( uint8_t )i;
+      flusher.update( image, i * 3, 1 );
+    }
+  }
+
+  std::ifstream fin{ path, std::ios::binary };
+  std::vector<uint8_t> data{ std::istreambuf_iterator<char>{ fin }, std::istreambuf_iterator<char>{} };
+  fin.close();
+  bool const tmpLeft = std::filesystem::exists( tmp );
+  std::filesystem::remove( path );
+
+  bool const ok = data == image && !tmpLeft;
+  fmt::print( "file: {} bytes {}\n", data.size(), ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  uint32_t writes = 10'000'000;
+  if ( argc == 3 && std::string_view{ argv[1] } == "--writes" )
+  {
+    writes = ( uint32_t )std::max( 1, std::atoi( argv[2] ) );
+  }
+  else if ( argc != 1 )
+  {
+    fmt::print( stderr, "Usage: {} [--writes N]\n", argv[0] );
+    return 2;
+  }
+
+  int failures = 0;
+  failures += testStalled( writes );
+  failures += testDetached();
+  failures += testFile();
+  failures += testCommands();
+
+  fmt::print( "{}\n", failures == 0 ? "OK" : "FAILED" );
+  return failures == 0 ? 0 : 1;
+}
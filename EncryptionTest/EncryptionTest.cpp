@@ -0,0 +1,76 @@
+#include "Encryption.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Boot block decryption test.
+//Decrypts known answer blocks, encrypted with the Lynx private key and checked with the arbitrary precision decryption used
+//before, including a block not reduced modulo the public modulus. Checks that blocks failing sanity checks are rejected
+//and that cached loaders are the same as decrypted ones.
+
+namespace
+{
+
+static constexpr size_t BLOCK_BYTES = 51;
+static constexpr size_t BLOCKS = 3;
+
+static constexpr std::array<uint8_t, BLOCK_BYTES * BLOCKS> ENCRYPTED = {
+  0xb2, 0x2f, 0x81, 0xd1, 0xf2, 0x8a, 0x59, 0x75, 0xd2, 0xfa, 0x49, 0xd2, 0xf2, 0x38, 0x5b, 0xb4, 0xe0,
+  0x4a, 0xbf, 0x4b, 0x66, 0x3c, 0x29, 0x2e, 0xbe, 0x9f, 0x78, 0xfe, 0x78, 0x69, 0x89, 0x76, 0xd0, 0xcf,
+  0xff, 0x38, 0x35, 0x89, 0x52, 0xc9, 0x03, 0xd7, 0x33, 0x04, 0x88, 0xc1, 0x07, 0xc4, 0xd0, 0xb1, 0x0d,
+  0x34, 0x65, 0x93, 0xc9, 0xfc, 0x2e, 0x15, 0xdb, 0x60, 0xca, 0xe1, 0x3f, 0x8a, 0x0a, 0x56, 0x11, 0xf3,
+  0x16, 0x7d, 0x9a, 0xac, 0xe0, 0x82, 0x1f, 0xb2, 0x00, 0xf8, 0x10, 0x30, 0x40, 0x4f, 0x91, 0x38, 0x60,
+  0xf2, 0x70, 0x41, 0xb2, 0x96, 0x0d, 0xea, 0xb7, 0x54, 0x3d, 0x81, 0xfe, 0xca, 0x10, 0x74, 0x27, 0x29,
+  0xd7, 0x4c, 0xfa, 0xa5, 0xe3, 0x5c, 0x0c, 0x16, 0x59, 0xc8, 0x45, 0xff, 0x9e, 0x39, 0x69, 0x09, 0x21,
+  0x30, 0x3d, 0xac, 0xfa, 0xac, 0x4d, 0xc8, 0x00, 0x91, 0xcf, 0x02, 0x6e, 0x96, 0x3a, 0x77, 0x56, 0x6f,
+  0x77, 0x42, 0xe3, 0x00, 0xf6, 0x1b, 0x7e, 0xb6, 0xe7, 0x70, 0xba, 0x78, 0x00, 0xdc, 0xfa, 0x06, 0x00
+};
+
+//first block of ENCRYPTED with public modulus added
+static constexpr std::array<uint8_t, BLOCK_BYTES> UNREDUCED = {
+  0x2b, 0xae, 0x2d, 0xcf, 0xd4, 0x89, 0x4e, 0xce, 0xfc, 0xb4, 0x3c, 0x1f, 0x29, 0xc2, 0xbf, 0xc7, 0xfc,
+  0x1e, 0xdb, 0x83, 0xc9, 0x89, 0x65, 0x9c, 0xee, 0xf9, 0xae, 0xfe, 0x9e, 0x19, 0x2d, 0x2d, 0xea, 0x19,
+  0x1c, 0x8f, 0x32, 0xc6, 0x04, 0x3b, 0xdb, 0x6c, 0x5a, 0xa6, 0x60, 0xc8, 0x2f, 0x58, 0x74, 0x67, 0x43
+};
+
+static constexpr std::array<uint8_t, ( BLOCK_BYTES - 1 ) * BLOCKS> DECRYPTED = {
+  0x44, 0x20, 0x82, 0x3c, 0xfd, 0xe6, 0xf1, 0xc2, 0x6b, 0x30, 0xf9, 0x0e, 0xc7, 0xdd, 0x01, 0xe4, 0x88,
+  0x75, 0x34, 0xa2, 0x0f, 0x0b, 0x0d, 0x04, 0xc3, 0x6e, 0xd8, 0x0e, 0x71, 0xe0, 0xfd, 0x77, 0xb0, 0x76,
+  0x70, 0xeb, 0x94, 0x0b, 0xd5, 0x33, 0x5f, 0x97, 0x3d, 0xaa, 0xd8, 0x61, 0x9b, 0x91, 0xff, 0xc9, 0x11,
+  0xf5, 0x7c, 0xce, 0xd4, 0x58, 0xbb, 0xbf, 0x2c, 0xe0, 0x37, 0x53, 0xc9, 0xbd, 0xfa, 0x0f, 0xf0, 0x16,
+  0x9d, 0xc9, 0x57, 0x56, 0x74, 0x06, 0x66, 0x76, 0xcf, 0xb0, 0xb4, 0xeb, 0x89, 0x02, 0xc4, 0x42, 0x69,
+  0xda, 0x1c, 0xf6, 0xba, 0x66, 0xd3, 0xf8, 0xb6, 0xd4, 0xb1, 0x00, 0xa9, 0xea, 0x0e, 0x75, 0x5a, 0x5c,
+  0x2e, 0x82, 0x10, 0x24, 0x2a, 0x08, 0xe7, 0x07, 0x8f, 0x7f, 0x89, 0x38, 0x5e, 0xb0, 0x94, 0x23, 0x55,
+  0x51, 0x82, 0x56, 0x8b, 0x96, 0xe8, 0xa4, 0xfe, 0xf2, 0x3a, 0x0c, 0x9f, 0xc5, 0xaf, 0xd7, 0x60, 0x84,
+  0x37, 0x81, 0x6b, 0xdd, 0x0a, 0x73, 0x09, 0xcb, 0x4a, 0x12, 0x52, 0xe4, 0xda, 0x00
+};
+
+//decrypts to block without sanity check byte
+static constexpr std::array<uint8_t, BLOCK_BYTES> CORRUPTED = {
+  0x70, 0xe6, 0x72, 0x0f, 0xca, 0xa4, 0xda, 0x1e, 0x98, 0x40, 0x6c, 0x18, 0x9c, 0x24, 0x27, 0x9e, 0x98,
+  0x51, 0xd5, 0x81, 0x42, 0x04, 0x13, 0x6f, 0xeb, 0x57, 0x13, 0xc1, 0x66, 0xb1, 0x32, 0x69, 0xdd, 0x63,
+  0xfc, 0x35, 0xc7, 0x97, 0xff, 0x08, 0xa6, 0xcd, 0x90, 0x09, 0x50, 0x66, 0xa7, 0x45, 0xad, 0xdb, 0x6d
+};
+
+int check( std::string_view name, bool ok )
+{
+  fmt::print( "{:<12} {}\n", name, ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+}
+
+int main()
+{
+  auto unreduced = std::vector<uint8_t>( ENCRYPTED.begin(), ENCRYPTED.end() );
+  std::ranges::copy( UNREDUCED, unreduced.begin() );
+
+  int failures = 0;
+  failures += check( "decrypt", std::ranges::equal( decrypt( BLOCKS, ENCRYPTED ), DECRYPTED ) );
+  failures += check( "cached", std::ranges::equal( decrypt( BLOCKS, ENCRYPTED ), DECRYPTED ) );
+  failures += check( "unreduced", std::ranges::equal( decrypt( BLOCKS, unreduced ), DECRYPTED ) );
+  //accumulator over a part of the blocks does not end at zero
+  failures += check( "truncated", decrypt( 1, ENCRYPTED ).empty() );
+  failures += check( "corrupted", decrypt( 1, CORRUPTED ).empty() );
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+#include "BenchCommon.hpp"
+#include "Core.hpp"
+#include "CoroutineFramePool.hpp"
+#include "CPU.hpp"
+#include "EEPROM.hpp"
+#include "GameDrive.hpp"
+#include "Suzy.hpp"
+#include "TraceHelper.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+#include <cstdlib>
+
+//Coroutine frame pool test.
+//Counts heap allocations through replaced global operator new while Suzy runs sprite chains over and over and EEPROM
+//executes commands, each restarting its coroutine, and checks that there are none once the pool is warm.
+//Also checks that CPU and GameDrive instances created one after another take their coroutine frames from the pool.
+
+namespace
+{
+
+std::atomic<uint64_t> gAllocations;
+
+static constexpr uint16_t SCB_BASE = 0x0200;
+static constexpr uint16_t SPRITE_DATA = 0x1000;
+static constexpr uint16_t VIDEO_BASE = 0x8000;
+static constexpr uint16_t COLLISION_BASE = 0xa000;
+static constexpr int SPRITES = 8;
+static constexpr int LINES = 16;
+static constexpr int LINE_BYTES = 12;
+static constexpr int WARM_UP = 2;
+
+void writeSuzy16( Core& core, uint16_t reg, uint16_t value )
+{
+  core.debugWriteSuzy( 0xfc00 + reg, value & 0xff );
+  core.debugWriteSuzy( 0xfc00 + reg + 1, value >> 8 );
+}
+
+//chain of literal and RLE sprites of all pen sizes sharing random sprite data
+void writeChain( Core& core )
+{
+  std::mt19937 rng{ 1 };
+  uint16_t address = SPRITE_DATA;
+  for ( int y = 0; y < LINES; ++y )
+  {
+    core.debugWriteRAM( address++, LINE_BYTES + 1 );
+    for ( int i = 0; i < LINE_BYTES; ++i )
+    {
+      core.debugWriteRAM( address++, ( uint8_t )rng() );
+    }
+  }
+  core.debugWriteRAM( address, 0 );
+
+  for ( int s = 0; s < SPRITES; ++s )
+  {
+    uint16_t const scb = SCB_BASE + s * 0x20;
+    uint16_t const next = s + 1 < SPRITES ? scb + 0x20 : 0;
+    std::array<uint8_t, 23> const bytes = {
+      ( uint8_t )( ( ( s % 4 ) << 6 ) | ( uint8_t )Suzy::Sprite::NORMAL ),
+      ( uint8_t )( ( s < 4 ? Suzy::SPRCTL1::LITERAL : 0 ) | ( uint8_t )Suzy::Reload::HV ),
+      ( uint8_t )( s + 1 ),
+      ( uint8_t )next, ( uint8_t )( next >> 8 ),
+      ( uint8_t )SPRITE_DATA, ( uint8_t )( SPRITE_DATA >> 8 ),
+      ( uint8_t )( s * 16 ), 0, ( uint8_t )( s * 8 ), 0,
+      0x00, 0x01, 0x00, 0x01,
+      0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
+    };
+    core.debugWriteRAM( scb, bytes );
+  }
+}
+
+void runChain( Core& core )
+{
+  writeSuzy16( core, Suzy::HOFF, 0 );
+  writeSuzy16( core, Suzy::VOFF, 0 );
+  writeSuzy16( core, Suzy::VIDBAS, VIDEO_BASE );
+  writeSuzy16( core, Suzy::COLLBAS, COLLISION_BASE );
+  writeSuzy16( core, Suzy::COLLOFF, 0x1f );
+  writeSuzy16( core, Suzy::HSIZOFF, 0x007f );
+  writeSuzy16( core, Suzy::VSIZOFF, 0x007f );
+  writeSuzy16( core, Suzy::SCBNEXT, SCB_BASE );
+  core.debugWriteSuzy( 0xfc00 + Suzy::SPRINIT, 0xf3 );
+  core.debugWriteSuzy( 0xfc00 + Suzy::SUZYBUSEN, Suzy::SUZYBUSEN::ENABLE );
+  core.debugWriteSuzy( 0xfc00 + Suzy::SPRSYS, 0 );
+  core.debugWriteSuzy( 0xfc00 + Suzy::SPRGO, Suzy::SPRGO::SPRITE_GO );
+  core.debugRunSprites();
+}
+
+//returns heap allocations made by action after it was run WARM_UP times
+template<typename ACTION>
+uint64_t steadyAllocations( int iterations, ACTION action )
+{
+  for ( int i = 0; i < WARM_UP; ++i )
+  {
+    action();
+  }
+
+  uint64_t const before = gAllocations.load( std::memory_order_relaxed );
+  for ( int i = 0; i < iterations; ++i )
+  {
+    action();
+  }
+  return gAllocations.load( std::memory_order_relaxed ) - before;
+}
+
+//returns coroutine frames taken from the heap for instances created after the first one
+template<typename CREATE>
+uint64_t poolMisses( int iterations, CREATE create )
+{
+  create();
+  uint64_t const before = CoroutineFramePool::heapAllocations();
+  for ( int i = 0; i < iterations; ++i )
+  {
+    create();
+  }
+  return CoroutineFramePool::heapAllocations() - before;
+}
+
+int report( std::string_view name, uint64_t allocations )
+{
+  fmt::print( "{:<10} {:>12}  {}\n", name, allocations, allocations == 0 ? "OK" : "FAILED" );
+  return allocations == 0 ? 0 : 1;
+}
+
+int testSprites( int iterations )
+{
+  auto core = makeCore();
+  writeChain( *core );
+  return report( "sprites", steadyAllocations( iterations, [&]
+  {
+    runChain( *core );
+  } ) );
+}
+
+int testEEPROM( int iterations )
+{
+  //93C46 organized in 16-bit words takes 2 bits of command and 6 bits of address
+  static constexpr int OPCODE_BITS = 8;
+  static constexpr uint32_t EWEN = 0b00110000;
+  static constexpr uint32_t EWDS = 0b00000000;
+  static constexpr uint32_t READ = 0b10000000;
+
+  auto const path = std::filesystem::temp_directory_path() / "FramePoolTest.e2p";
+  std::filesystem::remove( path );
+
+  uint64_t allocations;
+  {
+    EEPROM eeprom{ path, 1, true, std::make_shared<TraceHelper>() };
+    uint64_t tick = 0;
+    int address = 0;
+    allocations = steadyAllocations( iterations, [&]
+    {
+      eepromCommand( eeprom, tick, EWEN, OPCODE_BITS );
+      eepromCommand( eeprom, tick, READ | ( address++ & 0x3f ), OPCODE_BITS, 0, 16 );
+      eepromCommand( eeprom, tick, EWDS, OPCODE_BITS );
+    } );
+  }
+
+  std::filesystem::remove( path );
+  return report( "eeprom", allocations );
+}
+
+int testCPU( int iterations )
+{
+  auto traceHelper = std::make_shared<TraceHelper>();
+  return report( "cpu", poolMisses( iterations, [&]
+  {
+    CPU cpu{ traceHelper };
+  } ) );
+}
+
+int testGameDrive( int iterations )
+{
+  auto const path = std::filesystem::temp_directory_path() / "FramePoolTest.lnx";
+  return report( "gamedrive", poolMisses( iterations, [&]
+  {
+    auto gameDrive = std::make_unique<GameDrive>( path );
+  } ) );
+}
+
+}
+
+void* operator new( size_t size )
+{
+  gAllocations.fetch_add( 1, std::memory_order_relaxed );
+  if ( void* result = std::malloc( size == 0 ? 1 : size ) )
+    return result;
+  throw std::bad_alloc{};
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  std::free( ptr );
+}
+
+void operator delete( void* ptr, size_t ) noexcept
+{
+  std::free( ptr );
+}
+
+int main( int argc, char const* argv[] )
+{
+  try
+  {
+    CommandLine commandLine{ argc, argv };
+    int const iterations = commandLine.value( "--iterations", 1000 );
+    commandLine.done( "[--iterations N]" );
+
+    fmt::print( "{:<10} {:>12}\n", "coroutine", "allocations" );
+
+    int failures = 0;
+    failures += testSprites( iterations );
+    failures += testEEPROM( iterations );
+    failures += testCPU( iterations );
+    failures += testGameDrive( iterations );
+
+    return failures == 0 ? 0 : 1;
+  }
+  catch ( std::exception const& ex )
+  {
+    fmt::print( stderr, "{}\n", ex.what() );
+    return 2;
+  }
+}
@@ -0,0 +1,275 @@
+#include "BenchCommon.hpp"
+#include "Simd.hpp"
+#include "SpriteLineDecoder.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Sprite line decoder benchmark and regression check.
+//Decodes random literal and RLE sprite lines of all pen sizes with SpriteLineDecoder and with the bit by bit shifter and
+//line parser Suzy used before, checks that both give the same pens and sprite data fetches and compares pens per second.
+
+namespace
+{
+
+static constexpr int LINES = 256;
+
+//shifter and line parser as they were used by Suzy before SpriteLineDecoder
+class Shifter
+{
+public:
+  Shifter() : mShifter{}, mSize{} {}
+
+  int pull( int bits )
+  {
+    if ( mSize < bits )
+      return mSize - bits;
+
+    uint64_t result = mShifter >> ( 64 - bits );
+    mShifter <<= bits;
+    mSize -= bits;
+    return ( int )result;
+  }
+
+  void push( uint8_t value )
+  {
+    int offset = 64 - mSize - 8;
+    mShifter |= ( uint64_t )value << offset;
+    mSize += 8;
+  }
+
+  int size() const
+  {
+    return mSize;
+  }
+
+private:
+  uint64_t mShifter;
+  int mSize;
+};
+
+class SpriteLineParser
+{
+public:
+  SpriteLineParser( Shifter& shifter, bool literal, int bpp, int totalBits ) :
+    mShifter{ shifter }, mPen{}, mBPP{ bpp }, mTotalBits{ totalBits }, mRLECount{ -1 }, mRLELiteral{}, mLiteral{ literal }
+  {
+  }
+
+  int const* getPenIndex()
+  {
+    return mLiteral ? literalPen() : rlePen();
+  }
+
+  int totalBits() const
+  {
+    return mTotalBits;
+  }
+
+private:
+  void readPen()
+  {
+    mPen = mShifter.pull( mBPP );
+    mTotalBits -= mBPP;
+  }
+
+  int const* literalPen()
+  {
+    if ( mTotalBits <= mBPP )
+      return nullptr;
+
+    readPen();
+    return &mPen;
+  }
+
+  int const* rlePen()
+  {
+    if ( mRLECount < 0 )
+    {
+      if ( mTotalBits <= 5 )
+        return nullptr;
+
+      mRLELiteral = mShifter.pull( 1 );
+      mRLECount = mShifter.pull( 4 );
+      mTotalBits -= 5;
+      if ( !mRLELiteral )
+      {
+        if ( mRLECount == 0 || mTotalBits <= mBPP )
+          return nullptr;
+        readPen();
+      }
+    }
+
+    if ( mRLELiteral )
+    {
+      if ( mTotalBits <= mBPP )
+        return nullptr;
+      readPen();
+    }
+
+    mRLECount -= 1;
+    return &mPen;
+  }
+
+private:
+  Shifter& mShifter;
+  int mPen;
+  int mBPP;
+  int mTotalBits;
+  int mRLECount;
+  int mRLELiteral;
+  bool mLiteral;
+};
+
+struct Decoded
+{
+  std::array<uint8_t, SpriteLineDecoder::MAX_PENS> pens;
+  std::array<uint16_t, SpriteLineDecoder::MAX_LINE_BYTES> fetches;
+  int penCount;
+  int fetchCount;
+};
+
+//feeds the shifter the way Suzy did: four bytes on line start and a byte after a pen when it runs low
+void parse( uint8_t const* data, int bpp, bool literal, int totalBits, Decoded& out )
+{
+  Shifter shifter;
+  for ( int i = 0; i < 4; ++i )
+  {
+    shifter.push( data[i] );
+  }
+  int next = 4;
+
+  out.penCount = 0;
+  out.fetchCount = 0;
+  SpriteLineParser parser{ shifter, literal, bpp, totalBits };
+  while ( int const* pen = parser.getPenIndex() )
+  {
+    if ( shifter.size() < 24 && parser.totalBits() > shifter.size() )
+    {
+      out.fetches[out.fetchCount++] = ( uint16_t )out.penCount;
+      shifter.push( data[next++] );
+    }
+    out.pens[out.penCount++] = ( uint8_t )*pen;
+  }
+}
+
+struct Line
+{
+  size_t offset;
+  int bytes;
+};
+
+struct Workload
+{
+  std::string name;
+  int bpp;
+  bool literal;
+  std::vector<uint8_t> data;
+  std::vector<Line> lines;
+};
+
+std::vector<Workload> workloads()
+{
+  std::vector<Workload> result;
+  std::mt19937 rng{ 1 };
+
+  for ( bool literal : { true, false } )
+  {
+    for ( int bpp = 1; bpp <= 4; ++bpp )
+    {
+      Workload w{ fmt::format( "{}-{}bpp", literal ? "literal" : "rle", bpp ), bpp, literal };
+      for ( int i = 0; i < LINES; ++i )
+      {
+        //line lengths of typical sprites with occasional full width ones
+        int const bytes = i % 16 == 0 ? SpriteLineDecoder::MAX_LINE_BYTES : 2 + ( int )( rng() % 40 );
+        w.lines.push_back( { w.data.size(), bytes } );
+        for ( int b = 0; b < bytes; ++b )
+        {
+          w.data.push_back( ( uint8_t )rng() );
+        }
+        w.data.insert( w.data.end(), SpriteLineDecoder::PADDING, 0 );
+      }
+      result.push_back( std::move( w ) );
+    }
+  }
+
+  return result;
+}
+
+template<typename DECODE>
+double pensPerSecond( Workload const& workload, int iterations, DECODE decode )
+{
+  uint64_t pens = 0;
+  auto const start = std::chrono::steady_clock::now();
+  for ( int i = 0; i < iterations; ++i )
+  {
+    for ( auto const& line : workload.lines )
+    {
+      pens += decode( workload.data.data() + line.offset, line.bytes * 8 );
+    }
+  }
+  return pens / std::max( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count(), 1e-9 );
+}
+
+bool same( Workload const& workload, SpriteLineDecoder& decoder, Decoded& decoded )
+{
+  for ( auto const& line : workload.lines )
+  {
+    uint8_t const* data = workload.data.data() + line.offset;
+    parse( data, workload.bpp, workload.literal, line.bytes * 8, decoded );
+    decoder.decode( data, workload.bpp, workload.literal, line.bytes * 8 );
+
+    if ( !std::ranges::equal( decoder.pens(), std::span{ decoded.pens.data(), ( size_t )decoded.penCount } ) ||
+      !std::ranges::equal( decoder.fetches(), std::span{ decoded.fetches.data(), ( size_t )decoded.fetchCount } ) )
+      return false;
+  }
+
+  return true;
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  try
+  {
+    CommandLine commandLine{ argc, argv };
+    int const iterations = commandLine.value( "--iterations", 2000 );
+    commandLine.done( "[--iterations N]" );
+
+    auto decoder = std::make_unique<SpriteLineDecoder>();
+    auto decoded = std::make_unique<Decoded>();
+    int failures = 0;
+
+#if defined( FELIX_SSE2 )
+    fmt::print( "literal lines unpacked with {}\n", simd::avx2() ? "AVX2" : "SSE2" );
+#else
+    fmt::print( "literal lines unpacked without vector instructions\n" );
+#endif
+    fmt::print( "{:<12} {:>16} {:>16} {:>8}\n", "line", "parser pens/s", "decoder pens/s", "gain" );
+
+    for ( auto const& workload : workloads() )
+    {
+      double const parserRate = pensPerSecond( workload, iterations, [&]( uint8_t const* data, int totalBits )
+      {
+        parse( data, workload.bpp, workload.literal, totalBits, *decoded );
+        return decoded->penCount;
+      } );
+      double const decoderRate = pensPerSecond( workload, iterations, [&]( uint8_t const* data, int totalBits )
+      {
+        decoder->decode( data, workload.bpp, workload.literal, totalBits );
+        return decoder->pens().size();
+      } );
+
+      bool const ok = same( workload, *decoder, *decoded );
+      failures += ok ? 0 : 1;
+      fmt::print( "{:<12} {:>16.0f} {:>16.0f} {:>7.2f}x {}\n", workload.name, parserRate, decoderRate, decoderRate / parserRate, ok ? "OK" : "MISMATCH" );
+    }
+
+    return failures == 0 ? 0 : 1;
+  }
+  catch ( std::exception const& ex )
+  {
+    fmt::print( stderr, "{}\n", ex.what() );
+    return 2;
+  }
+}
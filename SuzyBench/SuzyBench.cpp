@@ -0,0 +1,564 @@
+#include "BenchCommon.hpp"
+#include "Core.hpp"
+#include "Suzy.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Suzy benchmark and regression check.
+//Builds SCB chains directly in RAM, runs them to completion without the CPU and compares RAM contents
+//(video buffer, collision buffer and collision depositories) against golden hashes.
+
+namespace
+{
+
+static constexpr uint16_t SCB_BASE = 0x0200;
+static constexpr uint16_t SCB_STRIDE = 0x20;
+//collision depository is placed after the longest SCB
+static constexpr uint16_t SCB_COLLOFF = SCB_STRIDE - 1;
+static constexpr uint16_t SPRITE_DATA_BASE = 0x2000;
+static constexpr uint16_t SPRITE_DATA_END = 0x8000;
+static constexpr uint16_t VIDEO_BASE = 0x8000;
+static constexpr uint16_t COLLISION_BASE = 0xa000;
+static constexpr uint16_t BUFFER_SIZE = ROW_BYTES * SCREEN_HEIGHT;
+
+struct SpriteDef
+{
+  uint8_t sprctl0;
+  uint8_t sprctl1;
+  uint8_t sprcoll;
+  int16_t hpos;
+  int16_t vpos;
+  uint16_t hsize = 0x100;
+  uint16_t vsize = 0x100;
+  uint16_t stretch = 0;
+  uint16_t tilt = 0;
+  int width = 24;
+  int height = 16;
+  //number of quadrants with sprite data: 1 or 4
+  int quadrants = 1;
+  uint8_t seed = 0;
+  //pen index palette as it is stored in SCB
+  std::array<uint8_t, 8> palette = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef };
+};
+
+//expected results of a run
+struct Golden
+{
+  uint64_t hash;
+  uint64_t ticks;
+};
+
+struct Workload
+{
+  std::string_view name;
+  std::vector<SpriteDef> sprites;
+  Golden golden;
+  uint8_t sprsys = 0;
+  uint8_t sprgo = Suzy::SPRGO::SPRITE_GO;
+};
+
+class BitWriter
+{
+public:
+  void put( uint32_t value, int bits )
+  {
+    for ( int i = bits - 1; i >= 0; --i )
+    {
+      if ( mBit == 0 )
+        mBytes.push_back( 0 );
+      mBytes.back() |= ( ( value >> i ) & 1 ) << ( 7 - mBit );
+      mBit = ( mBit + 1 ) & 7;
+    }
+  }
+
+  bool aligned() const
+  {
+    return mBit == 0;
+  }
+
+  std::vector<uint8_t> const& bytes() const
+  {
+    return mBytes;
+  }
+
+private:
+  std::vector<uint8_t> mBytes;
+  int mBit = 0;
+};
+
+int spriteBpp( SpriteDef const& def )
+{
+  return ( ( def.sprctl0 & Suzy::SPRCTL0::BITS_MASK ) >> 6 ) + 1;
+}
+
+bool isLiteral( SpriteDef const& def )
+{
+  return ( def.sprctl1 & Suzy::SPRCTL1::LITERAL ) != 0;
+}
+
+//pattern with horizontal runs broken by single pens so that RLE lines have both packet kinds
+uint8_t pen( SpriteDef const& def, int x, int y )
+{
+  int value = x % 7 == 3 ? x * y + def.seed * 5 : ( x >> 2 ) + ( y >> 1 ) + def.seed;
+  return ( uint8_t )( value & ( ( 1 << spriteBpp( def ) ) - 1 ) );
+}
+
+std::vector<uint8_t> encodeLiteralLine( SpriteDef const& def, int y )
+{
+  int const bpp = spriteBpp( def );
+  BitWriter writer;
+  for ( int x = 0; x < def.width; ++x )
+  {
+    writer.put( pen( def, x, y ), bpp );
+  }
+  //last pen is dropped if the line data ends exactly on it
+  if ( writer.aligned() )
+    writer.put( 0, 8 );
+
+  return writer.bytes();
+}
+
+std::vector<uint8_t> encodeRLELine( SpriteDef const& def, int y )
+{
+  int const bpp = spriteBpp( def );
+  BitWriter writer;
+
+  auto runLength = [&]( int x )
+  {
+    int length = 1;
+    while ( x + length < def.width && length < 16 && pen( def, x + length, y ) == pen( def, x, y ) )
+      ++length;
+    return length;
+  };
+
+  for ( int x = 0; x < def.width; )
+  {
+    //repeat packet of one pen would be read as the end of line
+    if ( int run = runLength( x ); run > 1 )
+    {
+      writer.put( run - 1, 5 );
+      writer.put( pen( def, x, y ), bpp );
+      x += run;
+    }
+    else
+    {
+      int count = 1;
+      while ( x + count < def.width && count < 16 && runLength( x + count ) == 1 )
+        ++count;
+      writer.put( 0x10 | ( count - 1 ), 5 );
+      for ( int i = 0; i < count; ++i )
+      {
+        writer.put( pen( def, x + i, y ), bpp );
+      }
+      x += count;
+    }
+  }
+  writer.put( 0, 5 );
+
+  return writer.bytes();
+}
+
+class SpriteChain
+{
+public:
+  SpriteChain( Workload const& workload ) : mImage{}, mPixels{}
+  {
+    std::ranges::fill( mImage, 0 );
+
+    uint16_t dataAddress = SPRITE_DATA_BASE;
+    for ( size_t i = 0; i < workload.sprites.size(); ++i )
+    {
+      auto const& def = workload.sprites[i];
+      uint16_t const scbAddress = scbAt( i );
+      uint16_t const next = i + 1 < workload.sprites.size() ? scbAt( i + 1 ) : 0;
+      if ( next >= SPRITE_DATA_BASE )
+        throw std::runtime_error{ fmt::format( "Too many sprites in workload {}", workload.name ) };
+
+      uint16_t address = scbAddress;
+      auto put8 = [&]( uint8_t value ) { mImage[address++] = value; };
+      auto put16 = [&]( uint16_t value ) { put8( value & 0xff ); put8( value >> 8 ); };
+
+      put8( def.sprctl0 );
+      put8( def.sprctl1 );
+      put8( def.sprcoll );
+      put16( next );
+      put16( dataAddress );
+      put16( ( uint16_t )def.hpos );
+      put16( ( uint16_t )def.vpos );
+
+      auto const reload = def.sprctl1 & Suzy::SPRCTL1::RELOAD_MASK;
+      if ( reload != Suzy::SPRCTL1::RELOAD_NONE )
+      {
+        put16( def.hsize );
+        put16( def.vsize );
+      }
+      if ( reload == Suzy::SPRCTL1::RELOAD_HVS || reload == Suzy::SPRCTL1::RELOAD_HVST )
+      {
+        put16( def.stretch );
+      }
+      if ( reload == Suzy::SPRCTL1::RELOAD_HVST )
+      {
+        put16( def.tilt );
+      }
+      if ( ( def.sprctl1 & Suzy::SPRCTL1::REUSE_PALETTE ) == 0 )
+      {
+        for ( uint8_t value : def.palette )
+          put8( value );
+      }
+      assert( address <= scbAddress + SCB_COLLOFF );
+
+      for ( int quadrant = 0; quadrant < def.quadrants; ++quadrant )
+      {
+        for ( int y = 0; y < def.height; ++y )
+        {
+          auto line = isLiteral( def ) ? encodeLiteralLine( def, y ) : encodeRLELine( def, y );
+          if ( dataAddress + line.size() + 2 >= SPRITE_DATA_END )
+            throw std::runtime_error{ fmt::format( "Too much sprite data in workload {}", workload.name ) };
+
+          mImage[dataAddress++] = ( uint8_t )( line.size() + 1 );
+          std::ranges::copy( line, mImage.begin() + dataAddress );
+          dataAddress += ( uint16_t )line.size();
+        }
+        //offset 1 starts next quadrant, 0 ends the sprite
+        mImage[dataAddress++] = quadrant + 1 < def.quadrants ? 1 : 0;
+      }
+
+      if ( ( def.sprctl1 & Suzy::SPRCTL1::SKIP_SPRITE ) == 0 )
+      {
+        mPixels += ( uint64_t )def.quadrants * ( ( def.width * def.hsize ) >> 8 ) * ( ( def.height * def.vsize ) >> 8 );
+      }
+    }
+
+    mSprites = workload.sprites.size();
+  }
+
+  static uint16_t scbAt( size_t index )
+  {
+    return ( uint16_t )( SCB_BASE + index * SCB_STRIDE );
+  }
+
+  std::array<uint8_t, 65536> const& image() const
+  {
+    return mImage;
+  }
+
+  size_t sprites() const
+  {
+    return mSprites;
+  }
+
+  //nominal number of drawn pixels not accounting for stretch and clipping
+  uint64_t pixels() const
+  {
+    return mPixels;
+  }
+
+private:
+  std::array<uint8_t, 65536> mImage;
+  size_t mSprites;
+  uint64_t mPixels;
+};
+
+void writeSuzy16( Core& core, uint16_t reg, uint16_t value )
+{
+  core.debugWriteSuzy( 0xfc00 + reg, value & 0xff );
+  core.debugWriteSuzy( 0xfc00 + reg + 1, value >> 8 );
+}
+
+//clears buffers written by Suzy leaving sprite data intact so that its decoded lines can be cached between runs
+void resetRun( Core& core, Workload const& workload )
+{
+  for ( uint16_t i = 0; i < BUFFER_SIZE; ++i )
+  {
+    core.debugWriteRAM( VIDEO_BASE + i, 0 );
+    core.debugWriteRAM( COLLISION_BASE + i, 0 );
+  }
+  for ( size_t i = 0; i < workload.sprites.size(); ++i )
+  {
+    core.debugWriteRAM( SpriteChain::scbAt( i ) + SCB_COLLOFF, 0 );
+  }
+
+  writeSuzy16( core, Suzy::HOFF, 0 );
+  writeSuzy16( core, Suzy::VOFF, 0 );
+  writeSuzy16( core, Suzy::VIDBAS, VIDEO_BASE );
+  writeSuzy16( core, Suzy::COLLBAS, COLLISION_BASE );
+  writeSuzy16( core, Suzy::COLLOFF, SCB_COLLOFF );
+  writeSuzy16( core, Suzy::HSIZOFF, 0x007f );
+  writeSuzy16( core, Suzy::VSIZOFF, 0x007f );
+  writeSuzy16( core, Suzy::SPRHSIZ, 0x0100 );
+  writeSuzy16( core, Suzy::SPRVSIZ, 0x0100 );
+  writeSuzy16( core, Suzy::STRETCH, 0 );
+  writeSuzy16( core, Suzy::TILT, 0 );
+  writeSuzy16( core, Suzy::SCBNEXT, SCB_BASE );
+  core.debugWriteSuzy( 0xfc00 + Suzy::SPRINIT, 0xf3 );
+  core.debugWriteSuzy( 0xfc00 + Suzy::SUZYBUSEN, Suzy::SUZYBUSEN::ENABLE );
+  core.debugWriteSuzy( 0xfc00 + Suzy::SPRSYS, workload.sprsys );
+  core.debugWriteSuzy( 0xfc00 + Suzy::SPRGO, workload.sprgo );
+}
+
+uint64_t hashRAM( Core& core )
+{
+  return fnv( FNV_BASIS, std::span<uint8_t const>{ core.debugRAM(), 65536 } );
+}
+
+uint8_t ctl0( int bpp, Suzy::Sprite type, uint8_t flags = 0 )
+{
+  return ( uint8_t )( ( ( bpp - 1 ) << 6 ) | flags | ( uint8_t )type );
+}
+
+uint8_t ctl1( bool literal, Suzy::Reload reload, Suzy::Quadrant quadrant = Suzy::Quadrant::DOWN_RIGHT, uint8_t flags = 0 )
+{
+  return ( uint8_t )( ( literal ? Suzy::SPRCTL1::LITERAL : 0 ) | ( uint8_t )reload | ( uint8_t )quadrant | flags );
+}
+
+//deterministic pseudo random sprite positions
+class Scatter
+{
+public:
+  int16_t next( int range )
+  {
+    mState = mState * 1103515245u + 12345u;
+    return ( int16_t )( ( mState >> 16 ) % range );
+  }
+
+private:
+  uint32_t mState = 1;
+};
+
+std::vector<Workload> workloads()
+{
+  std::vector<Workload> result;
+
+  static constexpr std::array<Golden, 8> depthGolden = {
+    Golden{ 0xa70bde1b022c3afeull, 120410 },
+    Golden{ 0x5e970343aa38b0dbull, 162912 },
+    Golden{ 0x44d2a71f5bcc1ecbull, 192229 },
+    Golden{ 0x7586b1e26aeb56faull, 213230 },
+    Golden{ 0xf2555018c81e0336ull, 132368 },
+    Golden{ 0x119779d0fc8b3e96ull, 167384 },
+    Golden{ 0xad853d05460a3374ull, 189652 },
+    Golden{ 0x1ec334e647b2f611ull, 206412 }
+  };
+  static constexpr std::array<std::string_view, 8> depthNames = {
+    "literal-1bpp", "literal-2bpp", "literal-3bpp", "literal-4bpp",
+    "rle-1bpp", "rle-2bpp", "rle-3bpp", "rle-4bpp"
+  };
+
+  for ( int i = 0; i < 8; ++i )
+  {
+    bool const literal = i < 4;
+    int const bpp = i % 4 + 1;
+    Scatter scatter;
+    Workload w{ depthNames[i], {}, depthGolden[i], Suzy::SPRSYS::NO_COLLIDE };
+    for ( int s = 0; s < 64; ++s )
+    {
+      SpriteDef def{ ctl0( bpp, Suzy::Sprite::NORMAL ), ctl1( literal, Suzy::Reload::HV ), 0, ( int16_t )( scatter.next( 184 ) - 24 ), ( int16_t )( scatter.next( 118 ) - 16 ) };
+      def.width = 32;
+      def.seed = ( uint8_t )s;
+      w.sprites.push_back( def );
+    }
+    result.push_back( std::move( w ) );
+  }
+
+  {
+    static constexpr std::array<Suzy::Sprite, 8> types = {
+      Suzy::Sprite::BACKGROUND, Suzy::Sprite::BACKNONCOLL, Suzy::Sprite::BSHADOW, Suzy::Sprite::BOUNDARY,
+      Suzy::Sprite::NORMAL, Suzy::Sprite::NONCOLL, Suzy::Sprite::XOR, Suzy::Sprite::SHADOW
+    };
+    Scatter scatter;
+    Workload w{ "sprite-types", {}, { 0xd4ccaa8aa48a76e3ull, 273802 } };
+    for ( int s = 0; s < 64; ++s )
+    {
+      SpriteDef def{ ctl0( 4, types[s % types.size()] ), ctl1( s % 2 == 0, Suzy::Reload::HV ), ( uint8_t )( s % 15 + 1 ), ( int16_t )scatter.next( 140 ), ( int16_t )scatter.next( 86 ) };
+      def.seed = ( uint8_t )s;
+      w.sprites.push_back( def );
+    }
+    result.push_back( std::move( w ) );
+  }
+
+  {
+    Workload w{ "quadrants", {}, { 0x97c8a4b2154782a8ull, 125948 } };
+    for ( int s = 0; s < 16; ++s )
+    {
+      uint8_t const flip = ( s & 4 ? Suzy::SPRCTL0::HFLIP : 0 ) | ( s & 8 ? Suzy::SPRCTL0::VFLIP : 0 );
+      SpriteDef def{ ctl0( s % 4 + 1, Suzy::Sprite::NORMAL, flip ), ctl1( s % 3 != 0, Suzy::Reload::HV, ( Suzy::Quadrant )( s % 4 ) ), ( uint8_t )( s % 15 + 1 ),
+        ( int16_t )( 20 + ( s % 4 ) * 40 ), ( int16_t )( 13 + ( s / 4 ) * 25 ) };
+      def.width = 16;
+      def.height = 10;
+      def.quadrants = 4;
+      def.seed = ( uint8_t )s;
+      w.sprites.push_back( def );
+    }
+    result.push_back( std::move( w ) );
+  }
+
+  {
+    Scatter scatter;
+    Workload w{ "stretch-tilt", {}, { 0xcfb18e2177528155ull, 361666 } };
+    for ( int s = 0; s < 32; ++s )
+    {
+      SpriteDef def{ ctl0( 4, Suzy::Sprite::NORMAL ), ctl1( s % 2 == 0, Suzy::Reload::HVST, ( Suzy::Quadrant )( s % 4 ) ), ( uint8_t )( s % 15 + 1 ), ( int16_t )scatter.next( 160 ), ( int16_t )scatter.next( 102 ) };
+      def.hsize = ( uint16_t )( 0x080 + s * 0x10 );
+      def.vsize = ( uint16_t )( 0x180 - s * 0x08 );
+      def.stretch = ( uint16_t )( s % 3 == 0 ? 0 : 0x0010 * ( s % 3 ) );
+      def.tilt = ( uint16_t )( s % 2 == 0 ? 0x0040 : -0x0030 );
+      def.quadrants = s % 4 == 0 ? 4 : 1;
+      def.seed = ( uint8_t )s;
+      w.sprites.push_back( def );
+    }
+    result.push_back( std::move( w ) );
+  }
+
+  {
+    Scatter scatter;
+    Workload w{ "vstretch", {}, { 0xbeac78124731947full, 156150 }, Suzy::SPRSYS::VSTRETCH };
+    for ( int s = 0; s < 32; ++s )
+    {
+      SpriteDef def{ ctl0( 2, Suzy::Sprite::NORMAL ), ctl1( s % 2 != 0, Suzy::Reload::HVS ), ( uint8_t )( s % 15 + 1 ), ( int16_t )scatter.next( 160 ), ( int16_t )scatter.next( 102 ) };
+      def.vsize = 0x0080;
+      def.stretch = ( uint16_t )( 0x0008 * ( s % 4 + 1 ) );
+      def.seed = ( uint8_t )s;
+      w.sprites.push_back( def );
+    }
+    result.push_back( std::move( w ) );
+  }
+
+  {
+    Scatter scatter;
+    Workload w{ "reuse-palette", {}, { 0x2f3d86935cba390eull, 203494 }, Suzy::SPRSYS::NO_COLLIDE };
+    for ( int s = 0; s < 64; ++s )
+    {
+      //every eighth sprite loads new palette and the others reuse it, half of them without reloading sizes
+      bool const load = s % 8 == 0;
+      Suzy::Reload const reload = load || s % 2 == 0 ? Suzy::Reload::HV : Suzy::Reload::NONE;
+      SpriteDef def{ ctl0( 4, Suzy::Sprite::NORMAL ), ctl1( s % 3 == 0, reload, Suzy::Quadrant::DOWN_RIGHT, load ? 0 : Suzy::SPRCTL1::REUSE_PALETTE ), 0, ( int16_t )scatter.next( 160 ), ( int16_t )scatter.next( 102 ) };
+      def.hsize = ( uint16_t )( 0x100 + ( s / 8 ) * 0x20 );
+      def.seed = ( uint8_t )s;
+      def.palette = { ( uint8_t )( 0xfe - s ), 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, ( uint8_t )( 0x10 + s / 8 ) };
+      w.sprites.push_back( def );
+    }
+    result.push_back( std::move( w ) );
+  }
+
+  {
+    static constexpr std::array<Suzy::Sprite, 4> types = {
+      Suzy::Sprite::XOR, Suzy::Sprite::SHADOW, Suzy::Sprite::BSHADOW, Suzy::Sprite::XOR_SHADOW
+    };
+    Scatter scatter;
+    Workload w{ "xor-shadow", {}, { 0x514e8efb988f088cull, 416334 } };
+    //opaque background to XOR and shadow against
+    SpriteDef background{ ctl0( 3, Suzy::Sprite::BACKGROUND ), ctl1( false, Suzy::Reload::HV ), 1, 0, 0 };
+    background.width = SCREEN_WIDTH;
+    background.height = SCREEN_HEIGHT;
+    w.sprites.push_back( background );
+    for ( int s = 0; s < 48; ++s )
+    {
+      SpriteDef def{ ctl0( s % 4 + 1, types[s % types.size()] ), ctl1( s % 2 == 0, Suzy::Reload::HV ), ( uint8_t )( s % 14 + 2 ), ( int16_t )scatter.next( 150 ), ( int16_t )scatter.next( 92 ) };
+      def.width = 32;
+      def.seed = ( uint8_t )s;
+      w.sprites.push_back( def );
+    }
+    result.push_back( std::move( w ) );
+  }
+
+  {
+    Scatter scatter;
+    Workload w{ "collision", {}, { 0xa93394e4b1f48e22ull, 262376 }, 0, Suzy::SPRGO::SPRITE_GO | Suzy::SPRGO::EVER_ON };
+    for ( int s = 0; s < 96; ++s )
+    {
+      //sprites overlap heavily and some are partly or completely off screen to exercise EVER_ON
+      Suzy::Sprite const type = s % 3 == 0 ? Suzy::Sprite::BOUNDARY : Suzy::Sprite::NORMAL;
+      SpriteDef def{ ctl0( s % 4 + 1, type ), ctl1( s % 2 != 0, Suzy::Reload::HV ), ( uint8_t )( s % 16 ), ( int16_t )( scatter.next( 200 ) - 20 ), ( int16_t )( scatter.next( 140 ) - 20 ) };
+      def.seed = ( uint8_t )s;
+      if ( s % 11 == 0 )
+        def.sprcoll |= Suzy::SPRCOLL::NO_COLLIDE;
+      w.sprites.push_back( def );
+    }
+    result.push_back( std::move( w ) );
+  }
+
+  return result;
+}
+
+struct Options
+{
+  int iterations;
+  bool update;
+};
+
+
+Options parseOptions( int argc, char const* argv[] )
+{
+  CommandLine commandLine{ argc, argv };
+  Options options{ commandLine.value( "--iterations", 200 ), commandLine.flag( "--update" ) };
+  commandLine.done( "[--iterations N] [--update]" );
+  return options;
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  try
+  {
+    auto const options = parseOptions( argc, argv );
+    int failures = 0;
+
+    fmt::print( "{:<14} {:>8} {:>14} {:>14} {:>12}  {:<16}\n", "workload", "sprites", "sprites/s", "pixels/s", "bus ticks", "hash" );
+
+    for ( auto const& workload : workloads() )
+    {
+      SpriteChain const chain{ workload };
+      auto core = makeCore();
+
+      for ( size_t i = 0; i < chain.image().size(); ++i )
+      {
+        core->debugWriteRAM( ( uint16_t )i, chain.image()[i] );
+      }
+
+      std::chrono::steady_clock::duration elapsed{};
+      uint64_t ticks = 0;
+      uint64_t hash = 0;
+      bool stable = true;
+
+      for ( int i = 0; i < options.iterations; ++i )
+      {
+        resetRun( *core, workload );
+        auto const start = std::chrono::steady_clock::now();
+        ticks = core->debugRunSprites();
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        //every run starts from the same state, so cached data must not change the result
+        uint64_t const runHash = hashRAM( *core );
+        stable &= i == 0 || runHash == hash;
+        hash = runHash;
+      }
+
+      double const seconds = std::max( std::chrono::duration<double>( elapsed ).count(), 1e-9 );
+      std::string_view status = "OK";
+      if ( !stable )
+        status = "UNSTABLE";
+      else if ( hash != workload.golden.hash )
+        status = "MISMATCH";
+      else if ( ticks != workload.golden.ticks )
+        status = "TIMING";
+      failures += status == "OK" ? 0 : 1;
+
+      fmt::print( "{:<14} {:>8} {:>14.0f} {:>14.0f} {:>12}  {:016x} {}\n", workload.name, chain.sprites(),
+        chain.sprites() * options.iterations / seconds, chain.pixels() * options.iterations / seconds, ticks, hash, status );
+    }
+
+    if ( options.update )
+    {
+      fmt::print( "\nGolden values are not checked with --update. Copy hashes and bus ticks to workloads() after verifying the change.\n" );
+      return 0;
+    }
+
+    return failures == 0 ? 0 : 1;
+  }
+  catch ( std::exception const& ex )
+  {
+    fmt::print( stderr, "{}\n", ex.what() );
+    return 2;
+  }
+}
@@ -0,0 +1,246 @@
+#include "BenchCommon.hpp"
+#include "Core.hpp"
+#include "CPUState.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Mikey timer benchmark and regression check.
+//Programs timers and audio channels the way timer heavy audio drivers do, runs the emulator for a second of audio per iteration
+//with the CPU reading timers in a loop loaded as BS93 image and compares rendered audio and timer registers against golden hashes.
+
+namespace
+{
+
+static constexpr int SPS = 48000;
+static constexpr size_t BUFFER_SAMPLES = 480;
+//load address of the loop and address of 16-bit sums of timer reads
+static constexpr uint16_t PROBE_ADDRESS = 0x0200;
+static constexpr uint16_t PROBE_SUMS = 0x1000;
+
+//CPU loop at PROBE_ADDRESS summing reads of timer 3 count and timer 7 control B, so that values computed on demand are checked too
+static constexpr std::array<uint8_t, 33> PROBE = {
+  0x18,                 //CLC
+  0xad, 0x0e, 0xfd,     //LDA TIM3CNT
+  0x6d, 0x00, 0x10,     //ADC $1000
+  0x8d, 0x00, 0x10,     //STA $1000
+  0x90, 0x03,           //BCC +3
+  0xee, 0x01, 0x10,     //INC $1001
+  0x18,                 //CLC
+  0xad, 0x1f, 0xfd,     //LDA TIM7CTLB
+  0x6d, 0x02, 0x10,     //ADC $1002
+  0x8d, 0x02, 0x10,     //STA $1002
+  0x90, 0x03,           //BCC +3
+  0xee, 0x03, 0x10,     //INC $1003
+  0x4c, 0x00, 0x02      //JMP $0200
+};
+
+struct RegisterWrite
+{
+  uint8_t reg;
+  uint8_t value;
+};
+
+//expected results of a run
+struct Golden
+{
+  uint64_t hash;
+};
+
+struct Workload
+{
+  std::string_view name;
+  std::vector<RegisterWrite> writes;
+  Golden golden;
+};
+
+//horizontal and vertical timers with display DMA as set up for BS93 images
+std::vector<RegisterWrite> display()
+{
+  return {
+    { 0x00, 0x9e }, { 0x01, 0x18 },
+    { 0x08, 0x68 }, { 0x09, 0x1f },
+    { 0x93, 0x29 }, { 0x94, 0x00 }, { 0x95, 0x20 }, { 0x92, 0x0d }
+  };
+}
+
+//audio channel registers: volume, feedback, shift, backup, control
+std::vector<RegisterWrite> channel( int idx, uint8_t volume, uint8_t feedback, uint8_t shift, uint8_t backup, uint8_t control )
+{
+  uint8_t const base = ( uint8_t )( 0x20 + idx * 8 );
+  return {
+    { base, volume }, { ( uint8_t )( base + 1 ), feedback }, { ( uint8_t )( base + 3 ), shift },
+    { ( uint8_t )( base + 4 ), backup }, { ( uint8_t )( base + 6 ), backup }, { ( uint8_t )( base + 5 ), control }
+  };
+}
+
+std::vector<Workload> workloads()
+{
+  std::vector<Workload> result;
+
+  auto add = [&]( std::string_view name, std::initializer_list<std::vector<RegisterWrite>> parts, Golden golden )
+  {
+    Workload w{ name, display(), golden };
+    for ( auto const& part : parts )
+    {
+      w.writes.insert( w.writes.end(), part.begin(), part.end() );
+    }
+    result.push_back( std::move( w ) );
+  };
+
+  add( "display", {}, { 0x95fe3ca3f471c66cull } );
+
+  //timer 1 at 1MHz cascading through linked timers 3, 5 and 7 into linked audio channel 0
+  add( "linked", {
+    { { 0x04, 0x00 }, { 0x05, 0x18 }, { 0x0c, 0x03 }, { 0x0d, 0x1f }, { 0x14, 0x01 }, { 0x15, 0x1f }, { 0x1c, 0x00 }, { 0x1d, 0x1f } },
+    channel( 0, 0x40, 0x01, 0x01, 0x00, 0x1f )
+  }, { 0x78964ac88caf7d13ull } );
+
+  //timer 1 without interrupt cascading through linked timers 3 and 5 into timer 7 raising interrupts that are masked in the CPU
+  add( "cascade", {
+    { { 0x04, 0x01 }, { 0x05, 0x18 }, { 0x0c, 0x04 }, { 0x0d, 0x1f }, { 0x14, 0x02 }, { 0x15, 0x1f }, { 0x1c, 0x03 }, { 0x1d, 0x9f } }
+  }, { 0x9dc1aad751da0b34ull } );
+
+  //all channels integrating at high rates
+  add( "integrate", {
+    channel( 0, 0x10, 0x01, 0x01, 0x01, 0x38 ),
+    channel( 1, 0x11, 0x03, 0x21, 0x02, 0x38 ),
+    channel( 2, 0x12, 0x31, 0x41, 0x04, 0x38 ),
+    channel( 3, 0x13, 0x0f, 0x81, 0x06, 0x38 )
+  }, { 0xa92dc5012f935206ull } );
+
+  //all channels generating noise and square waves at high rates
+  add( "noise", {
+    channel( 0, 0x20, 0x01, 0x01, 0x00, 0x18 ),
+    channel( 1, 0x30, 0x03, 0x21, 0x01, 0x18 ),
+    channel( 2, 0x40, 0x31, 0x41, 0x03, 0x18 ),
+    channel( 3, 0x50, 0x0f, 0x81, 0x05, 0x98 )
+  }, { 0xbb8046ed3587783dull } );
+
+  //noise channels chained by linking with the last one integrating
+  add( "chain", {
+    channel( 0, 0x20, 0x01, 0x01, 0x00, 0x18 ),
+    channel( 1, 0x30, 0x03, 0x21, 0x01, 0x1f ),
+    channel( 2, 0x40, 0x31, 0x41, 0x00, 0x1f ),
+    channel( 3, 0x50, 0x0f, 0x81, 0x00, 0x3f )
+  }, { 0x31bec6d76489798cull } );
+
+  return result;
+}
+
+//writes the loop as BS93 image, so the emulator starts it the way it starts homebrew programs
+std::filesystem::path writeProbe()
+{
+  uint16_t const size = ( uint16_t )( 10 + PROBE.size() );
+  std::vector<uint8_t> image{ 0x80, 0x08, PROBE_ADDRESS >> 8, PROBE_ADDRESS & 0xff, ( uint8_t )( size >> 8 ), ( uint8_t )size, 'B', 'S', '9', '3' };
+  image.insert( image.end(), PROBE.begin(), PROBE.end() );
+
+  auto path = std::filesystem::temp_directory_path() / "TimerBench.o";
+  std::ofstream fout{ path, std::ios::binary };
+  fout.write( ( char const* )image.data(), image.size() );
+  if ( !fout )
+    throw std::runtime_error{ fmt::format( "Can't write {}", path.string() ) };
+
+  return path;
+}
+
+struct Options
+{
+  int iterations;
+  bool update;
+};
+
+Options parseOptions( int argc, char const* argv[] )
+{
+  CommandLine commandLine{ argc, argv };
+  Options options{ commandLine.value( "--iterations", 5 ), commandLine.flag( "--update" ) };
+  commandLine.done( "[--iterations N] [--update]" );
+  return options;
+}
+
+//runs a second of audio and returns hash of samples and timer registers
+uint64_t run( Workload const& workload, std::filesystem::path const& probe, std::chrono::steady_clock::duration& elapsed )
+{
+  auto core = makeCore( probe );
+  //reset sequence accesses memory at random program counter and stack pointer, which makes its timing random
+  core->debugState().pc = PROBE_ADDRESS;
+  core->debugState().s = 0x1ff;
+
+  for ( auto const& write : workload.writes )
+  {
+    core->debugWriteMikey( write.reg, write.value );
+  }
+
+  uint64_t hash = FNV_BASIS;
+  std::vector<AudioSample> samples( BUFFER_SAMPLES );
+
+  auto const start = std::chrono::steady_clock::now();
+  for ( size_t i = 0; i < SPS / BUFFER_SAMPLES; ++i )
+  {
+    core->advanceAudio( SPS, samples, RunMode::RUN );
+    hash = fnv( hash, samples );
+  }
+  elapsed += std::chrono::steady_clock::now() - start;
+
+  //timer and audio registers
+  for ( uint8_t reg = 0; reg < 0x40; ++reg )
+  {
+    hash = fnv( hash, core->debugReadMikey( reg ) );
+  }
+  for ( uint16_t i = 0; i < 4; ++i )
+  {
+    hash = fnv( hash, core->debugReadRAM( PROBE_SUMS + i ) );
+  }
+
+  return hash;
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  try
+  {
+    auto const options = parseOptions( argc, argv );
+    int failures = 0;
+    auto const probe = writeProbe();
+
+    fmt::print( "{:<12} {:>14}  {:<16}\n", "workload", "x realtime", "hash" );
+
+    for ( auto const& workload : workloads() )
+    {
+      std::chrono::steady_clock::duration elapsed{};
+      uint64_t hash = 0;
+      bool stable = true;
+
+      for ( int i = 0; i < options.iterations; ++i )
+      {
+        uint64_t const runHash = run( workload, probe, elapsed );
+        stable &= i == 0 || runHash == hash;
+        hash = runHash;
+      }
+
+      double const seconds = std::max( std::chrono::duration<double>( elapsed ).count(), 1e-9 );
+      std::string_view status = "OK";
+      if ( !stable )
+        status = "UNSTABLE";
+      else if ( hash != workload.golden.hash )
+        status = "MISMATCH";
+      failures += status == "OK" ? 0 : 1;
+
+      fmt::print( "{:<12} {:>14.2f}  {:016x} {}\n", workload.name, options.iterations / seconds, hash, status );
+    }
+
+    if ( options.update )
+    {
+      fmt::print( "\nGolden values are not checked with --update. Copy hashes to workloads() after verifying the change.\n" );
+      return 0;
+    }
+
+    return failures == 0 ? 0 : 1;
+  }
+  catch ( std::exception const& ex )
+  {
+    fmt::print( stderr, "{}\n", ex.what() );
+    return 2;
+  }
+}
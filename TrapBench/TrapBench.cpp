@@ -0,0 +1,396 @@
+#include "BenchCommon.hpp"
+#include "Core.hpp"
+#include "CPUState.hpp"
+#include "LuaProxies.hpp"
+#include "ScriptDebugger.hpp"
+#include "ScriptDebuggerEscapes.hpp"
+#include "SymbolSource.hpp"
+#include "TrapCondition.hpp"
+#include "sol/sol.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Trap condition and range watchpoint benchmark and regression check.
+//Checks conditions against known CPU and memory state, then calls a conditional trap that is rarely true
+//as compiled condition entering Lua only on hit and as equivalent Lua trap, and compares hits per second.
+//Lua traps and the ram and cpu tables they read are the ones scripts get from WinFelix.
+//Adds and removes thousands of overlapping range watchpoints sharing traps and checks hits of sweeps over RAM.
+//Checks range traps clearing themselves and adding ranges while called.
+
+namespace
+{
+
+static constexpr uint16_t TRAP_ADDRESS = 0x0200;
+static constexpr uint16_t FLAG_ADDRESS = 0x0080;
+
+class CountingTrap : public IMemoryAccessTrap
+{
+public:
+  ~CountingTrap() override = default;
+
+  uint8_t trap( Core& core, uint16_t address, uint8_t orgValue ) override
+  {
+    count += 1;
+    return orgValue;
+  }
+
+  Kind getKind() const override
+  {
+    return UI;
+  }
+
+  int count = 0;
+};
+
+struct Check
+{
+  std::string_view source;
+  bool expected;
+};
+
+//evaluated with a = $42, x = 1, y = $80, carry set, zero clear, ram[$80] = 5, mikey[$fd00] = $9e, value = 7 and address = $200
+static constexpr std::array<Check, 24> CHECKS{ {
+  { "a == 0x42 and ram[0x80] > 3", true },
+  { "a == $42 and ram[$80] > 5", false },
+  { "a ~= 66", false },
+  { "a != 66 or x == 1", true },
+  { "not z and c", true },
+  { "!c || z", false },
+  { "ram[y] == 5", true },
+  { "ram[y + x - 1] * 2 == 10", true },
+  { "mikey[$fd00] == $9e", true },
+  { "suzy[$fc88] == 1", true },
+  { "value == 7 and address == 0x200", true },
+  { "( a & 0xf0 ) >> 4 == 4", true },
+  { "a & 0xf0 >> 4 == 2", true },
+  { "1 + 2 * 3 == 7", true },
+  { "( 1 + 2 ) * 3 == 7", false },
+  { "-1 < 0 and ~0 == -1", true },
+  { "7 // 2 == 3 and 7 % 2 == 1 and 7 / 0 == 0", true },
+  { "1 << 3 | 1 ~ 3 == 11", false },
+  { "0 or 0 or 3", true },
+  { "0 and ram[$80]", false },
+  { "0x7fffffff + 1 < 0 and -2147483647 - 2 > 0", true },
+  { "0x10000 * 0x10000 == 0 and -( -2147483647 - 1 ) < 0", true },
+  { "( -2147483647 - 1 ) // -1 == -2147483647 - 1", true },
+  { "( -2147483647 - 1 ) % -1 == 0", true }
+} };
+
+static constexpr std::array<std::string_view, 7> INVALID{ {
+  "", "a ==", "( a == 1", "ram 5", "0xg", "b == 1",
+  "1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + ( 1 + 1 ) ) ) ) ) ) ) ) ) ) ) ) ) ) ) ) )"
+} };
+
+struct Options
+{
+  int iterations;
+  int hits;
+};
+
+Options parseOptions( int argc, char const* argv[] )
+{
+  CommandLine commandLine{ argc, argv };
+  Options options{ commandLine.value( "--iterations", 5 ), commandLine.value( "--hits", 10000000 ) };
+  commandLine.done( "[--iterations N] [--hits N]" );
+  return options;
+}
+
+int checkConditions( Core& core )
+{
+  auto& state = core.debugState();
+  state.a = 0x42;
+  state.x = 0x01;
+  state.y = 0x80;
+  state.c.set();
+  state.z.clear();
+  core.debugWriteRAM( FLAG_ADDRESS, 5 );
+  core.debugWriteMikey( 0x00, 0x9e );
+
+  int failures = 0;
+
+  for ( auto const& check : CHECKS )
+  {
+    std::string error;
+    auto condition = TrapCondition::compile( check.source, error );
+    if ( !condition )
+    {
+      fmt::print( "{:<52} {}\n", check.source, error );
+      failures += 1;
+    }
+    else if ( ( *condition )( core, TRAP_ADDRESS, 7 ) != check.expected )
+    {
+      fmt::print( "{:<52} MISMATCH\n", check.source );
+      failures += 1;
+    }
+  }
+
+  for ( auto source : INVALID )
+  {
+    std::string error;
+    if ( TrapCondition::compile( source, error ) || error.empty() )
+    {
+      fmt::print( "{:<52} ACCEPTED\n", source );
+      failures += 1;
+    }
+  }
+
+  fmt::print( "{} conditions checked, {} failed\n\n", CHECKS.size() + INVALID.size(), failures );
+  return failures;
+}
+
+//reads whole RAM through the debugger and returns accesses per second
+double sweep( Core& core, ScriptDebugger& debugger )
+{
+  auto const start = std::chrono::steady_clock::now();
+  uint32_t sum = 0;
+  for ( uint32_t address = 0; address < 0x10000; ++address )
+  {
+    sum += debugger.readRAM( core, (uint16_t)address, (uint8_t)address );
+  }
+  double const seconds = std::max( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count(), 1e-9 );
+  return sum == 0x100 * 0x7f80 ? 0x10000 / seconds : 0.0;
+}
+
+//4096 ranges of 8 bytes every 16 bytes sharing one trap, a 2 KB range over them, and a single address trap inside
+int checkRanges( Core& core )
+{
+  ScriptDebugger debugger;
+  auto small = std::make_shared<CountingTrap>();
+  auto large = std::make_shared<CountingTrap>();
+  auto single = std::make_shared<CountingTrap>();
+
+  int failures = 0;
+  auto check = [&]( std::string_view name, int smallHits, int largeHits, int singleHits, size_t ranges, double elapsed )
+  {
+    small->count = large->count = single->count = 0;
+    double const rate = sweep( core, debugger );
+    size_t count = 0;
+    for ( auto const& range : debugger.getRanges( IMemoryAccessTrap::UI ) )
+    {
+      count += std::get<0>( range ) == ScriptDebugger::Type::RAM_READ ? 1 : 0;
+    }
+    bool const ok = rate > 0.0 && small->count == smallHits && large->count == largeHits && single->count == singleHits && count == ranges;
+    failures += ok ? 0 : 1;
+    fmt::print( "{:<12} {:>14.0f} {:>10} {:>10.3f} {}\n", name, rate, count, elapsed * 1000.0, ok ? "OK" : "MISMATCH" );
+  };
+
+  auto time = []( auto fun )
+  {
+    auto const start = std::chrono::steady_clock::now();
+    fun();
+    return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+  };
+
+  fmt::print( "{:<12} {:>14} {:>10} {:>10}\n", "ranges", "reads/s", "count", "ms" );
+
+  check( "empty", 0, 0, 0, 0, 0.0 );
+
+  double elapsed = time( [&]
+  {
+    for ( uint32_t address = 0; address < 0x10000; address += 16 )
+    {
+      debugger.addRange( ScriptDebugger::Type::RAM_READ, (uint16_t)address, (uint16_t)( address + 7 ), small );
+    }
+    debugger.addRange( ScriptDebugger::Type::RAM_READ, 0x2000, 0x27ff, large );
+    debugger.addTrap( ScriptDebugger::Type::RAM_READ, 0x2004, single );
+  } );
+  check( "added", 4096 * 8, 2048, 1, 4097, elapsed );
+
+  elapsed = time( [&]
+  {
+    for ( uint32_t address = 0; address < 0x10000; address += 32 )
+    {
+      debugger.deleteRange( ScriptDebugger::Type::RAM_READ, (uint16_t)address, (uint16_t)( address + 7 ) );
+    }
+  } );
+  check( "halved", 2048 * 8, 2048, 1, 2049, elapsed );
+
+  elapsed = time( [&]
+  {
+    debugger.deleteRange( ScriptDebugger::Type::RAM_READ, 0x2000, 0x27ff );
+    debugger.deleteTrap( ScriptDebugger::Type::RAM_READ, 0x2004 );
+  } );
+  check( "removed", 2048 * 8, 0, 0, 2048, elapsed );
+
+  fmt::print( "\n" );
+  return failures;
+}
+
+//trap that calls given function on each hit, for traps editing ranges of the debugger they are called from
+class EditingTrap : public IMemoryAccessTrap
+{
+public:
+  EditingTrap( int& count, std::function<void()> edit ) : mCount{ count }, mEdit{ std::move( edit ) } {}
+  ~EditingTrap() override = default;
+
+  uint8_t trap( Core& core, uint16_t address, uint8_t orgValue ) override
+  {
+    mCount += 1;
+    mEdit();
+    return orgValue;
+  }
+
+  Kind getKind() const override
+  {
+    return UI;
+  }
+
+private:
+  int& mCount;
+  std::function<void()> mEdit;
+};
+
+//a range trap owned only by the debugger clearing itself, and a range trap adding ranges to its own page while called
+int checkRangeEdits( Core& core )
+{
+  ScriptDebugger debugger;
+  auto counting = std::make_shared<CountingTrap>();
+  int clearing = 0;
+  int adding = 0;
+  int failures = 0;
+
+  auto check = [&]( std::string_view name, int hits, int expectedHits, int countingHits )
+  {
+    bool const ok = hits == expectedHits && counting->count == countingHits;
+    failures += ok ? 0 : 1;
+    fmt::print( "{:<12} {:>10} {:>10} {}\n", name, hits, counting->count, ok ? "OK" : "MISMATCH" );
+  };
+
+  auto read = [&]( uint16_t first, uint16_t last )
+  {
+    counting->count = 0;
+    for ( uint32_t address = first; address <= last; ++address )
+    {
+      debugger.readRAM( core, (uint16_t)address, 0 );
+    }
+  };
+
+  fmt::print( "{:<12} {:>10} {:>10}\n", "edits", "hits", "counting" );
+
+  debugger.addRange( ScriptDebugger::Type::RAM_READ, 0x0300, 0x030f, std::make_shared<EditingTrap>( clearing, [&]
+  {
+    debugger.deleteRange( ScriptDebugger::Type::RAM_READ, 0x0300, 0x030f );
+  } ) );
+  debugger.addRange( ScriptDebugger::Type::RAM_READ, 0x0300, 0x03ff, counting );
+  read( 0x0300, 0x03ff );
+  check( "clear", clearing, 1, 0x100 );
+
+  debugger.addRange( ScriptDebugger::Type::RAM_READ, 0x0400, 0x0400, std::make_shared<EditingTrap>( adding, [&]
+  {
+    for ( int i = 0; i < 64; ++i )
+    {
+      debugger.addRange( ScriptDebugger::Type::RAM_READ, 0x0400, 0x04ff, counting );
+    }
+  } ) );
+  read( 0x0400, 0x04ff );
+  check( "add", adding, 1, 64 * 0xff );
+
+  fmt::print( "\n" );
+  return failures;
+}
+
+//calls trap with accumulator and flag in RAM changing so that the condition holds once every 512 calls on average
+int64_t run( Core& core, IMemoryAccessTrap& trap, sol::state& lua, int hits, std::chrono::steady_clock::duration& elapsed )
+{
+  lua["hits"] = 0;
+  auto& state = core.debugState();
+
+  auto const start = std::chrono::steady_clock::now();
+  for ( int i = 0; i < hits; ++i )
+  {
+    state.a = (uint8_t)i;
+    if ( ( i & 0xff ) == 0 )
+      core.debugWriteRAM( FLAG_ADDRESS, (uint8_t)( ( i >> 8 ) & 7 ) );
+    trap.trap( core, TRAP_ADDRESS, 0xea );
+  }
+  elapsed += std::chrono::steady_clock::now() - start;
+
+  return lua["hits"];
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  try
+  {
+    auto const options = parseOptions( argc, argv );
+    std::shared_ptr<Core> core = makeCore();
+    int failures = checkConditions( *core );
+    failures += checkRanges( *core );
+    failures += checkRangeEdits( *core );
+
+    auto scriptDebuggerEscapes = std::make_shared<ScriptDebuggerEscapes>();
+    auto symbols = std::make_unique<SymbolSource>();
+    LuaContext const context{ core, scriptDebuggerEscapes, symbols };
+
+    sol::state lua;
+    lua.open_libraries( sol::lib::base );
+    lua.new_usertype<RamProxy>( "RAM", sol::meta_function::index, &RamProxy::get, sol::meta_function::new_index, &RamProxy::set );
+    lua.new_usertype<CPUProxy>( "CPU", sol::meta_function::index, &CPUProxy::get, sol::meta_function::new_index, &CPUProxy::set );
+    lua["ram"] = std::make_unique<RamProxy>( context );
+    lua["cpu"] = std::make_unique<CPUProxy>( context );
+    lua.script( R"(
+      function count( value, address ) hits = hits + 1 return value end
+      function filter( value, address ) if cpu.a == 0x42 and ram[0x80] > 3 then hits = hits + 1 end return value end
+      compiled = { "a == 0x42 and ram[0x80] > 3", count }
+    )" );
+
+    //write past the end of RAM is cut off and reports bytes written
+    int const written = lua.script( "return ram:write( 0xfffe, 'abc' )" ).get<int>();
+    bool const cutOff = written == 2 && core->debugReadRAM( 0xffff ) == 'b';
+    failures += cutOff ? 0 : 1;
+    fmt::print( "{:<12} {:>10} {}\n\n", "ram:write", written, cutOff ? "OK" : "MISMATCH" );
+
+    struct Variant
+    {
+      std::string_view name;
+      std::shared_ptr<IMemoryAccessTrap> trap;
+    };
+
+    //made as for trap[addr] = { "condition", count } and trap[addr] = filter
+    std::array<Variant, 2> const variants{ {
+      { "compiled", makeTrap( lua.get<sol::object>( "compiled" ) ) },
+      { "lua", makeTrap( lua.get<sol::object>( "filter" ) ) }
+    } };
+
+    int64_t expected = 0;
+    for ( int i = 0; i < options.hits; ++i )
+    {
+      expected += ( i & 0xff ) == 0x42 && ( ( i >> 8 ) & 7 ) > 3 ? 1 : 0;
+    }
+
+    fmt::print( "{:<12} {:>14} {:>10}\n", "trap", "hits/s", "true" );
+
+    for ( auto const& variant : variants )
+    {
+      std::chrono::steady_clock::duration elapsed{};
+      int64_t count = 0;
+      bool stable = true;
+
+      for ( int i = 0; i < options.iterations; ++i )
+      {
+        int64_t const runCount = run( *core, *variant.trap, lua, options.hits, elapsed );
+        stable &= i == 0 || runCount == count;
+        count = runCount;
+      }
+
+      double const seconds = std::max( std::chrono::duration<double>( elapsed ).count(), 1e-9 );
+      std::string_view status = "OK";
+      if ( !stable )
+        status = "UNSTABLE";
+      else if ( count != expected )
+        status = "MISMATCH";
+      failures += status == "OK" ? 0 : 1;
+
+      fmt::print( "{:<12} {:>14.0f} {:>10} {}\n", variant.name, (double)options.hits * options.iterations / seconds, count, status );
+    }
+
+    return failures == 0 ? 0 : 1;
+  }
+  catch ( std::exception const& ex )
+  {
+    fmt::print( stderr, "{}\n", ex.what() );
+    return 2;
+  }
+}
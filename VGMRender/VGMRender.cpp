@@ -0,0 +1,227 @@
+#include "BenchCommon.hpp"
+#include "VGMPlayer.hpp"
+#include "VGMWriter.hpp"
+#include "AudioSink.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//Headless VGM renderer.
+//Renders VGM files of Mikey register writes to WAV files next to them with VGMPlayer, without CPU or Suzy, far faster than real time.
+//With --test it records a synthetic tune through VGMWriter, renders it and compares the audio against a golden hash.
+
+namespace
+{
+
+static constexpr size_t BUFFER_SAMPLES = 4096;
+static constexpr uint64_t TEST_GOLDEN = 0x8d6e2974255242baull;
+
+struct Options
+{
+  int sps;
+  bool test;
+  std::vector<std::filesystem::path> files;
+};
+
+Options parseOptions( int argc, char const* argv[] )
+{
+  static constexpr std::string_view USAGE = "[--rate N] file.vgm... | --test";
+
+  CommandLine commandLine{ argc, argv };
+  Options options{ commandLine.value( "--rate", 48000, 8000, 192000 ), commandLine.flag( "--test" ) };
+  for ( auto arg : commandLine.arguments() )
+  {
+    options.files.emplace_back( arg );
+  }
+  commandLine.done( USAGE );
+
+  if ( options.files.empty() && !options.test )
+    throw std::runtime_error{ fmt::format( "Usage: {} {}", argv[0], USAGE ) };
+
+  return options;
+}
+
+struct Rendered
+{
+  uint64_t samples;
+  uint64_t hash;
+  double seconds;
+};
+
+//renders whole file into sink and returns hash of samples
+Rendered render( VGMPlayer& player, int sps, IAudioSink& sink )
+{
+  std::vector<AudioSample> buffer( BUFFER_SAMPLES );
+  Rendered result{ 0, FNV_BASIS, 0.0 };
+
+  auto const start = std::chrono::steady_clock::now();
+  while ( !player.finished() )
+  {
+    size_t const count = player.render( sps, buffer );
+    std::span<AudioSample const> samples{ buffer.data(), count };
+    sink.push( samples );
+    result.hash = fnv( result.hash, samples );
+    result.samples += count;
+  }
+  result.seconds = std::max( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count(), 1e-9 );
+
+  return result;
+}
+
+int renderFile( std::filesystem::path const& path, int sps )
+{
+  auto data = readFile( path );
+  auto player = VGMPlayer::create( data );
+  if ( !player )
+  {
+    fmt::print( stderr, "{}: not a VGM file with Mikey data\n", path.string() );
+    return 1;
+  }
+
+  auto wavPath = path;
+  wavPath.replace_extension( ".wav" );
+  WavAudioSink sink{ wavPath, sps };
+  if ( !sink.good() )
+  {
+    fmt::print( stderr, "{}: can't write {}\n", path.string(), wavPath.string() );
+    return 1;
+  }
+
+  auto const rendered = render( *player, sps, sink );
+  double const duration = ( double )rendered.samples / sps;
+  fmt::print( "{}: {:.1f} s in {:.3f} s, {:.0f} x realtime\n", wavPath.string(), duration, rendered.seconds, duration / rendered.seconds );
+  return 0;
+}
+
+//Records four seconds of a tune playing square, noise and integrated channels with changing pitch, volume and mixing.
+//Tremolo on channel 3 writes often enough to make VGMWriter hand several buffers to its thread
+void writeTestTune( std::filesystem::path const& path )
+{
+  static constexpr uint64_t CLOCK = 16000000;
+  static constexpr uint64_t STEP = CLOCK / 8;
+  static constexpr uint64_t TREMOLO_STEP = 0x800;
+  static constexpr std::array<uint8_t, 8> NOTES = { 0x77, 0x6a, 0x5e, 0x59, 0x4f, 0x47, 0x3f, 0x3b };
+
+  struct Write
+  {
+    uint64_t tick;
+    uint8_t reg;
+    uint8_t value;
+  };
+  std::vector<Write> writes;
+
+  uint64_t tick = 0;
+  auto write = [&]( uint8_t reg, uint8_t value )
+  {
+    writes.push_back( { tick, reg, value } );
+    tick += 0x100;
+  };
+
+  //channel 0 square, 1 noise, 2 integrated, 3 noise at low rate
+  static constexpr std::array<uint8_t, 4> FEEDBACK = { 0x01, 0x35, 0x01, 0x3f };
+  static constexpr std::array<uint8_t, 4> CONTROL = { 0x19, 0x1a, 0x39, 0x9d };
+  for ( uint8_t channel = 0; channel < 4; ++channel )
+  {
+    uint8_t const base = 0x20 + channel * 8;
+    write( base + 0, 0x20 );
+    write( base + 1, FEEDBACK[channel] );
+    write( base + 3, 0x01 );
+    write( base + 7, 0x00 );
+    write( base + 4, NOTES[channel] );
+    write( base + 5, CONTROL[channel] );
+  }
+  write( 0x50, 0x00 );
+
+  for ( int i = 0; i < 32; ++i )
+  {
+    tick = ( i + 1 ) * STEP;
+    write( 0x24, NOTES[i % NOTES.size()] );
+    write( 0x28, ( uint8_t )( 0x10 + ( i % 4 ) * 0x08 ) );
+    write( 0x34, NOTES[( i * 3 ) % NOTES.size()] >> 1 );
+    if ( i % 8 == 4 )
+    {
+      write( 0x44, 0x0f );
+      write( 0x40 + ( i / 8 ), 0x3c );
+    }
+    if ( i % 8 == 0 )
+    {
+      write( 0x44, 0xff );
+    }
+  }
+
+  for ( tick = STEP / 2; tick < 33 * STEP; )
+  {
+    write( 0x38, ( uint8_t )( 0x08 + ( tick / TREMOLO_STEP ) % 0x18 ) );
+    tick += TREMOLO_STEP - 0x100;
+  }
+
+  tick = 33 * STEP;
+  write( 0x2d, 0x00 );
+
+  std::ranges::stable_sort( writes, {}, &Write::tick );
+
+  VGMWriter writer{ path };
+  writer.init( 0 );
+  for ( auto const& w : writes )
+  {
+    writer.write( w.tick, w.reg, w.value );
+  }
+}
+
+int test()
+{
+  //golden hash is for this rate
+  static constexpr int SPS = 48000;
+
+  auto const path = std::filesystem::temp_directory_path() / "VGMRender.vgm";
+  writeTestTune( path );
+
+  auto data = readFile( path );
+  std::filesystem::remove( path );
+
+  auto player = VGMPlayer::create( data );
+  if ( !player )
+  {
+    fmt::print( "test: recorded file is not recognized FAILED\n" );
+    return 1;
+  }
+
+  uint32_t const total = player->totalSamples();
+  NullAudioSink sink{ SPS };
+  auto const rendered = render( *player, SPS, sink );
+
+  //all samples up to the last write are rendered
+  uint64_t const expected = ( uint64_t )total * SPS / VGMWriter::SAMPLE_RATE;
+  bool const lengthOk = total > 0 && rendered.samples + AudioSynth::HALF_WIDTH + 1 >= expected && rendered.samples <= expected + 1;
+  bool const hashOk = rendered.hash == TEST_GOLDEN;
+  double const duration = ( double )rendered.samples / SPS;
+
+  fmt::print( "test: {} samples hash {:016x} {:.0f} x realtime {}\n", rendered.samples, rendered.hash, duration / rendered.seconds,
+    !lengthOk ? "LENGTH MISMATCH" : hashOk ? "OK" : "MISMATCH" );
+  return lengthOk && hashOk ? 0 : 1;
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  try
+  {
+    auto const options = parseOptions( argc, argv );
+    int failures = 0;
+
+    if ( options.test )
+      failures += test();
+
+    for ( auto const& file : options.files )
+    {
+      failures += renderFile( file, options.sps );
+    }
+
+    return failures == 0 ? 0 : 1;
+  }
+  catch ( std::exception const& ex )
+  {
+    fmt::print( stderr, "{}\n", ex.what() );
+    return 2;
+  }
+}
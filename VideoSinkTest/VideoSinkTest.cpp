@@ -0,0 +1,154 @@
+#include "VideoSink.hpp"
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+//VideoSink stress test.
+//Producer thread writes frames row by row like the display generator while consumer thread takes published frames like the renderer.
+//Consumer checks that every frame it gets is whole, that dirty rows are exactly the rows that differ from previous frame
+//and that a copy updated only with dirty rows matches the frame.
+//In the first half producer waits for the consumer to get every frame, in the second half it runs freely so frames are skipped.
+
+namespace
+{
+
+//Rows change every 1, 2, 4 or 8 frames depending on row number. Rows changing every frame identify the frame
+Pixel content( int frame, int row, int column )
+{
+  uint32_t const version = ( uint32_t )frame >> ( row % 4 );
+  uint32_t value = ( version * 0x9e3779b9u ) ^ ( ( uint32_t )row << 24 ) ^ ( uint32_t )column;
+  return Pixel{ value | 1 };
+}
+
+bool unchanged( int frame, int row )
+{
+  return frame > 0 && ( ( uint32_t )frame >> ( row % 4 ) ) == ( ( uint32_t )( frame - 1 ) >> ( row % 4 ) );
+}
+
+void produce( VideoSink& sink, int frames, std::atomic<uint64_t> const& received )
+{
+  for ( int frame = 0; frame < frames; ++frame )
+  {
+    while ( frame < frames / 2 && received.load() < ( uint64_t )frame )
+    {
+      std::this_thread::yield();
+    }
+
+    for ( int row = 0; row < SCREEN_HEIGHT; ++row )
+    {
+      //slowest changing rows are not written at all when they do not change to check that sink keeps them
+      if ( row % 4 == 3 && unchanged( frame, row ) )
+        continue;
+
+      Doublet* dst = sink.getRow( row );
+      for ( int column = 0; column < ( int )ROW_BYTES; ++column )
+      {
+        dst[column] = { content( frame, row, column * 2 ), content( frame, row, column * 2 + 1 ) };
+      }
+    }
+    sink.newFrame();
+  }
+}
+
+struct ConsumerResult
+{
+  int received;
+  int skipped;
+  int errors;
+};
+
+ConsumerResult consume( VideoSink& sink, int frames, std::atomic<uint64_t>& received )
+{
+  ConsumerResult result{};
+  std::vector<Doublet> texture( ROW_BYTES * SCREEN_HEIGHT );
+  uint64_t sequence = 0;
+
+  while ( sequence < ( uint64_t )frames )
+  {
+    auto frame = sink.nextFrame();
+    if ( !frame )
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    if ( frame->sequence <= sequence )
+    {
+      result.errors += 1;
+      break;
+    }
+
+    bool const consecutive = frame->sequence == sequence + 1;
+    result.received += 1;
+    result.skipped += ( int )( frame->sequence - sequence - 1 );
+    sequence = frame->sequence;
+    int const number = ( int )sequence - 1;
+
+    bool whole = true;
+    bool dirty = true;
+    for ( int row = 0; row < SCREEN_HEIGHT; ++row )
+    {
+      Doublet const* src = frame->pixels.data() + row * ROW_BYTES;
+      for ( int column = 0; column < ( int )ROW_BYTES; ++column )
+      {
+        whole &= src[column].left.toRGBA() == content( number, row, column * 2 ).toRGBA();
+        whole &= src[column].right.toRGBA() == content( number, row, column * 2 + 1 ).toRGBA();
+      }
+
+      if ( consecutive )
+        dirty &= frame->dirty[row] == !unchanged( number, row );
+
+      if ( !consecutive || frame->dirty[row] )
+        std::copy_n( src, ROW_BYTES, texture.data() + row * ROW_BYTES );
+    }
+
+    bool const uploaded = std::ranges::equal( texture, frame->pixels, []( Doublet const& left, Doublet const& right )
+    {
+      return left.left.toRGBA() == right.left.toRGBA() && left.right.toRGBA() == right.right.toRGBA();
+    } );
+
+    result.errors += ( int )!whole + ( int )!dirty + ( int )!uploaded;
+    if ( result.errors > 0 )
+    {
+      fmt::print( "frame {}: whole {} dirty {} uploaded {}\n", sequence, whole, dirty, uploaded );
+      break;
+    }
+    received.store( sequence );
+  }
+
+  //releases waiting producer also on error
+  received.store( std::numeric_limits<uint64_t>::max() );
+  return result;
+}
+
+}
+
+int main( int argc, char const* argv[] )
+{
+  int frames = 20000;
+  if ( argc == 3 && std::string_view{ argv[1] } == "--frames" )
+  {
+    frames = std::max( 1, std::atoi( argv[2] ) );
+  }
+  else if ( argc != 1 )
+  {
+    fmt::print( stderr, "Usage: {} [--frames N]\n", argv[0] );
+    return 2;
+  }
+
+  auto sink = std::make_unique<VideoSink>();
+  ConsumerResult result{};
+  std::atomic<uint64_t> received{};
+
+  std::thread consumer{ [&]
+  {
+    result = consume( *sink, frames, received );
+  } };
+
+  produce( *sink, frames, received );
+  consumer.join();
+
+  fmt::print( "frames {} received {} skipped {} errors {}\n", frames, result.received, result.skipped, result.errors );
+  bool const ok = result.errors == 0 && result.received + result.skipped == frames;
+  fmt::print( "{}\n", ok ? "OK" : "FAILED" );
+  return ok ? 0 : 1;
+}
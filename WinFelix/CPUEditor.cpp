@@ -3,6 +3,7 @@
 #include "Core.hpp"
 #include "CPU.hpp"
 #include "CPUState.hpp"
+#include "DebugSnapshot.hpp"
 
 CPUEditor::CPUEditor()
 {
@@ -48,20 +49,24 @@ void CPUEditor::drawRegister( const char* label, uint8_t reg )
   {
     int r;
     std::from_chars( regBuf.data(), regBuf.data() + regBuf.size(), r, 16 );
-    auto &state = mManager->mInstance->debugCPU().state();
 
-    if ( 0 == strcmp( label, "A") )
+    mManager->mDebugSnapshots->edit( [=]( Core& core )
     {
-      state.a = r;
-    }
-    else if ( 0 == strcmp( label, "X" ) )
-    {
-      state.x = r;
-    }
-    else if ( 0 == strcmp( label, "Y" ) )
-    {
-      state.y = r;
-    }    
+      auto &state = core.debugCPU().state();
+
+      if ( 0 == strcmp( label, "A") )
+      {
+        state.a = r;
+      }
+      else if ( 0 == strcmp( label, "X" ) )
+      {
+        state.x = r;
+      }
+      else if ( 0 == strcmp( label, "Y" ) )
+      {
+        state.y = r;
+      }
+    } );
   }
   ImGui::EndDisabled();
 
@@ -108,16 +113,19 @@ void CPUEditor::drawPS( const char* label, uint16_t ps )
     int v;
     std::from_chars( regBuf.data(), regBuf.data() + regBuf.size(), v, 16 );
 
-    auto &state = mManager->mInstance->debugCPU().state();
-
-    if ( 0 == strcmp( label, "S" ) )
+    mManager->mDebugSnapshots->edit( [=]( Core& core )
     {
-      state.s = ( v & 0xff ) | 0x0100;
-    }
-    else if ( 0 == strcmp( label, "PC" ) )
-    {
-      state.pc = v;
-    }
+      auto &state = core.debugCPU().state();
+
+      if ( 0 == strcmp( label, "S" ) )
+      {
+        state.s = ( v & 0xff ) | 0x0100;
+      }
+      else if ( 0 == strcmp( label, "PC" ) )
+      {
+        state.pc = v;
+      }
+    } );
   }
   ImGui::EndDisabled();
 }
@@ -135,7 +143,6 @@ void CPUEditor::drawFlag( const char* label, bool enabled, bool* b )
   ImGui::Checkbox( labelbuf.data(), b );
   if ( ImGui::IsItemClicked() )
   {
-    auto &state = mManager->mInstance->debugCPU().state();
     int mask;
 
     if ( 0 == strcmp( label, "N" ) )
@@ -167,8 +174,12 @@ void CPUEditor::drawFlag( const char* label, bool enabled, bool* b )
       return;
     }
 
-    auto p = state.getP();
-    state.setP( p & mask ? p & ~mask : p | mask );
+    mManager->mDebugSnapshots->edit( [=]( Core& core )
+    {
+      auto &state = core.debugCPU().state();
+      auto p = state.getP();
+      state.setP( p & mask ? p & ~mask : p | mask );
+    } );
   }
 }
 
@@ -179,7 +190,7 @@ void CPUEditor::drawContents()
     return;
   }
 
-  auto& state = mManager->mInstance->debugState();
+  auto const& state = mManager->mDebugSnapshots->currentSnapshot().cpu;
 
   drawRegister( "A", state.a );
   drawRegister( "X", state.x );
@@ -52,7 +52,7 @@ static ComPtr<ID3D11ComputeShader> gRendererCS;
 
 }
 
-DX11Renderer::DX11Renderer( HWND hWnd, std::filesystem::path const& iniPath, Tag ) : mHWnd{ hWnd }, mRefreshRate{}, mVideoSink{ std::make_shared<VideoSink>() }, mLastRenderTimePoint{}
+DX11Renderer::DX11Renderer( HWND hWnd, std::filesystem::path const& iniPath, Tag ) : mHWnd{ hWnd }, mRefreshRate{}, mVideoSink{ std::make_shared<VideoSink>() }, mFrameSequence{}, mLastRenderTimePoint{}
 {
   LARGE_INTEGER l;
   QueryPerformanceCounter( &l );
@@ -131,9 +131,9 @@ DX11Renderer::DX11Renderer( HWND hWnd, std::filesystem::path const& iniPath, Tag
   desc.ArraySize = 1;
   desc.SampleDesc.Count = 1;
   desc.SampleDesc.Quality = 0;
-  desc.Usage = D3D11_USAGE_DYNAMIC;
+  desc.Usage = D3D11_USAGE_DEFAULT;
   desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-  desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+  desc.CPUAccessFlags = 0;
   desc.MiscFlags = 0;
 
   std::vector<uint32_t> buf;
@@ -249,23 +249,33 @@ bool DX11Renderer::resizeOutput()
 
 void DX11Renderer::updateSourceFromNextFrame()
 {
-  D3D11_MAPPED_SUBRESOURCE d3dmap;
-  gImmediateContext->Map( mSource.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &d3dmap );
+  auto frame = mVideoSink->nextFrame();
+  if ( !frame )
+    return;
+
+  //texture holds previous frame only if no frame was skipped
+  bool const whole = mFrameSequence == 0 || frame->sequence != mFrameSequence + 1;
+  mFrameSequence = frame->sequence;
 
-  struct MappedTexture
+  //uploads runs of changed rows
+  for ( int begin = 0; begin < SCREEN_HEIGHT; )
   {
-    Doublet* data;
-    uint32_t stride;
-  } dst{ ( Doublet*)d3dmap.pData, d3dmap.RowPitch / (uint32_t)sizeof( Doublet ) };
+    if ( !whole && !frame->dirty[begin] )
+    {
+      ++begin;
+      continue;
+    }
 
-  Doublet const* src = mVideoSink->frame.data();
+    int end = begin + 1;
+    while ( end < SCREEN_HEIGHT && ( whole || frame->dirty[end] ) )
+    {
+      ++end;
+    }
 
-  for ( int i = 0; i < SCREEN_HEIGHT; ++i )
-  {
-    std::copy_n( src + i * ROW_BYTES, ROW_BYTES, dst.data + i * dst.stride );
+    D3D11_BOX box{ 0, ( UINT )begin, 0, ( UINT )SCREEN_WIDTH, ( UINT )end, 1 };
+    gImmediateContext->UpdateSubresource( mSource.Get(), 0, &box, frame->pixels.data() + begin * ROW_BYTES, ROW_BYTES * sizeof( Doublet ), 0 );
+    begin = end;
   }
-
-  gImmediateContext->Unmap( mSource.Get(), 0 );
 }
 
 void DX11Renderer::renderGui( UI& ui )
@@ -481,7 +491,7 @@ void DX11Renderer::saveFrame( std::filesystem::path const& path )
   std::vector<uint32_t> buf;
   buf.reserve( 160 * 102 );
 
-  for ( auto d : mVideoSink->frame )
+  for ( auto d : mVideoSink->currentFrame().pixels )
   {
     buf.push_back( d.left.toRGBA() );
     buf.push_back( d.right.toRGBA() );
@@ -4,7 +4,7 @@
 #include "Utility.hpp"
 
 class WinImgui11;
-struct VideoSink;
+class VideoSink;
 
 class DX11Renderer : public IRenderer
 {
@@ -77,6 +77,8 @@ private:
 
   rational::Ratio<int32_t>          mRefreshRate;
   std::shared_ptr<VideoSink>        mVideoSink;
+  //sequence of last frame uploaded to mSource
+  uint64_t                          mFrameSequence;
   mutable std::mutex                mDebugViewMutex;
   int64_t                           mLastRenderTimePoint;
 };
@@ -6,6 +6,7 @@
 #include "TraceHelper.hpp"
 #include "ConfigProvider.hpp"
 #include "SysConfig.hpp"
+#include "DebugSnapshot.hpp"
 
 DisasmEditor::DisasmEditor() : mPC{ 0 }, mFollowPC { 0 }
 {
@@ -62,8 +63,9 @@ void DisasmEditor::drawTable()
 {
   char buf[100];
   auto& cpu = mManager->mInstance->debugCPU();
-  auto ram = mManager->mInstance->debugRAM();
-  auto rom = mManager->mInstance->debugROM();
+  auto const& snapshot = mManager->mDebugSnapshots->currentSnapshot();
+  auto ram = snapshot.ram.data();
+  auto rom = snapshot.rom.data();
   auto opColor = IM_COL32( 126, 88, 137, 255 );
   auto tableSize = ImGui::GetWindowSize();
   tableSize.y -= ImGuiStyleVar_CellPadding * 3;
@@ -71,7 +73,7 @@ void DisasmEditor::drawTable()
   uint8_t oprLength = 0;
   int prevPC;
 
-  mPC = cpu.state().pc;
+  mPC = snapshot.cpu.pc;
   if ( mFollowPC )
   {
     mTablePC = mPC;
@@ -205,7 +207,7 @@ void DisasmEditor::scrollUp()
   int prevPC;
 
   auto& cpu = mManager->mInstance->debugCPU();
-  auto ram = mManager->mInstance->debugRAM();
+  auto ram = mManager->mDebugSnapshots->currentSnapshot().ram.data();
 
   for ( char i = 1; i < 4; ++i )
   {
@@ -244,7 +246,7 @@ void DisasmEditor::scrollDown()
 {
   char buf[50];
   auto& cpu = mManager->mInstance->debugCPU();
-  auto ram = mManager->mInstance->debugRAM();
+  auto ram = mManager->mDebugSnapshots->currentSnapshot().ram.data();
   
   cpu.disasmOp( buf, (Opcode)ram[mTablePC] );
   cpu.disasmOpr( ram, (char*)buf, mTablePC );
@@ -1,33 +1,111 @@
 #include "LuaProxies.hpp"
 #include "ScriptDebuggerEscapes.hpp"
-#include "Manager.hpp"
 #include "SymbolSource.hpp"
 #include "Core.hpp"
 #include "CPUState.hpp"
+#include "TrapCondition.hpp"
+#include "Ex.hpp"
 
-void TrapProxy::set( TrapProxy& proxy, int idx, sol::function fun )
+namespace
 {
-  struct LuaTrap : public IMemoryAccessTrap
+
+struct LuaTrap : public IMemoryAccessTrap
+{
+  sol::function fun;
+
+  LuaTrap( sol::function fun ) : fun{ fun } {}
+  ~LuaTrap() override = default;
+
+  virtual uint8_t trap( Core& core, uint16_t address, uint8_t orgValue ) override
   {
-    sol::function fun;
+    return fun( orgValue, address );
+  }
 
-    LuaTrap( sol::function fun ) : fun{ fun } {}
-    ~LuaTrap() override = default;
+  Kind getKind() const override
+  {
+    return LUA;
+  }
+};
 
-    virtual uint8_t trap( Core& core, uint16_t address, uint8_t orgValue ) override
-    {
-      return fun( orgValue, address );
-    }
+TrapCondition compileCondition( std::string const& source )
+{
+  std::string error;
+  if ( auto condition = TrapCondition::compile( source, error ) )
+    return std::move( *condition );
 
-    Kind getKind() const override
-    {
-      return LUA;
-    }
+  throw Ex{} << "trap condition \"" << source << "\": " << error;
+}
+
+}
+
+//trap[addr] = function( value, address ) ... end calls the function on each access
+//trap[addr] = "condition" breaks when condition holds
+//trap[addr] = { "condition", function( value, address ) ... end } calls the function only when condition holds
+std::shared_ptr<IMemoryAccessTrap> makeTrap( sol::object const& value )
+{
+  if ( value.is<sol::function>() )
+  {
+    return std::make_shared<LuaTrap>( value.as<sol::function>() );
+  }
+  else if ( value.is<std::string>() )
+  {
+    return std::make_shared<ConditionalTrap>( compileCondition( value.as<std::string>() ), std::shared_ptr<IMemoryAccessTrap>{}, IMemoryAccessTrap::LUA );
+  }
+  else if ( value.is<sol::table>() )
+  {
+    sol::table tab = value.as<sol::table>();
+    sol::optional<std::string> source = tab[1];
+    sol::optional<sol::function> fun = tab[2];
+    if ( !source || !fun )
+      throw Ex{} << "trap requires { \"condition\", function }";
+
+    return std::make_shared<ConditionalTrap>( compileCondition( *source ), std::make_shared<LuaTrap>( *fun ), IMemoryAccessTrap::LUA );
+  }
+  else
+  {
+    throw Ex{} << "trap requires function, condition or { \"condition\", function }";
+  }
+}
+
+ScriptDebugger::FrameCallback makeFrameCallback( sol::function fun )
+{
+  return [fun = std::move( fun )]( Core& )
+  {
+    fun();
+  };
+}
+
+ScriptDebugger::ScanlineCallback makeScanlineCallback( sol::function fun )
+{
+  return [fun = std::move( fun )]( Core&, int line )
+  {
+    fun( line );
   };
+}
 
+void TrapProxy::set( TrapProxy& proxy, int idx, sol::object value )
+{
   if ( idx >= 0 && idx < 65536 )
   {
-    proxy.scriptDebuggerEscapes->addTrap( proxy.type, (uint16_t)idx, std::make_shared<LuaTrap>( fun ) );
+    proxy.scriptDebuggerEscapes->addTrap( proxy.type, (uint16_t)idx, makeTrap( value ) );
+  }
+}
+
+//trap:range( first, last, trap ) watches all addresses from first to last with one trap of any kind accepted by trap[addr]
+void TrapProxy::range( TrapProxy& proxy, int first, int last, sol::object value )
+{
+  if ( first >= 0 && first <= last && last < 65536 )
+  {
+    proxy.scriptDebuggerEscapes->addRange( proxy.type, (uint16_t)first, (uint16_t)last, makeTrap( value ) );
+  }
+}
+
+//trap:clear( first, last ) removes ranges added with the same first and last address
+void TrapProxy::clear( TrapProxy& proxy, int first, int last )
+{
+  if ( first >= 0 && first <= last && last < 65536 )
+  {
+    proxy.scriptDebuggerEscapes->deleteRange( proxy.type, (uint16_t)first, (uint16_t)last );
   }
 }
 
@@ -36,9 +114,9 @@ sol::object RamProxy::get( sol::stack_object key, sol::this_state L )
   if ( auto optIdx = key.as<sol::optional<int>>() )
   {
     int idx = *optIdx;
-    if ( idx >= 0 && idx < 65536 && manager.mInstance )
+    if ( idx >= 0 && idx < 65536 && context.instance )
     {
-      auto result = manager.mInstance->debugReadRAM( (uint16_t)idx );
+      auto result = context.instance->debugReadRAM( (uint16_t)idx );
       return sol::object( L, sol::in_place, result );
     }
   }
@@ -48,21 +126,50 @@ sol::object RamProxy::get( sol::stack_object key, sol::this_state L )
 
     if ( k == "r" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::RAM_READ } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::RAM_READ } );
     }
     else if ( k == "w" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::RAM_WRITE } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::RAM_WRITE } );
     }
     else if ( k == "x" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::RAM_EXECUTE } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::RAM_EXECUTE } );
+    }
+    else if ( k == "read" )
+    {
+      return sol::make_object( L, &RamProxy::read );
+    }
+    else if ( k == "write" )
+    {
+      return sol::make_object( L, &RamProxy::write );
     }
   }
 
   return sol::object( L, sol::in_place, sol::lua_nil );
 }
 
+sol::object RamProxy::read( RamProxy& proxy, int address, int length, sol::this_state L )
+{
+  if ( address >= 0 && address < 65536 && length >= 0 && proxy.context.instance )
+  {
+    size_t const size = std::min<size_t>( length, 65536 - address );
+    return sol::make_object( L, std::string_view{ (char const*)proxy.context.instance->debugRAM() + address, size } );
+  }
+
+  return sol::object( L, sol::in_place, sol::lua_nil );
+}
+
+int RamProxy::write( RamProxy& proxy, int address, std::string_view data )
+{
+  if ( address >= 0 && address < 65536 && proxy.context.instance )
+  {
+    return (int)proxy.context.instance->debugWriteRAM( (uint16_t)address, std::span<uint8_t const>{ (uint8_t const*)data.data(), data.size() } );
+  }
+
+  return 0;
+}
+
 void RamProxy::set( sol::stack_object key, sol::stack_object value, sol::this_state )
 {
   if ( auto optIdx = key.as<sol::optional<int>>() )
@@ -70,7 +177,7 @@ void RamProxy::set( sol::stack_object key, sol::stack_object value, sol::this_st
     int idx = *optIdx;
     if ( idx >= 0 && idx < 65536 )
     {
-      manager.mInstance->debugWriteRAM( (uint16_t)idx, value.as<uint8_t>() );
+      context.instance->debugWriteRAM( (uint16_t)idx, value.as<uint8_t>() );
     }
   }
 }
@@ -80,7 +187,7 @@ sol::object MikeyProxy::get( sol::stack_object key, sol::this_state L )
   if ( auto optIdx = key.as<sol::optional<int>>() )
   {
     uint16_t idx = (uint16_t)( *optIdx & 0xff );
-    auto result = manager.mInstance->debugReadMikey( idx );
+    auto result = context.instance->debugReadMikey( idx );
     return sol::object( L, sol::in_place, result );
   }
   else if ( auto optSt = key.as<sol::optional<std::string>>() )
@@ -89,11 +196,11 @@ sol::object MikeyProxy::get( sol::stack_object key, sol::this_state L )
 
     if ( k == "r" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::MIKEY_READ } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::MIKEY_READ } );
     }
     else if ( k == "w" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::MIKEY_WRITE } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::MIKEY_WRITE } );
     }
   }
 
@@ -105,7 +212,7 @@ void MikeyProxy::set( sol::stack_object key, sol::stack_object value, sol::this_
   if ( auto optIdx = key.as<sol::optional<int>>() )
   {
     uint16_t idx = (uint16_t)( *optIdx & 0xff );
-    manager.mInstance->debugWriteMikey( idx, value.as<uint8_t>() );
+    context.instance->debugWriteMikey( idx, value.as<uint8_t>() );
   }
 }
 
@@ -114,7 +221,7 @@ sol::object SuzyProxy::get( sol::stack_object key, sol::this_state L )
   if ( auto optIdx = key.as<sol::optional<int>>() )
   {
     uint16_t idx = (uint16_t)( *optIdx & 0xff );
-    auto result = manager.mInstance->debugReadSuzy( idx );
+    auto result = context.instance->debugReadSuzy( idx );
     return sol::object( L, sol::in_place, result );
   }
   else if ( auto optSt = key.as<sol::optional<std::string>>() )
@@ -123,11 +230,11 @@ sol::object SuzyProxy::get( sol::stack_object key, sol::this_state L )
 
     if ( k == "r" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::SUZY_READ } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::SUZY_READ } );
     }
     else if ( k == "w" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::SUZY_WRITE } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::SUZY_WRITE } );
     }
   }
 
@@ -139,7 +246,7 @@ void SuzyProxy::set( sol::stack_object key, sol::stack_object value, sol::this_s
   if ( auto optIdx = key.as<sol::optional<int>>() )
   {
     uint16_t idx = (uint16_t)( *optIdx & 0xff );
-    manager.mInstance->debugWriteSuzy( idx, value.as<uint8_t>() );
+    context.instance->debugWriteSuzy( idx, value.as<uint8_t>() );
   }
 }
 
@@ -148,7 +255,7 @@ sol::object RomProxy::get( sol::stack_object key, sol::this_state L )
   if ( auto optIdx = key.as<sol::optional<int>>() )
   {
     uint16_t idx = (uint16_t)( *optIdx & 0x1ff );
-    auto result = manager.mInstance->debugReadROM( idx );
+    auto result = context.instance->debugReadROM( idx );
   }
   else if ( auto optSt = key.as<sol::optional<std::string>>() )
   {
@@ -156,15 +263,15 @@ sol::object RomProxy::get( sol::stack_object key, sol::this_state L )
 
     if ( k == "r" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::ROM_READ } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::ROM_READ } );
     }
     else if ( k == "w" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::ROM_WRITE } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::ROM_WRITE } );
     }
     else if ( k == "x" )
     {
-      return sol::object( L, sol::in_place, TrapProxy{ manager.mScriptDebuggerEscapes, ScriptDebugger::Type::ROM_EXECUTE } );
+      return sol::object( L, sol::in_place, TrapProxy{ context.scriptDebuggerEscapes, ScriptDebugger::Type::ROM_EXECUTE } );
     }
   }
 
@@ -184,19 +291,19 @@ sol::object CPUProxy::get( sol::stack_object key, sol::this_state L )
 
     if ( k == "a" )
     {
-      return sol::object( L, sol::in_place, manager.mInstance->debugState().a );
+      return sol::object( L, sol::in_place, context.instance->debugState().a );
     }
     if ( k == "x" )
     {
-      return sol::object( L, sol::in_place, manager.mInstance->debugState().x );
+      return sol::object( L, sol::in_place, context.instance->debugState().x );
     }
     if ( k == "y" )
     {
-      return sol::object( L, sol::in_place, manager.mInstance->debugState().y );
+      return sol::object( L, sol::in_place, context.instance->debugState().y );
     }
     if ( k == "pc" )
     {
-      return sol::object( L, sol::in_place, manager.mInstance->debugState().pc );
+      return sol::object( L, sol::in_place, context.instance->debugState().pc );
     }
   }
 
@@ -211,15 +318,15 @@ void CPUProxy::set( sol::stack_object key, sol::stack_object value, sol::this_st
 
     if ( k == "a" )
     {
-      manager.mInstance->debugState().a = value.as<uint8_t>();
+      context.instance->debugState().a = value.as<uint8_t>();
     }
     if ( k == "x" )
     {
-      manager.mInstance->debugState().x = value.as<uint8_t>();
+      context.instance->debugState().x = value.as<uint8_t>();
     }
     if ( k == "y" )
     {
-      manager.mInstance->debugState().y = value.as<uint8_t>();
+      context.instance->debugState().y = value.as<uint8_t>();
     }
   }
 }
@@ -230,9 +337,9 @@ sol::object SymbolProxy::get( sol::stack_object key, sol::this_state L )
   {
     const std::string& k = *optSt;
 
-    if ( manager.mSymbols )
+    if ( context.symbols )
     {
-      if ( auto opt = manager.mSymbols->symbol( k ) )
+      if ( auto opt = context.symbols->symbol( k ) )
       {
         return sol::object( L, sol::in_place, *opt );
       }
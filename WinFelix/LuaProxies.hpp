@@ -3,27 +3,51 @@
 #include "ScriptDebugger.hpp"
 #include "sol/sol.hpp"
 
-class Manager;
+class Core;
+class SymbolSource;
+class ScriptDebuggerEscapes;
+
+//emulator state the proxies below give scripts access to
+struct LuaContext
+{
+  std::shared_ptr<Core> const& instance;
+  std::shared_ptr<ScriptDebuggerEscapes> const& scriptDebuggerEscapes;
+  std::unique_ptr<SymbolSource> const& symbols;
+};
 
 struct TrapProxy
 {
   std::shared_ptr<ScriptDebuggerEscapes> scriptDebuggerEscapes;
   ScriptDebugger::Type type;
 
-  static void set( TrapProxy & proxy, int idx, sol::function fun );
+  static void set( TrapProxy & proxy, int idx, sol::object value );
+  static void range( TrapProxy & proxy, int first, int last, sol::object value );
+  static void clear( TrapProxy & proxy, int first, int last );
 };
 
+//trap for trap[addr] = function, "condition" or { "condition", function }
+std::shared_ptr<IMemoryAccessTrap> makeTrap( sol::object const& value );
+
+//onFrame( function() ... end ) and onScanline( function( line ) ... end ) callbacks
+ScriptDebugger::FrameCallback makeFrameCallback( sol::function fun );
+ScriptDebugger::ScanlineCallback makeScanlineCallback( sol::function fun );
+
 struct RamProxy
 {
-  Manager& manager;
+  LuaContext const& context;
 
   sol::object get( sol::stack_object key, sol::this_state L );
   void set( sol::stack_object key, sol::stack_object value, sol::this_state );
+
+  //ram:read( addr, len ) returns string of bytes up to the end of RAM.
+  //ram:write( addr, string ) writes bytes up to the end of RAM and returns their count, so a cut off write can be detected
+  static sol::object read( RamProxy& proxy, int address, int length, sol::this_state L );
+  static int write( RamProxy& proxy, int address, std::string_view data );
 };
 
 struct RomProxy
 {
-  Manager& manager;
+  LuaContext const& context;
 
   sol::object get( sol::stack_object key, sol::this_state L );
   void set( sol::stack_object key, sol::stack_object value, sol::this_state );
@@ -31,7 +55,7 @@ struct RomProxy
 
 struct MikeyProxy
 {
-  Manager& manager;
+  LuaContext const& context;
 
   sol::object get( sol::stack_object key, sol::this_state L );
   void set( sol::stack_object key, sol::stack_object value, sol::this_state );
@@ -39,7 +63,7 @@ struct MikeyProxy
 
 struct SuzyProxy
 {
-  Manager& manager;
+  LuaContext const& context;
 
   sol::object get( sol::stack_object key, sol::this_state L );
   void set( sol::stack_object key, sol::stack_object value, sol::this_state );
@@ -47,7 +71,7 @@ struct SuzyProxy
 
 struct CPUProxy
 {
-  Manager& manager;
+  LuaContext const& context;
 
   sol::object get( sol::stack_object key, sol::this_state L );
   void set( sol::stack_object key, sol::stack_object value, sol::this_state );
@@ -55,7 +79,7 @@ struct CPUProxy
 
 struct SymbolProxy
 {
-  Manager& manager;
+  LuaContext const& context;
 
   sol::object get( sol::stack_object key, sol::this_state L );
 };
@@ -2,6 +2,7 @@
 #include "InputFile.hpp"
 #include "WinImgui.hpp"
 #include "WinAudioOut.hpp"
+#include "AudioSink.hpp"
 #include "ComLynxWire.hpp"
 #include "Core.hpp"
 #include "SymbolSource.hpp"
@@ -23,6 +24,7 @@
 #include "ISystemDriver.hpp"
 #include "VGMWriter.hpp"
 #include "TraceHelper.hpp"
+#include "DebugSnapshot.hpp"
 
 
 Manager::Manager() : mUI{ *this },
@@ -36,6 +38,9 @@ mRenderThread{},
 mAudioThread{},
 mRenderingTime{},
 mScriptDebuggerEscapes{},
+mLuaContext{ mInstance, mScriptDebuggerEscapes, mSymbols },
+mDebugSnapshots{ std::make_shared<DebugSnapshots>() },
+mDebugSnapshotTick{},
 mImageProperties{},
 mRenderer{},
 mDebugWindows{}
@@ -67,33 +72,46 @@ mDebugWindows{}
     }
   } };
 
+  //Emulation thread. Runs emulation for samples due by wall clock at rate requested by audio sink and pushes them
+  //to the sink, whose device thread plays them on its own clock
   mAudioThread = std::thread{ [this]
   {
     try
     {
+      AudioPacer pacer;
+      std::vector<AudioSample> samples;
       while ( !mJoinThreads.load() )
       {
         if ( mProcessThreads.load() )
         {
-          int64_t renderingTime;
+          int const sps = mAudioOut->rate();
+          size_t const count = std::min( pacer.due( std::chrono::steady_clock::now(), sps ), mAudioOut->space() );
+          if ( count > 0 )
           {
-            std::scoped_lock<std::mutex> l{ mMutex };
-            renderingTime = mRenderingTime;
-          }
-          if ( mAudioOut->wait() )
-          {
-            auto runMode = mDebugger.mRunMode.load();
-            auto cpuBreakType = mAudioOut->fillBuffer( mInstance, renderingTime, runMode );
-            if ( cpuBreakType != CpuBreakType::NEXT )
+            samples.resize( count );
+            if ( mInstance )
+            {
+              auto runMode = mDebugger.mRunMode.load();
+              auto cpuBreakType = mInstance->advanceAudio( sps, samples, runMode );
+              if ( cpuBreakType != CpuBreakType::NEXT )
+              {
+                mDebugger.mRunMode.store( RunMode::PAUSE );
+              }
+            }
+            else
             {
-              mDebugger.mRunMode.store( RunMode::PAUSE );
+              std::ranges::fill( samples, AudioSample{} );
             }
+            mAudioOut->push( samples );
           }
           mSystemDriver->setPaused( mDebugger.mRunMode.load() != RunMode::RUN );
           updateDebugWindows();
+          //samples due are accumulated over the sleep, so emulation runs in chunks of at least a millisecond
+          std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
         }
         else
         {
+          pacer.reset();
           mThreadsWaiting.fetch_add( 1 );
           do
           {
@@ -156,31 +174,36 @@ void Manager::quit()
   mSystemDriver->quit();
 }
 
+//Called on emulation thread. Debug windows read only published snapshots and queue their edits, so this waits for
+//the render thread at most while it queues an edit
 void Manager::updateDebugWindows()
 {
   if ( !mInstance )
     return;
 
   if ( !mDebugger.isDebugMode() )
+  {
+    mInstance->setDebugSnapshots( {} );
     return;
+  }
 
-  std::unique_lock<std::mutex> l{ mDebugger.lockMutex() };
+  //edits queued by debug windows are applied here, so only this thread writes emulator state
+  mInstance->setDebugSnapshots( mDebugSnapshots );
+  bool const requested = mDebugSnapshots->requested();
+  if ( requested )
+  {
+    mDebugSnapshots->applyEdits( *mInstance );
+  }
 
-  auto svs = mDebugger.screenViews();
-  auto& csvs = mDebugWindows.customScreenViews;
-  //removing elements in csvs that are not in svs 
-  auto ret = std::ranges::remove_if( csvs, [&] ( int id ) { return std::ranges::find( svs, id, &ScreenView::id ) == svs.end(); }, [] ( auto const& p ) { return p.first; } );
-  csvs.erase( ret.begin(), ret.end() );
-  //add missing elements to csvs that are in svs
-  for ( auto const& sv : svs )
+  //running emulator publishes at vertical blank, stopped one when its state changed or debug windows edited it
+  if ( mDebugger.mRunMode.load() != RunMode::RUN )
   {
-    if ( std::ranges::find( csvs, sv.id, [] ( auto const& p ) { return p.first; } ) == csvs.end() )
+    if ( requested || mInstance->tick() != mDebugSnapshotTick )
     {
-      csvs.emplace_back( sv.id, mRenderer->makeCustomScreenView() );
+      mDebugSnapshotTick = mInstance->tick();
+      mInstance->publishDebugSnapshot();
     }
   }
-
-  auto& cpu = mInstance->debugCPU();
 }
 
 void Manager::processLua( std::filesystem::path const& path )
@@ -206,7 +229,7 @@ void Manager::processLua( std::filesystem::path const& path )
   mLua = sol::state{};
   mLua.open_libraries( sol::lib::base, sol::lib::io );
 
-  mLua.new_usertype<TrapProxy>( "TRAP", sol::meta_function::new_index, &TrapProxy::set );
+  mLua.new_usertype<TrapProxy>( "TRAP", sol::meta_function::new_index, &TrapProxy::set, "range", &TrapProxy::range, "clear", &TrapProxy::clear );
   mLua.new_usertype<RamProxy>( "RAM", sol::meta_function::index, &RamProxy::get, sol::meta_function::new_index, &RamProxy::set );
   mLua.new_usertype<RomProxy>( "ROM", sol::meta_function::index, &RomProxy::get, sol::meta_function::new_index, &RomProxy::set );
   mLua.new_usertype<MikeyProxy>( "MIKEY", sol::meta_function::index, &MikeyProxy::get, sol::meta_function::new_index, &MikeyProxy::set );
@@ -214,12 +237,12 @@ void Manager::processLua( std::filesystem::path const& path )
   mLua.new_usertype<CPUProxy>( "CPU", sol::meta_function::index, &CPUProxy::get, sol::meta_function::new_index, &CPUProxy::set );
   mLua.new_usertype<SymbolProxy>( "SYMBOL", sol::meta_function::index, &SymbolProxy::get );
 
-  mLua["ram"] = std::make_unique<RamProxy>( *this );
-  mLua["rom"] = std::make_unique<RomProxy>( *this );
-  mLua["mikey"] = std::make_unique<MikeyProxy>( *this );
-  mLua["suzy"] = std::make_unique<SuzyProxy>( *this );
-  mLua["cpu"] = std::make_unique<CPUProxy>( *this );
-  mLua["symbol"] = std::make_unique<SymbolProxy>( *this );
+  mLua["ram"] = std::make_unique<RamProxy>( mLuaContext );
+  mLua["rom"] = std::make_unique<RomProxy>( mLuaContext );
+  mLua["mikey"] = std::make_unique<MikeyProxy>( mLuaContext );
+  mLua["suzy"] = std::make_unique<SuzyProxy>( mLuaContext );
+  mLua["cpu"] = std::make_unique<CPUProxy>( mLuaContext );
+  mLua["symbol"] = std::make_unique<SymbolProxy>( mLuaContext );
 
   mLua["WavOut"] = [this] ( sol::table const& tab )
   {
@@ -302,6 +325,26 @@ void Manager::processLua( std::filesystem::path const& path )
     }
   };
 
+  //onFrame and onScanline return id of the callback for removeCallback( id )
+  mLua["onFrame"] = [this]( sol::function fun )
+  {
+    return mScriptDebuggerEscapes->addFrameCallback( makeFrameCallback( std::move( fun ) ) );
+  };
+
+  mLua["onScanline"] = [this]( sol::function fun )
+  {
+    return mScriptDebuggerEscapes->addScanlineCallback( makeScanlineCallback( std::move( fun ) ) );
+  };
+
+  mLua["removeCallback"] = [this]( int id )
+  {
+    mScriptDebuggerEscapes->deleteCallback( id );
+    if ( mInstance )
+    {
+      mInstance->getScriptDebugger()->deleteCallback( id );
+    }
+  };
+
   mLua["trap"] = trap;
   mLua["brk"] = trap;
 
@@ -382,6 +425,8 @@ void Manager::machineReset()
   mInstance.reset();
 
   mScriptDebuggerEscapes = std::make_shared<ScriptDebuggerEscapes>();
+  mDebugSnapshots->discardEdits();
+  mDebugSnapshots->request();
 
   if ( auto input = computeInputFile() )
   {
@@ -392,6 +437,8 @@ void Manager::machineReset()
 
     if ( !mLogPath.empty() )
       mInstance->setLog( mLogPath );
+    else if ( gConfigProvider.sysConfig()->fastBoot )
+      mInstance->enableFastBoot();
   }
   else
   {
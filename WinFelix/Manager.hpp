@@ -8,6 +8,7 @@
 #include "MemEditor.hpp"
 #include "DisasmEditor.h"
 #include "Monitor.hpp"
+#include "LuaProxies.hpp"
 #include "sol/sol.hpp"
 
 class WinAudioOut;
@@ -24,6 +25,7 @@ class ImageROM;
 struct ImGuiIO;
 class IRenderer;
 class ISystemDriver;
+class DebugSnapshots;
 
 class Manager
 {
@@ -50,12 +52,6 @@ private:
   static std::shared_ptr<ImageROM const> getOptionalBootROM();
 private:
 
-  friend struct RamProxy;
-  friend struct RomProxy;
-  friend struct MikeyProxy;
-  friend struct SuzyProxy;
-  friend struct CPUProxy;
-  friend struct SymbolProxy;
   friend class UI;
   friend class CPUEditor;
   friend class MemEditor;
@@ -92,6 +88,11 @@ private:
   std::unique_ptr<SymbolSource> mSymbols;
   std::shared_ptr<Core> mInstance;
   std::shared_ptr<ScriptDebuggerEscapes> mScriptDebuggerEscapes;
+  LuaContext mLuaContext;
+  //written by emulation thread and read by debug windows without locking
+  std::shared_ptr<DebugSnapshots> mDebugSnapshots;
+  //emulation thread owned
+  uint64_t mDebugSnapshotTick;
   std::shared_ptr<ImageProperties> mImageProperties;
   std::filesystem::path mArg;
   std::filesystem::path mLogPath;
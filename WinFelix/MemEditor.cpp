@@ -4,6 +4,7 @@
 #include "Debugger.hpp"
 #include "ConfigProvider.hpp"
 #include "SysConfig.hpp"
+#include "DebugSnapshot.hpp"
 
 //TODO: get rid of the below global used for the write callback.
 MemEditor* gActiveMemEditor;
@@ -71,7 +72,7 @@ void MemEditor::drawContents()
     return;
   }
 
-  auto ram = mManager->mInstance->debugRAM();
+  auto ram = mManager->mDebugSnapshots->currentSnapshot().ram.data();
 
   mMemoryEditor.ReadOnly = isReadOnly();
 
@@ -80,5 +81,8 @@ void MemEditor::drawContents()
 
 void MemEditor::writeChanges( uint16_t offset, ImU8 data )
 {
-    mManager->mInstance->debugWriteRAM( offset, data );
+    mManager->mDebugSnapshots->edit( [=]( Core& core )
+    {
+      core.debugWriteRAM( offset, data );
+    } );
 }
\ No newline at end of file
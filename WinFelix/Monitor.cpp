@@ -1,14 +1,18 @@
 #include "Monitor.hpp"
-#include "Core.hpp"
+#include "DebugSnapshot.hpp"
 
 void Monitor::addEntry( Entry entry )
 {
   mEntries.push_back( std::move( entry ) );
 }
 
-cppcoro::generator<std::string_view> Monitor::sample( Core const& core )
+cppcoro::generator<std::string_view> Monitor::sample( DebugSnapshot const& snapshot )
 {
   char buf[128];
+  auto read = [&]( int address )
+  {
+    return snapshot.ram[( uint16_t )address];
+  };
 
   for ( auto const& e : mEntries )
   {
@@ -29,7 +33,7 @@ cppcoro::generator<std::string_view> Monitor::sample( Core const& core )
       pBuf += sprintf( pBuf, "%s: $", e.name.c_str() );
       for ( int i = 0; i < e.size; ++i )
       {
-        uint32_t value = core.debugReadRAM( e.address + i );
+        uint32_t value = read( e.address + i );
         pBuf += sprintf( pBuf, "%02x", value );
       }
       co_yield std::string_view{ buf, (size_t)( pBuf - buf ) };
@@ -39,34 +43,34 @@ cppcoro::generator<std::string_view> Monitor::sample( Core const& core )
       {
       case 1:
       {
-        uint32_t value = core.debugReadRAM( e.address );
+        uint32_t value = read( e.address );
         pBuf += sprintf( pBuf, "%s: %u", e.name.c_str(), value );
         co_yield std::string_view{ buf, ( size_t )( pBuf - buf ) };
         break;
       }
       case 2:
       {
-        uint32_t value = core.debugReadRAM( e.address );
-        value |= ( uint64_t )core.debugReadRAM( e.address + 1 ) << 8;
+        uint32_t value = read( e.address );
+        value |= ( uint64_t )read( e.address + 1 ) << 8;
         pBuf += sprintf( pBuf, "%s: %u", e.name.c_str(), value );
         co_yield std::string_view{ buf, ( size_t )( pBuf - buf ) };
         break;
       }
       case 3:
       {
-        uint32_t value = core.debugReadRAM( e.address );
-        value |= ( uint64_t )core.debugReadRAM( e.address + 1 ) << 8;
-        value |= ( uint64_t )core.debugReadRAM( e.address + 2 ) << 16;
+        uint32_t value = read( e.address );
+        value |= ( uint64_t )read( e.address + 1 ) << 8;
+        value |= ( uint64_t )read( e.address + 2 ) << 16;
         pBuf += sprintf( pBuf, "%s: %u", e.name.c_str(), value );
         co_yield std::string_view{ buf, ( size_t )( pBuf - buf ) };
         break;
       }
       case 4:
       {
-        uint32_t value = core.debugReadRAM( e.address );
-        value |= ( uint64_t )core.debugReadRAM( e.address + 1 ) << 8;
-        value |= ( uint64_t )core.debugReadRAM( e.address + 2 ) << 16;
-        value |= ( uint64_t )core.debugReadRAM( e.address + 3 ) << 24;
+        uint32_t value = read( e.address );
+        value |= ( uint64_t )read( e.address + 1 ) << 8;
+        value |= ( uint64_t )read( e.address + 2 ) << 16;
+        value |= ( uint64_t )read( e.address + 3 ) << 24;
         pBuf += sprintf( pBuf, "%s: %u", e.name.c_str(), value );
         co_yield std::string_view{ buf, ( size_t )( pBuf - buf ) };
         break;
@@ -80,25 +84,25 @@ cppcoro::generator<std::string_view> Monitor::sample( Core const& core )
       {
       case 1:
       {
-        int8_t value = core.debugReadRAM( e.address );
+        int8_t value = read( e.address );
         pBuf += sprintf( pBuf, "%s: %hhd", e.name.c_str(), value );
         co_yield std::string_view{ buf, ( size_t )( pBuf - buf ) };
         break;
       }
       case 2:
       {
-        int16_t value = core.debugReadRAM( e.address );
-        value |= ( int16_t )core.debugReadRAM( e.address + 1 ) << 8;
+        int16_t value = read( e.address );
+        value |= ( int16_t )read( e.address + 1 ) << 8;
         pBuf += sprintf( pBuf, "%s: %hd", e.name.c_str(), value );
         co_yield std::string_view{ buf, ( size_t )( pBuf - buf ) };
         break;
       }
       case 4:
       {
-        int32_t value = core.debugReadRAM( e.address );
-        value |= ( int32_t )core.debugReadRAM( e.address + 1 ) << 8;
-        value |= ( int32_t )core.debugReadRAM( e.address + 2 ) << 16;
-        value |= ( int32_t )core.debugReadRAM( e.address + 3 ) << 24;
+        int32_t value = read( e.address );
+        value |= ( int32_t )read( e.address + 1 ) << 8;
+        value |= ( int32_t )read( e.address + 2 ) << 16;
+        value |= ( int32_t )read( e.address + 3 ) << 24;
         pBuf += sprintf( pBuf, "%s: %d", e.name.c_str(), value );
         co_yield std::string_view{ buf, ( size_t )( pBuf - buf ) };
         break;
@@ -3,7 +3,7 @@
 #include "generator.hpp"
 
 class SymbolSource;
-class Core;
+struct DebugSnapshot;
 
 class Monitor
 {
@@ -23,7 +23,7 @@ public:
     uint16_t size = {};
   };
 
-  cppcoro::generator<std::string_view> sample( Core const& core );
+  cppcoro::generator<std::string_view> sample( DebugSnapshot const& snapshot );
 
   void addEntry( Entry entry );
 
@@ -34,6 +34,7 @@ void SysConfig::serialize( std::filesystem::path path )
   fout << "\theight = " << mainWindow.height << ";\n";
   fout << "};\n";
   fout << "singleInstance = " << ( singleInstance ? "true;\n" : "false;\n" );
+  fout << "fastBoot = " << ( fastBoot ? "true;\n" : "false;\n" );
   fout << "bootROM = {\n";
   fout << "\tuseExternal = " << ( bootROM.useExternal ? "true;\n" : "false;\n" );
   fout << "\tpath = " << bootROM.path << ";\n";
@@ -96,6 +97,7 @@ SysConfig::SysConfig( sol::state const& lua )
   mainWindow.width = lua["mainWindow"]["width"].get_or( mainWindow.width );
   mainWindow.height = lua["mainWindow"]["height"].get_or( mainWindow.height );
   singleInstance = lua["singleInstance"].get_or( singleInstance );
+  fastBoot = lua["fastBoot"].get_or( fastBoot );
   bootROM.useExternal = lua["bootROM"]["useExternal"].get_or( bootROM.useExternal );
   bootROM.path = lua["bootROM"]["path"].get_or<std::string>( {} );
   keyMapping.pause = lua["keyMapping"]["pause"].get_or( keyMapping.pause );
@@ -12,6 +12,8 @@ struct SysConfig
     int height = 630;
   } mainWindow;
   bool singleInstance = false;
+  //copies cartridge loader loops in bulk, not cycle exact
+  bool fastBoot = false;
   struct BootROM
   {
     bool useExternal = false;
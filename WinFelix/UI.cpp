@@ -10,6 +10,7 @@
 #include "Core.hpp"
 #include "CPU.hpp"
 #include "SysConfig.hpp"
+#include "DebugSnapshot.hpp"
 
 UI::UI( Manager& manager ) :
   mManager{ manager },
@@ -365,6 +366,7 @@ bool UI::mainMenu( ImGuiIO& io )
       }
 
       ImGui::Checkbox( "Single emulator instance", &sysConfig->singleInstance );
+      ImGui::Checkbox( "Fast boot (applies on reset)", &sysConfig->fastBoot );
       ImGui::EndMenu();
     }
 
@@ -547,12 +549,30 @@ void UI::drawDebugWindows( ImGuiIO& io )
 
   if ( debugMode )
   {
+    //all windows show the same snapshot during the frame
+    mManager.mDebugSnapshots->nextSnapshot();
+    auto const& snapshot = mManager.mDebugSnapshots->currentSnapshot();
+
+    auto svs = mManager.mDebugger.screenViews();
+    auto& csvs = mManager.mDebugWindows.customScreenViews;
+    //removing elements in csvs that are not in svs 
+    auto ret = std::ranges::remove_if( csvs, [&] ( int id ) { return std::ranges::find( svs, id, &ScreenView::id ) == svs.end(); }, [] ( auto const& p ) { return p.first; } );
+    csvs.erase( ret.begin(), ret.end() );
+    //add missing elements to csvs that are in svs
+    for ( auto const& sv : svs )
+    {
+      if ( std::ranges::find( csvs, sv.id, [] ( auto const& p ) { return p.first; } ) == csvs.end() )
+      {
+        csvs.emplace_back( sv.id, mManager.mRenderer->makeCustomScreenView() );
+      }
+    }
+
     ImGui::PushStyleVar( ImGuiStyleVar_WindowPadding, ImVec2{ 2.0f, 2.0f } );
 
     if ( mManager.mDebugger.showMonitor )
     {
       ImGui::Begin( "Monitor", &mManager.mDebugger.showMonitor );
-      for ( auto sv : mManager.mMonitor.sample( *mManager.mInstance ) )
+      for ( auto sv : mManager.mMonitor.sample( snapshot ) )
         ImGui::Text( sv.data() );
       ImGui::End();
     }
@@ -603,33 +623,33 @@ void UI::drawDebugWindows( ImGuiIO& io )
         ImGui::BeginDisabled();
         if ( mManager.mInstance )
         {
-          uint16_t addr = mManager.mInstance->debugDispAdr();
+          uint16_t addr = snapshot.dispAdr;
           std::sprintf( buf, "%04x", addr );
-          data = std::span<uint8_t const>{ mManager.mInstance->debugRAM() + addr, ROW_BYTES * SCREEN_HEIGHT };
+          data = std::span<uint8_t const>{ snapshot.ram.data() + addr, ROW_BYTES * SCREEN_HEIGHT };
           if ( !sv.safePalette )
-            palette = mManager.mInstance->debugPalette();
+            palette = snapshot.palette;
         }
         break;
       case ScreenViewType::VIDBAS:
         ImGui::BeginDisabled();
         if ( mManager.mInstance )
         {
-          uint16_t addr = mManager.mInstance->debugVidBas();
+          uint16_t addr = snapshot.vidBas;
           std::sprintf( buf, "%04x", addr );
-          data = std::span<uint8_t const>{ mManager.mInstance->debugRAM() + addr, ROW_BYTES * SCREEN_HEIGHT };
+          data = std::span<uint8_t const>{ snapshot.ram.data() + addr, ROW_BYTES * SCREEN_HEIGHT };
           if ( !sv.safePalette )
-            palette = mManager.mInstance->debugPalette();
+            palette = snapshot.palette;
         }
         break;
       case ScreenViewType::COLLBAS:
         ImGui::BeginDisabled();
         if ( mManager.mInstance )
         {
-          uint16_t addr = mManager.mInstance->debugCollBas();
+          uint16_t addr = snapshot.collBas;
           std::sprintf( buf, "%04x", addr );
-          data = std::span<uint8_t const>{ mManager.mInstance->debugRAM() + addr, ROW_BYTES * SCREEN_HEIGHT };
+          data = std::span<uint8_t const>{ snapshot.ram.data() + addr, ROW_BYTES * SCREEN_HEIGHT };
           if ( !sv.safePalette )
-            palette = mManager.mInstance->debugPalette();
+            palette = snapshot.palette;
         }
         break;
       default:  //ScreenViewType::CUSTOM:
@@ -638,9 +658,9 @@ void UI::drawDebugWindows( ImGuiIO& io )
         {
           uint16_t addr = sv.customAddress;
           std::sprintf( buf, "%04x", sv.customAddress );
-          data = std::span<uint8_t const>{ mManager.mInstance->debugRAM() + sv.customAddress, ROW_BYTES * SCREEN_HEIGHT };
+          data = std::span<uint8_t const>{ snapshot.ram.data() + sv.customAddress, ROW_BYTES * SCREEN_HEIGHT };
           if ( !sv.safePalette )
-            palette = mManager.mInstance->debugPalette();
+            palette = snapshot.palette;
         }
         break;
       }
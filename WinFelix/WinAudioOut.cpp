@@ -1,10 +1,10 @@
 #include "WinAudioOut.hpp"
-#include "Core.hpp"
+#include "AudioSink.hpp"
 #include "Log.hpp"
 #include "ConfigProvider.hpp"
 #include "SysConfig.hpp"
 
-WinAudioOut::WinAudioOut() : mWav{}, mNormalizer{ 1.0f / 32768.0f }, mMutex{}
+WinAudioOut::WinAudioOut() : mEvent{}, mMixFormat{}, mWav{}, mMutex{}, mNormalizer{ 1.0f / 32768.0f }, mStop{}
 {
   CoInitializeEx( NULL, COINIT_MULTITHREADED );
 
@@ -39,7 +39,7 @@ WinAudioOut::WinAudioOut() : mWav{}, mNormalizer{ 1.0f / 32768.0f }, mMutex{}
   if ( mEvent == NULL )
     throw std::exception{};
 
-  mAudioClient->SetEventHandle( mEvent );
+  hr = mAudioClient->SetEventHandle( mEvent );
   if ( FAILED( hr ) )
     throw std::exception{};
 
@@ -53,31 +53,27 @@ WinAudioOut::WinAudioOut() : mWav{}, mNormalizer{ 1.0f / 32768.0f }, mMutex{}
   if ( FAILED( hr ) )
     throw std::exception{};
 
-  hr = mAudioClient->GetService( __uuidof( IAudioClock ), reinterpret_cast<void**>( mAudioClock.ReleaseAndGetAddressOf() ) );
-  if ( FAILED( hr ) )
-    throw std::exception{};
+  //Device takes up to a buffer at once and emulation thread renders in chunks as coarse as its sleep granularity,
+  //so ring is kept at two buffers
+  mRing = std::make_unique<RingAudioSink>( ( int )mMixFormat->nSamplesPerSec, 2 * ( size_t )mBufferSize );
 
-  //bytes per second
-  uint64_t frequency;
-  hr = mAudioClock->GetFrequency( &frequency );
-  if ( FAILED( hr ) )
-    throw std::exception{};
-
-  LARGE_INTEGER l;
-  QueryPerformanceFrequency( &l );
-
-  mTimeToSamples = (double)frequency / (double)(l.QuadPart * mMixFormat->nBlockAlign);
-
-  mSamplesDelta = mSamplesDeltaDelta = 0;
+  auto sysConfig = gConfigProvider.sysConfig();
+  mute( sysConfig->audio.mute );
 
   mAudioClient->Start();
 
-  auto sysConfig = gConfigProvider.sysConfig();
-  mute( sysConfig->audio.mute );
+  mDeviceThread = std::thread{ [this]
+  {
+    deviceLoop();
+  } };
 }
 
 WinAudioOut::~WinAudioOut()
 {
+  mStop.store( true );
+  if ( mDeviceThread.joinable() )
+    mDeviceThread.join();
+
   mAudioClient->Stop();
 
   if ( mEvent )
@@ -94,45 +90,50 @@ WinAudioOut::~WinAudioOut()
     mMixFormat = nullptr;
   }
 
-  if ( mWav )
   {
-    wav_close( mWav );
-    mWav = nullptr;
+    std::unique_lock lock{ mMutex };
+    mWav.reset();
   }
 
   auto sysConfig = gConfigProvider.sysConfig();
   sysConfig->audio.mute = mute();
 }
 
-void WinAudioOut::setWavOut( std::filesystem::path path )
+int WinAudioOut::rate() const
+{
+  return mRing->rate();
+}
+
+size_t WinAudioOut::space() const
 {
+  return mRing->space();
+}
+
+void WinAudioOut::push( std::span<AudioSample const> samples )
+{
+  mRing->push( samples );
+
   std::unique_lock lock{ mMutex };
-  if ( path.empty() )
-  {
-    if ( mWav )
-    {
-      wav_close( mWav );
-      mWav = nullptr;
-    }
-    return;
-  }
+  if ( mWav )
+    mWav->push( samples );
+}
 
-  mWav = wav_open( path.string().c_str(), WAV_OPEN_WRITE );
-  if ( wav_err()->code != WAV_OK )
+void WinAudioOut::setWavOut( std::filesystem::path path )
+{
+  std::unique_ptr<WavAudioSink> wav;
+  if ( !path.empty() )
   {
-    L_ERROR << "Error opening wav file " << path.string() << ": " << wav_err()->message;
-    if ( mWav )
+    //wav is written at nominal rate, rate control corrections are inaudible
+    wav = std::make_unique<WavAudioSink>( path, ( int )mMixFormat->nSamplesPerSec );
+    if ( !wav->good() )
     {
-      wav_close( mWav );
-      mWav = nullptr;
+      L_ERROR << "Error opening wav file " << path.string();
+      wav.reset();
     }
-    return;
   }
 
-  wav_set_format( mWav, WAV_FORMAT_IEEE_FLOAT );
-  wav_set_num_channels( mWav, mMixFormat->nChannels );
-  wav_set_sample_rate( mWav, mMixFormat->nSamplesPerSec );
-  wav_set_sample_size( mWav, sizeof(float) );
+  std::unique_lock lock{ mMutex };
+  std::swap( mWav, wav );
 }
 
 bool WinAudioOut::isWavOut() const
@@ -143,59 +144,53 @@ bool WinAudioOut::isWavOut() const
 
 void WinAudioOut::mute( bool value )
 {
-  mNormalizer = value ? 0.0f : 1 / 32768.0f;
+  mNormalizer.store( value ? 0.0f : 1 / 32768.0f );
 }
 
 bool WinAudioOut::mute() const
 {
-  return mNormalizer == 0;
+  return mNormalizer.load() == 0;
 }
 
-bool WinAudioOut::wait()
+void WinAudioOut::deviceLoop()
 {
-  DWORD retval = WaitForSingleObject( mEvent, 100 );
-  return retval == WAIT_OBJECT_0;
+  CoInitializeEx( NULL, COINIT_MULTITHREADED );
+
+  while ( !mStop.load() )
+  {
+    if ( WaitForSingleObject( mEvent, 100 ) == WAIT_OBJECT_0 )
+      fillBuffer();
+  }
+
+  CoUninitialize();
 }
 
-CpuBreakType WinAudioOut::fillBuffer( std::shared_ptr<Core> instance, int64_t renderingTimeQPC, RunMode runMode )
+void WinAudioOut::fillBuffer()
 {
   HRESULT hr;
   uint32_t padding{};
   hr = mAudioClient->GetCurrentPadding( &padding );
+  if ( FAILED( hr ) )
+    return;
   uint32_t framesAvailable = mBufferSize - padding;
 
   if ( framesAvailable > 0 )
   {
-    if ( !instance )
-      return CpuBreakType::NEXT;
-
-    auto cpuBreakType = instance->advanceAudio( mMixFormat->nSamplesPerSec, std::span<AudioSample>{ mSamplesBuffer.data(), framesAvailable }, runMode );
+    std::span<AudioSample> samples{ mSamplesBuffer.data(), framesAvailable };
+    mRing->pull( samples );
 
     BYTE *pData;
     hr = mRenderClient->GetBuffer( framesAvailable, &pData );
     if ( FAILED( hr ) )
-      return CpuBreakType::NEXT;
+      return;
+    float const normalizer = mNormalizer.load();
     float* pfData = reinterpret_cast<float*>( pData );
     for ( uint32_t i = 0; i < framesAvailable; ++i )
     {
-      pfData[i * mMixFormat->nChannels + 0] = mSamplesBuffer[i].left * mNormalizer;
-      pfData[i * mMixFormat->nChannels + 1] = mSamplesBuffer[i].right * mNormalizer;
-    }
-
-    {
-      std::unique_lock lock{ mMutex };
-      if ( mWav )
-        wav_write( mWav, pfData, framesAvailable );
+      pfData[i * mMixFormat->nChannels + 0] = samples[i].left * normalizer;
+      pfData[i * mMixFormat->nChannels + 1] = samples[i].right * normalizer;
     }
 
     hr = mRenderClient->ReleaseBuffer( framesAvailable, 0 );
-
-    return cpuBreakType;
   }
-
-  return CpuBreakType::NEXT;
 }
-
-
-
-
@@ -1,42 +1,50 @@
 #pragma once
 
 #include "Utility.hpp"
-#include "wav.h"
+#include "IAudioSink.hpp"
 
-class Core;
+class RingAudioSink;
+class WavAudioSink;
 
-class WinAudioOut
+//Audio sink played by WASAPI. Emulation thread pushes samples into a lock-free ring that
+//own device thread drains whenever audio client asks for more, so emulation never runs inside device event wait.
+class WinAudioOut : public IAudioSink
 {
 public:
 
   WinAudioOut();
-  ~WinAudioOut();
+  ~WinAudioOut() override;
+
+  //emulation thread side
+  int rate() const override;
+  size_t space() const override;
+  void push( std::span<AudioSample const> samples ) override;
 
-  bool wait();
-  CpuBreakType fillBuffer( std::shared_ptr<Core> instance, int64_t renderingTime, RunMode runMode );
   void setWavOut( std::filesystem::path path );
   bool isWavOut() const;
   void mute( bool value );
   bool mute() const;
 
 private:
+  void deviceLoop();
+  void fillBuffer();
 
   ComPtr<IMMDevice> mDevice;
   ComPtr<IAudioClient> mAudioClient;
-  ComPtr<IAudioClock> mAudioClock;
   ComPtr<IAudioRenderClient> mRenderClient;
-  WavFile* mWav;
   HANDLE mEvent;
-  mutable std::mutex mMutex;
-
-  double mTimeToSamples;
 
   uint32_t mBufferSize;
   std::vector<AudioSample> mSamplesBuffer;
 
   WAVEFORMATEX * mMixFormat;
-  int32_t mSamplesDelta;
-  int32_t mSamplesDeltaDelta;
 
-  float mNormalizer;
+  std::unique_ptr<RingAudioSink> mRing;
+  //wav capture is written by emulation thread and swapped by UI
+  std::unique_ptr<WavAudioSink> mWav;
+  mutable std::mutex mMutex;
+
+  std::atomic<float> mNormalizer;
+  std::atomic_bool mStop;
+  std::thread mDeviceThread;
 };
@@ -1,8 +1,10 @@
 #include "AudioChannel.hpp"
+#include "AudioSynth.hpp"
 #include "TimerCore.hpp"
 #include "Utility.hpp"
 
-AudioChannel::AudioChannel( TimerCore& timer ) : mTimer{ timer }, mChangeCycle{}, mShiftRegisterBackup{}, mShiftRegister{}, mTapSelector{}, mParity{ ~0u }, mEnableIntegrate{}, mVolume{}, mOutput{}, mOldOutput{}
+AudioChannel::AudioChannel( TimerCore& timers, int timer, AudioSynth& synth ) : mTimers{ timers }, mTimer{ timer }, mSynth{ synth }, mChangeCycle{}, mShiftRegisterBackup{}, mShiftRegister{}, mTapSelector{}, mParity{ ~0u }, mEnableIntegrate{}, mVolume{},
+  mOutput{}, mOldOutput{}, mGainLeft{}, mGainRight{}, mJumpLow{}, mJumpHigh{}, mJumpTaps{ ~0u }
 {
 }
 
@@ -18,9 +20,9 @@ SequencedAction AudioChannel::setFeedback( uint8_t value )
   return {};
 }
 
-SequencedAction AudioChannel::setOutput( uint8_t value )
+SequencedAction AudioChannel::setOutput( uint64_t tick, uint8_t value )
 {
-  mOutput = (int8_t)value;
+  changeOutput( tick, (int8_t)value );
   return {};
 }
 
@@ -32,25 +34,25 @@ SequencedAction AudioChannel::setShift( uint8_t value )
 
 SequencedAction AudioChannel::setBackup( uint64_t tick, uint8_t value )
 {
-  return mTimer.setBackup( tick, value );
+  return mTimers.setBackup( mTimer, tick, value );
 }
 
 SequencedAction AudioChannel::setControl( uint64_t tick, uint8_t value )
 {
   mTapSelector = ( mTapSelector & 0b1111'0111'1111 ) | ( value & AUD_CONTROL::FEEDBACK_7 );
   mEnableIntegrate = ( value & AUD_CONTROL::ENABLE_INTEGRATE ) != 0;
-  return mTimer.setControlA( tick, value & ~( AUD_CONTROL::FEEDBACK_7 | AUD_CONTROL::ENABLE_INTEGRATE ) );
+  return mTimers.setControlA( mTimer, tick, value & ~( AUD_CONTROL::FEEDBACK_7 | AUD_CONTROL::ENABLE_INTEGRATE ) );
 }
 
 SequencedAction AudioChannel::setCounter( uint64_t tick, uint8_t value )
 {
-  return mTimer.setCount( tick, value );
+  return mTimers.setCount( mTimer, tick, value );
 }
 
 SequencedAction AudioChannel::setOther( uint64_t tick, uint8_t value )
 {
-  mShiftRegister = mShiftRegister & 0b0000'1111'1111 | ( ( (int)value & 0b1111'0000 ) << 4 );
-  return mTimer.setControlB( tick, value & 0b0000'1111 );
+  mShiftRegister = ( mShiftRegister & 0b0000'1111'1111 ) | ( ( (int)value & 0b1111'0000 ) << 4 );
+  return mTimers.setControlB( mTimer, tick, value & 0b0000'1111 );
 }
 
 int8_t AudioChannel::getVolume()
@@ -60,7 +62,7 @@ int8_t AudioChannel::getVolume()
 
 uint8_t AudioChannel::getFeedback()
 {
-  return mTapSelector & 0b0000'0011'1111 | ( ( mTapSelector & 0b1100'0000'0000 ) >> 10 );
+  return ( mTapSelector & 0b0000'0011'1111 ) | ( ( mTapSelector & 0b1100'0000'0000 ) >> 10 );
 }
 
 int8_t AudioChannel::getOutput()
@@ -75,12 +77,12 @@ uint8_t AudioChannel::getShift()
 
 uint8_t AudioChannel::getBackup( uint64_t tick )
 {
-  return mTimer.getBackup( tick );
+  return mTimers.getBackup( mTimer, tick );
 }
 
 uint8_t AudioChannel::getControl( uint64_t tick )
 {
-  auto result = mTimer.getControlA( tick ) & ~( AUD_CONTROL::FEEDBACK_7 | AUD_CONTROL::ENABLE_INTEGRATE );
+  auto result = mTimers.getControlA( mTimer, tick ) & ~( AUD_CONTROL::FEEDBACK_7 | AUD_CONTROL::ENABLE_INTEGRATE );
 
   return result |
     ( mTapSelector & 0b1000'0000 ) |
@@ -89,12 +91,12 @@ uint8_t AudioChannel::getControl( uint64_t tick )
 
 uint8_t AudioChannel::getCounter( uint64_t tick )
 {
-  return mTimer.getCount( tick );
+  return mTimers.getCount( mTimer, tick );
 }
 
 uint8_t AudioChannel::getOther( uint64_t tick )
 {
-  auto result = mTimer.getControlB( tick ) & 0b0000'1111;
+  auto result = mTimers.getControlB( mTimer, tick ) & 0b0000'1111;
 
   return result | ( ( mShiftRegister & 0b1111'0000'0000 ) >> 4 );
 }
@@ -109,10 +111,26 @@ float AudioChannel::sample( uint64_t tick ) const
   return mOutput; // std::lerp( mOldOutput, mOutput, sampleHelper( (uint32_t)( tick - mChangeCycle ) ) );
 }
 
+void AudioChannel::setGains( uint64_t tick, int left, int right )
+{
+  int const output = (int)mOutput;
+  mSynth.step( tick, output * ( left - mGainLeft ), output * ( right - mGainRight ) );
+  mGainLeft = left;
+  mGainRight = right;
+}
+
+void AudioChannel::changeOutput( uint64_t tick, float output )
+{
+  int const diff = (int)output - (int)mOutput;
+  mOutput = output;
+  if ( diff != 0 )
+    mSynth.step( tick, diff * mGainLeft, diff * mGainRight );
+}
+
 void AudioChannel::trigger( uint64_t tick )
 {
   uint32_t xorGate = mTapSelector & mShiftRegister;
-  uint32_t parity = std::popcount( xorGate ) & 1 ^ 1;
+  uint32_t parity = ( std::popcount( xorGate ) & 1 ) ^ 1;
   mShiftRegister = ( mShiftRegister << 1 ) | parity;
   int8_t vol = ( parity ? ~mVolume : mVolume );
 
@@ -121,7 +139,7 @@ void AudioChannel::trigger( uint64_t tick )
   {
     mOldOutput = mOutput;
     float temp = mOldOutput + vol;
-    mOutput = std::clamp( temp, (float)std::numeric_limits<int8_t>::min(), (float)std::numeric_limits<int8_t>::max() );
+    changeOutput( tick, std::clamp( temp, (float)std::numeric_limits<int8_t>::min(), (float)std::numeric_limits<int8_t>::max() ) );
   }
 
   if ( parity != mParity )
@@ -129,11 +147,95 @@ void AudioChannel::trigger( uint64_t tick )
     if ( !mEnableIntegrate )
     {
       mOldOutput = sample( tick );
-      mOutput = vol;
+      changeOutput( tick, vol );
     }
 
     mChangeCycle = tick;
     mParity = parity;
   }
+}
+
+void AudioChannel::sync( uint64_t tick )
+{
+  if ( !mTimers.lazy( mTimer ) )
+    return;
+
+  uint64_t const first = mTimers.nextUnderflow( mTimer );
+  uint64_t const period = mTimers.period( mTimer );
+  uint64_t const count = mTimers.skip( mTimer, tick );
+  if ( count == 0 )
+    return;
+
+  if ( mJumpTaps != mTapSelector )
+    updateJumpTable();
+
+  //Shifts are done 12 at a time with jump tables. The 12 new bits are the parities of the shifts, oldest in the highest bit.
+  //Output changes only where parity differs from the previous one, so only those underflows emit steps
+  uint32_t shiftRegister = mShiftRegister & 0xfff;
+  for ( uint64_t done = 0; done < count; )
+  {
+    int const shifts = (int)std::min<uint64_t>( 12, count - done );
+    if ( shifts == 12 )
+    {
+      shiftRegister = mJumpLow[shiftRegister & 63] ^ mJumpHigh[shiftRegister >> 6];
+    }
+    else
+    {
+      for ( int i = 0; i < shifts; ++i )
+      {
+        shiftRegister = ( ( shiftRegister << 1 ) | ( ( std::popcount( mTapSelector & shiftRegister ) & 1 ) ^ 1 ) ) & 0xfff;
+      }
+    }
+
+    uint32_t const mask = ( 1u << shifts ) - 1;
+    uint32_t const parities = shiftRegister & mask;
+    uint32_t changes = ( parities ^ ( ( ( ( mParity & 1 ) << shifts ) | parities ) >> 1 ) ) & mask;
+    if ( mParity > 1 )
+      changes |= 1u << ( shifts - 1 );
+
+    while ( changes != 0 )
+    {
+      int const bit = std::bit_width( changes ) - 1;
+      changes &= ~( 1u << bit );
+      uint64_t const underflow = first + ( done + shifts - 1 - bit ) * period;
+      mOldOutput = mOutput;
+      changeOutput( underflow, (int8_t)( ( ( parities >> bit ) & 1 ) ? ~mVolume : mVolume ) );
+      mChangeCycle = underflow;
+    }
+
+    mParity = parities & 1;
+    done += shifts;
+  }
+
+  mShiftRegister = shiftRegister;
+}
 
+SequencedAction AudioChannel::updateLazy( bool nextLinked )
+{
+  return mTimers.setLazy( mTimer, mTimers.periodic( mTimer ) && !mEnableIntegrate && !nextLinked );
+}
+
+void AudioChannel::updateJumpTable()
+{
+  auto shift12 = [this]( uint32_t shiftRegister )
+  {
+    for ( int i = 0; i < 12; ++i )
+    {
+      shiftRegister = ( ( shiftRegister << 1 ) | ( ( std::popcount( mTapSelector & shiftRegister ) & 1 ) ^ 1 ) ) & 0xfff;
+    }
+    return shiftRegister;
+  };
+
+  //shifting is linear apart from the inverted feedback, so 12 shifts of a register are
+  //the xor of 12 shifts of its single bits without the inversion and 12 shifts of zero
+  uint32_t const zero = shift12( 0 );
+  mJumpLow[0] = (uint16_t)zero;
+  mJumpHigh[0] = 0;
+  for ( uint32_t i = 1; i < 64; ++i )
+  {
+    int const bit = std::countr_zero( i );
+    mJumpLow[i] = (uint16_t)( mJumpLow[i & ( i - 1 )] ^ shift12( 1u << bit ) ^ zero );
+    mJumpHigh[i] = (uint16_t)( mJumpHigh[i & ( i - 1 )] ^ shift12( 1u << ( bit + 6 ) ) ^ zero );
+  }
+  mJumpTaps = mTapSelector;
 }
@@ -3,15 +3,16 @@
 #include "ActionQueue.hpp"
 
 class TimerCore;
+class AudioSynth;
 
 class AudioChannel
 {
 public:
-  AudioChannel( TimerCore & timer );
+  AudioChannel( TimerCore & timers, int timer, AudioSynth & synth );
 
   SequencedAction setVolume( int8_t );
   SequencedAction setFeedback( uint8_t );
-  SequencedAction setOutput( uint8_t );
+  SequencedAction setOutput( uint64_t tick, uint8_t );
   SequencedAction setShift( uint8_t );
   SequencedAction setBackup( uint64_t tick, uint8_t );
   SequencedAction setControl( uint64_t tick, uint8_t );
@@ -29,10 +30,23 @@ public:
 
   float sample( uint64_t tick ) const;
 
+  //sets contribution of channel output to left and right output
+  void setGains( uint64_t tick, int left, int right );
+
   void trigger( uint64_t tick );
 
+  //Runs underflows of lazily evaluated timer up to given tick.
+  //Must be called before any access to the channel or its timer
+  void sync( uint64_t tick );
+  //Timer is evaluated lazily when it is periodic, output is not integrated and next timer does not count its borrows.
+  //Returns action of next underflow when leaving lazy evaluation
+  SequencedAction updateLazy( bool nextLinked );
+
 private:
   static float sampleHelper( uint32_t diff );
+  void changeOutput( uint64_t tick, float output );
+  //builds tables of shift register after 12 shifts for current taps
+  void updateJumpTable();
 
 private:
   struct AUD_CONTROL
@@ -53,7 +67,9 @@ private:
   };
 
 private:
-  TimerCore & mTimer;
+  TimerCore & mTimers;
+  int const mTimer;
+  AudioSynth & mSynth;
   uint64_t mChangeCycle;
 
   uint32_t mShiftRegisterBackup;
@@ -65,5 +81,13 @@ private:
   int8_t mVolume;
   float mOutput;
   float mOldOutput;
+  int mGainLeft;
+  int mGainRight;
+
+  //shift register after 12 shifts is mJumpLow[reg & 63] ^ mJumpHigh[reg >> 6]
+  std::array<uint16_t, 64> mJumpLow;
+  std::array<uint16_t, 64> mJumpHigh;
+  //taps of jump tables
+  uint32_t mJumpTaps;
 };
 
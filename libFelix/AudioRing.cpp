@@ -0,0 +1,50 @@
+#include "AudioRing.hpp"
+
+AudioRing::AudioRing( size_t capacity ) : mSamples( std::bit_ceil( std::max<size_t>( capacity, 1 ) ) ), mMask{ mSamples.size() - 1 }, mWritePos{}, mReadPos{}
+{
+}
+
+size_t AudioRing::write( std::span<AudioSample const> samples )
+{
+  uint64_t const writePos = mWritePos.load( std::memory_order_relaxed );
+  uint64_t const readPos = mReadPos.load( std::memory_order_acquire );
+  size_t const count = std::min<size_t>( samples.size(), mSamples.size() - ( size_t )( writePos - readPos ) );
+
+  size_t const offset = ( size_t )( writePos & mMask );
+  size_t const first = std::min( count, mSamples.size() - offset );
+  std::copy_n( samples.data(), first, mSamples.data() + offset );
+  std::copy_n( samples.data() + first, count - first, mSamples.data() );
+
+  mWritePos.store( writePos + count, std::memory_order_release );
+  return count;
+}
+
+size_t AudioRing::read( std::span<AudioSample> out )
+{
+  uint64_t const readPos = mReadPos.load( std::memory_order_relaxed );
+  uint64_t const writePos = mWritePos.load( std::memory_order_acquire );
+  size_t const count = std::min<size_t>( out.size(), ( size_t )( writePos - readPos ) );
+
+  size_t const offset = ( size_t )( readPos & mMask );
+  size_t const first = std::min( count, mSamples.size() - offset );
+  std::copy_n( mSamples.data() + offset, first, out.data() );
+  std::copy_n( mSamples.data(), count - first, out.data() + first );
+
+  mReadPos.store( readPos + count, std::memory_order_release );
+  return count;
+}
+
+size_t AudioRing::size() const
+{
+  return ( size_t )( mWritePos.load( std::memory_order_acquire ) - mReadPos.load( std::memory_order_acquire ) );
+}
+
+size_t AudioRing::space() const
+{
+  return mSamples.size() - size();
+}
+
+size_t AudioRing::capacity() const
+{
+  return mSamples.size();
+}
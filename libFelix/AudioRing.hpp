@@ -0,0 +1,29 @@
+#pragma once
+#include "Utility.hpp"
+
+//Lock-free ring buffer of audio samples between one producer thread and one consumer thread.
+//Capacity is a power of two. Positions only grow and are wrapped on access, so full and empty are told apart.
+class AudioRing
+{
+public:
+  //capacity is rounded up to a power of two
+  explicit AudioRing( size_t capacity );
+
+  //Producer side. Writes as many samples as fit and returns their count
+  size_t write( std::span<AudioSample const> samples );
+  //Consumer side. Reads up to out.size() samples and returns their count
+  size_t read( std::span<AudioSample> out );
+
+  //Samples waiting for the consumer. Called from producer or consumer side, the other side may change it concurrently
+  size_t size() const;
+  size_t space() const;
+  size_t capacity() const;
+
+private:
+  std::vector<AudioSample> mSamples;
+  uint64_t const mMask;
+  //written by producer
+  alignas( 64 ) std::atomic<uint64_t> mWritePos;
+  //written by consumer
+  alignas( 64 ) std::atomic<uint64_t> mReadPos;
+};
@@ -0,0 +1,180 @@
+#include "AudioSink.hpp"
+
+static_assert( std::endian::native == std::endian::little, "WAV samples are written as they are in memory" );
+
+NullAudioSink::NullAudioSink( int sps ) : mSPS{ sps }, mSamples{}
+{
+}
+
+int NullAudioSink::rate() const
+{
+  return mSPS;
+}
+
+size_t NullAudioSink::space() const
+{
+  return std::numeric_limits<size_t>::max();
+}
+
+void NullAudioSink::push( std::span<AudioSample const> samples )
+{
+  mSamples += samples.size();
+}
+
+uint64_t NullAudioSink::samples() const
+{
+  return mSamples;
+}
+
+WavAudioSink::WavAudioSink( std::filesystem::path const& path, int sps ) : mFile{ path, std::ios::binary }, mSPS{ sps }, mSamples{}
+{
+  writeHeader();
+}
+
+WavAudioSink::~WavAudioSink()
+{
+  writeHeader();
+}
+
+int WavAudioSink::rate() const
+{
+  return mSPS;
+}
+
+size_t WavAudioSink::space() const
+{
+  return std::numeric_limits<size_t>::max();
+}
+
+void WavAudioSink::push( std::span<AudioSample const> samples )
+{
+  mFile.write( ( char const* )samples.data(), samples.size() * sizeof( AudioSample ) );
+  mSamples += samples.size();
+}
+
+bool WavAudioSink::good() const
+{
+  return mFile.good();
+}
+
+void WavAudioSink::writeHeader()
+{
+  static constexpr uint32_t CHANNELS = 2;
+  static constexpr uint32_t BITS = 16;
+  static constexpr uint32_t BLOCK = CHANNELS * BITS / 8;
+
+  uint32_t const dataSize = ( uint32_t )std::min<uint64_t>( mSamples * BLOCK, std::numeric_limits<uint32_t>::max() - 36 );
+
+  std::array<uint8_t, 44> header{};
+  auto put = [&, pos = size_t{}]( std::string_view tag, uint32_t value, size_t size ) mutable
+  {
+    std::copy( tag.begin(), tag.end(), header.begin() + pos );
+    pos += tag.size();
+    for ( size_t i = 0; i < size; ++i )
+    {
+      header[pos++] = ( uint8_t )( value >> ( i * 8 ) );
+    }
+  };
+
+  put( "RIFF", 36 + dataSize, 4 );
+  put( "WAVEfmt ", 16, 4 );
+  put( "", 1, 2 );  //PCM
+  put( "", CHANNELS, 2 );
+  put( "", ( uint32_t )mSPS, 4 );
+  put( "", ( uint32_t )mSPS * BLOCK, 4 );
+  put( "", BLOCK, 2 );
+  put( "", BITS, 2 );
+  put( "data", dataSize, 4 );
+
+  auto const end = mFile.tellp();
+  mFile.seekp( 0 );
+  mFile.write( ( char const* )header.data(), header.size() );
+  if ( mSamples > 0 )
+    mFile.seekp( end );
+}
+
+RingAudioSink::RingAudioSink( int sps, size_t target ) : mRing{ 2 * target }, mSPS{ sps }, mTarget{ target }, mPriming{ true }, mUnderruns{}
+{
+}
+
+int RingAudioSink::rate() const
+{
+  //proportional control, ring below target gets more samples per second of emulation than consumer plays
+  double const error = ( ( double )mTarget - ( double )mRing.size() ) / ( double )mTarget;
+  double const delta = std::clamp( error * MAX_DELTA, -MAX_DELTA, MAX_DELTA );
+  return ( int )std::lround( mSPS * ( 1.0 + delta ) );
+}
+
+size_t RingAudioSink::space() const
+{
+  return mRing.space();
+}
+
+void RingAudioSink::push( std::span<AudioSample const> samples )
+{
+  //overflow only happens when producer ignores space and the rest is dropped
+  mRing.write( samples );
+}
+
+size_t RingAudioSink::pull( std::span<AudioSample> out )
+{
+  if ( mPriming )
+  {
+    if ( mRing.size() < mTarget )
+    {
+      std::ranges::fill( out, AudioSample{} );
+      return 0;
+    }
+    mPriming = false;
+  }
+
+  size_t const count = mRing.read( out );
+  if ( count < out.size() )
+  {
+    std::fill( out.begin() + count, out.end(), AudioSample{} );
+    mUnderruns += 1;
+    mPriming = true;
+  }
+
+  return count;
+}
+
+uint64_t RingAudioSink::underruns() const
+{
+  return mUnderruns;
+}
+
+size_t RingAudioSink::fill() const
+{
+  return mRing.size();
+}
+
+size_t RingAudioSink::target() const
+{
+  return mTarget;
+}
+
+AudioPacer::AudioPacer() : mLast{}, mFraction{}
+{
+}
+
+size_t AudioPacer::due( std::chrono::steady_clock::time_point now, int sps )
+{
+  if ( !mLast )
+  {
+    mLast = now;
+    return 0;
+  }
+
+  double const samples = std::chrono::duration<double>( now - *mLast ).count() * sps + mFraction;
+  mLast = now;
+  size_t const result = ( size_t )samples;
+  mFraction = samples - ( double )result;
+  return result;
+}
+
+void AudioPacer::reset()
+{
+  mLast.reset();
+  mFraction = 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "IAudioSink.hpp"
+#include "AudioRing.hpp"
+
+//Discards samples. Takes any amount at nominal rate
+class NullAudioSink : public IAudioSink
+{
+public:
+  explicit NullAudioSink( int sps );
+  ~NullAudioSink() override = default;
+
+  int rate() const override;
+  size_t space() const override;
+  void push( std::span<AudioSample const> samples ) override;
+
+  //samples pushed so far
+  uint64_t samples() const;
+
+private:
+  int const mSPS;
+  uint64_t mSamples;
+};
+
+//Writes samples to 16-bit stereo PCM WAV file. Takes any amount at nominal rate
+class WavAudioSink : public IAudioSink
+{
+public:
+  WavAudioSink( std::filesystem::path const& path, int sps );
+  ~WavAudioSink() override;
+
+  int rate() const override;
+  size_t space() const override;
+  void push( std::span<AudioSample const> samples ) override;
+
+  bool good() const;
+
+private:
+  //header is rewritten on close with final sizes
+  void writeHeader();
+
+  std::ofstream mFile;
+  int const mSPS;
+  uint64_t mSamples;
+};
+
+//Keeps samples in a lock-free ring for a consumer playing them on its own clock, e.g. audio device thread.
+//Rate follows ring fill to keep it at target against drift between emulation and consumer clocks.
+//Consumer waits until target fill is reached at start and after underrun, so playback starts with full latency margin.
+class RingAudioSink : public IAudioSink
+{
+public:
+  //maximal relative correction of rate
+  static constexpr double MAX_DELTA = 0.005;
+
+  RingAudioSink( int sps, size_t target );
+  ~RingAudioSink() override = default;
+
+  //producer side
+  int rate() const override;
+  size_t space() const override;
+  void push( std::span<AudioSample const> samples ) override;
+
+  //Consumer side. Fills out with samples, silence while waiting for target fill. Returns count of samples taken from ring
+  size_t pull( std::span<AudioSample> out );
+  //consumer side
+  uint64_t underruns() const;
+
+  size_t fill() const;
+  size_t target() const;
+
+private:
+  AudioRing mRing;
+  int const mSPS;
+  size_t const mTarget;
+  //consumer owned
+  bool mPriming;
+  uint64_t mUnderruns;
+};
+
+//Paces emulation thread by wall clock. Sinks bound the amount by space and correct drift of their clock by rate
+class AudioPacer
+{
+public:
+  AudioPacer();
+
+  //samples due at given rate since previous call. First call and calls after reset return none
+  size_t due( std::chrono::steady_clock::time_point now, int sps );
+  void reset();
+
+private:
+  std::optional<std::chrono::steady_clock::time_point> mLast;
+  double mFraction;
+};
@@ -0,0 +1,170 @@
+#include "AudioSynth.hpp"
+
+namespace
+{
+
+static constexpr int HALF_WIDTH = AudioSynth::HALF_WIDTH;
+static constexpr int PHASES = AudioSynth::PHASES;
+//fixed point of kernels and integrated output
+static constexpr int SCALE_BITS = 15;
+static constexpr uint64_t CLOCK = 16000000;
+
+using Kernels = std::array<std::array<int32_t, AudioSynth::WIDTH>, PHASES>;
+
+//Step response of Blackman windowed sinc with cutoff at 90% of Nyquist frequency.
+//Sampled in 1/PHASES of sample from -HALF_WIDTH to HALF_WIDTH and normalized to end at 1
+std::vector<double> stepResponse()
+{
+  static constexpr int SUBSTEPS = 16;
+  static constexpr double CUTOFF = 0.9;
+
+  auto impulse = []( double x )
+  {
+    double const sinc = x == 0.0 ? 1.0 : std::sin( std::numbers::pi * CUTOFF * x ) / ( std::numbers::pi * CUTOFF * x );
+    double const window = 0.42 + 0.5 * std::cos( std::numbers::pi * x / HALF_WIDTH ) + 0.08 * std::cos( 2.0 * std::numbers::pi * x / HALF_WIDTH );
+    return sinc * window;
+  };
+
+  std::vector<double> result( 2 * HALF_WIDTH * PHASES + 1 );
+  double const dx = 1.0 / ( PHASES * SUBSTEPS );
+  double sum = 0.0;
+  for ( size_t i = 1; i < result.size(); ++i )
+  {
+    for ( int s = 0; s < SUBSTEPS; ++s )
+    {
+      sum += impulse( -HALF_WIDTH + ( ( i - 1 ) * SUBSTEPS + s + 0.5 ) * dx ) * dx;
+    }
+    result[i] = sum;
+  }
+
+  for ( double& value : result )
+  {
+    value /= sum;
+  }
+
+  return result;
+}
+
+//Differences of step response between consecutive samples for each phase of step within a sample.
+//Response is quantized before taking differences, so each kernel sums exactly to 1 and steps do not accumulate errors
+Kernels makeKernels()
+{
+  auto const response = stepResponse();
+
+  auto quantized = [&]( int x ) -> int64_t
+  {
+    x += HALF_WIDTH * PHASES;
+    if ( x <= 0 )
+      return 0;
+    if ( x >= ( int )response.size() - 1 )
+      return 1 << SCALE_BITS;
+    return std::lround( response[x] * ( 1 << SCALE_BITS ) );
+  };
+
+  Kernels kernels;
+  for ( int phase = 0; phase < PHASES; ++phase )
+  {
+    for ( int i = 0; i < AudioSynth::WIDTH; ++i )
+    {
+      kernels[phase][i] = ( int32_t )( quantized( ( i + 1 - HALF_WIDTH ) * PHASES - phase ) - quantized( ( i - HALF_WIDTH ) * PHASES - phase ) );
+    }
+  }
+
+  return kernels;
+}
+
+Kernels const kernels = makeKernels();
+
+}
+
+AudioSynth::AudioSynth() : mDifferences{}, mTick0{}, mRendered{}, mSPS{}, mLevel{}, mIntegral{}
+{
+}
+
+void AudioSynth::step( uint64_t tick, int left, int right )
+{
+  mLevel.left += left;
+  mLevel.right += right;
+
+  if ( mSPS == 0 || ( left == 0 && right == 0 ) )
+    return;
+
+  uint64_t pos = position( tick );
+  //steps are never placed before samples already rendered
+  if ( pos < mRendered * PHASES )
+    pos = mRendered * PHASES;
+
+  //response starts one sample after the sample containing the step
+  size_t const offset = ( size_t )( pos / PHASES - mRendered ) + 1;
+  if ( mDifferences.size() < offset + WIDTH )
+    mDifferences.resize( offset + WIDTH, Difference{} );
+
+  auto const& kernel = kernels[pos % PHASES];
+  Difference* dst = mDifferences.data() + offset;
+  for ( int i = 0; i < WIDTH; ++i )
+  {
+    dst[i].left += ( int64_t )left * kernel[i];
+    dst[i].right += ( int64_t )right * kernel[i];
+  }
+}
+
+uint64_t AudioSynth::endTick( uint64_t tick, int sps, size_t samples )
+{
+  if ( mSPS == 0 )
+  {
+    mTick0 = tick;
+    mRendered = 0;
+    mDifferences.clear();
+    mIntegral = { mLevel.left << SCALE_BITS, mLevel.right << SCALE_BITS };
+  }
+  else if ( sps != mSPS )
+  {
+    //new rate starts where rendered samples end, so steps already added are kept
+    mTick0 += ( mRendered * CLOCK + mSPS - 1 ) / mSPS;
+    mRendered = 0;
+  }
+  mSPS = sps;
+
+  uint64_t const end = ( mRendered + samples ) * CLOCK;
+  return mTick0 + ( end + mSPS - 1 ) / mSPS;
+}
+
+size_t AudioSynth::render( uint64_t tick, std::span<AudioSample> out )
+{
+  if ( mSPS == 0 )
+    return 0;
+
+  uint64_t const complete = position( tick ) / PHASES;
+  size_t const count = ( size_t )std::min<uint64_t>( out.size(), complete > mRendered ? complete - mRendered : 0 );
+  if ( mDifferences.size() < count )
+    mDifferences.resize( count, Difference{} );
+
+  static constexpr int64_t HALF = 1 << ( SCALE_BITS - 1 );
+  for ( size_t i = 0; i < count; ++i )
+  {
+    mIntegral.left += mDifferences[i].left;
+    mIntegral.right += mDifferences[i].right;
+    out[i].left = ( int16_t )std::clamp<int64_t>( ( mIntegral.left + HALF ) >> SCALE_BITS, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max() );
+    out[i].right = ( int16_t )std::clamp<int64_t>( ( mIntegral.right + HALF ) >> SCALE_BITS, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max() );
+  }
+
+  mDifferences.erase( mDifferences.begin(), mDifferences.begin() + count );
+  mRendered += count;
+
+  //a second of samples is exactly CLOCK ticks
+  while ( mRendered >= ( uint64_t )mSPS )
+  {
+    mRendered -= mSPS;
+    mTick0 += CLOCK;
+  }
+
+  return count;
+}
+
+uint64_t AudioSynth::position( uint64_t tick ) const
+{
+  if ( tick <= mTick0 )
+    return 0;
+
+  return ( tick - mTick0 ) * mSPS * PHASES / CLOCK;
+}
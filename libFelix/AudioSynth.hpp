@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Utility.hpp"
+
+//Band limited step synthesis of audio output.
+//Every change of output is added at its tick as a step spread by a windowed sinc step response into a buffer of differences
+//at output sample rate. Samples are integrated from the buffer when rendered, so output is computed only when it changes.
+//Output is delayed by HALF_WIDTH samples to make room for the response before the step.
+class AudioSynth
+{
+public:
+  static constexpr int HALF_WIDTH = 12;
+  static constexpr int WIDTH = 2 * HALF_WIDTH + 1;
+  static constexpr int PHASES = 64;
+
+  AudioSynth();
+
+  //adds step of output by given difference
+  void step( uint64_t tick, int left, int right );
+  //Tick at which given count of samples is complete.
+  //Synthesis starts at given tick. Sample rate can change between calls without a gap, so it can be corrected continuously
+  uint64_t endTick( uint64_t tick, int sps, size_t samples );
+  //renders samples that are complete at given tick and returns their count
+  size_t render( uint64_t tick, std::span<AudioSample> out );
+
+private:
+  struct Difference
+  {
+    int64_t left;
+    int64_t right;
+  };
+
+  //position of tick in PHASES fractions of sample since mTick0
+  uint64_t position( uint64_t tick ) const;
+
+  std::vector<Difference> mDifferences;
+  //tick of sample 0. Moved by a second at a time to keep positions small
+  uint64_t mTick0;
+  //samples rendered since mTick0. Differences start at this sample
+  uint64_t mRendered;
+  int mSPS;
+  //output after all added steps
+  Difference mLevel;
+  Difference mIntegral;
+};
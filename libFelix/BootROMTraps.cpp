@@ -3,6 +3,7 @@
 #include "TraceHelper.hpp"
 #include "ScriptDebugger.hpp"
 #include "Core.hpp"
+#include "CPU.hpp"
 #include "Encryption.hpp"
 #include "Opcodes.hpp"
 #include "Log.hpp"
@@ -150,6 +151,282 @@ public:
   }
 };
 
+
+//Fast boot. Accelerates loops loaders use to pull the game from the cartridge byte by byte:
+//  loop: LDA RCART0 ; STA (zp),Y | STA abs,X | STA abs,Y ; one or two of INX INY DEX DEY ; BNE loop
+//CPU reading cartridge register from such a loop installs execute trap at the loop. After two ordinary iterations
+//measuring how many ticks one takes, the trap copies bytes of following iterations from cartridge to RAM in runs
+//and leaves registers, flags, cartridge counter and tick as the CPU would. Last iteration is left to the CPU to leave the loop.
+//Sequenced actions falling due are executed between runs, late by less than an iteration, and copying stops at one
+//raising an interrupt or ending the batch. Loops are left to the CPU while it is traced or when they access RAM with other traps.
+class CartLoaderTrap : public IMemoryAccessTrap, public std::enable_shared_from_this<CartLoaderTrap>
+{
+  struct Loop
+  {
+    uint8_t cartRegister;
+    Opcode store;
+    uint16_t operand;
+    std::array<Opcode, 2> steps;
+    int stepCount;
+    uint16_t length;
+  };
+
+  //expected state at next iteration of the loop being measured
+  struct Iteration
+  {
+    uint16_t address;
+    uint8_t x;
+    uint8_t y;
+    uint64_t tick;
+    uint64_t period;
+    //ticks to next sequenced action at the start of iteration
+    uint64_t quiet;
+  };
+
+public:
+  ~CartLoaderTrap() override = default;
+
+  uint8_t trap( Core& state, uint16_t address, uint8_t orgValue ) override
+  {
+    if ( ( address & 0xff00 ) == 0xfc00 )
+    {
+      //cartridge register is read by LDA abs which already left PC past its operand
+      install( state, state.debugState().pc - 3 );
+    }
+    else
+    {
+      run( state, address );
+    }
+
+    return orgValue;
+  }
+
+  Kind getKind() const override
+  {
+    return ROM_HLE;
+  }
+
+private:
+  static std::optional<Loop> decode( Core& state, uint16_t address )
+  {
+    static constexpr uint16_t MAX_LENGTH = 10;
+
+    //loop must be in RAM
+    if ( address >= 0xfc00 - MAX_LENGTH )
+      return std::nullopt;
+
+    auto byte = [&]( uint16_t offset )
+    {
+      return state.debugReadRAM( address + offset );
+    };
+
+    if ( byte( 0 ) != (uint8_t)Opcode::RAB_LDA || byte( 2 ) != 0xfc || ( byte( 1 ) != Suzy::RCART0 && byte( 1 ) != Suzy::RCART1 ) )
+      return std::nullopt;
+
+    Loop loop{ byte( 1 ), (Opcode)byte( 3 ), 0, {}, 0, 0 };
+    uint16_t pos = 4;
+
+    switch ( loop.store )
+    {
+    case Opcode::WIY_STA:
+      loop.operand = byte( pos++ );
+      break;
+    case Opcode::WAX_STA:
+    case Opcode::WAY_STA:
+      loop.operand = byte( pos ) | ( byte( pos + 1 ) << 8 );
+      pos += 2;
+      break;
+    default:
+      return std::nullopt;
+    }
+
+    while ( loop.stepCount < (int)loop.steps.size() )
+    {
+      auto op = (Opcode)byte( pos );
+      if ( op != Opcode::IMP_INX && op != Opcode::IMP_INY && op != Opcode::IMP_DEX && op != Opcode::IMP_DEY )
+        break;
+      loop.steps[loop.stepCount++] = op;
+      pos += 1;
+    }
+
+    if ( loop.stepCount == 0 || byte( pos ) != (uint8_t)Opcode::BRL_BNE || (uint16_t)( pos + 2 + (int8_t)byte( pos + 1 ) ) != 0 )
+      return std::nullopt;
+
+    loop.length = pos + 2;
+    return loop;
+  }
+
+  //applies index register steps of an iteration and returns the value its branch tests
+  static uint8_t step( Loop const& loop, uint8_t& x, uint8_t& y )
+  {
+    uint8_t result{};
+    for ( int i = 0; i < loop.stepCount; ++i )
+    {
+      switch ( loop.steps[i] )
+      {
+      case Opcode::IMP_INX:
+        result = ++x;
+        break;
+      case Opcode::IMP_INY:
+        result = ++y;
+        break;
+      case Opcode::IMP_DEX:
+        result = --x;
+        break;
+      default:
+        result = --y;
+        break;
+      }
+    }
+    return result;
+  }
+
+  static uint16_t target( Core& state, Loop const& loop, uint8_t x, uint8_t y )
+  {
+    switch ( loop.store )
+    {
+    case Opcode::WIY_STA:
+      return ( state.debugReadRAM( loop.operand ) | ( state.debugReadRAM( loop.operand + 1 ) << 8 ) ) + y;
+    case Opcode::WAX_STA:
+      return loop.operand + x;
+    default:
+      return loop.operand + y;
+    }
+  }
+
+  //stores that would hit hardware registers or modify the loop itself are left to the CPU
+  static bool isPlain( Loop const& loop, uint16_t address, uint16_t target )
+  {
+    if ( target >= 0xfc00 || ( target >= address && target < address + loop.length ) )
+      return false;
+
+    return loop.store != Opcode::WIY_STA || ( target != loop.operand && target != loop.operand + 1 );
+  }
+
+  void install( Core& state, uint16_t address )
+  {
+    if ( std::ranges::find( mLoops, address ) != mLoops.end() || !decode( state, address ) )
+      return;
+
+    mLoops.push_back( address );
+    state.getScriptDebugger()->addTrap( ScriptDebugger::Type::RAM_EXECUTE, address, shared_from_this() );
+  }
+
+  void run( Core& state, uint16_t address )
+  {
+    auto loop = decode( state, address );
+    if ( !loop )
+    {
+      mIteration.reset();
+      return;
+    }
+
+    auto& cpu = state.debugState();
+
+    //iteration takes the same number of ticks each time unless interrupted or stalled by actions like display DMA,
+    //so two equal periods in a row during which no action fell due are the true one
+    uint64_t period{};
+    if ( mIteration && mIteration->address == address && mIteration->x == cpu.x && mIteration->y == cpu.y && state.tick() - mIteration->tick <= mIteration->quiet )
+    {
+      period = state.tick() - mIteration->tick;
+      if ( period == mIteration->period && state.debugCPU().interruptedMask() == 0 && !state.debugCPU().isTracing() && untrapped( state, address, *loop ) )
+        copy( state, address, *loop, period );
+    }
+
+    uint8_t x = cpu.x;
+    uint8_t y = cpu.y;
+    step( *loop, x, y );
+    mIteration = Iteration{ address, x, y, state.tick(), period, state.debugTicksToNextAction() };
+  }
+
+  //whether CPU running the loop would call no other trap than this one fetching the loop and reading its zero page pointer
+  bool untrapped( Core& state, uint16_t address, Loop const& loop ) const
+  {
+    auto const& debugger = *state.getScriptDebugger();
+
+    for ( uint16_t i = 0; i < loop.length; ++i )
+    {
+      if ( debugger.isRAMTrapped( ScriptDebugger::Type::RAM_EXECUTE, address + i, this ) )
+        return false;
+    }
+
+    return loop.store != Opcode::WIY_STA ||
+      ( !debugger.isRAMTrapped( ScriptDebugger::Type::RAM_READ, loop.operand ) && !debugger.isRAMTrapped( ScriptDebugger::Type::RAM_READ, loop.operand + 1 ) );
+  }
+
+  //runs iterations of loop at address from the beginning of which CPU has just fetched the opcode
+  static void copy( Core& state, uint16_t address, Loop const& loop, uint64_t period )
+  {
+    auto& cpu = state.debugState();
+    auto const& debugger = *state.getScriptDebugger();
+
+    //iterations up to the last one or to a store the CPU has to do, at most 255 as index registers are 8-bit
+    std::array<uint16_t, 256> targets;
+    uint8_t x = cpu.x;
+    uint8_t y = cpu.y;
+    size_t count = 0;
+
+    for ( ;; )
+    {
+      uint16_t const dst = target( state, loop, x, y );
+      uint8_t nextX = x;
+      uint8_t nextY = y;
+      uint8_t const nextResult = step( loop, nextX, nextY );
+
+      if ( nextResult == 0 || !isPlain( loop, address, dst ) || debugger.isRAMTrapped( ScriptDebugger::Type::RAM_WRITE, dst ) )
+        break;
+
+      targets[count++] = dst;
+      x = nextX;
+      y = nextY;
+    }
+
+    std::array<uint8_t, 256> bytes;
+    size_t done = 0;
+
+    while ( done < count )
+    {
+      //run ends before next action is due, or after the iteration it is due in
+      size_t const run = ( size_t )std::clamp<uint64_t>( state.debugTicksToNextAction() / period, 1, count - done );
+
+      //cartridge is read at the start of iteration, which is a few ticks before the CPU would
+      if ( state.debugPeekCartridge( loop.cartRegister == Suzy::RCART1, period, { bytes.data() + done, run } ) != run )
+        break;
+
+      for ( size_t i = done; i < done + run; ++i )
+      {
+        state.debugWriteRAM( targets[i], bytes[i] );
+      }
+      state.debugAdvance( run * period );
+      done += run;
+
+      if ( !state.debugRunActions() )
+        break;
+    }
+
+    if ( done == 0 )
+      return;
+
+    //index registers and flags are left by the last index register step of iterations done
+    x = cpu.x;
+    y = cpu.y;
+    uint8_t result{};
+    for ( size_t i = 0; i < done; ++i )
+    {
+      result = step( loop, x, y );
+    }
+
+    cpu.a = bytes[done - 1];
+    cpu.x = x;
+    cpu.y = y;
+    cpu.n.set( ( result & 0x80 ) != 0 );
+    cpu.z.clear();
+  }
+
+private:
+  std::vector<uint16_t> mLoops;
+  std::optional<Iteration> mIteration;
+};
 }
 
 void setBootROMTraps( std::shared_ptr<TraceHelper> traceHelper, ScriptDebugger& scriptDebugger )
@@ -158,6 +435,13 @@ void setBootROMTraps( std::shared_ptr<TraceHelper> traceHelper, ScriptDebugger&
   scriptDebugger.addTrap( ScriptDebugger::Type::ROM_EXECUTE, 0xfe19, std::make_shared<ClearTrap>() );
   scriptDebugger.addTrap( ScriptDebugger::Type::ROM_EXECUTE, 0xfe4a, std::make_shared<DecryptTrap>() );
   scriptDebugger.addTrap( ScriptDebugger::Type::ROM_EXECUTE, 0xff80, std::make_shared<ResetTrap>() );
+}
+
+void setCartLoaderTraps( ScriptDebugger& scriptDebugger )
+{
+  auto cartLoaderTrap = std::make_shared<CartLoaderTrap>();
+  scriptDebugger.addTrap( ScriptDebugger::Type::SUZY_READ, 0xfc00 | Suzy::RCART0, cartLoaderTrap );
+  scriptDebugger.addTrap( ScriptDebugger::Type::SUZY_READ, 0xfc00 | Suzy::RCART1, cartLoaderTrap );
 }
 
 void initMikeyRegisters( Core& state )
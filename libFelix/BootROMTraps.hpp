@@ -11,5 +11,7 @@ static constexpr uint16_t BOOTROM_SHIFT_HANDLER_ADDRESS = 0xfe00;
 static constexpr uint16_t DECRYPTED_ROM_START_ADDRESS = 0x0200;
 
 void setBootROMTraps( std::shared_ptr<TraceHelper> traceHelper, ScriptDebugger& scriptDebugger );
+//fast boot: copies loops loading the game from cartridge to RAM in bulk
+void setCartLoaderTraps( ScriptDebugger& scriptDebugger );
 
 void initMikeyRegisters( Core& state );
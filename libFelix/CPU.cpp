@@ -3619,6 +3619,11 @@ void CPU::traceNextCount( int count )
 }
 
 
+bool CPU::isTracing() const
+{
+  return mGlobalTrace;
+}
+
 void CPU::setGlobalTrace()
 {
   if ( mTrace || mTraceNextCount )
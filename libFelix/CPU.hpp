@@ -2,6 +2,7 @@
 
 #include "CPUState.hpp"
 #include "Utility.hpp"
+#include "CoroutineFramePool.hpp"
 
 enum class Opcode : uint8_t;
 struct CpuTrace;
@@ -79,6 +80,8 @@ public:
   void disableTrace();
   void toggleTrace( bool on );
   void traceNextCount( int count );
+  //whether executed instructions are traced
+  bool isTracing() const;
   void printStatus( std::span<uint8_t, 3 * 14> text );
   static bool disasmOp( char* out, Opcode op, CPUState* state = nullptr );
   uint8_t disasmOpr( uint8_t const* ram, char* out, int& pc );
@@ -94,7 +97,7 @@ private:
     struct promise_type;
     using handle = std::coroutine_handle<promise_type>;
 
-    struct promise_type
+    struct promise_type : PooledFrame
     {
       auto get_return_object() { return Execute{ handle::from_promise( *this ) }; }
       auto initial_suspend() { return std::suspend_always{}; }
@@ -31,6 +31,25 @@ uint8_t CartBank::operator()( uint32_t shiftRegister, uint32_t count ) const
   return address < mData.size() ? mData[address] : 0xff;
 }
 
+void CartBank::copy( uint32_t shiftRegister, uint32_t count, std::span<uint8_t> out ) const
+{
+  uint32_t const page = shiftRegister << mShift;
+
+  while ( !out.empty() )
+  {
+    uint32_t const offset = count & mShiftMask;
+    size_t const run = std::min<size_t>( out.size(), mShiftMask + 1 - offset );
+    size_t const address = page + offset;
+    size_t const available = address < mData.size() ? std::min( run, mData.size() - address ) : 0;
+
+    if ( available )
+      std::copy_n( mData.data() + address, available, out.begin() );
+    std::fill_n( out.begin() + available, run - available, 0xff );
+    out = out.subspan( run );
+    count += ( uint32_t )run;
+  }
+}
+
 bool CartBank::empty() const
 {
   return mData.empty();
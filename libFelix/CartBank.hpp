@@ -11,6 +11,8 @@ public:
 
 
   uint8_t operator()( uint32_t shiftRegister, uint32_t count ) const;
+  //bytes at consecutive counts from given one, wrapping within the page like the counter does
+  void copy( uint32_t shiftRegister, uint32_t count, std::span<uint8_t> out ) const;
 
 private:
   std::span<uint8_t const> mData;
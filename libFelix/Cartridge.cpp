@@ -122,6 +122,30 @@ uint8_t Cartridge::peekRCART1( uint64_t tick )
   return result;
 }
 
+size_t Cartridge::peekBulk( bool rcart1, uint64_t tick, uint64_t period, std::span<uint8_t> out )
+{
+  if ( mGameDrive && !rcart1 )
+    return 0;
+
+  CartBank const& bank = rcart1 ? mBank1 : mBank0;
+
+  if ( mEEPROM || mCurrentStrobe )
+  {
+    for ( size_t i = 0; i < out.size(); ++i )
+    {
+      out[i] = bank( mShiftRegister, mCounter );
+      incrementCounter( tick + i * period );
+    }
+  }
+  else
+  {
+    bank.copy( mShiftRegister, mCounter, out );
+    mCounter += ( uint16_t )out.size();
+  }
+
+  return out.size();
+}
+
 void Cartridge::pokeRCART0( uint64_t tick, uint8_t value )
 {
   mTraceHelper->comment<"RCART0 poke ${:03x}.">(  mCounter );
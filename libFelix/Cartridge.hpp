@@ -24,6 +24,10 @@ public:
   uint8_t peekRCART0( uint64_t tick );
   uint8_t peekRCART1( uint64_t tick );
 
+  //Bytes that consecutive peeks of RCART0 or RCART1 given ticks apart from given tick would return, leaving the counter where they would.
+  //Returns their count, which is 0 when GameDrive serves RCART0
+  size_t peekBulk( bool rcart1, uint64_t tick, uint64_t period, std::span<uint8_t> out );
+
   void pokeRCART0( uint64_t tick, uint8_t value );
   void pokeRCART1( uint64_t tick, uint8_t value );
 
@@ -1,6 +1,7 @@
 #include "ColOperator.hpp"
 #include "SpriteTemplates.hpp"
 #include "Log.hpp"
+#include "Simd.hpp"
 
 namespace
 {
@@ -178,66 +179,99 @@ static constexpr std::array<bool, ColOperator::SPRITE_TYPES> depositoryUpdatable
 }
 
 
-ColOperator::ColOperator( Suzy::Sprite spriteType, uint8_t sprColl ) : mSpriteType{ (size_t)spriteType }, mCollidingColors{ statesTables[mSpriteType] }, mMask{}, mHiColl{}, mStoreOff{}, mColAdr{}, mColl{ (uint16_t)( ( sprColl & 0xf ) | ( ( sprColl & 0xf ) << 4 ) ) }
+ColOperator::ColOperator( Suzy::Sprite spriteType, uint8_t sprColl ) : mSpriteType{ (size_t)spriteType }, mCollidingColors{ statesTables[mSpriteType] }, mMasks{}, mHiColl{}, mColAdr{}, mColl{ (uint16_t)( ( sprColl & 0xf ) | ( ( sprColl & 0xf ) << 4 ) ) }
 {
   mColl |= mColl << 8;
 }
 
-ColOperator::MemOp ColOperator::flush()
+ColOperator::LineOp ColOperator::flush() const
 {
-  if ( mMask )
+  uint32_t groups = 0;
+  for ( auto mask : mMasks )
   {
-    return MemOp{ mMask, ( uint16_t )( mColAdr + mStoreOff ), mColl };
-  }
-  else
-  {
-    return {};
+    groups += mask != 0 ? 1 : 0;
   }
+
+  return LineOp{ mColAdr, mColl, groups };
 }
 
 void ColOperator::newLine( uint16_t coladr )
 {
   mColAdr = coladr;
-  mStoreOff = ~0;  //invalid address to detect first access
-  mMask = 0x0000;
+  mMasks.fill( 0 );
 }
 
-ColOperator::MemOp ColOperator::process( int hpos, uint8_t pixel )
+void ColOperator::process( int hpos, uint8_t pixel )
 {
-  MemOp result{};
+  assert( hpos >= 0 && hpos < SCREEN_WIDTH );
+  assert( pixel < ColOperator::POSSIBLE_PIXELS );
 
-  int32_t hposfloor = ( hpos & ~7 ) >> 1;
   int32_t hposrem = hpos & 7;
 
-  if ( mStoreOff != hposfloor )
+  if ( mCollidingColors[pixel] )
   {
-    if ( mMask )
+    if constexpr ( std::endian::native == std::endian::little )
+    {
+      mMasks[hpos >> 3] |= 0x0000000f << ( ( hposrem ^ 1 ) * 4 );
+    }
+    else
     {
-      result = MemOp{ mMask, (uint16_t)( mColAdr + mStoreOff ), mColl };
-      mMask = 0;
+      mMasks[hpos >> 3] |= 0xf0000000 >> ( hposrem * 4 );
     }
-    mStoreOff = hposfloor;
   }
+}
 
-  assert( pixel < ColOperator::POSSIBLE_PIXELS );
+std::span<uint32_t const, ColOperator::LINE_GROUPS> ColOperator::masks() const
+{
+  return mMasks;
+}
 
-  if ( mCollidingColors[pixel] )
+uint32_t ColOperator::collideLine( uint8_t * line, std::span<uint32_t const, LINE_GROUPS> masks, uint16_t value )
+{
+  //masks are laid out in memory in the same way as collision buffer bytes
+  uint8_t const* maskBytes = (uint8_t const*)masks.data();
+  static constexpr size_t LINE_BYTES = LINE_GROUPS * sizeof( uint32_t );
+
+#if defined( FELIX_SSE2 )
+  static_assert( LINE_BYTES % 16 == 0 );
+
+  const __m128i nibble = _mm_set1_epi8( 0x0f );
+  const __m128i coll = _mm_set1_epi8( (char)( value & 0xff ) );
+  __m128i hi = _mm_setzero_si128();
+
+  for ( size_t i = 0; i < LINE_BYTES; i += 16 )
+  {
+    __m128i mask = _mm_loadu_si128( (__m128i const*)( maskBytes + i ) );
+    __m128i old = _mm_loadu_si128( (__m128i const*)( line + i ) );
+    __m128i masked = _mm_and_si128( old, mask );
+    hi = _mm_max_epu8( hi, _mm_and_si128( masked, nibble ) );
+    hi = _mm_max_epu8( hi, _mm_and_si128( _mm_srli_epi16( masked, 4 ), nibble ) );
+    _mm_storeu_si128( (__m128i *)( line + i ), _mm_or_si128( _mm_andnot_si128( mask, old ), _mm_and_si128( coll, mask ) ) );
+  }
+
+  hi = _mm_max_epu8( hi, _mm_srli_si128( hi, 8 ) );
+  hi = _mm_max_epu8( hi, _mm_srli_si128( hi, 4 ) );
+  hi = _mm_max_epu8( hi, _mm_srli_si128( hi, 2 ) );
+  hi = _mm_max_epu8( hi, _mm_srli_si128( hi, 1 ) );
+
+  return (uint32_t)_mm_cvtsi128_si32( hi ) & 0x0f;
+#else
+  uint8_t const coll = (uint8_t)( value & 0xff );
+  uint32_t hi = 0;
+
+  for ( size_t i = 0; i < LINE_BYTES; ++i )
   {
-    if constexpr ( std::endian::native == std::endian::little )
-    {
-      mMask |= 0x0000000f << ( ( hposrem ^ 1 ) * 4 );
-    }
-    else
-    {
-      mMask |= 0xf0000000 >> ( hposrem * 4 );
-    }
+    uint8_t masked = line[i] & maskBytes[i];
+    hi = std::max<uint32_t>( { hi, masked & 0x0fu, masked >> 4u } );
+    line[i] = ( line[i] & ~maskBytes[i] ) | ( coll & maskBytes[i] );
   }
-
-  return result;
-}
-
-void ColOperator::receiveHiColl( uint32_t value )
-{
+
+  return hi;
+#endif
+}
+
+void ColOperator::receiveHiColl( uint32_t value )
+{
   if ( depositoryUpdatable[mSpriteType] )
   {
     auto v7 = value & 0xf0000000;
@@ -268,10 +302,10 @@ void ColOperator::receiveHiColl( uint32_t value )
       ( v1 > t1 ? v1 : t1 ) |
       ( v0 > t0 ? v0 : t0 );
   }
-}
-
-std::optional<uint8_t> ColOperator::hiColl() const
-{
+}
+
+std::optional<uint8_t> ColOperator::hiColl() const
+{
   if ( depositoryUpdatable[mSpriteType] )
   {
     auto t7 = ( mHiColl & 0xf0000000 ) >> 28;
@@ -294,7 +328,7 @@ std::optional<uint8_t> ColOperator::hiColl() const
     auto t76543210 = t7654 > t3210 ? t7654 : t3210;
 
     return t76543210;
-  }
-  else
-    return {};
+  }
+  else
+    return {};
 }
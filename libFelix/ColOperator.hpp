@@ -1,40 +1,43 @@
 #pragma once
 #include "Suzy.hpp"
+#include "Utility.hpp"
 
 class ColOperator
 {
 public:
-  struct MemOp
+  //collision buffer line of 160 pixels is written in groups of 8 pixels
+  static constexpr size_t LINE_GROUPS = SCREEN_WIDTH / 8;
+
+  struct LineOp
   {
-    union
-    {
-      struct
-      {
-        uint32_t mask;
-        uint16_t addr;
-        uint16_t value;
-      };
-      uint64_t word;
-    };
+    //address of collision buffer line
+    uint16_t addr;
+    //quadrupled sprite's collision number
+    uint16_t value;
+    //number of groups with written pixels
+    uint32_t groups;
 
     explicit operator bool() const
     {
-      return word != 0;
+      return groups != 0;
     }
   };
 
-  static_assert( sizeof( MemOp ) == sizeof( uint64_t ) );
-
 public:
   ColOperator( Suzy::Sprite spriteType, uint8_t sprColl );
 
-  MemOp flush();
+  LineOp flush() const;
   void newLine( uint16_t coladr );
 
-  MemOp process( int hpos, uint8_t pixel );
+  void process( int hpos, uint8_t pixel );
+  //masks of updated nibbles of all groups of the line
+  std::span<uint32_t const, LINE_GROUPS> masks() const;
   void receiveHiColl( uint32_t value );
   std::optional<uint8_t> hiColl() const;
 
+  //writes collision number to masked nibbles of whole collision buffer line and returns the highest nibble value overwritten
+  static uint32_t collideLine( uint8_t * line, std::span<uint32_t const, LINE_GROUPS> masks, uint16_t value );
+
   typedef bool( *processFunT )( uint8_t );
 
   static constexpr size_t POSSIBLE_PIXELS = 16;
@@ -45,12 +48,10 @@ private:
   size_t mSpriteType;
   //table of colliding colors for given sprite type
   std::array<bool, ColOperator::POSSIBLE_PIXELS> const& mCollidingColors;
-  //mask of updated nibbles of collision buffer
-  uint32_t mMask;
+  //masks of updated nibbles of collision buffer for each 8-pixel group of the line
+  std::array<uint32_t, LINE_GROUPS> mMasks;
   //highest collistion number detected
   uint32_t mHiColl;
-  //offset from the beginning of line of current 8-pixel collision buffer cache. It's initialized to impossible value
-  int32_t mStoreOff;
   //address of current collision buffer line
   uint16_t mColAdr;
   //quadrupled sprite's collision number
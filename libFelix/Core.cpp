@@ -14,6 +14,8 @@
 #include "DebugRAM.hpp"
 #include "ScriptDebuggerEscapes.hpp"
 #include "VGMWriter.hpp"
+#include "ColOperator.hpp"
+#include "DebugSnapshot.hpp"
 
 uint8_t* gDebugRAM;
 
@@ -24,10 +26,10 @@ static constexpr bool ENABLE_TRAPS = true;
 Core::Core( ImageProperties const& imageProperties, std::shared_ptr<ComLynxWire> comLynxWire, std::shared_ptr<IVideoSink> videoSink,
   std::shared_ptr<IInputSource> inputSource, InputFile inputFile, std::shared_ptr<ImageROM const> bootROM,
   std::shared_ptr<ScriptDebuggerEscapes> scriptDebuggerEscapes ) :
-  mRAM{}, mROM{}, mPageTypes{}, mScriptDebugger{ std::make_shared<ScriptDebugger>() }, mCurrentTick{}, mSamplesRemainder{}, mActionQueue{}, mTraceHelper{ std::make_shared<TraceHelper>() }, mCpu{ std::make_shared<CPU>( mTraceHelper ) },
+  mRAM{}, mRAMPageGenerations{}, mROM{}, mPageTypes{}, mScriptDebugger{ std::make_shared<ScriptDebugger>() }, mDebugSnapshots{}, mCurrentTick{}, mSPS{}, mActionQueue{}, mTraceHelper{ std::make_shared<TraceHelper>() }, mCpu{ std::make_shared<CPU>( mTraceHelper ) },
   mCartridge{ std::make_shared<Cartridge>( imageProperties, std::shared_ptr<ImageCart>{}, mTraceHelper ) }, mComLynx{ std::make_shared<ComLynx>( comLynxWire ) }, mComLynxWire{ comLynxWire },
   mMikey{ std::make_shared<Mikey>( *this, *mComLynx, videoSink ) }, mSuzy{ std::make_shared<Suzy>( *this, inputSource ) }, mMapCtl{},
-  mDMAAddress{}, mFastCycleTick{ 4 }, mResetRequestDuringSpriteRendering{}, mSuzyRunning{}, mHaltSuzy{}
+  mDMAAddress{}, mFastCycleTick{ 4 }, mResetRequestDuringSpriteRendering{}, mSuzyRunning{}, mHaltSuzy{}, mFastBoot{}
 {
   gDebugRAM = &mRAM[0];
 
@@ -142,6 +144,7 @@ void Core::pulseReset( std::optional<uint16_t> resetAddress )
     writeMAPCTL( 0x08 );  //enable RAM in vector space
     mRAM[CPU::RESET_VECTOR + 0] = *resetAddress & 0xff;
     mRAM[CPU::RESET_VECTOR + 1] = *resetAddress >> 8;
+    markRAMWritten( CPU::RESET_VECTOR );
   }
   else
   {
@@ -161,6 +164,8 @@ void Core::pulseReset( std::optional<uint16_t> resetAddress )
 
 Core::~Core()
 {
+  auto stats = debugSpriteLineCache();
+  L_DEBUG << "Sprite line cache hits: " << stats.hits << ", misses: " << stats.misses;
   gDebugRAM = nullptr;
 }
 
@@ -170,6 +175,11 @@ void Core::requestDisplayDMA( uint64_t tick, uint16_t address )
   mActionQueue.push( { Action::DISPLAY_DMA, tick } );
 }
 
+void Core::requestAction( SequencedAction action )
+{
+  mActionQueue.push( action );
+}
+
 void Core::runSuzy()
 {
   mSuzyRunning = true;
@@ -255,7 +265,7 @@ void Core::executeSequencedAction( SequencedAction seqAction )
     mCpu->desertInterrupt( CPUState::I_RESET );
     break;
   case Action::SAMPLE_AUDIO:
-    mOutputSamples[mSamplesEmitted++] = mMikey->sampleAudio( mCurrentTick );
+    mSamplesEmitted += ( uint32_t )mMikey->renderAudio( seqAction.getTick(), mOutputSamples.subspan( mSamplesEmitted ) );
     if ( mSamplesEmitted >= mOutputSamples.size() )
     {
       mCpu->breakNext();
@@ -292,72 +302,123 @@ bool Core::executeSuzyAction()
     return false;
   }
 
-  mSuzyProcessRequest = mSuzyProcess->advance();
+  if ( mSuzyProcessRequests.empty() )
+    mSuzyProcessRequests = mSuzyProcess->advance();
 
-  switch ( mSuzyProcessRequest->type )
+  //draining the batch until it's empty or a sequenced action is due
+  do
   {
-  case ISuzyProcess::Request::FINISH:
-    mSuzyRunning = false;
-    mMikey->suzyDone();
-    mSuzyProcess.reset();
-    //workaround to problem with resetting during Suzy activity
-    if ( mResetRequestDuringSpriteRendering )
-    {
-      mResetRequestDuringSpriteRendering = false;
-      pulseReset();
-    }
-    break;
-  case ISuzyProcess::Request::READ:
-  case ISuzyProcess::Request::FETCHSCB:
-    mSuzyProcess->respond( mRAM[mSuzyProcessRequest->addr] );
-    mCurrentTick += 5ull; //read byte
-    break;
-  case ISuzyProcess::Request::READ4:
-  case ISuzyProcess::Request::READPAL:
-    if ( mSuzyProcessRequest->addr <= 0xfffc )
-      mSuzyProcess->respond( *( (uint32_t const *)( mRAM.data() + mSuzyProcessRequest->addr ) ) );
-    mCurrentTick += 5ull + 3 * mFastCycleTick;  //read 4 bytes
-    break;
-  case ISuzyProcess::Request::WRITE:
-  case ISuzyProcess::Request::WRITEFRED:
-    mRAM[mSuzyProcessRequest->addr] = (uint8_t)mSuzyProcessRequest->value;
-    mCurrentTick += 5ull; //write byte
-    break;
-  case ISuzyProcess::Request::COLRMW:
-    {
-      if ( mSuzyProcessRequest->addr > 0xfffc )
-        break;
-
-      const uint32_t u16 = mSuzyProcessRequest->value;
-      const uint32_t u32 = u16 | ( u16 << 16 );
-      const uint32_t maskedU32 = u32 & mSuzyProcessRequest->mask;
-
-      const uint32_t value = *( (uint32_t const*)( mRAM.data() + mSuzyProcessRequest->addr ) );
-      const uint32_t maskedValue = value & ~mSuzyProcessRequest->mask;
-      const uint32_t outValue = value & mSuzyProcessRequest->mask;
+    auto const& req = mSuzyProcessRequests.front();
+    mSuzyProcessRequests = mSuzyProcessRequests.subspan( 1 );
 
-      *( (uint32_t *)( mRAM.data() + mSuzyProcessRequest->addr ) ) = maskedValue | maskedU32;
-
-      mSuzyProcess->respond( outValue );
-    }
-    mCurrentTick += 5ull + 7 * mFastCycleTick;  //read 4 bytes & write 4 bytes
-    break;
-  case ISuzyProcess::Request::VIDRMW:
+    switch ( req.type )
     {
-      auto value = mRAM[mSuzyProcessRequest->addr] & mSuzyProcessRequest->mask | mSuzyProcessRequest->value;
-      mRAM[mSuzyProcessRequest->addr] = (uint8_t)value;
-  }
-    mCurrentTick += 5ull + mFastCycleTick;  //read & write byte
-    break;
-  case ISuzyProcess::Request::XOR:
-    {
-      auto ramValue = mRAM[mSuzyProcessRequest->addr];
-      auto xorValue = ramValue ^ mSuzyProcessRequest->value;
-      mRAM[mSuzyProcessRequest->addr] = (uint8_t)xorValue;
+    case ISuzyProcess::Request::FINISH:
+      mSuzyRunning = false;
+      mMikey->suzyDone();
+      mSuzyProcessRequests = {};
+      mSuzyProcess.reset();
+      //workaround to problem with resetting during Suzy activity
+      if ( mResetRequestDuringSpriteRendering )
+      {
+        mResetRequestDuringSpriteRendering = false;
+        pulseReset();
+      }
+      return true;
+    case ISuzyProcess::Request::READ:
+    case ISuzyProcess::Request::FETCHSCB:
+      mSuzyProcess->respond( mRAM[req.addr] );
+      mCurrentTick += 5ull; //read byte
+      break;
+    case ISuzyProcess::Request::READLINE:
+      if ( req.addr + req.value <= mRAM.size() )
+      {
+        mSuzyProcess->respondLine( { mRAM.data() + req.addr, req.value } );
+      }
+      else
+      {
+        //sprite data wrapping around the end of address space
+        std::array<uint8_t, 256> wrapped;
+        for ( size_t i = 0; i < req.value; ++i )
+        {
+          wrapped[i] = mRAM[( req.addr + i ) & 0xffff];
+        }
+        mSuzyProcess->respondLine( { wrapped.data(), req.value } );
+      }
+      mCurrentTick += 5ull + 3 * mFastCycleTick;  //read 4 bytes. Further bytes are accounted by READ requests
+      break;
+    case ISuzyProcess::Request::READPAL:
+      if ( req.addr <= 0xfffc )
+        mSuzyProcess->respond( *( (uint32_t const *)( mRAM.data() + req.addr ) ) );
+      mCurrentTick += 5ull + 3 * mFastCycleTick;  //read 4 bytes
+      break;
+    case ISuzyProcess::Request::WRITE:
+    case ISuzyProcess::Request::WRITEFRED:
+      mRAM[req.addr] = (uint8_t)req.value;
+      markRAMWritten( req.addr );
+      mCurrentTick += 5ull; //write byte
+      break;
+    case ISuzyProcess::Request::COLLINE:
+      {
+        auto masks = mSuzyProcess->collisionMasks();
+        assert( masks.size() == ColOperator::LINE_GROUPS );
+
+        if ( req.addr <= 0x10000 - ColOperator::LINE_GROUPS * sizeof( uint32_t ) )
+        {
+          mSuzyProcess->respondCollision( ColOperator::collideLine( mRAM.data() + req.addr, masks.first<ColOperator::LINE_GROUPS>(), req.value ) );
+          markRAMWritten( req.addr );
+          markRAMWritten( req.addr + ColOperator::LINE_GROUPS * sizeof( uint32_t ) - 1 );
+          mCurrentTick += req.mask * ( 5ull + 7 * mFastCycleTick );  //read 4 bytes & write 4 bytes for each group
+        }
+        else
+        {
+          //line wrapping around the end of address space is written group by group
+          const uint32_t u16 = req.value;
+          const uint32_t u32 = u16 | ( u16 << 16 );
+          uint32_t hiColl = 0;
+
+          for ( size_t i = 0; i < masks.size(); ++i )
+          {
+            const uint16_t addr = (uint16_t)( req.addr + i * sizeof( uint32_t ) );
+            if ( masks[i] == 0 || addr > 0xfffc )
+              continue;
+
+            const uint32_t value = *( (uint32_t const*)( mRAM.data() + addr ) );
+            *( (uint32_t *)( mRAM.data() + addr ) ) = ( value & ~masks[i] ) | ( u32 & masks[i] );
+            markRAMWritten( addr );
+            markRAMWritten( addr + 3 );
+
+            const uint32_t outValue = value & masks[i];
+            for ( int nibble = 0; nibble < 8; ++nibble )
+            {
+              hiColl = std::max( hiColl, ( outValue >> ( nibble * 4 ) ) & 0x0f );
+            }
+            mCurrentTick += 5ull + 7 * mFastCycleTick;  //read 4 bytes & write 4 bytes
+          }
+
+          mSuzyProcess->respondCollision( hiColl );
+        }
+      }
+      break;
+    case ISuzyProcess::Request::VIDRMW:
+      {
+        auto value = mRAM[req.addr] & req.mask | req.value;
+        mRAM[req.addr] = (uint8_t)value;
+        markRAMWritten( req.addr );
+      }
+      mCurrentTick += 5ull + mFastCycleTick;  //read & write byte
+      break;
+    case ISuzyProcess::Request::XOR:
+      {
+        auto ramValue = mRAM[req.addr];
+        auto xorValue = ramValue ^ req.value;
+        mRAM[req.addr] = (uint8_t)xorValue;
+        markRAMWritten( req.addr );
+      }
+      mCurrentTick += 5ull + mFastCycleTick; //read & write byte
+      break;
     }
-    mCurrentTick += 5ull + mFastCycleTick; //read & write byte
-    break;
-  }
+  } while ( !mSuzyProcessRequests.empty() && ( mActionQueue.empty() || mActionQueue.headTick() > mCurrentTick ) );
 
   return true;
 }
@@ -457,15 +518,8 @@ CpuBreakType Core::executeCPUAction()
 
 void Core::enqueueSampling()
 {
-  int ticks = 16000000 / mSPS;
-  mSamplesRemainder += 16000000 % mSPS;
-  if ( mSamplesRemainder > mSPS )
-  {
-    mSamplesRemainder %= mSPS;
-    ticks += 1;
-  }
-
-  mActionQueue.push( { Action::SAMPLE_AUDIO, mCurrentTick + ticks } );
+  //audio is synthesized from output changes, so the whole buffer is rendered at once when its last sample is complete
+  mActionQueue.push( { Action::SAMPLE_AUDIO, mMikey->audioEndTick( mCurrentTick, mSPS, mOutputSamples.size() - mSamplesEmitted ) } );
 }
 
 CpuBreakType Core::run( RunMode runMode )
@@ -523,6 +577,12 @@ CpuBreakType Core::advanceAudio( int sps, std::span<AudioSample> outputBuffer, R
   if ( mSamplesEmitted < mOutputSamples.size() )
   {
     mActionQueue.erase( Action::SAMPLE_AUDIO );
+    if ( runMode != RunMode::PAUSE )
+    {
+      //actions still pending before current tick may change audio output
+      uint64_t const tick = mActionQueue.empty() ? mCurrentTick : std::min( mCurrentTick, mActionQueue.headTick() );
+      mSamplesEmitted += ( uint32_t )mMikey->renderAudio( tick, mOutputSamples.subspan( mSamplesEmitted ) );
+    }
     for ( size_t i = mSamplesEmitted; i < mOutputSamples.size(); ++i )
     {
       mOutputSamples[mSamplesEmitted++] = {};
@@ -544,6 +604,22 @@ Cartridge & Core::getCartridge()
 
 void Core::newLine( int rowNr )
 {
+  if constexpr ( ENABLE_TRAPS )
+  {
+    mScriptDebugger->scanline( *this, rowNr );
+  }
+}
+
+void Core::newFrame()
+{
+  if constexpr ( ENABLE_TRAPS )
+  {
+    mScriptDebugger->frame( *this );
+  }
+  if ( mDebugSnapshots )
+  {
+    publishDebugSnapshot();
+  }
 }
 
 std::shared_ptr<TraceHelper> Core::getTraceHelper() const
@@ -556,6 +632,28 @@ std::shared_ptr<ScriptDebugger> Core::getScriptDebugger() const
   return mScriptDebugger;
 }
 
+void Core::setDebugSnapshots( std::shared_ptr<DebugSnapshots> debugSnapshots )
+{
+  mDebugSnapshots = std::move( debugSnapshots );
+}
+
+void Core::publishDebugSnapshot()
+{
+  if ( !mDebugSnapshots )
+    return;
+
+  auto& snapshot = mDebugSnapshots->back();
+  snapshot.ram = mRAM;
+  snapshot.rom = mROM;
+  snapshot.cpu = mCpu->state();
+  std::ranges::copy( mMikey->debugPalette(), snapshot.palette.begin() );
+  snapshot.dispAdr = mMikey->debugDispAdr();
+  snapshot.vidBas = mSuzy->debugVidBas();
+  snapshot.collBas = mSuzy->debugCollBas();
+  snapshot.tick = mCurrentTick;
+  mDebugSnapshots->publish();
+}
+
 uint64_t Core::fetchRAMTiming( uint16_t address )
 {
   return mFastCycleTick;
@@ -644,6 +742,12 @@ void Core::writeRAM( uint16_t address, uint8_t value )
   {
     mRAM[address] = value;
   }
+  markRAMWritten( address );
+}
+
+void Core::markRAMWritten( uint16_t address )
+{
+  mRAMPageGenerations[address >> 8] += 1;
 }
 
 uint8_t Core::readMikey( uint16_t address )
@@ -800,6 +904,21 @@ uint8_t Core::debugReadROM( uint16_t address ) const
 void Core::debugWriteRAM( uint16_t address, uint8_t value )
 {
   mRAM[address] = value;
+  markRAMWritten( address );
+}
+
+size_t Core::debugWriteRAM( uint16_t address, std::span<uint8_t const> data )
+{
+  size_t const size = std::min( data.size(), mRAM.size() - address );
+  if ( size == 0 )
+    return 0;
+
+  std::copy_n( data.begin(), size, mRAM.begin() + address );
+  for ( size_t page = address >> 8; page <= ( address + size - 1 ) >> 8; ++page )
+  {
+    mRAMPageGenerations[page] += 1;
+  }
+  return size;
 }
 
 uint8_t Core::debugReadMikey( uint16_t address ) const
@@ -868,3 +987,59 @@ std::span<uint8_t const, 32> Core::debugPalette() const
   return mMikey->debugPalette();
 }
 
+SpriteLineCache::Stats Core::debugSpriteLineCache() const
+{
+  return mSuzy->debugSpriteLineCache();
+}
+
+uint64_t Core::debugRunSprites()
+{
+  uint64_t const startTick = mCurrentTick;
+
+  runSuzy();
+  while ( mSuzyRunning && executeSuzyAction() )
+  {
+  }
+
+  return mCurrentTick - startTick;
+}
+
+uint64_t Core::debugTicksToNextAction() const
+{
+  if ( mActionQueue.empty() )
+    return std::numeric_limits<uint64_t>::max();
+
+  uint64_t const headTick = mActionQueue.headTick();
+  return headTick > mCurrentTick ? headTick - mCurrentTick : 0;
+}
+
+void Core::debugAdvance( uint64_t ticks )
+{
+  mCurrentTick += ticks;
+}
+
+bool Core::debugRunActions()
+{
+  while ( !mActionQueue.empty() && mActionQueue.headTick() <= mCurrentTick )
+  {
+    executeSequencedAction( mActionQueue.pop() );
+    if ( mHaltSuzy || mCpu->interruptedMask() != 0 )
+      return false;
+  }
+
+  return true;
+}
+
+size_t Core::debugPeekCartridge( bool rcart1, uint64_t period, std::span<uint8_t> out )
+{
+  return mCartridge->peekBulk( rcart1, mCurrentTick, period, out );
+}
+
+void Core::enableFastBoot()
+{
+  if ( !mFastBoot )
+  {
+    setCartLoaderTraps( *mScriptDebugger );
+    mFastBoot = true;
+  }
+}
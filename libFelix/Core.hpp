@@ -20,18 +20,19 @@ class TraceHelper;
 class ScriptDebuggerEscapes;
 class ScriptDebugger;
 class VGMWriter;
+class DebugSnapshots;
 struct CPUState;
 
 class Core
 {
 public:
-  Core( ImageProperties const& imageProperties, std::shared_ptr<ComLynxWire> comLynxWire, std::shared_ptr<IVideoSink> videoSink,
-    std::shared_ptr<IInputSource> inputSource, InputFile inputFile, std::shared_ptr<ImageROM const> bios,
-    std::shared_ptr<ScriptDebuggerEscapes> scriptDebuggerEscapes );
+  Core( ImageProperties const& imageProperties, std::shared_ptr<ComLynxWire> comLynxWire, std::shared_ptr<IVideoSink> videoSink,
+    std::shared_ptr<IInputSource> inputSource, InputFile inputFile, std::shared_ptr<ImageROM const> bios,
+    std::shared_ptr<ScriptDebuggerEscapes> scriptDebuggerEscapes );
   ~Core();
 
   CpuBreakType advanceAudio( int sps, std::span<AudioSample> outputBuffer, RunMode runMode );
-  CpuBreakType run( RunMode runMode );
+  CpuBreakType run( RunMode runMode );
 
   void setLog( std::filesystem::path const & path );
   void setVGMWriter( std::filesystem::path const& path );
@@ -48,6 +49,8 @@ public:
   uint8_t debugReadROM( uint16_t address ) const;
   uint8_t debugReadRAM( uint16_t address ) const;
   void debugWriteRAM( uint16_t address, uint8_t value );
+  //writes data from address up to the end of RAM and returns count of bytes written, bytes past 0xffff are dropped
+  size_t debugWriteRAM( uint16_t address, std::span<uint8_t const> data );
   uint8_t debugReadMikey( uint16_t address ) const;
   void debugWriteMikey( uint16_t address, uint8_t value );
   uint8_t debugReadSuzy( uint16_t address ) const;
@@ -60,8 +63,24 @@ public:
   uint16_t debugVidBas() const;
   uint16_t debugCollBas() const;
   std::span<uint8_t const, 32> debugPalette() const;
+  SpriteLineCache::Stats debugSpriteLineCache() const;
+  //Not thread safe. Runs sprite chain started with SPRGO to completion without the CPU and returns ticks spent on it
+  uint64_t debugRunSprites();
+  //Not thread safe. Used by traps emulating guest code in bulk: ticks left before next sequenced action is due, advancing time by ticks the code took,
+  //executing actions that are due and reading the cartridge with Cartridge::peekBulk.
+  //Executing actions returns false when the CPU has to run next, that is on pending interrupt or end of batch
+  uint64_t debugTicksToNextAction() const;
+  void debugAdvance( uint64_t ticks );
+  bool debugRunActions();
+  size_t debugPeekCartridge( bool rcart1, uint64_t period, std::span<uint8_t> out );
+  //Copies cartridge loader loops in RAM in bulk, see BootROMTraps. Off by default as it is not cycle exact
+  void enableFastBoot();
   std::shared_ptr<TraceHelper> getTraceHelper() const;
   std::shared_ptr<ScriptDebugger> getScriptDebugger() const;
+  //Not thread safe. Snapshots are published at each vertical blank while set. Call with nullptr to stop
+  void setDebugSnapshots( std::shared_ptr<DebugSnapshots> debugSnapshots );
+  //Not thread safe. Publishes snapshot of current state
+  void publishDebugSnapshot();
 
 private:
 
@@ -90,6 +109,7 @@ private:
   uint8_t fetchRAM( uint16_t address );
   uint8_t readRAM( uint16_t address );
   void writeRAM( uint16_t address, uint8_t value );
+  void markRAMWritten( uint16_t address );
   uint8_t readMikey( uint16_t address );
   void writeMikey( uint16_t address, uint8_t value );
   uint8_t readSuzy( uint16_t address );
@@ -105,9 +125,11 @@ private:
   void assertInterrupt( int mask, std::optional<uint64_t> tick = std::nullopt );
   void desertInterrupt( int mask, std::optional<uint64_t> tick = std::nullopt );
   void requestDisplayDMA( uint64_t tick, uint16_t address );
+  void requestAction( SequencedAction action );
   void runSuzy();
   Cartridge & getCartridge();
   void newLine( int rowNr );  
+  void newFrame();
   inline uint64_t fetchRAMTiming( uint16_t address );
   inline uint64_t fetchROMTiming( uint16_t address );
   inline uint64_t readTiming( uint16_t address );
@@ -119,11 +141,13 @@ private:
 
 private:
   std::array<uint8_t, 65536> mRAM;
+  //incremented on each write to a RAM page to detect stale data derived from it
+  std::array<uint32_t, 256> mRAMPageGenerations;
   std::array<uint8_t, 512> mROM;
   std::array<PageType, 256> mPageTypes;
   std::shared_ptr<ScriptDebugger> mScriptDebugger;
+  std::shared_ptr<DebugSnapshots> mDebugSnapshots;
   uint64_t mCurrentTick;
-  int mSamplesRemainder;
   int mSPS;
   std::span<AudioSample> mOutputSamples;
   uint32_t mSamplesEmitted;
@@ -139,8 +163,9 @@ private:
   uint64_t mFastCycleTick;
   uint16_t mDMAAddress;
   std::shared_ptr<ISuzyProcess> mSuzyProcess;
-  ISuzyProcess::Request const* mSuzyProcessRequest;
+  std::span<ISuzyProcess::Request const> mSuzyProcessRequests;
   bool mResetRequestDuringSpriteRendering;
   bool mSuzyRunning;
   bool mHaltSuzy;
+  bool mFastBoot;
 };
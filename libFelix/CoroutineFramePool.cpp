@@ -0,0 +1,79 @@
+#include "CoroutineFramePool.hpp"
+
+namespace
+{
+
+class FrameList
+{
+public:
+  FrameList() : mHead{}, mHeapAllocations{}
+  {
+  }
+
+  ~FrameList()
+  {
+    while ( mHead )
+    {
+      auto next = mHead->next;
+      ::operator delete( mHead );
+      mHead = next;
+    }
+  }
+
+  void * allocate( size_t size )
+  {
+    for ( FreeFrame ** link = &mHead; *link; link = &( *link )->next )
+    {
+      if ( ( *link )->size == size )
+      {
+        FreeFrame * frame = *link;
+        *link = frame->next;
+        return frame;
+      }
+    }
+
+    mHeapAllocations += 1;
+    return ::operator new( std::max( size, sizeof( FreeFrame ) ) );
+  }
+
+  void release( void * frame, size_t size )
+  {
+    mHead = new ( frame ) FreeFrame{ mHead, size };
+  }
+
+  uint64_t heapAllocations() const
+  {
+    return mHeapAllocations;
+  }
+
+private:
+  //free frame is linked through its own memory
+  struct FreeFrame
+  {
+    FreeFrame * next;
+    size_t size;
+  };
+
+  FreeFrame * mHead;
+  uint64_t mHeapAllocations;
+};
+
+//there are only a few coroutines alive at any time, so a list per thread is enough
+thread_local FrameList gFrameList;
+
+}
+
+void * CoroutineFramePool::allocate( size_t size )
+{
+  return gFrameList.allocate( size );
+}
+
+void CoroutineFramePool::release( void * frame, size_t size )
+{
+  gFrameList.release( frame, size );
+}
+
+uint64_t CoroutineFramePool::heapAllocations()
+{
+  return gFrameList.heapAllocations();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+//Recycles coroutine frames freed by the calling thread, so coroutines restarted over and over do not reach the heap.
+//Frames are reused only for coroutines of the same frame size.
+class CoroutineFramePool
+{
+public:
+  static void * allocate( size_t size );
+  static void release( void * frame, size_t size );
+  //number of frames taken from the heap by the calling thread
+  static uint64_t heapAllocations();
+};
+
+//Promise types inheriting from this struct get their coroutine frames from CoroutineFramePool
+struct PooledFrame
+{
+  static void * operator new( size_t size )
+  {
+    return CoroutineFramePool::allocate( size );
+  }
+
+  static void operator delete( void * frame, size_t size )
+  {
+    CoroutineFramePool::release( frame, size );
+  }
+};
@@ -0,0 +1,69 @@
+#include "DebugSnapshot.hpp"
+
+DebugSnapshots::DebugSnapshots() : mSnapshots{}, mReady{ 1 }, mRequested{}, mEditsMutex{}, mEdits{}, mBack{ 2 }, mFront{}
+{
+}
+
+DebugSnapshot& DebugSnapshots::back()
+{
+  return mSnapshots[mBack];
+}
+
+void DebugSnapshots::publish()
+{
+  mBack = mReady.exchange( mBack | FRESH, std::memory_order_acq_rel ) & ~FRESH;
+}
+
+//acquire pairs with release in request, so whatever consumer did before asking is visible to producer
+bool DebugSnapshots::requested()
+{
+  return mRequested.load( std::memory_order_acquire ) && mRequested.exchange( false, std::memory_order_acquire );
+}
+
+void DebugSnapshots::applyEdits( Core& core )
+{
+  std::vector<Edit> edits;
+  {
+    std::scoped_lock<std::mutex> l{ mEditsMutex };
+    std::swap( edits, mEdits );
+  }
+
+  for ( auto const& edit : edits )
+  {
+    edit( core );
+  }
+}
+
+void DebugSnapshots::discardEdits()
+{
+  std::scoped_lock<std::mutex> l{ mEditsMutex };
+  mEdits.clear();
+}
+
+DebugSnapshot const* DebugSnapshots::nextSnapshot()
+{
+  if ( ( mReady.load( std::memory_order_relaxed ) & FRESH ) == 0 )
+    return nullptr;
+
+  mFront = mReady.exchange( mFront, std::memory_order_acq_rel ) & ~FRESH;
+  return &mSnapshots[mFront];
+}
+
+DebugSnapshot const& DebugSnapshots::currentSnapshot() const
+{
+  return mSnapshots[mFront];
+}
+
+void DebugSnapshots::request()
+{
+  mRequested.store( true, std::memory_order_release );
+}
+
+void DebugSnapshots::edit( Edit edit )
+{
+  {
+    std::scoped_lock<std::mutex> l{ mEditsMutex };
+    mEdits.push_back( std::move( edit ) );
+  }
+  request();
+}
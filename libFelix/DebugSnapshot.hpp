@@ -0,0 +1,62 @@
+#pragma once
+#include "CPUState.hpp"
+
+class Core;
+
+//Consistent copy of emulator state read by debug windows instead of live emulator state
+struct DebugSnapshot
+{
+  std::array<uint8_t, 65536> ram;
+  std::array<uint8_t, 512> rom;
+  CPUState cpu;
+  std::array<uint8_t, 32> palette;
+  uint16_t dispAdr;
+  uint16_t vidBas;
+  uint16_t collBas;
+  uint64_t tick;
+};
+
+//Triple buffered snapshots. Filled by emulation thread at vertical blank or when emulation stops and read by render thread.
+//Producer and consumer never wait for each other. Snapshots published while the consumer was busy are skipped.
+//Debug windows do not write emulator state themselves but queue edits that the producer applies before publishing.
+class DebugSnapshots
+{
+public:
+  using Edit = std::function<void( Core& core )>;
+
+  DebugSnapshots();
+  ~DebugSnapshots() = default;
+
+  //producer side. Snapshot to fill before publishing it
+  DebugSnapshot& back();
+  void publish();
+  //Producer side. Whether consumer asked for a snapshot since last call, e.g. after editing stopped emulator state
+  bool requested();
+  //Producer side. Applies edits queued since last call in order
+  void applyEdits( Core& core );
+  //Drops queued edits, e.g. when the emulator they were made for is gone
+  void discardEdits();
+
+  //Consumer side. Returns latest published snapshot or nullptr if nothing was published since last call
+  DebugSnapshot const* nextSnapshot();
+  //Consumer side. Last snapshot returned by nextSnapshot
+  DebugSnapshot const& currentSnapshot() const;
+  void request();
+  //Consumer side. Queues edit of emulator state and requests snapshot showing it
+  void edit( Edit edit );
+
+private:
+  static constexpr uint32_t FRESH = 0x80000000;
+
+  std::array<DebugSnapshot, 3> mSnapshots;
+  //index of snapshot waiting for the consumer with FRESH flag set if it was not taken yet
+  std::atomic<uint32_t> mReady;
+  std::atomic<bool> mRequested;
+  //guards only the queue, held for a push or a swap
+  std::mutex mEditsMutex;
+  std::vector<Edit> mEdits;
+  //producer owned
+  uint32_t mBack;
+  //consumer owned
+  uint32_t mFront;
+};
@@ -1,14 +1,22 @@
 #include "DisplayGenerator.hpp"
 #include "IVideoSink.hpp"
 #include "Log.hpp"
+#include "Simd.hpp"
 
 DisplayGenerator::DisplayGenerator( std::shared_ptr<IVideoSink> videoSink ) :
-  mDMAData{}, mVideoSink{ std::move( videoSink ) }, mRowStartTick{ std::numeric_limits<uint64_t>::max() }, mDMAIteration{}, mDisplayRow{}, mEmittedRowDoublets{},
-  mDispAdr{}, mDispColor{}, mDispFlip{}, mDMAEnable{}, mDMAOffset{ -1 }, mRowPtr{}
+  mVectorConvert{}, mDMAData{}, mVideoSink{ std::move( videoSink ) }, mRowStartTick{ std::numeric_limits<uint64_t>::max() }, mDMAIteration{}, mDisplayRow{}, mEmittedRowDoublets{},
+  mDispAdr{}, mDispColor{}, mDispFlip{}, mDMAEnable{}, mDMAOffset{ -1 }, mRowPtr{}, mPenRowPtr{}, mPenOutput{}
 {
   assert( mVideoSink );
+  mPenOutput = mVideoSink->format() == IVideoSink::Format::PENS;
   std::ranges::fill( mPalette, 0 );
   std::ranges::fill( mDoublets, Doublet{} );
+  std::ranges::fill( mBlue, 0 );
+  std::ranges::fill( mGreen, 0 );
+  std::ranges::fill( mRed, 0 );
+#if defined( FELIX_SSE2 )
+  mVectorConvert = simd::ssse3();
+#endif
 }
 
 void DisplayGenerator::dispCtl( bool dispColor, bool dispFlip, bool dmaEnable )
@@ -46,7 +54,10 @@ DisplayGenerator::DMARequest DisplayGenerator::hblank( uint64_t tick, int row )
   mDisplayRow = 101 - row;
   if ( mDisplayRow >= 0 && mDMAOffset >= 0 )
   {
-    mRowPtr = mVideoSink->getRow( mDisplayRow );
+    if ( mPenOutput )
+      mPenRowPtr = mVideoSink->getPenRow( mDisplayRow );
+    else
+      mRowPtr = mVideoSink->getRow( mDisplayRow );
     mRowStartTick = tick + mDMAOffset;
     if ( mDMAEnable )
     {
@@ -89,6 +100,7 @@ void DisplayGenerator::setColorReg( uint64_t tick, uint8_t reg, uint8_t value )
 
     //green
     uint8_t g = ( value << 4 ) | ( value & 0x0f );
+    mGreen[regLo] = g;
 
     for ( uint32_t i = regHi; i < regHi + 16; ++i )
     {
@@ -109,6 +121,8 @@ void DisplayGenerator::setColorReg( uint64_t tick, uint8_t reg, uint8_t value )
     uint8_t b = ( value >> 4 ) | ( value & 0xf0 );
     //red
     uint8_t r = ( value << 4 ) | ( value & 0x0f );
+    mBlue[regLo] = b;
+    mRed[regLo] = r;
 
     for ( uint32_t i = regHi; i < regHi + 16; ++i )
     {
@@ -121,6 +135,14 @@ void DisplayGenerator::setColorReg( uint64_t tick, uint8_t reg, uint8_t value )
       mDoublets[i].right.r = r;
     }
   }
+
+  if ( mPenOutput )
+  {
+    if ( mRowStartTick != std::numeric_limits<uint64_t>::max() && mDisplayRow >= 0 )
+      mVideoSink->colorReg( mDisplayRow, ( int )mEmittedRowDoublets * 2, reg, mPalette[reg] );
+    else
+      mVideoSink->colorReg( -1, 0, reg, mPalette[reg] );
+  }
 }
 
 uint8_t DisplayGenerator::getColorReg( uint8_t reg ) const
@@ -135,13 +157,87 @@ std::span<uint8_t const, 32> DisplayGenerator::debugPalette() const
 
 void DisplayGenerator::flushDisplay( uint64_t tick )
 {
-  if ( tick > mRowStartTick )
+  if ( tick <= mRowStartTick )
+    return;
+
+  uint32_t limit = ( std::min )( ROW_BYTES, ( uint32_t )( tick - mRowStartTick ) / ( ( uint32_t )TICKS_PER_BYTE ) );
+  if ( limit > mEmittedRowDoublets )
   {
-    for ( uint32_t limit = ( std::min )( ROW_BYTES, ( uint32_t )( tick - mRowStartTick ) / ( ( uint32_t )TICKS_PER_BYTE ) ); mEmittedRowDoublets < limit; ++mEmittedRowDoublets )
+    //NOTICE - pixels are processed in byte pairs, so in this implementation it is not possible to alter color register between nibbles of a screen byte.
+    //Color register writes flush the row up to the write, so a row with palette changes is converted in segments
+    std::span<uint8_t const> row{ std::bit_cast< uint8_t const* >( mDMAData.data() ), ROW_BYTES };
+    auto segment = row.subspan( mEmittedRowDoublets, limit - mEmittedRowDoublets );
+    if ( mPenOutput )
     {
-      //NOTICE - pixels are processed in byte pairs, so in this implementation it is not possible to alter color register between nibbles of a screen byte
-      *mRowPtr++ = mDoublets[std::bit_cast< uint8_t const* >( mDMAData.data() )[mEmittedRowDoublets]];
+      std::ranges::copy( segment, mPenRowPtr );
+      mPenRowPtr += segment.size();
     }
+    else
+    {
+      convert( segment, mRowPtr );
+      mRowPtr += segment.size();
+    }
+    mEmittedRowDoublets = limit;
+  }
+}
+
+#if defined( FELIX_SSE2 )
+
+namespace
+{
+
+//16-entry lookups of each color component with SSSE3 byte shuffles. Eight screen bytes make sixteen pixels.
+//Returns number of bytes converted, which is a multiple of eight
+FELIX_TARGET( "ssse3" )
+size_t convertSSSE3( std::span<uint8_t const> data, uint8_t const* blueTable, uint8_t const* greenTable, uint8_t const* redTable, Doublet* out )
+{
+  const __m128i blue = _mm_load_si128( (__m128i const*)blueTable );
+  const __m128i green = _mm_load_si128( (__m128i const*)greenTable );
+  const __m128i red = _mm_load_si128( (__m128i const*)redTable );
+  const __m128i nibble = _mm_set1_epi8( 0x0f );
+  const __m128i zero = _mm_setzero_si128();
+
+  size_t i = 0;
+  for ( ; i + 8 <= data.size(); i += 8 )
+  {
+    __m128i bytes = _mm_loadl_epi64( (__m128i const*)( data.data() + i ) );
+    //left pixel is in the high nibble
+    __m128i pens = _mm_unpacklo_epi8( _mm_and_si128( _mm_srli_epi16( bytes, 4 ), nibble ), _mm_and_si128( bytes, nibble ) );
+    __m128i b = _mm_shuffle_epi8( blue, pens );
+    __m128i g = _mm_shuffle_epi8( green, pens );
+    __m128i r = _mm_shuffle_epi8( red, pens );
+    __m128i bgLo = _mm_unpacklo_epi8( b, g );
+    __m128i bgHi = _mm_unpackhi_epi8( b, g );
+    __m128i rxLo = _mm_unpacklo_epi8( r, zero );
+    __m128i rxHi = _mm_unpackhi_epi8( r, zero );
+    __m128i* dst = (__m128i*)( out + i );
+    _mm_storeu_si128( dst + 0, _mm_unpacklo_epi16( bgLo, rxLo ) );
+    _mm_storeu_si128( dst + 1, _mm_unpackhi_epi16( bgLo, rxLo ) );
+    _mm_storeu_si128( dst + 2, _mm_unpacklo_epi16( bgHi, rxHi ) );
+    _mm_storeu_si128( dst + 3, _mm_unpackhi_epi16( bgHi, rxHi ) );
+  }
+
+  return i;
+}
+
+}
+
+#endif
+
+void DisplayGenerator::convert( std::span<uint8_t const> data, Doublet* out ) const
+{
+  size_t i = 0;
+
+#if defined( FELIX_SSE2 )
+  if ( mVectorConvert )
+  {
+    i = convertSSSE3( data, mBlue.data(), mGreen.data(), mRed.data(), out );
+  }
+#endif
+
+  for ( ; i < data.size(); ++i )
+  {
+    out[i] = mDoublets[data[i]];
   }
 }
 
@@ -36,6 +36,8 @@ public:
   void setColorReg( uint64_t tick, uint8_t reg, uint8_t value );
   uint8_t getColorReg( uint8_t reg ) const;
   std::span<uint8_t const, 32> debugPalette() const;
+  //converts screen bytes to pixels with current palette
+  void convert( std::span<uint8_t const> data, Doublet* out ) const;
 
   bool rest() const override;
 
@@ -45,6 +47,12 @@ private:
 private:
 
   std::array<Doublet, 256> mDoublets;
+  //color components of each pen for vectorized conversion
+  alignas( 16 ) std::array<uint8_t, 16> mBlue;
+  alignas( 16 ) std::array<uint8_t, 16> mGreen;
+  alignas( 16 ) std::array<uint8_t, 16> mRed;
+  //whether the CPU can do the vectorized conversion, checked once as convert is called for each display DMA
+  bool mVectorConvert;
   std::array<uint8_t, 32> mPalette;
   std::array<uint64_t,10> mDMAData;
   std::shared_ptr<IVideoSink> mVideoSink;
@@ -58,6 +66,8 @@ private:
   bool mDMAEnable;
   int mDMAOffset;
   Doublet* mRowPtr;
+  uint8_t* mPenRowPtr;
+  bool mPenOutput;
 
   static constexpr uint64_t DMA_FETCH_SIZE = 8;
   static constexpr uint64_t TICKS_PER_PIXEL = 12;
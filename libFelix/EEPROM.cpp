@@ -1,9 +1,10 @@
 #include "EEPROM.hpp"
 #include "ImageProperties.hpp"
 #include "TraceHelper.hpp"
+#include "EEPROMFlusher.hpp"
 
-EEPROM::EEPROM( std::filesystem::path imagePath, int eeType, bool is16Bit, std::shared_ptr<TraceHelper> traceHelper ) : mEECoroutine{}, mImagePath{ std::move( imagePath ) },
-  mTraceHelper{ std::move( traceHelper ) }, mData{}, mOpcodeBits{}, mAddressMask{}, mDataBits{}, mWriteEnable{}, mChanged{ true }
+EEPROM::EEPROM( std::filesystem::path imagePath, int eeType, bool is16Bit, std::shared_ptr<TraceHelper> traceHelper ) : io{}, mEECoroutine{}, mImagePath{ std::move( imagePath ) },
+  mTraceHelper{ std::move( traceHelper ) }, mData{}, mOpcodeBits{}, mAddressMask{}, mDataBits{}, mWriteEnable{}, mFlusher{}
 {
   assert( eeType > 0 && eeType < 6 );
 
@@ -47,28 +48,20 @@ EEPROM::EEPROM( std::filesystem::path imagePath, int eeType, bool is16Bit, std::
     mDataBits = 8;
   }
 
-  if ( std::filesystem::exists( mImagePath ) )
+  bool exists = std::filesystem::exists( mImagePath );
+  if ( exists )
   {
     auto size = std::min( (size_t)std::filesystem::file_size( mImagePath ), mData.size() );
     std::ifstream fin{ mImagePath, std::ios::binary };
     fin.read( (char*)mData.data(), size );
-    mChanged = false;
   }
+
+  //missing image is created with erased contents
+  mFlusher = std::make_unique<EEPROMFlusher>( mImagePath, std::span<uint8_t const>{ mData.data(), mData.size() }, !exists );
 }
 
 EEPROM::~EEPROM()
 {
-  if ( mChanged )
-  {
-    try
-    {
-      std::ofstream fout{ mImagePath, std::ios::binary };
-      fout.write( (char const*)mData.data(), mData.size() );
-    }
-    catch ( ... )
-    {
-    }
-  }
 }
 
 std::unique_ptr<EEPROM> EEPROM::create( ImageProperties const& imageProperties, std::shared_ptr<TraceHelper> traceHelper )
@@ -252,15 +245,11 @@ void EEPROM::write( int address, int data, bool erase )
       address <<= 1;
       if ( address < ( int )mData.size() )
       {
-        if ( mData[address] != ( data & 0xff ) )
+        if ( mData[address] != ( data & 0xff ) || mData[address + 1] != ( ( data >> 8 ) & 0xff ) )
         {
-          mChanged = true;
           mData[address] = data & 0xff;
-        }
-        if ( mData[address + 1] != ( ( data >> 8 ) & 0xff ) )
-        {
-          mChanged = true;
           mData[address + 1] = ( data >> 8 ) & 0xff;
+          changed( address, 2 );
         }
       }
       if ( erase )
@@ -270,9 +259,10 @@ void EEPROM::write( int address, int data, bool erase )
     }
     else
     {
-      if ( address < ( int )mData.size() )
+      if ( address < ( int )mData.size() && mData[address] != ( data & 0xff ) )
       {
         mData[address] = data & 0xff;
+        changed( address, 1 );
       }
       if ( erase )
         mTraceHelper->comment< "EEPROM: EXECUTE ERASE8 ${:x}" >( address );
@@ -308,7 +298,7 @@ void EEPROM::eral()
   {
     mTraceHelper->comment< "EEPROM: EXECUTE ERAL." >();
     std::ranges::fill( mData, 0xff );
-    mChanged = true;
+    changed( 0, ( int )mData.size() );
     startProgram( ERAL_TICKS );
   }
   else
@@ -334,7 +324,7 @@ void EEPROM::wral( int data )
       std::ranges::fill( mData, data & 0xff );
       mTraceHelper->comment< "EEPROM: EXECUTE WRAL8 ${:x}." >( data );
     }
-    mChanged = true;
+    changed( 0, ( int )mData.size() );
     startProgram( WRAL_TICKS );
   }
   else
@@ -356,6 +346,11 @@ void EEPROM::ewds()
   mWriteEnable = false;
 }
 
+void EEPROM::changed( int address, int size )
+{
+  mFlusher->update( std::span<uint8_t const>{ mData.data(), mData.size() }, ( size_t )address, ( size_t )size );
+}
+
 void EEPROM::startProgram( uint64_t duration )
 {
   io.busyUntil = io.currentTick + WRITE_TICKS;
@@ -1,9 +1,11 @@
 #pragma once
 #include "Utility.hpp"
+#include "CoroutineFramePool.hpp"
 
 class ImageCart;
 class TraceHelper;
 class ImageProperties;
+class EEPROMFlusher;
 
 class EEPROM
 {
@@ -43,6 +45,8 @@ private:
   void eral();
   void wral( int data );
   void ewds();
+  //hands over changed bytes to flusher
+  void changed( int address, int size );
 
   void startProgram( uint64_t duration );
 
@@ -52,7 +56,7 @@ private:
     struct promise_type;
     using handle = std::coroutine_handle<promise_type>;
 
-    struct promise_type
+    struct promise_type : PooledFrame
     {
       promise_type( EEPROM& ee ) : mEE{ ee }
       {
@@ -136,7 +140,7 @@ private:
     int mAddressMask;
     int mDataBits;
     bool mWriteEnable;
-    bool mChanged;
+    std::unique_ptr<EEPROMFlusher> mFlusher;
 
     static constexpr uint64_t WRITE_TICKS = 10 * 16;
     static constexpr uint64_t ERAL_TICKS = 15 * 16;
@@ -0,0 +1,124 @@
+#include "EEPROMFlusher.hpp"
+
+EEPROMFlusher::EEPROMFlusher( std::filesystem::path path, std::span<uint8_t const> image, bool dirty ) : EEPROMFlusher{ [path = std::move( path )]( std::span<uint8_t const> image )
+{
+  return storeFile( path, image );
+}, image, dirty }
+{
+}
+
+EEPROMFlusher::EEPROMFlusher( Store store, std::span<uint8_t const> image, bool dirty ) : mState{ std::make_shared<State>() }, mThread{}
+{
+  mState->store = std::move( store );
+  mState->shared.assign( image.begin(), image.end() );
+  mState->dirtyBegin = 0;
+  mState->dirtyEnd = dirty ? image.size() : 0;
+  mState->stop = false;
+  mState->stopped = false;
+
+  mThread = std::thread{ [state = mState]
+  {
+    flushLoop( *state );
+  } };
+}
+
+EEPROMFlusher::~EEPROMFlusher()
+{
+  bool stopped;
+  {
+    std::unique_lock lock{ mState->mutex };
+    mState->stop = true;
+    mState->condition.notify_all();
+    //a store stalled by the file system must not hang whoever destroys the EEPROM
+    stopped = mState->condition.wait_for( lock, STOP_TIMEOUT, [this]
+    {
+      return mState->stopped;
+    } );
+  }
+
+  if ( stopped )
+    mThread.join();
+  else
+    mThread.detach();
+}
+
+void EEPROMFlusher::update( std::span<uint8_t const> image, size_t offset, size_t size )
+{
+  assert( image.size() == mState->shared.size() && offset + size <= image.size() );
+
+  if ( size == 0 )
+    return;
+
+  bool wasClean;
+  {
+    std::unique_lock lock{ mState->mutex };
+    std::copy_n( image.begin() + offset, size, mState->shared.begin() + offset );
+    wasClean = mState->dirtyBegin == mState->dirtyEnd;
+    mState->dirtyBegin = wasClean ? offset : std::min( mState->dirtyBegin, offset );
+    mState->dirtyEnd = wasClean ? offset + size : std::max( mState->dirtyEnd, offset + size );
+  }
+
+  if ( wasClean )
+    mState->condition.notify_all();
+}
+
+bool EEPROMFlusher::storeFile( std::filesystem::path const& path, std::span<uint8_t const> image )
+{
+  auto tmp = path;
+  tmp += ".tmp";
+
+  {
+    std::ofstream fout{ tmp, std::ios::binary };
+    fout.write( (char const*)image.data(), image.size() );
+    fout.close();
+    if ( !fout )
+      return false;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename( tmp, path, ec );
+  return !ec;
+}
+
+void EEPROMFlusher::flushLoop( State& state )
+{
+  std::unique_lock lock{ state.mutex };
+  //emulation thread may hand over changes as soon as the thread starts, so the image is copied under the lock
+  std::vector<uint8_t> image = state.shared;
+  //every store writes whole image, so changes of a failed store are retried with the next one
+  bool stored = true;
+
+  for ( ;; )
+  {
+    state.condition.wait( lock, [&]
+    {
+      return state.stop || state.dirtyBegin != state.dirtyEnd;
+    } );
+
+    if ( state.dirtyBegin == state.dirtyEnd )
+    {
+      if ( !stored )
+      {
+        lock.unlock();
+        state.store( image );
+        lock.lock();
+      }
+      state.stopped = true;
+      state.condition.notify_all();
+      return;
+    }
+
+    //lets a burst of writes finish before storing
+    state.condition.wait_for( lock, COALESCE_TIME, [&]
+    {
+      return state.stop;
+    } );
+
+    std::copy( state.shared.begin() + state.dirtyBegin, state.shared.begin() + state.dirtyEnd, image.begin() + state.dirtyBegin );
+    state.dirtyBegin = state.dirtyEnd = 0;
+
+    lock.unlock();
+    stored = state.store( image );
+    lock.lock();
+  }
+}
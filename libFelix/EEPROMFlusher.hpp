@@ -0,0 +1,49 @@
+#pragma once
+#include "Utility.hpp"
+
+//Persists EEPROM image on a background thread.
+//Emulation thread hands over changed bytes, flusher coalesces changes arriving close together and stores the whole image.
+//Emulation thread only copies changed bytes under a lock that the flusher never holds while storing.
+//Thread shares ownership of everything it uses, so it can be left to finish a stalled store on its own.
+class EEPROMFlusher : NonCopyable
+{
+public:
+  //stores image and returns whether it succeeded
+  using Store = std::function<bool( std::span<uint8_t const> )>;
+
+  //stores to path through temporary file renamed over it, so a crash leaves either old or new image
+  EEPROMFlusher( std::filesystem::path path, std::span<uint8_t const> image, bool dirty );
+  EEPROMFlusher( Store store, std::span<uint8_t const> image, bool dirty );
+  //stores pending changes, waiting at most STOP_TIMEOUT for the store before leaving it to the thread
+  ~EEPROMFlusher();
+
+  //hands over size bytes at offset of image that have changed
+  void update( std::span<uint8_t const> image, size_t offset, size_t size );
+
+  static bool storeFile( std::filesystem::path const& path, std::span<uint8_t const> image );
+
+  //changes arriving within this time after the first one are stored together
+  static constexpr std::chrono::milliseconds COALESCE_TIME{ 100 };
+  static constexpr std::chrono::seconds STOP_TIMEOUT{ 1 };
+
+private:
+  struct State
+  {
+    Store store;
+    std::mutex mutex;
+    std::condition_variable condition;
+    //image with changes handed over by emulation thread
+    std::vector<uint8_t> shared;
+    //range of shared changed since last store
+    size_t dirtyBegin;
+    size_t dirtyEnd;
+    bool stop;
+    //thread has stored pending changes after stop and is about to exit
+    bool stopped;
+  };
+
+  static void flushLoop( State& state );
+
+  std::shared_ptr<State> mState;
+  std::thread mThread;
+};
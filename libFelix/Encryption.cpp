@@ -1,42 +1,151 @@
 #include "Encryption.hpp"
 #include "Log.hpp"
 
-#define BOOST_MP_STANDALONE
-#include <boost/multiprecision/cpp_int.hpp>
+namespace
+{
+
+//408 bit block held in 32 bit limbs, least significant first. 32 bit limbs keep products in uint64_t on every compiler.
+static constexpr size_t BLOCK_BYTES = 51;
+static constexpr size_t LIMBS = ( BLOCK_BYTES + 3 ) / 4;
+
+using Number = std::array<uint32_t, LIMBS>;
+
+//lynx public modulus 0x35b5a3942806d8a22695d771b23cfd561c4a19b6a3b02600365a306e3c4d63381bd41c136489364cf2ba2a58f4fee1fdac7e79
+static constexpr Number LYNX_PUB_MOD = {
+  0xfdac7e79, 0x58f4fee1, 0x4cf2ba2a, 0x13648936, 0x381bd41c, 0x6e3c4d63, 0x00365a30,
+  0xb6a3b026, 0x561c4a19, 0x71b23cfd, 0xa22695d7, 0x942806d8, 0x0035b5a3
+};
+
+constexpr bool greaterOrEqual( Number const& a, Number const& b )
+{
+  for ( size_t i = LIMBS; i-- > 0; )
+  {
+    if ( a[i] != b[i] )
+      return a[i] > b[i];
+  }
+  return true;
+}
+
+constexpr void subtract( Number& a, Number const& b )
+{
+  uint64_t borrow = 0;
+  for ( size_t i = 0; i < LIMBS; ++i )
+  {
+    uint64_t const diff = (uint64_t)a[i] - b[i] - borrow;
+    a[i] = (uint32_t)diff;
+    borrow = ( diff >> 32 ) & 1;
+  }
+}
+
+//-N^-1 mod 2^32 by Newton iteration, each step doubles the number of correct bits
+constexpr uint32_t montgomeryInverse( uint32_t n )
+{
+  uint32_t inv = 1;
+  for ( int i = 0; i < 5; ++i )
+  {
+    inv *= 2 - n * inv;
+  }
+  return 0 - inv;
+}
+
+//R^2 mod N where R = 2^(32 * LIMBS), by doubling 1 modulo N
+constexpr Number montgomeryR2( Number const& n )
+{
+  Number r{ 1 };
+  for ( size_t i = 0; i < 2 * 32 * LIMBS; ++i )
+  {
+    uint32_t carry = 0;
+    for ( size_t j = 0; j < LIMBS; ++j )
+    {
+      uint32_t const next = r[j] >> 31;
+      r[j] = ( r[j] << 1 ) | carry;
+      carry = next;
+    }
+    if ( carry != 0 || greaterOrEqual( r, n ) )
+      subtract( r, n );
+  }
+  return r;
+}
+
+static constexpr uint32_t LYNX_PUB_MOD_INV = montgomeryInverse( LYNX_PUB_MOD[0] );
+static constexpr Number LYNX_PUB_MOD_R2 = montgomeryR2( LYNX_PUB_MOD );
+
+//a * b * R^-1 mod N. Operands need a * b < N * R, so one of them may be any block not reduced modulo N
+Number montgomeryMultiply( Number const& a, Number const& b )
+{
+  std::array<uint32_t, LIMBS + 2> t{};
+
+  for ( size_t i = 0; i < LIMBS; ++i )
+  {
+    uint64_t carry = 0;
+    for ( size_t j = 0; j < LIMBS; ++j )
+    {
+      uint64_t const sum = t[j] + (uint64_t)a[j] * b[i] + carry;
+      t[j] = (uint32_t)sum;
+      carry = sum >> 32;
+    }
+    uint64_t sum = t[LIMBS] + carry;
+    t[LIMBS] = (uint32_t)sum;
+    t[LIMBS + 1] = (uint32_t)( sum >> 32 );
+
+    uint32_t const m = t[0] * LYNX_PUB_MOD_INV;
+    carry = ( t[0] + (uint64_t)m * LYNX_PUB_MOD[0] ) >> 32;
+    for ( size_t j = 1; j < LIMBS; ++j )
+    {
+      sum = t[j] + (uint64_t)m * LYNX_PUB_MOD[j] + carry;
+      t[j - 1] = (uint32_t)sum;
+      carry = sum >> 32;
+    }
+    sum = t[LIMBS] + carry;
+    t[LIMBS - 1] = (uint32_t)sum;
+    t[LIMBS] = t[LIMBS + 1] + (uint32_t)( sum >> 32 );
+  }
+
+  Number result;
+  std::copy_n( t.begin(), LIMBS, result.begin() );
+  if ( t[LIMBS] != 0 || greaterOrEqual( result, LYNX_PUB_MOD ) )
+    subtract( result, LYNX_PUB_MOD );
+  return result;
+}
+
+//enc^3 mod N. Squaring and multiplying in Montgomery form cancel R^-1 of each other after entering it with R^2
+Number cube( Number const& enc )
+{
+  Number const encR = montgomeryMultiply( enc, LYNX_PUB_MOD_R2 );
+  Number const enc2R = montgomeryMultiply( encR, encR );
+  return montgomeryMultiply( enc2R, enc );
+}
 
 uint8_t decrypt( std::span<uint8_t const> encrypted, int& accumulator, std::vector<uint8_t>& result )
 {
-  using namespace boost::multiprecision;
-  using namespace boost::multiprecision::literals;
+  Number enc{};
+  for ( size_t i = 0; i < BLOCK_BYTES; ++i )
+  {
+    enc[i / 4] |= (uint32_t)encrypted[i] << ( 8 * ( i % 4 ) );
+  }
 
-  uint512_t constexpr lynxpubmod = 0x35b5a3942806d8a22695d771b23cfd561c4a19b6a3b02600365a306e3c4d63381bd41c136489364cf2ba2a58f4fee1fdac7e79_cppui512;
-  uint512_t constexpr lynxprvexp = 0x23ce6d0d7004906c19b93a4bcc28a8e412dc11246d2019557987ab5ca818a3d3c8e3276d4270cb8021d6bda4296d47b1e5e2a3_cppui512;
-  uint512_t constexpr lynxpubexp = 3;
-  uint512_t enc;
-  import_bits( enc, encrypted.begin(), encrypted.end(), 8, false );
-  uint512_t decr = powm( enc, lynxpubexp, lynxpubmod );
-  std::vector<uint8_t> decrv;
-  export_bits( decr, std::back_inserter( decrv ), 8, false );
+  Number const decr = cube( enc );
 
-  for ( size_t i = 0; i < decrv.size() - 1; ++i ) //skipping last byte
+  for ( size_t i = 0; i < BLOCK_BYTES - 1; ++i ) //skipping last byte
   {
-    accumulator += decrv[i];
+    accumulator += (uint8_t)( decr[i / 4] >> ( 8 * ( i % 4 ) ) );
     result.push_back( accumulator );
   }
 
-  return decrv.back();
+  return (uint8_t)( decr[( BLOCK_BYTES - 1 ) / 4] >> ( 8 * ( ( BLOCK_BYTES - 1 ) % 4 ) ) );
 }
 
-std::vector<uint8_t> decrypt( size_t blockcount, std::span<uint8_t const> encrypted )
+std::vector<uint8_t> decryptBlocks( size_t blockcount, std::span<uint8_t const> encrypted )
 {
   std::vector<uint8_t> result;
+  result.reserve( ( BLOCK_BYTES - 1 ) * blockcount );
   int accumulator = 0;
   for ( size_t i = 0; i < blockcount; ++i )
   {
-    uint8_t sanityChek = decrypt( std::span<uint8_t const>{ encrypted.data() + 51 * i, 51 }, accumulator, result );
+    uint8_t sanityChek = decrypt( std::span<uint8_t const>{ encrypted.data() + BLOCK_BYTES * i, BLOCK_BYTES }, accumulator, result );
     if ( sanityChek != 0x15 )
     {
-      L_ERROR << "Sanity check #1 value for block " << i << " is 0x" << std::hex << sanityChek << " != 0x15";
+      L_ERROR << "Sanity check #1 value for block " << i << " is 0x" << std::hex << (int)sanityChek << " != 0x15";
       return {};
     }
   }
@@ -49,3 +158,41 @@ std::vector<uint8_t> decrypt( size_t blockcount, std::span<uint8_t const> encryp
   }
   return result;
 }
+
+//successfully decrypted loaders keyed by their encrypted contents, so loading an image, resetting it
+//and running more instances of it decrypt its loader once. Holds a few most recently used ones, last at the back
+static constexpr size_t CACHE_ENTRIES = 8;
+using CacheEntry = std::pair<std::string, std::vector<uint8_t>>;
+std::mutex gCacheMutex;
+std::vector<CacheEntry> gCache;
+
+}
+
+std::vector<uint8_t> decrypt( size_t blockcount, std::span<uint8_t const> encrypted )
+{
+  std::string key{ (char const*)encrypted.data(), BLOCK_BYTES * blockcount };
+
+  {
+    std::unique_lock lock{ gCacheMutex };
+    if ( auto it = std::ranges::find( gCache, key, &CacheEntry::first ); it != gCache.end() )
+    {
+      std::rotate( it, it + 1, gCache.end() );
+      return gCache.back().second;
+    }
+  }
+
+  auto result = decryptBlocks( blockcount, encrypted );
+
+  if ( !result.empty() )
+  {
+    std::unique_lock lock{ gCacheMutex };
+    if ( std::ranges::find( gCache, key, &CacheEntry::first ) == gCache.end() )
+    {
+      if ( gCache.size() == CACHE_ENTRIES )
+        gCache.erase( gCache.begin() );
+      gCache.emplace_back( std::move( key ), result );
+    }
+  }
+
+  return result;
+}
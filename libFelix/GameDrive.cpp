@@ -1,6 +1,7 @@
 #include "GameDrive.hpp"
 #include "CartBank.hpp"
 #include "ImageProperties.hpp"
+#include "ImageSource.hpp"
 #include "Log.hpp"
 
 GameDrive::GameDrive( std::filesystem::path const& imagePath ) : mMemoryBank{}, mBasePath { imagePath.parent_path() }, mBuffer{}, mGDCoroutine{ process() }, mReadTick{}
@@ -11,6 +12,7 @@ GameDrive::GameDrive( std::filesystem::path const& imagePath ) : mMemoryBank{},
 
 GameDrive::~GameDrive()
 {
+  detachLoader();
 }
 
 std::unique_ptr<GameDrive> GameDrive::create( ImageProperties const& imageProperties )
@@ -55,22 +57,169 @@ CartBank* GameDrive::getBank( uint64_t tick ) const
   return mProgrammedBank.get();
 }
 
+namespace
+{
+
+//whether name is a valid FAT 8.3 name: up to 8 characters, optionally followed by a dot and up to 3 characters of extension
+bool isShortName( std::string_view name )
+{
+  static constexpr std::string_view INVALID = " \"*+,./:;<=>?[\\]|";
+
+  auto const dot = name.find( '.' );
+  auto const stem = name.substr( 0, dot );
+  auto const extension = dot == std::string_view::npos ? std::string_view{} : name.substr( dot + 1 );
+
+  if ( stem.empty() || stem.size() > 8 || extension.size() > 3 || ( dot != std::string_view::npos && extension.empty() ) )
+    return false;
+
+  auto const valid = []( std::string_view part )
+  {
+    return std::ranges::all_of( part, []( char c )
+    {
+      return c > ' ' && (uint8_t)c < 0x80 && INVALID.find( c ) == std::string_view::npos;
+    } );
+  };
+
+  return valid( stem ) && valid( extension );
+}
+
+//path of name given by the guest below base directory, or nothing if it names an absolute path or one escaping base
+std::optional<std::filesystem::path> resolve( std::filesystem::path const& base, std::string const& name )
+{
+  auto const relative = std::filesystem::path{ name }.lexically_normal();
+  if ( relative.has_root_path() || ( !relative.empty() && *relative.begin() == ".." ) )
+    return std::nullopt;
+
+  return base / relative;
+}
+
+//directory entry as FatFs FILINFO without long file names
+struct DirEntry
+{
+  uint32_t size;
+  uint16_t date;
+  uint16_t time;
+  uint8_t attrib;
+  std::array<char, 13> name;
+};
+
+std::vector<DirEntry> listDirectory( std::filesystem::path const& path )
+{
+  static constexpr uint8_t AM_DIR = 0x10;
+  static constexpr uint8_t AM_ARC = 0x20;
+
+  std::vector<DirEntry> result;
+  std::error_code ec;
+  for ( auto const& entry : std::filesystem::directory_iterator{ path, ec } )
+  {
+    DirEntry dirEntry{};
+    bool const isDir = entry.is_directory( ec );
+    dirEntry.attrib = isDir ? AM_DIR : AM_ARC;
+    dirEntry.size = isDir ? 0 : (uint32_t)entry.file_size( ec );
+
+    auto const writeTime = entry.last_write_time( ec );
+    if ( !ec )
+    {
+      auto const sysTime = std::chrono::file_clock::to_sys( writeTime );
+      auto const days = std::chrono::floor<std::chrono::days>( sysTime );
+      std::chrono::year_month_day const ymd{ days };
+      std::chrono::hh_mm_ss const hms{ std::chrono::floor<std::chrono::seconds>( sysTime - days ) };
+      int const year = std::clamp( (int)ymd.year() - 1980, 0, 127 );
+      dirEntry.date = (uint16_t)( ( year << 9 ) | ( (unsigned)ymd.month() << 5 ) | (unsigned)ymd.day() );
+      dirEntry.time = (uint16_t)( ( hms.hours().count() << 11 ) | ( hms.minutes().count() << 5 ) | ( hms.seconds().count() / 2 ) );
+    }
+
+    //guest knows files by short names only and opens them by name, so those without one it could use are left out
+    auto const name = entry.path().filename().string();
+    if ( !isShortName( name ) )
+      continue;
+
+    std::ranges::copy( name, dirEntry.name.begin() );
+    result.push_back( dirEntry );
+  }
+
+  std::ranges::sort( result, []( DirEntry const& left, DirEntry const& right )
+  {
+    return std::string_view{ left.name.data() } < std::string_view{ right.name.data() };
+  } );
+
+  return result;
+}
+
+}
+
+std::shared_future<std::shared_ptr<ImageSource const>> GameDrive::load( std::filesystem::path const& path )
+{
+  std::promise<std::shared_ptr<ImageSource const>> promise;
+  auto result = promise.get_future().share();
+
+  //replacing the loader stops read ahead of previous file
+  detachLoader();
+  mLoader = std::jthread{ [path, promise = std::move( promise )]( std::stop_token stop ) mutable
+  {
+    auto source = ImageSource::open( path );
+    promise.set_value( source );
+
+    if ( source && source->mapped() )
+    {
+      //touching a byte of each page faults it in
+      static constexpr size_t PAGE_SIZE = 4096;
+      auto data = source->data();
+      for ( size_t i = 0; i < data.size() && !stop.stop_requested(); i += PAGE_SIZE )
+      {
+        ( void )*( volatile uint8_t const* )( data.data() + i );
+      }
+    }
+  } };
+
+  return result;
+}
+
+void GameDrive::detachLoader()
+{
+  //loader owns everything it uses
+  if ( mLoader.joinable() )
+  {
+    mLoader.request_stop();
+    mLoader.detach();
+  }
+}
+
 GameDrive::GDCoroutine GameDrive::process()
 {
   std::filesystem::path base = mBasePath;
   std::filesystem::path path{};
-  std::fstream file{};
-  std::vector<uint8_t> finData{};
+  std::shared_future<std::shared_ptr<ImageSource const>> pending{};
+  std::shared_ptr<ImageSource const> source{};
+  bool opened{};
+  //size seen by the guest, which grows when it seeks past the end of file
+  size_t fileSize{};
   size_t fileOffset{};
+  std::optional<std::vector<DirEntry>> dir{};
+  size_t dirOffset{};
   static constexpr uint64_t byteReadLatency = 120;
   static constexpr uint64_t blockReadLatency = 159 * 5 * 16;
   static constexpr uint64_t programByteLatency = 34;
 
+  auto data = [&]() -> std::span<uint8_t const>
+  {
+    if ( pending.valid() )
+    {
+      //waits only when guest reads sooner than loader thread opens the file
+      source = pending.get();
+      pending = {};
+    }
+    return source ? source->data() : std::span<uint8_t const>{};
+  };
+
   auto readByte = [&]()
   {
-    if ( fileOffset < finData.size() )
+    if ( fileOffset < fileSize )
     {
-      return finData[fileOffset++];
+      auto bytes = data();
+      uint8_t value = fileOffset < bytes.size() ? bytes[fileOffset] : uint8_t{};
+      fileOffset += 1;
+      return value;
     }
     else
     {
@@ -78,27 +227,75 @@ GameDrive::GDCoroutine GameDrive::process()
     }
   };
 
+  auto close = [&]()
+  {
+    pending = {};
+    source.reset();
+    opened = false;
+    fileSize = 0;
+    fileOffset = 0;
+  };
+
   for ( ;; )
   {
     auto cmd = (ECommandByte)co_await getByte();
     switch ( cmd )
     {
     case ECommandByte::OpenDir:
-      L_DEBUG << "GD OpenDir NYI";
-      co_await putResult( FRESULT::NOT_ENABLED );
+    {
+      std::string dname{};
+      for ( ;; )
+      {
+        uint8_t b = co_await getByte();
+        if ( b == 0 )
+          break;
+        if ( b == '/' && dname.empty() )
+          continue;
+        dname += (char)b;
+      }
+      std::error_code ec;
+      auto dirPath = resolve( base, dname );
+      if ( dirPath && std::filesystem::is_directory( *dirPath, ec ) )
+      {
+        L_DEBUG << "GD Open dir " << *dirPath;
+        dir = listDirectory( *dirPath );
+        dirOffset = 0;
+        co_await putResult( FRESULT::OK );
+      }
+      else
+      {
+        L_DEBUG << "GD Dir " << dname << " open error";
+        dir = std::nullopt;
+        co_await putResult( FRESULT::NO_FILE );
+      }
       break;
+    }
     case ECommandByte::ReadDir:
-      L_DEBUG << "GD ReadDir NYI";
-      co_await putResult( FRESULT::NOT_ENABLED );
-      break;
-    case ECommandByte::OpenFile:
     {
-      if ( file.is_open() )
+      if ( !dir )
       {
-        file.close();
+        L_DEBUG << "GD ReadDir not opened";
+        co_await putResult( FRESULT::NOT_OPENED );
+        break;
       }
-      finData.clear();
-      fileOffset = 0;
+      //entry with empty name marks the end of directory
+      DirEntry entry = dirOffset < dir->size() ? ( *dir )[dirOffset++] : DirEntry{};
+      L_DEBUG << "GD ReadDir " << entry.name.data();
+      for ( int i = 0; i < 4; ++i )
+        co_await putByte( (uint8_t)( entry.size >> ( 8 * i ) ), byteReadLatency );
+      co_await putByte( (uint8_t)( entry.date >> 0 ), byteReadLatency );
+      co_await putByte( (uint8_t)( entry.date >> 8 ), byteReadLatency );
+      co_await putByte( (uint8_t)( entry.time >> 0 ), byteReadLatency );
+      co_await putByte( (uint8_t)( entry.time >> 8 ), byteReadLatency );
+      co_await putByte( entry.attrib, byteReadLatency );
+      for ( char c : entry.name )
+        co_await putByte( (uint8_t)c, byteReadLatency );
+      co_await putResult( FRESULT::OK );
+      break;
+    }
+    case ECommandByte::OpenFile:
+    {
+      close();
       std::string fname{};
       for ( ;; )
       {
@@ -109,27 +306,34 @@ GameDrive::GDCoroutine GameDrive::process()
           continue;
         fname += (char)b;
       }
-      path = base / fname;
-      if ( std::filesystem::exists( path ) )
+      auto resolved = resolve( base, fname );
+      path = resolved.value_or( std::filesystem::path{} );
+      std::error_code ec;
+      if ( resolved && std::filesystem::exists( path, ec ) )
       {
         L_DEBUG << "GD Open file " << path;
-        file.open( path, std::ios::binary | std::ios::in );
-        uint32_t size = (uint32_t)std::filesystem::file_size( path );
-        finData.resize( size );
-        file.read( (char*)finData.data(), finData.size() );
-        file.close();
-        co_await putResult( file.good() ? FRESULT::OK : FRESULT::NOT_OPENED );
+        //only metadata is read here, contents are loaded on loader thread while emulation goes on
+        if ( std::filesystem::is_regular_file( path, ec ) )
+        {
+          fileSize = (size_t)std::filesystem::file_size( path, ec );
+          opened = !ec;
+        }
+        if ( opened )
+          pending = load( path );
+        else
+          fileSize = 0;
+        co_await putResult( opened ? FRESULT::OK : FRESULT::NOT_OPENED );
       }
       else
       {
-        L_DEBUG << "GD File " << path << " open error";
+        L_DEBUG << "GD File " << fname << " open error";
         co_await putResult( FRESULT::NO_FILE );
       }
       break;
     }
     case ECommandByte::GetSize:
     {
-      uint32_t size =  file.is_open() ? (uint32_t)std::filesystem::file_size( path ) : (uint32_t)finData.size();
+      uint32_t size = (uint32_t)fileSize;
       L_DEBUG << "GD File size " << size;
       co_await putByte( (uint8_t)( ( size >> 0 ) & 0xff ) );
       co_await putByte( (uint8_t)( ( size >> 8 ) & 0xff ) );
@@ -143,17 +347,17 @@ GameDrive::GDCoroutine GameDrive::process()
       offset |= ( co_await getByte() ) << 8;
       offset |= ( co_await getByte() ) << 16;
       offset |= ( co_await getByte() ) << 24;
-      if ( finData.empty() )
+      if ( !opened )
       {
         L_DEBUG << "GD File seek not opened";
         co_await putResult( FRESULT::NOT_OPENED );
       }
       else
       {
-        if ( offset > finData.size() )
+        if ( offset > fileSize )
         {
-          L_DEBUG << "GD File resized from " << finData.size() << " to " << offset << std::hex << "($" << offset << ")";
-          finData.resize( offset );
+          L_DEBUG << "GD File resized from " << fileSize << " to " << offset << std::hex << "($" << offset << ")";
+          fileSize = offset;
         }
         L_DEBUG << "GD File seek " << offset;
         fileOffset = offset;
@@ -166,13 +370,13 @@ GameDrive::GDCoroutine GameDrive::process()
       int32_t size = co_await getByte();
       size |= ( co_await getByte() ) << 8;
 
-      if ( fileOffset < finData.size() && fileOffset + size <= finData.size() )
+      if ( fileOffset < fileSize && fileOffset + size <= fileSize )
       {
         L_DEBUG << "GD Read " << size << "\t[" << fileOffset << "," << fileOffset + size << ")\t\t$" << std::hex << size << "\t[$" << fileOffset << ",$" << fileOffset + size << ")";
       }
-      else if ( fileOffset < finData.size() && fileOffset + size > finData.size() )
+      else if ( fileOffset < fileSize && fileOffset + size > fileSize )
       {
-        L_DEBUG << "GD Read " << size << "\t[" << fileOffset << "," << finData.size() << ") | " << fileOffset + size - finData.size() << " * 0\t\t$" << std::hex << size << "\t[$" << fileOffset << ",$" << finData.size() << ") | $" << fileOffset + size - finData.size() << " * 0";
+        L_DEBUG << "GD Read " << size << "\t[" << fileOffset << "," << fileSize << ") | " << fileOffset + size - fileSize << " * 0\t\t$" << std::hex << size << "\t[$" << fileOffset << ",$" << fileSize << ") | $" << fileOffset + size - fileSize << " * 0";
       }
       else
       {
@@ -183,7 +387,7 @@ GameDrive::GDCoroutine GameDrive::process()
       {
         co_await putByte( readByte(), byteReadLatency );
       }
-      co_await putResult( finData.empty() ? FRESULT::NOT_OPENED : FRESULT::OK );
+      co_await putResult( opened ? FRESULT::OK : FRESULT::NOT_OPENED );
       break;
     }
     case ECommandByte::Write:
@@ -191,16 +395,14 @@ GameDrive::GDCoroutine GameDrive::process()
       co_await putResult( FRESULT::NOT_ENABLED );
       break;
     case ECommandByte::Close:
-      if ( finData.empty() )
+      if ( !opened )
       {
         L_DEBUG << "GD Close not opened";
         co_await putResult( FRESULT::NOT_OPENED );
       }
       else
       {
-        file.close();
-        finData.clear();
-        fileOffset = 0;
+        close();
         L_DEBUG << "GD Close";
         co_await putResult( FRESULT::OK );
       }
@@ -212,7 +414,7 @@ GameDrive::GDCoroutine GameDrive::process()
       size_t blockSize = 256 * co_await getByte();
       size_t blockCount = co_await getByte();
       blockCount |= (size_t)( co_await getByte() ) << 8; //unused hight byte of block count
-      if ( finData.empty() )
+      if ( !opened )
       {
         L_DEBUG << "GD Program not opened";
         co_await putResult( FRESULT::NOT_OPENED );
@@ -222,13 +424,13 @@ GameDrive::GDCoroutine GameDrive::process()
         blockCount = std::max( blockCount, (size_t)256 );
         size_t size = blockCount * blockSize;
 
-        if ( fileOffset < finData.size() && fileOffset + size <= finData.size() )
+        if ( fileOffset < fileSize && fileOffset + size <= fileSize )
         {
           L_DEBUG << "GD Program " << size << "\t[" << fileOffset << "," << fileOffset + size << ") to start:" << startBlock << ", blockSize:" << blockSize << ", blockCount:" << blockCount << "\t\t$" << size << "\t[$" << fileOffset << ",$" << fileOffset + size << ") to start:$" << startBlock << ", blockSize:$" << blockSize << ", blockCount:$" << blockCount;
         }
-        else if ( fileOffset < finData.size() && fileOffset + size > finData.size() )
+        else if ( fileOffset < fileSize && fileOffset + size > fileSize )
         {
-          L_DEBUG << "GD Read " << size << "\t[" << fileOffset << "," << finData.size() << ") | " << fileOffset + size - finData.size() << " * 0 to start:" << startBlock << ", blockSize:" << blockSize << ", blockCount:" << blockCount << "\t\t$" << size << "\t[$" << fileOffset << ",$" << finData.size() << ") | $" << fileOffset + size - finData.size() << " * 0 to start:$" << startBlock << ", blockSize:$" << blockSize << ", blockCount:$" << blockCount;
+          L_DEBUG << "GD Read " << size << "\t[" << fileOffset << "," << fileSize << ") | " << fileOffset + size - fileSize << " * 0 to start:" << startBlock << ", blockSize:" << blockSize << ", blockCount:" << blockCount << "\t\t$" << size << "\t[$" << fileOffset << ",$" << fileSize << ") | $" << fileOffset + size - fileSize << " * 0 to start:$" << startBlock << ", blockSize:$" << blockSize << ", blockCount:$" << blockCount;
         }
         else
         {
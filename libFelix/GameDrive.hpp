@@ -1,8 +1,10 @@
 #pragma once
 #include "Utility.hpp"
+#include "CoroutineFramePool.hpp"
 
 class CartBank;
 class ImageProperties;
+class ImageSource;
 
 class GameDrive
 {
@@ -98,7 +100,7 @@ private:
     struct promise_type;
     using handle = std::coroutine_handle<promise_type>;
 
-    struct promise_type
+    struct promise_type : PooledFrame
     {
       promise_type( GameDrive& gd ) : mGD{ gd } {}
       auto get_return_object() { return GDCoroutine{ std::coroutine_handle<promise_type>::from_promise( *this ) }; }
@@ -134,6 +136,11 @@ private:
 
   private:
   GDCoroutine process();
+  //opens file on loader thread which then reads ahead pages of mapped file, so guest reads do not wait for the disk
+  std::shared_future<std::shared_ptr<ImageSource const>> load( std::filesystem::path const& path );
+  //stops read ahead of the loader and lets it finish opening its file on its own, so emulation never waits for it
+  void detachLoader();
   std::chrono::steady_clock::time_point mBaseTime;
   double mLastTimePoint;
+  std::jthread mLoader;
 };
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Utility.hpp"
+
+//Destination of samples rendered by emulation thread.
+//Emulation thread renders samples at rate() as its clock dictates and pushes no more than space() samples at a time.
+struct IAudioSink
+{
+  virtual ~IAudioSink() = default;
+
+  //Sample rate to render next samples at. Sinks played on other clock correct it slightly to keep their buffer filled
+  virtual int rate() const = 0;
+  //number of samples the sink takes now
+  virtual size_t space() const = 0;
+  virtual void push( std::span<AudioSample const> samples ) = 0;
+};
@@ -4,10 +4,55 @@
 
 struct IVideoSink
 {
+  enum class Format
+  {
+    //rows of pixels from getRow
+    PIXELS,
+    //rows of ROW_BYTES screen bytes from getPenRow with two 4-bit pen indices each, left pixel in high nibble.
+    //Colors are expanded by the sink from color register writes reported to colorReg
+    PENS
+  };
+
   virtual ~IVideoSink() = default;
 
+  //queried once on construction of the display generator
+  virtual Format format() const { return Format::PIXELS; }
   virtual void newFrame() = 0;
   //row counts from 0 to 101
   virtual Doublet* getRow( int row ) = 0;
+  //row counts from 0 to 101, called instead of getRow only by sinks of Format::PENS
+  virtual uint8_t* getPenRow( int ) { return nullptr; }
+  //Color register write effective from given pixel of given row. Row is -1 outside of displayed rows.
+  //All color registers are zero at start and all writes are reported in order with other calls
+  virtual void colorReg( int, int, uint8_t, uint8_t ) {}
 };
 
+//expands pens of Format::PENS rows to pixels
+class PenPalette
+{
+public:
+  void setColorReg( uint8_t reg, uint8_t value )
+  {
+    Pixel& pixel = mPens[reg & 0x0f];
+    if ( reg < 16 )
+    {
+      pixel.g = ( value << 4 ) | ( value & 0x0f );
+    }
+    else
+    {
+      pixel.b = ( value >> 4 ) | ( value & 0xf0 );
+      pixel.r = ( value << 4 ) | ( value & 0x0f );
+    }
+  }
+
+  void expand( std::span<uint8_t const> data, Doublet* out ) const
+  {
+    for ( uint8_t byte : data )
+    {
+      *out++ = { mPens[byte >> 4], mPens[byte & 0x0f] };
+    }
+  }
+
+private:
+  std::array<Pixel, 16> mPens{};
+};
@@ -1,12 +1,16 @@
 #include "ImageBS93.hpp"
+#include "ImageSource.hpp"
 
-std::shared_ptr<ImageBS93 const> ImageBS93::create( std::vector<uint8_t> & data )
+std::shared_ptr<ImageBS93 const> ImageBS93::create( std::shared_ptr<ImageSource const> const& source )
 {
-  auto const* pHeader = (ImageBS93::Header const*)data.data();
+  if ( source->size() < sizeof( Header ) )
+    return {};
+
+  auto const* pHeader = (ImageBS93::Header const*)source->data().data();
 
   if ( pHeader->magic[0] == 'B' && pHeader->magic[1] == 'S' && pHeader->magic[2] == '9' && pHeader->magic[3] == '3' )
   {
-    return std::make_shared<ImageBS93 const>( std::move( data ) );
+    return std::make_shared<ImageBS93 const>( source );
   }
   else
   {
@@ -15,7 +19,7 @@ std::shared_ptr<ImageBS93 const> ImageBS93::create( std::vector<uint8_t> & data
 }
 
 
-ImageBS93::ImageBS93( std::vector<uint8_t> data ) : mData{ std::move( data ) }
+ImageBS93::ImageBS93( std::shared_ptr<ImageSource const> source ) : mSource{ std::move( source ) }, mData{ mSource->data() }
 {
 }
 
@@ -28,8 +32,8 @@ std::optional<uint16_t> ImageBS93::load( std::span<uint8_t> memory ) const
   if ( realLoadAddress >= loadAddress )
     return std::nullopt;
 
-  auto beg = mData.cbegin();
-  auto end = mData.cend();
+  auto beg = mData.begin();
+  auto end = mData.end();
 
   size_t realSize = std::min( ( size_t )size, ( size_t )std::distance( beg, end ) );
 
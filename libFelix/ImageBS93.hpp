@@ -1,5 +1,7 @@
 #pragma once
 
+class ImageSource;
+
 class ImageBS93
 {
 public:
@@ -15,14 +17,15 @@ public:
 
 public:
 
-  static std::shared_ptr<ImageBS93 const> create( std::vector<uint8_t> & data );
+  static std::shared_ptr<ImageBS93 const> create( std::shared_ptr<ImageSource const> const& source );
   std::optional<uint16_t> load( std::span<uint8_t> memory ) const;
-  ImageBS93( std::vector<uint8_t> data );
+  ImageBS93( std::shared_ptr<ImageSource const> source );
 
 private:
   uint16_t getLoadAddress() const;
   uint16_t getSize() const;
 
 private:
-  std::vector<uint8_t> const mData;
+  std::shared_ptr<ImageSource const> const mSource;
+  std::span<uint8_t const> const mData;
 };
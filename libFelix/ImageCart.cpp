@@ -1,14 +1,15 @@
 #include "ImageCart.hpp"
 #include "ImageProperties.hpp"
 #include "Encryption.hpp"
+#include "ImageSource.hpp"
 
-std::shared_ptr<ImageCart const> ImageCart::create( std::vector<uint8_t>& data )
+std::shared_ptr<ImageCart const> ImageCart::create( std::shared_ptr<ImageSource const> const& source )
 {
-  if ( auto pLnx = createLnx( data ) )
+  if ( auto pLnx = createLnx( source ) )
   {
     return pLnx;
   }
-  else if ( auto pLyx = createLyx( data ) )
+  else if ( auto pLyx = createLyx( source ) )
   {
     return pLyx;
   }
@@ -18,7 +19,7 @@ std::shared_ptr<ImageCart const> ImageCart::create( std::vector<uint8_t>& data )
   }
 }
 
-ImageCart::ImageCart( std::vector<uint8_t> data, TagLnx lnx ) : mData{ std::move( data ) },
+ImageCart::ImageCart( std::shared_ptr<ImageSource const> source, TagLnx lnx ) : mSource{ std::move( source ) }, mData{ mSource->data() },
   mBank0{}, mBank0A{}, mBank1{}, mBank1A{}, mHeader{ (Header const*)mData.data() }
 {
   auto const* pImageData = mData.data() + sizeof( Header );
@@ -43,8 +44,8 @@ ImageCart::ImageCart( std::vector<uint8_t> data, TagLnx lnx ) : mData{ std::move
     mBank1A = { std::span<uint8_t const>{ pImageData + bank1AOffset, bank1ASize }, (uint32_t)mHeader->pageSizeBank1 * 256 };
 }
 
-ImageCart::ImageCart( std::vector<uint8_t> data, TagLyx lyx ) : mData{ std::move( data ) },
-  mBank0{ std::span<uint8_t const>( mData.data(), mData.size() ) }, mBank0A{}, mBank1{}, mBank1A{}, mHeader{}
+ImageCart::ImageCart( std::shared_ptr<ImageSource const> source, TagLyx lyx ) : mSource{ std::move( source ) }, mData{ mSource->data() },
+  mBank0{ mData }, mBank0A{}, mBank1{}, mBank1A{}, mHeader{}
 {
 }
 
@@ -68,13 +69,15 @@ CartBank ImageCart::getBank1A() const
   return mBank1A;
 }
 
-std::shared_ptr<ImageCart const> ImageCart::createLyx( std::vector<uint8_t>& data )
+std::shared_ptr<ImageCart const> ImageCart::createLyx( std::shared_ptr<ImageSource const> const& source )
 {
+  auto const data = source->data();
+
   // First byte of loader has two's complement of number of blocks in first frame. 
   size_t blockcount = 0x100 - data[0];
 
   // If value is greater than 5 it is not a correct header
-  if ( blockcount > 5 )
+  if ( blockcount > 5 || data.size() < 1 + 51 * blockcount )
   {
     return {};
   }
@@ -90,19 +93,23 @@ std::shared_ptr<ImageCart const> ImageCart::createLyx( std::vector<uint8_t>& dat
   case 128 * 1024:
   case 256 * 1024:
   case 512 * 1024:
-    return std::make_shared<ImageCart const>( std::move( data ), TagLyx{} );
+    return std::make_shared<ImageCart const>( source, TagLyx{} );
   default:
     return {};
   }
 }
 
-std::shared_ptr<ImageCart const> ImageCart::createLnx( std::vector<uint8_t>& data )
+std::shared_ptr<ImageCart const> ImageCart::createLnx( std::shared_ptr<ImageSource const> const& source )
 {
+  auto const data = source->data();
+  if ( data.size() < sizeof( Header ) )
+    return {};
+
   auto const* pHeader = (Header const*)data.data();
 
   if ( pHeader->magic[0] == 'L' && pHeader->magic[1] == 'Y' && pHeader->magic[2] == 'N' && pHeader->magic[3] == 'X' && pHeader->version == 1 )
   {
-    return std::make_shared<ImageCart const>( std::move( data ), TagLnx{} );
+    return std::make_shared<ImageCart const>( source, TagLnx{} );
   }
   else
   {
@@ -3,7 +3,9 @@
 #include "CartBank.hpp"
 
 class ImageProperties;
+class ImageSource;
 
+//Cartridge image. Header is parsed in place and banks reference contents of the source without a copy
 class ImageCart
 {
 
@@ -26,10 +28,10 @@ public:
     std::array<uint8_t, 3>   spare;
   };
 
-  static std::shared_ptr<ImageCart const> create( std::vector<uint8_t> & data );
+  static std::shared_ptr<ImageCart const> create( std::shared_ptr<ImageSource const> const& source );
 
-  ImageCart( std::vector<uint8_t> data, TagLnx lnx );
-  ImageCart( std::vector<uint8_t> data, TagLyx lyx );
+  ImageCart( std::shared_ptr<ImageSource const> source, TagLnx lnx );
+  ImageCart( std::shared_ptr<ImageSource const> source, TagLyx lyx );
 
   CartBank getBank0() const;
   CartBank getBank0A() const;
@@ -40,12 +42,13 @@ public:
 
 private:
 
-  static std::shared_ptr<ImageCart const> createLyx( std::vector<uint8_t> & data );
-  static std::shared_ptr<ImageCart const> createLnx( std::vector<uint8_t> & data );
+  static std::shared_ptr<ImageCart const> createLyx( std::shared_ptr<ImageSource const> const& source );
+  static std::shared_ptr<ImageCart const> createLnx( std::shared_ptr<ImageSource const> const& source );
 
 protected:
 
-  std::vector<uint8_t> const mData;
+  std::shared_ptr<ImageSource const> const mSource;
+  std::span<uint8_t const> const mData;
   CartBank mBank0;
   CartBank mBank0A;
   CartBank mBank1;
@@ -1,29 +1,31 @@
 #include "ImageROM.hpp"
-#include "Utility.hpp"
+#include "ImageSource.hpp"
 
 std::shared_ptr<ImageROM const> ImageROM::create( std::filesystem::path const& path )
 {
-  auto data = readFile( path );
+  auto source = ImageSource::open( path );
 
-  if ( data.size() != 512 )
+  if ( !source || source->size() != 512 )
     return {};
 
-  uint16_t resetVector = *(uint16_t*)( data.data() + 0x1fc );
+  auto const data = source->data();
+
+  uint16_t resetVector = *(uint16_t const*)( data.data() + 0x1fc );
 
   if ( resetVector < 0xfe00 )
     return {};
 
-  return std::make_shared<ImageROM const>( std::move( data ) );
+  return std::make_shared<ImageROM const>( std::move( source ) );
 }
 
-ImageROM::ImageROM( std::vector<uint8_t> data ) : mData{ std::move( data ) }
+ImageROM::ImageROM( std::shared_ptr<ImageSource const> source ) : mSource{ std::move( source ) }, mData{ mSource->data() }
 {
 }
 
 void ImageROM::load( std::span<uint8_t> memory ) const
 {
-  auto beg = mData.cbegin();
-  auto end = mData.cend();
+  auto beg = mData.begin();
+  auto end = mData.end();
 
   assert( mData.size() == memory.size() );
 
@@ -1,5 +1,7 @@
   #pragma once
 
+class ImageSource;
+
 class ImageROM
 {
 public:
@@ -7,10 +9,11 @@ public:
 public:
   static std::shared_ptr<ImageROM const> create( std::filesystem::path const& path );
 
-  ImageROM( std::vector<uint8_t> data );
+  ImageROM( std::shared_ptr<ImageSource const> source );
 
   void load( std::span<uint8_t> memory ) const;
 
 private:
-  std::vector<uint8_t> const mData;
+  std::shared_ptr<ImageSource const> const mSource;
+  std::span<uint8_t const> const mData;
 };
@@ -0,0 +1,137 @@
+#include "ImageSource.hpp"
+#include "Utility.hpp"
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FELIX_MMAP
+#endif
+
+namespace
+{
+
+//Smaller files are read. Mapped file that is truncated or rewritten by another process faults on access of pages past its new end,
+//so only images larger than any cartridge, which gain most from loading just the pages that are read, take the risk
+static constexpr uintmax_t MAP_MIN_SIZE = 1024 * 1024;
+
+struct CacheEntry
+{
+  std::weak_ptr<ImageSource const> source;
+  //identity of file contents the source was made from
+  uintmax_t size;
+  std::filesystem::file_time_type time;
+};
+
+std::mutex gCacheMutex;
+std::unordered_map<std::string, CacheEntry> gCache;
+
+}
+
+std::shared_ptr<ImageSource const> ImageSource::open( std::filesystem::path const& path )
+{
+  std::error_code ec;
+  auto const canonical = std::filesystem::canonical( path, ec );
+  if ( ec )
+    return {};
+  auto const size = std::filesystem::file_size( canonical, ec );
+  if ( ec || size == 0 )
+    return {};
+  auto const time = std::filesystem::last_write_time( canonical, ec );
+  if ( ec )
+    return {};
+
+  auto const key = canonical.string();
+  auto cached = [&]() -> std::shared_ptr<ImageSource const>
+  {
+    auto it = gCache.find( key );
+    if ( it != gCache.end() && it->second.size == size && it->second.time == time )
+      return it->second.source.lock();
+    return {};
+  };
+
+  {
+    std::unique_lock lock{ gCacheMutex };
+    if ( auto source = cached() )
+      return source;
+  }
+
+  //file is read without the lock, so instances of other images are not held up by it
+  auto source = load( canonical, ( size_t )size );
+
+  std::unique_lock lock{ gCacheMutex };
+  //instance opened on another thread meanwhile is shared instead
+  if ( auto other = cached() )
+    return other;
+
+  gCache[key] = { source, size, time };
+
+  //drops entries of released sources
+  std::erase_if( gCache, []( auto const& pair )
+  {
+    return pair.second.source.expired();
+  } );
+
+  return source;
+}
+
+std::shared_ptr<ImageSource const> ImageSource::fromMemory( std::vector<uint8_t> data )
+{
+  if ( data.empty() )
+    return {};
+
+  return std::make_shared<ImageSource const>( Tag{}, std::move( data ) );
+}
+
+std::shared_ptr<ImageSource const> ImageSource::load( std::filesystem::path const& path, size_t size )
+{
+#ifdef FELIX_MMAP
+  int fd = size >= MAP_MIN_SIZE ? ::open( path.c_str(), O_RDONLY ) : -1;
+  if ( fd >= 0 )
+  {
+    //file that changed since it was examined is read instead, pages past its end would fault
+    struct stat st{};
+    void* mapping = MAP_FAILED;
+    if ( ::fstat( fd, &st ) == 0 && ( size_t )st.st_size == size )
+      mapping = ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    //mapping stays valid after the descriptor is closed
+    ::close( fd );
+    if ( mapping != MAP_FAILED )
+      return std::make_shared<ImageSource const>( Tag{}, mapping, size );
+  }
+#endif
+
+  return fromMemory( readFile( path ) );
+}
+
+ImageSource::ImageSource( Tag, std::vector<uint8_t> data ) : mBuffer{ std::move( data ) }, mMapping{}, mData{ mBuffer.data(), mBuffer.size() }
+{
+}
+
+ImageSource::ImageSource( Tag, void const* mapping, size_t size ) : mBuffer{}, mMapping{ mapping }, mData{ ( uint8_t const* )mapping, size }
+{
+}
+
+ImageSource::~ImageSource()
+{
+#ifdef FELIX_MMAP
+  if ( mMapping )
+    ::munmap( const_cast<void*>( mMapping ), mData.size() );
+#endif
+}
+
+std::span<uint8_t const> ImageSource::data() const
+{
+  return mData;
+}
+
+size_t ImageSource::size() const
+{
+  return mData.size();
+}
+
+bool ImageSource::mapped() const
+{
+  return mMapping != nullptr;
+}
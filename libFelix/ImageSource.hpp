@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Utility.hpp"
+
+//Read-only contents of an image file.
+//Where the platform supports it files larger than any cartridge are mapped to memory, so images reference its pages directly
+//instead of a copy and pages that are never read are never loaded. Sources are cached by path, so all instances of the same image
+//in the process share one mapping as long as the file does not change.
+class ImageSource : NonCopyable
+{
+public:
+  //contents of file, empty for missing or empty file
+  static std::shared_ptr<ImageSource const> open( std::filesystem::path const& path );
+  //contents held in memory
+  static std::shared_ptr<ImageSource const> fromMemory( std::vector<uint8_t> data );
+
+  ~ImageSource();
+
+  std::span<uint8_t const> data() const;
+  size_t size() const;
+  //whether contents reference a mapping of the file
+  bool mapped() const;
+
+private:
+  struct Tag {};
+
+public:
+  //use open or fromMemory
+  ImageSource( Tag, std::vector<uint8_t> data );
+  ImageSource( Tag, void const* mapping, size_t size );
+
+private:
+  static std::shared_ptr<ImageSource const> load( std::filesystem::path const& path, size_t size );
+
+  std::vector<uint8_t> const mBuffer;
+  void const* const mMapping;
+  std::span<uint8_t const> const mData;
+};
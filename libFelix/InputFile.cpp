@@ -1,15 +1,15 @@
 #include "InputFile.hpp"
 #include "ImageBS93.hpp"
 #include "ImageCart.hpp"
-#include "Utility.hpp"
+#include "ImageSource.hpp"
 #include "ImageProperties.hpp"
 #include "Log.hpp"
 
 InputFile::InputFile( std::filesystem::path const & path, std::shared_ptr<ImageProperties> & imageProperties ) : mType{}, mBS93{}, mCart{}
 {
-  auto data = readFile( path );
+  auto source = ImageSource::open( path );
 
-  if ( data.empty() )
+  if ( !source )
     return;
 
   bool propsReset = false;
@@ -25,7 +25,7 @@ InputFile::InputFile( std::filesystem::path const & path, std::shared_ptr<ImageP
     propsReset = true;
   }
 
-  if ( auto pCart = ImageCart::create( data ) )
+  if ( auto pCart = ImageCart::create( source ) )
   {
     if ( propsReset )
     {
@@ -36,7 +36,7 @@ InputFile::InputFile( std::filesystem::path const & path, std::shared_ptr<ImageP
     mCart = std::move( pCart );
     return;
   }
-  else if ( auto pBS93 = ImageBS93::create( data ) )
+  else if ( auto pBS93 = ImageBS93::create( source ) )
   {
     mType = FileType::BS93;
     mBS93 = std::move( pBS93 );
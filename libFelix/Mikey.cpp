@@ -1,114 +1,14 @@
 #include "Mikey.hpp"
 #include "TimerCore.hpp"
-#include "AudioChannel.hpp"
 #include "Core.hpp"
 #include "Cartridge.hpp"
 #include "CPU.hpp"
 #include "ComLynx.hpp"
 #include "VGMWriter.hpp"
 
-Mikey::Mikey( Core & core, ComLynx & comLynx, std::shared_ptr<IVideoSink> videoSink ) : mCore{ core }, mComLynx{ comLynx }, mAccessTick{}, mTimers{}, mAudioChannels{},
-  mAttenuation{ 0xff, 0xff, 0xff, 0xff }, mAttenuationLeft{ 0x3c, 0x3c, 0x3c, 0x3c }, mAttenuationRight{ 0x3c, 0x3c, 0x3c, 0x3c }, mDisplayGenerator{ std::make_unique<DisplayGenerator>( std::move( videoSink ) ) },
-  mParallelPort{ mCore, mComLynx, *mDisplayGenerator }, mDisplayRegs{}, mSuzyDone{}, mPan{ 0xff }, mStereo{}, mSerDat{}, mIRQ{}, mVGMWriterMutex{}
+Mikey::Mikey( Core & core, ComLynx & comLynx, std::shared_ptr<IVideoSink> videoSink ) : mCore{ core }, mComLynx{ comLynx }, mAccessTick{}, mSyncTick{}, mAccessRequested{}, mTimers{}, mAudio{ mTimers },
+  mDisplayGenerator{ std::make_unique<DisplayGenerator>( std::move( videoSink ) ) }, mParallelPort{ mCore, mComLynx, *mDisplayGenerator }, mDisplayRegs{}, mSuzyDone{}, mSerDat{}, mIRQ{}, mVGMWriterMutex{}
 {
-  mTimers[0x0] = std::make_unique<TimerCore>( 0x0, [this]( uint64_t tick, bool interrupt )
-  {
-    mTimers[0x2]->borrowIn( tick );
-    uint8_t cnt = mTimers[0x02]->getCount( tick );
-    if ( cnt == 101 )
-    {
-      mDisplayGenerator->updateDispAddr( tick, mDisplayRegs.dispAdr );
-    }
-    mCore.newLine( cnt );
-    if ( auto dma = mDisplayGenerator->hblank( tick, cnt ) )
-    {
-      mCore.requestDisplayDMA( dma.tick, dma.address );
-    }
-    if ( interrupt )
-    {
-      setIRQ( 0x01 );
-    }
-  } );  //timer 0 -> timer 2
-  mTimers[0x1] = std::make_unique<TimerCore>( 0x1, [this]( uint64_t tick, bool interrupt )
-  {
-    mTimers[0x3]->borrowIn( tick );
-    if ( interrupt )
-    {
-      setIRQ( 0x02 );
-    }
-  } );  //timer 1 -> timer 3
-  mTimers[0x2] = std::make_unique<TimerCore>( 0x2, [this]( uint64_t tick, bool interrupt )
-  {
-    mTimers[0x4]->borrowIn( tick );
-    mDisplayGenerator->vblank( tick );
-    if ( interrupt )
-    {
-      setIRQ( 0x04 );
-    }
-  } );  //timer 2 -> timer 4
-  mTimers[0x3] = std::make_unique<TimerCore>( 0x3, [this]( uint64_t tick, bool interrupt )
-  {
-    mTimers[0x5]->borrowIn( tick );
-    if ( interrupt )
-    {
-      setIRQ( 0x08 );
-    }
-  } );  //timer 3 -> timer 5
-  mTimers[0x4] = std::make_unique<TimerCore>( 0x4, [this]( uint64_t tick, bool interrupt )
-  {
-    if ( mComLynx.pulse() )
-    {
-      setIRQ( 0x10 );
-    }
-  } );  //timer 4
-  mTimers[0x5] = std::make_unique<TimerCore>( 0x5, [this]( uint64_t tick, bool interrupt )
-  {
-    mTimers[0x7]->borrowIn( tick );
-    if ( interrupt )
-    {
-      setIRQ( 0x20 );
-    }
-  } );  //timer 5 -> timer 7
-  mTimers[0x6] = std::make_unique<TimerCore>( 0x6, [this]( uint64_t tick, bool interrupt )
-  {
-    if ( interrupt )
-    {
-      setIRQ( 0x40 );
-    }
-  } );  //timer 6
-  mTimers[0x7] = std::make_unique<TimerCore>( 0x7, [this]( uint64_t tick, bool interrupt )
-  {
-    mTimers[0x8]->borrowIn( tick );
-    if ( interrupt )
-    {
-      setIRQ( 0x80 );
-    }
-  } );  //timer 7 -> audio 0
-  mTimers[0x8] = std::make_unique<TimerCore>( 0x8, [this]( uint64_t tick, bool unused )
-  {
-    mAudioChannels[0x0]->trigger( tick );
-    mTimers[0x9]->borrowIn( tick );
-  } );  //audio 0 -> audio 1
-  mTimers[0x9] = std::make_unique<TimerCore>( 0x9, [this]( uint64_t tick, bool unused )
-  {
-    mAudioChannels[0x1]->trigger( tick );
-    mTimers[0xa]->borrowIn( tick );
-  } );  //audio 1 -> audio 2
-  mTimers[0xa] = std::make_unique<TimerCore>( 0xa, [this]( uint64_t tick, bool unused )
-  {
-    mAudioChannels[0x2]->trigger( tick );
-    mTimers[0xb]->borrowIn( tick );
-  } );  //audio 2 -> audio 3
-  mTimers[0xb] = std::make_unique<TimerCore>( 0xb, [this]( uint64_t tick, bool unused )
-  {
-    mAudioChannels[0x3]->trigger( tick );
-    mTimers[0x0]->borrowIn( tick );
-  } );  //audio 3 -> timer 1
-
-  mAudioChannels[0x0] = std::make_unique<AudioChannel>( *mTimers[0x8] );
-  mAudioChannels[0x1] = std::make_unique<AudioChannel>( *mTimers[0x9] );
-  mAudioChannels[0x2] = std::make_unique<AudioChannel>( *mTimers[0xa] );
-  mAudioChannels[0x3] = std::make_unique<AudioChannel>( *mTimers[0xb] );
 }
 
 Mikey::~Mikey()
@@ -117,6 +17,13 @@ Mikey::~Mikey()
 
 uint64_t Mikey::requestAccess( uint64_t tick, uint16_t address )
 {
+  //Core requests access again before reading, but actions are executed only up to the first request
+  if ( !mAccessRequested )
+  {
+    mSyncTick = tick;
+    mAccessRequested = true;
+  }
+
   mAccessTick = tick + 5;
 
   address &= 0xff;
@@ -143,57 +50,38 @@ uint64_t Mikey::requestAccess( uint64_t tick, uint16_t address )
 uint8_t Mikey::read( uint16_t address )
 {
   address &= 0xff;
+  mAccessRequested = false;
 
   if ( address < 0x20 )
   {
+    mTimers.sync( ( address >> 2 ) & 7, mSyncTick );
+
     switch ( address & 0x3 )
     {
     case TIMER::BACKUP:
-      return mTimers[( address >> 2 ) & 7]->getBackup( mAccessTick );
+      return mTimers.getBackup( ( address >> 2 ) & 7, mAccessTick );
     case TIMER::CONTROLA:
-      return mTimers[( address >> 2 ) & 7]->getControlA( mAccessTick );
+      return mTimers.getControlA( ( address >> 2 ) & 7, mAccessTick );
     case TIMER::COUNT:
-      return mTimers[( address >> 2 ) & 7]->getCount( mAccessTick );
+      return mTimers.getCount( ( address >> 2 ) & 7, mAccessTick );
     case TIMER::CONTROLB:
-      return mTimers[( address >> 2 ) & 7]->getControlB( mAccessTick );
+      return mTimers.getControlB( ( address >> 2 ) & 7, mAccessTick );
     }
   }
   else if ( address < 0x40 )
   {
-    switch ( address & 0x7 )
-    {
-    case AUDIO::VOLCNTRL:
-      return std::bit_cast<uint8_t>( mAudioChannels[( address >> 3 ) & 3]->getVolume() );
-    case AUDIO::FEEDBACK:
-      return mAudioChannels[( address >> 3 ) & 3]->getFeedback();
-    case AUDIO::OUTPUT:
-      return std::bit_cast<uint8_t>( mAudioChannels[( address >> 3 ) & 3]->getOutput() );
-    case AUDIO::SHIFT:
-      return mAudioChannels[( address >> 3 ) & 3]->getShift();
-    case AUDIO::BACKUP:
-      return mAudioChannels[( address >> 3 ) & 3]->getBackup( mAccessTick );
-    case AUDIO::CONTROL:
-      return mAudioChannels[( address >> 3 ) & 3]->getControl( mAccessTick );
-    case AUDIO::COUNTER:
-      return mAudioChannels[( address >> 3 ) & 3]->getCounter( mAccessTick );
-    case AUDIO::OTHER:
-      return mAudioChannels[( address >> 3 ) & 3]->getOther( mAccessTick );
-    }
+    mTimers.sync( 0x8 + ( ( address >> 3 ) & 3 ), mSyncTick );
+    return mAudio.read( mAccessTick, address );
   }
   else switch ( address )
   {
   case ATTENREG0:
-    return mAttenuation[0];
   case ATTENREG1:
-    return mAttenuation[1];
   case ATTENREG2:
-    return mAttenuation[2];
   case ATTENREG3:
-    return mAttenuation[3];
   case MPAN:
-    return mPan;
   case MSTEREO:
-    return mStereo;
+    return mAudio.read( mAccessTick, address );
   case INTRST:
   case INTSET:
     return mIRQ;
@@ -251,49 +139,41 @@ uint8_t Mikey::read( uint16_t address )
 SequencedAction Mikey::write( uint16_t address, uint8_t value )
 {
   address &= 0xff;
+  mAccessRequested = false;
+
+  if ( address > MSTEREO )
+    return writeRegister( address, value );
+
+  //lazily evaluated channels and timer chains catch up before the write and are re-evaluated after it as it can change timer linking, integration or gains
+  mAudio.sync( mAccessTick );
+  mTimers.sync( mSyncTick );
+  auto action = writeRegister( address, value );
+  updateLazyAudio();
+  updateTimerActions();
+  return action;
+}
+
+SequencedAction Mikey::writeRegister( uint16_t address, uint8_t value )
+{
 
   if ( address < 0x20 )
   {
     switch ( address & 0x3 )
     {
     case TIMER::BACKUP:
-      return mTimers[(address >> 2) & 7]->setBackup( mAccessTick, value );
+      return mTimers.setBackup( ( address >> 2 ) & 7, mAccessTick, value );
     case TIMER::CONTROLA:
-      return mTimers[( address >> 2 ) & 7]->setControlA( mAccessTick, value );
+      return mTimers.setControlA( ( address >> 2 ) & 7, mAccessTick, value );
     case TIMER::COUNT:
-      return mTimers[( address >> 2 ) & 7]->setCount( mAccessTick, value );
+      return mTimers.setCount( ( address >> 2 ) & 7, mAccessTick, value );
     case TIMER::CONTROLB:
-      return mTimers[( address >> 2 ) & 7]->setControlB( mAccessTick, value );
+      return mTimers.setControlB( ( address >> 2 ) & 7, mAccessTick, value );
     }
   }
   else if ( address < 0x40 )
   {
-    {
-      std::unique_lock lock( mVGMWriterMutex );
-      if ( mVGMWriter )
-        mVGMWriter->write( mAccessTick, ( uint8_t )address, value );
-    }
-    int idx = ( address >> 3 ) & 3;
-
-    switch ( address & 0x7 )
-    {
-    case AUDIO::VOLCNTRL:
-      return mAudioChannels[( address >> 3 ) & 3]->setVolume( (int8_t)value );
-    case AUDIO::FEEDBACK:
-      return mAudioChannels[( address >> 3 ) & 3]->setFeedback( value );
-    case AUDIO::OUTPUT:
-      return mAudioChannels[( address >> 3 ) & 3]->setOutput( value );
-    case AUDIO::SHIFT:
-      return mAudioChannels[( address >> 3 ) & 3]->setShift( value );
-    case AUDIO::BACKUP:
-      return mAudioChannels[( address >> 3 ) & 3]->setBackup( mAccessTick, value );
-    case AUDIO::CONTROL:
-      return mAudioChannels[( address >> 3 ) & 3]->setControl( mAccessTick, value );
-    case AUDIO::COUNTER:
-      return mAudioChannels[( address >> 3 ) & 3]->setCounter( mAccessTick, value );
-    case AUDIO::OTHER:
-      return mAudioChannels[( address >> 3 ) & 3]->setOther( mAccessTick, value );
-    }
+    writeVGM( address, value );
+    return mAudio.write( mAccessTick, address, value );
   }
   else switch ( address )
   {
@@ -301,31 +181,10 @@ SequencedAction Mikey::write( uint16_t address, uint8_t value )
   case ATTENREG1:
   case ATTENREG2:
   case ATTENREG3:
-    mAttenuation[address & 3] = value;
-    mAttenuationRight[address & 3] = ( value & 0x0f ) << 2;
-    mAttenuationLeft[address & 3] = ( value & 0xf0 ) >> 2;
-    {
-      std::unique_lock lock( mVGMWriterMutex );
-      if ( mVGMWriter )
-        mVGMWriter->write( mAccessTick, ( uint8_t )address, value );
-    }
-    break;
   case MPAN:
-    mPan = value;
-    {
-      std::unique_lock lock( mVGMWriterMutex );
-      if ( mVGMWriter )
-        mVGMWriter->write( mAccessTick, ( uint8_t )address, value );
-    }
-    break;
   case MSTEREO:
-    mStereo = value;
-    {
-      std::unique_lock lock( mVGMWriterMutex );
-      if ( mVGMWriter )
-        mVGMWriter->write( mAccessTick, ( uint8_t )address, value );
-    }
-    break;
+    writeVGM( address, value );
+    return mAudio.write( mAccessTick, address, value );
   case INTRST:
     resetIRQ( value );
     break;
@@ -433,7 +292,60 @@ SequencedAction Mikey::write( uint16_t address, uint8_t value )
 SequencedAction Mikey::fireTimer( uint64_t tick, uint32_t timer )
 {
   assert( timer < 12 );
-  return mTimers[timer]->fireAction( tick );
+  auto underflows = mTimers.fire( (int)timer, tick );
+  //deeper timers of the cascade are handled first as they were when borrows nested
+  for ( int i = underflows.count - 1; i >= 0; --i )
+  {
+    timerUnderflow( underflows.timers[i], tick );
+  }
+  return underflows.action;
+}
+
+void Mikey::timerUnderflow( int timer, uint64_t tick )
+{
+  bool const interrupt = mTimers.interruptEnabled( timer );
+
+  switch ( timer )
+  {
+  case 0x0:
+  {
+    uint8_t cnt = mTimers.getCount( 0x2, tick );
+    if ( cnt == 101 )
+    {
+      mDisplayGenerator->updateDispAddr( tick, mDisplayRegs.dispAdr );
+    }
+    mCore.newLine( cnt );
+    if ( auto dma = mDisplayGenerator->hblank( tick, cnt ) )
+    {
+      mCore.requestDisplayDMA( dma.tick, dma.address );
+    }
+    break;
+  }
+  case 0x2:
+    mDisplayGenerator->vblank( tick );
+    mCore.newFrame();
+    break;
+  case 0x4:
+    //serial timer raises interrupt on its own terms
+    if ( mComLynx.pulse() )
+    {
+      setIRQ( 0x10 );
+    }
+    return;
+  case 0x8:
+  case 0x9:
+  case 0xa:
+  case 0xb:
+    mAudio.trigger( timer - 0x8, tick );
+    return;
+  default:
+    break;
+  }
+
+  if ( interrupt )
+  {
+    setIRQ( (uint8_t)( 1 << timer ) );
+  }
 }
 
 void Mikey::setDMAData( uint64_t tick, uint64_t data )
@@ -449,39 +361,50 @@ void Mikey::suzyDone()
   mSuzyDone = true;
 }
 
-AudioSample Mikey::sampleAudio( uint64_t tick ) const
+uint64_t Mikey::audioEndTick( uint64_t tick, int sps, size_t samples )
 {
-  int16_t left{};
-  int16_t right{};
-  int16_t samples[4];
+  return mAudio.endTick( tick, sps, samples );
+}
 
-  samples[0] = (int16_t)mAudioChannels[0]->sample( tick );
-  samples[1] = (int16_t)mAudioChannels[1]->sample( tick );
-  samples[2] = (int16_t)mAudioChannels[2]->sample( tick );
-  samples[3] = (int16_t)mAudioChannels[3]->sample( tick );
+size_t Mikey::renderAudio( uint64_t tick, std::span<AudioSample> out )
+{
+  mAudio.sync( tick );
+  return mAudio.render( tick, out );
+}
 
-  for ( size_t i = 0; i < 4; ++i )
+void Mikey::updateLazyAudio()
+{
+  for ( int i = 0; i < MikeyAudio::CHANNELS; ++i )
   {
-    if ( ( mStereo & ( (uint8_t)0x01 << i ) ) == 0 )
-    {
-      const int attenuation = ( mPan & ( (uint8_t)0x01 << i ) ) != 0 ? mAttenuationLeft[i] : 0x3c;
-      left += (int16_t)samples[i] * attenuation;
-    }
+    if ( auto action = mAudio.updateLazy( i ) )
+      mCore.requestAction( action );
+  }
+}
 
-    if ( ( mStereo & ( (uint8_t)0x10 << i ) ) == 0 )
-    {
-      const int attenuation = ( mPan & ( (uint8_t)0x01 << i ) ) != 0 ? mAttenuationRight[i] : 0x3c;
-      right += (int16_t)samples[i] * attenuation;
-    }
+void Mikey::updateTimerActions()
+{
+  for ( int timer = 0; timer < TimerCore::TIMERS; ++timer )
+  {
+    if ( auto action = mTimers.updateAction( timer ) )
+      mCore.requestAction( action );
   }
+}
 
-  return { left, right };
+void Mikey::writeVGM( uint16_t address, uint8_t value )
+{
+  std::unique_lock lock( mVGMWriterMutex );
+  if ( mVGMWriter )
+    mVGMWriter->write( mAccessTick, ( uint8_t )address, value );
 }
 
 void Mikey::setVGMWriter( std::shared_ptr<VGMWriter> writer )
 {
-  std::unique_lock lock( mVGMWriterMutex );
-  mVGMWriter = std::move( writer );
+  {
+    std::unique_lock lock( mVGMWriterMutex );
+    std::swap( mVGMWriter, writer );
+  }
+  //previous writer finishes its file when released here, outside of the lock taken on emulation thread
+  writer.reset();
 }
 
 bool Mikey::isVGMWriter() const
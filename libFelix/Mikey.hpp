@@ -2,12 +2,12 @@
 
 #include "ActionQueue.hpp"
 #include "ParallelPort.hpp"
+#include "MikeyAudio.hpp"
+#include "TimerCore.hpp"
 #include "DisplayGenerator.hpp"
 #include "Utility.hpp"
 
 class Core;
-class TimerCore;
-class AudioChannel;
 class DisplayGenerator;
 class VGMWriter;
 
@@ -83,7 +83,10 @@ public:
   SequencedAction fireTimer( uint64_t tick, uint32_t timer );
   void setDMAData( uint64_t tick, uint64_t data );
   void suzyDone();
-  AudioSample sampleAudio( uint64_t tick ) const;
+  //tick at which given count of audio samples is complete
+  uint64_t audioEndTick( uint64_t tick, int sps, size_t samples );
+  //renders audio samples complete at given tick and returns their count
+  size_t renderAudio( uint64_t tick, std::span<AudioSample> out );
   void setVGMWriter( std::shared_ptr<VGMWriter> writer );
   bool isVGMWriter() const;
 
@@ -93,16 +96,26 @@ public:
   uint16_t debugDispAdr() const;
   std::span<uint8_t const, 32> debugPalette() const;
 
+private:
+  SequencedAction writeRegister( uint16_t address, uint8_t value );
+  //effects of timer underflow other than borrow to linked timer
+  void timerUnderflow( int timer, uint64_t tick );
+  //switches audio channels between lazy and per-underflow evaluation
+  void updateLazyAudio();
+  //reschedules timers after a write that can change what their chains underflow into
+  void updateTimerActions();
+  void writeVGM( uint16_t address, uint8_t value );
+
 private:
   Core & mCore;
   ComLynx & mComLynx;
   uint64_t mAccessTick;
+  //tick up to which queued actions are executed at current access. Linked timers are synced to it
+  uint64_t mSyncTick;
+  bool mAccessRequested;
 
-  std::array<std::unique_ptr<TimerCore>, 12> mTimers;
-  std::array<std::unique_ptr<AudioChannel>, 4> mAudioChannels;
-  std::array<uint8_t, 4> mAttenuation;
-  std::array<int16_t, 4> mAttenuationLeft;
-  std::array<int16_t, 4> mAttenuationRight;
+  TimerCore mTimers;
+  MikeyAudio mAudio;
 
   std::unique_ptr<DisplayGenerator> mDisplayGenerator;
   std::shared_ptr<VGMWriter> mVGMWriter;
@@ -122,8 +135,6 @@ private:
 
   bool mSuzyDone;
 
-  uint8_t mPan;
-  uint8_t mStereo;
   uint8_t mSerDat;
   uint8_t mIRQ;
 };
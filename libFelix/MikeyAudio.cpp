@@ -0,0 +1,165 @@
+#include "MikeyAudio.hpp"
+#include "AudioChannel.hpp"
+#include "Mikey.hpp"
+#include "TimerCore.hpp"
+
+MikeyAudio::MikeyAudio( TimerCore & timers ) : mTimers{ timers }, mChannels{}, mAttenuation{ 0xff, 0xff, 0xff, 0xff }, mAttenuationLeft{ 0x3c, 0x3c, 0x3c, 0x3c },
+  mAttenuationRight{ 0x3c, 0x3c, 0x3c, 0x3c }, mPan{ 0xff }, mStereo{}, mSynth{}
+{
+  for ( int i = 0; i < CHANNELS; ++i )
+  {
+    mChannels[i] = std::make_unique<AudioChannel>( mTimers, 0x8 + i, mSynth );
+  }
+
+  updateGains( 0 );
+}
+
+MikeyAudio::~MikeyAudio()
+{
+}
+
+uint8_t MikeyAudio::read( uint64_t tick, uint16_t address )
+{
+  if ( address >= 0x20 && address < 0x40 )
+  {
+    auto& channel = *mChannels[( address >> 3 ) & 3];
+    channel.sync( tick );
+
+    switch ( address & 0x7 )
+    {
+    case Mikey::AUDIO::VOLCNTRL:
+      return std::bit_cast<uint8_t>( channel.getVolume() );
+    case Mikey::AUDIO::FEEDBACK:
+      return channel.getFeedback();
+    case Mikey::AUDIO::OUTPUT:
+      return std::bit_cast<uint8_t>( channel.getOutput() );
+    case Mikey::AUDIO::SHIFT:
+      return channel.getShift();
+    case Mikey::AUDIO::BACKUP:
+      return channel.getBackup( tick );
+    case Mikey::AUDIO::CONTROL:
+      return channel.getControl( tick );
+    case Mikey::AUDIO::COUNTER:
+      return channel.getCounter( tick );
+    case Mikey::AUDIO::OTHER:
+      return channel.getOther( tick );
+    }
+  }
+
+  switch ( address )
+  {
+  case Mikey::ATTENREG0:
+  case Mikey::ATTENREG1:
+  case Mikey::ATTENREG2:
+  case Mikey::ATTENREG3:
+    return mAttenuation[address & 3];
+  case Mikey::MPAN:
+    return mPan;
+  case Mikey::MSTEREO:
+    return mStereo;
+  default:
+    return (uint8_t)0xff;
+  }
+}
+
+SequencedAction MikeyAudio::write( uint64_t tick, uint16_t address, uint8_t value )
+{
+  if ( address >= 0x20 && address < 0x40 )
+  {
+    auto& channel = *mChannels[( address >> 3 ) & 3];
+
+    switch ( address & 0x7 )
+    {
+    case Mikey::AUDIO::VOLCNTRL:
+      return channel.setVolume( (int8_t)value );
+    case Mikey::AUDIO::FEEDBACK:
+      return channel.setFeedback( value );
+    case Mikey::AUDIO::OUTPUT:
+      return channel.setOutput( tick, value );
+    case Mikey::AUDIO::SHIFT:
+      return channel.setShift( value );
+    case Mikey::AUDIO::BACKUP:
+      return channel.setBackup( tick, value );
+    case Mikey::AUDIO::CONTROL:
+      return channel.setControl( tick, value );
+    case Mikey::AUDIO::COUNTER:
+      return channel.setCounter( tick, value );
+    case Mikey::AUDIO::OTHER:
+      return channel.setOther( tick, value );
+    }
+  }
+
+  switch ( address )
+  {
+  case Mikey::ATTENREG0:
+  case Mikey::ATTENREG1:
+  case Mikey::ATTENREG2:
+  case Mikey::ATTENREG3:
+    mAttenuation[address & 3] = value;
+    mAttenuationRight[address & 3] = ( value & 0x0f ) << 2;
+    mAttenuationLeft[address & 3] = ( value & 0xf0 ) >> 2;
+    updateGains( tick );
+    break;
+  case Mikey::MPAN:
+    mPan = value;
+    updateGains( tick );
+    break;
+  case Mikey::MSTEREO:
+    mStereo = value;
+    updateGains( tick );
+    break;
+  default:
+    break;
+  }
+
+  return {};
+}
+
+void MikeyAudio::trigger( int channel, uint64_t tick )
+{
+  mChannels[channel]->trigger( tick );
+}
+
+void MikeyAudio::sync( uint64_t tick )
+{
+  for ( auto const& channel : mChannels )
+  {
+    channel->sync( tick );
+  }
+}
+
+SequencedAction MikeyAudio::updateLazy( int channel )
+{
+  return mChannels[channel]->updateLazy( mTimers.linked( TimerCore::BORROW_TARGET[0x8 + channel] ) );
+}
+
+uint64_t MikeyAudio::endTick( uint64_t tick, int sps, size_t samples )
+{
+  return mSynth.endTick( tick, sps, samples );
+}
+
+size_t MikeyAudio::render( uint64_t tick, std::span<AudioSample> out )
+{
+  return mSynth.render( tick, out );
+}
+
+void MikeyAudio::updateGains( uint64_t tick )
+{
+  for ( size_t i = 0; i < CHANNELS; ++i )
+  {
+    int left{};
+    int right{};
+
+    if ( ( mStereo & ( (uint8_t)0x01 << i ) ) == 0 )
+    {
+      left = ( mPan & ( (uint8_t)0x01 << i ) ) != 0 ? mAttenuationLeft[i] : 0x3c;
+    }
+
+    if ( ( mStereo & ( (uint8_t)0x10 << i ) ) == 0 )
+    {
+      right = ( mPan & ( (uint8_t)0x01 << i ) ) != 0 ? mAttenuationRight[i] : 0x3c;
+    }
+
+    mChannels[i]->setGains( tick, left, right );
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ActionQueue.hpp"
+#include "AudioSynth.hpp"
+#include "Utility.hpp"
+
+class AudioChannel;
+class TimerCore;
+
+//Mikey audio block: four audio channels driven by timers 8 to 11, their attenuation, pan and stereo registers and the mixer.
+//Shared by Mikey and VGMPlayer so that VGM files play back through the same register handling and mixing as emulation.
+class MikeyAudio
+{
+public:
+  static constexpr int CHANNELS = 4;
+
+  MikeyAudio( TimerCore & timers );
+  ~MikeyAudio();
+
+  //audio channel registers from 0x20 to 0x3f, ATTENREG0 to ATTENREG3, MPAN and MSTEREO
+  uint8_t read( uint64_t tick, uint16_t address );
+  SequencedAction write( uint64_t tick, uint16_t address, uint8_t value );
+  //underflow of timer of given channel
+  void trigger( int channel, uint64_t tick );
+  //runs underflows of lazily evaluated channels up to given tick
+  void sync( uint64_t tick );
+  //switches given channel between lazy and per-underflow evaluation as linking of its timer dictates
+  SequencedAction updateLazy( int channel );
+  //tick at which given count of audio samples is complete
+  uint64_t endTick( uint64_t tick, int sps, size_t samples );
+  //renders audio samples complete at given tick and returns their count
+  size_t render( uint64_t tick, std::span<AudioSample> out );
+
+private:
+  //passes mixer settings to audio channels
+  void updateGains( uint64_t tick );
+
+private:
+  TimerCore & mTimers;
+  std::array<std::unique_ptr<AudioChannel>, CHANNELS> mChannels;
+  std::array<uint8_t, CHANNELS> mAttenuation;
+  std::array<int16_t, CHANNELS> mAttenuationLeft;
+  std::array<int16_t, CHANNELS> mAttenuationRight;
+  uint8_t mPan;
+  uint8_t mStereo;
+  AudioSynth mSynth;
+};
@@ -28,6 +28,167 @@ class ScriptDebugger
     }
   };
 
+  //Traps of 64 KB address space kept sorted by address, with a bit per 256 byte page telling whether the page has any.
+  //Accesses to pages without traps cost a single bit test.
+  class SparseTraps
+  {
+  public:
+    struct Entry
+    {
+      uint16_t address;
+      std::shared_ptr<IMemoryAccessTrap> trap;
+    };
+
+    bool page( uint16_t address ) const
+    {
+      return ( mPages[address >> 14] & ( 1ull << ( ( address >> 8 ) & 63 ) ) ) != 0;
+    }
+
+    //returns owning pointer, so the trap survives removing itself while it runs
+    std::shared_ptr<IMemoryAccessTrap> find( uint16_t address ) const
+    {
+      auto it = lowerBound( address );
+      return it != mEntries.end() && it->address == address ? it->trap : nullptr;
+    }
+
+    void add( uint16_t address, std::shared_ptr<IMemoryAccessTrap> trap )
+    {
+      auto it = lowerBound( address );
+      if ( it != mEntries.end() && it->address == address )
+      {
+        it->trap = std::make_shared<CompositeTrap>( std::move( it->trap ), std::move( trap ) );
+      }
+      else
+      {
+        mEntries.insert( it, Entry{ address, std::move( trap ) } );
+        mPages[address >> 14] |= 1ull << ( ( address >> 8 ) & 63 );
+      }
+    }
+
+    void remove( uint16_t address )
+    {
+      auto it = lowerBound( address );
+      if ( it == mEntries.end() || it->address != address )
+        return;
+
+      it = mEntries.erase( it );
+
+      bool const pageEmpty = ( it == mEntries.end() || ( it->address >> 8 ) != ( address >> 8 ) ) &&
+        ( it == mEntries.begin() || ( std::prev( it )->address >> 8 ) != ( address >> 8 ) );
+      if ( pageEmpty )
+        mPages[address >> 14] &= ~( 1ull << ( ( address >> 8 ) & 63 ) );
+    }
+
+    std::span<Entry const> entries() const
+    {
+      return mEntries;
+    }
+
+  private:
+    std::vector<Entry>::const_iterator lowerBound( uint16_t address ) const
+    {
+      return std::ranges::lower_bound( mEntries, address, {}, &Entry::address );
+    }
+
+    std::vector<Entry>::iterator lowerBound( uint16_t address )
+    {
+      return std::ranges::lower_bound( mEntries, address, {}, &Entry::address );
+    }
+
+    std::array<uint64_t, 4> mPages{};
+    std::vector<Entry> mEntries;
+  };
+
+  //Traps of address ranges with a bit per covered address, and ranges overlapping each 256 byte page listed by the page.
+  //Accesses outside ranges cost a single bit test. A range can share its trap with any number of other ranges.
+  class RangeTraps
+  {
+  public:
+    struct Range
+    {
+      uint16_t first;
+      uint16_t last;
+      std::shared_ptr<IMemoryAccessTrap> trap;
+    };
+
+    bool covers( uint16_t address ) const
+    {
+      return ( mCovered[address >> 6] & ( 1ull << ( address & 63 ) ) ) != 0;
+    }
+
+    //calls traps of all ranges containing address in order of addition.
+    //Traps may add and remove ranges, so they are called from a copy of the page that keeps them alive.
+    uint8_t trap( Core& core, uint16_t address, uint8_t value ) const
+    {
+      auto const ranges = mPages[address >> 8];
+      for ( auto const& range : ranges )
+      {
+        if ( address >= range.first && address <= range.last )
+          value = range.trap->trap( core, address, value );
+      }
+      return value;
+    }
+
+    void add( uint16_t first, uint16_t last, std::shared_ptr<IMemoryAccessTrap> trap )
+    {
+      if ( first > last )
+        return;
+
+      for ( int page = first >> 8; page <= last >> 8; ++page )
+      {
+        mPages[page].push_back( Range{ first, last, trap } );
+      }
+      cover( first, last );
+    }
+
+    //removes ranges added with the same first and last address
+    void remove( uint16_t first, uint16_t last )
+    {
+      if ( first > last )
+        return;
+
+      for ( int page = first >> 8; page <= last >> 8; ++page )
+      {
+        std::erase_if( mPages[page], [=]( Range const& range )
+        {
+          return range.first == first && range.last == last;
+        } );
+
+        uint16_t const pageFirst = (uint16_t)( page << 8 );
+        std::fill_n( mCovered.begin() + page * 4, 4, 0 );
+        for ( auto const& range : mPages[page] )
+        {
+          cover( std::max( range.first, pageFirst ), std::min( range.last, (uint16_t)( pageFirst + 0xff ) ) );
+        }
+      }
+    }
+
+    //each range is listed once, by the page of its first address
+    cppcoro::generator<Range const&> ranges() const
+    {
+      for ( size_t page = 0; page < mPages.size(); ++page )
+      {
+        for ( auto const& range : mPages[page] )
+        {
+          if ( (size_t)( range.first >> 8 ) == page )
+            co_yield range;
+        }
+      }
+    }
+
+  private:
+    void cover( uint16_t first, uint16_t last )
+    {
+      for ( uint32_t address = first; address <= last; ++address )
+      {
+        mCovered[address >> 6] |= 1ull << ( address & 63 );
+      }
+    }
+
+    std::array<uint64_t, 1024> mCovered{};
+    std::array<std::vector<Range>, 256> mPages{};
+  };
+
 public:
 
   enum class Type : uint16_t
@@ -46,24 +207,23 @@ public:
     MAPCTL_WRITE
   };
 
+  //called at vertical blank, and at horizontal blank with line counter
+  using FrameCallback = std::function<void( Core& core )>;
+  using ScanlineCallback = std::function<void( Core& core, int line )>;
+
   ScriptDebugger() = default;
   ~ScriptDebugger() = default;
 
   cppcoro::generator<std::tuple<Type, uint16_t, std::shared_ptr<IMemoryAccessTrap>>> getTraps( IMemoryAccessTrap::Kind kind )
   {
-    for ( int i = 0; i < 0xffff; ++i )
+    for ( auto const& [type, traps] : { std::pair{ Type::RAM_READ, &mRamReadTraps }, std::pair{ Type::RAM_WRITE, &mRamWriteTraps }, std::pair{ Type::RAM_EXECUTE, &mRamExecuteTraps } } )
     {
-      if ( mRamReadTraps[i] && mRamReadTraps[i]->getKind() == kind )
-      {
-        co_yield std::tuple<Type, uint16_t, std::shared_ptr<IMemoryAccessTrap>>( Type::RAM_READ, i, mRamReadTraps[i] );
-      }
-      if ( mRamWriteTraps[i] && mRamWriteTraps[i]->getKind() == kind )
-      {
-        co_yield std::tuple<Type, uint16_t, std::shared_ptr<IMemoryAccessTrap>>( Type::RAM_WRITE, i, mRamWriteTraps[i] );
-      }
-      if ( mRamExecuteTraps[i] && mRamExecuteTraps[i]->getKind() == kind )
+      for ( auto const& entry : traps->entries() )
       {
-        co_yield std::tuple<Type, uint16_t, std::shared_ptr<IMemoryAccessTrap>>( Type::RAM_EXECUTE, i, mRamExecuteTraps[i] );
+        if ( entry.trap->getKind() == kind )
+        {
+          co_yield std::tuple<Type, uint16_t, std::shared_ptr<IMemoryAccessTrap>>( type, entry.address, entry.trap );
+        }
       }
     }
 
@@ -105,21 +265,77 @@ public:
     }
   }
 
+  cppcoro::generator<std::tuple<Type, uint16_t, uint16_t, std::shared_ptr<IMemoryAccessTrap>>> getRanges( IMemoryAccessTrap::Kind kind )
+  {
+    for ( auto const& [type, ranges] : { std::pair{ Type::RAM_READ, &mRamReadRanges }, std::pair{ Type::RAM_WRITE, &mRamWriteRanges }, std::pair{ Type::RAM_EXECUTE, &mRamExecuteRanges } } )
+    {
+      for ( auto const& range : ranges->ranges() )
+      {
+        if ( range.trap->getKind() == kind )
+        {
+          co_yield std::tuple<Type, uint16_t, uint16_t, std::shared_ptr<IMemoryAccessTrap>>( type, range.first, range.last, range.trap );
+        }
+      }
+    }
+  }
+
+  //RAM ranges share one trap. Other types are small tables, so ranges of them are added and deleted address by address.
+  void addRange( Type type, uint16_t first, uint16_t last, std::shared_ptr<IMemoryAccessTrap> trap )
+  {
+    switch ( type )
+    {
+    case Type::RAM_READ:
+      mRamReadRanges.add( first, last, std::move( trap ) );
+      break;
+    case Type::RAM_WRITE:
+      mRamWriteRanges.add( first, last, std::move( trap ) );
+      break;
+    case Type::RAM_EXECUTE:
+      mRamExecuteRanges.add( first, last, std::move( trap ) );
+      break;
+    default:
+      for ( uint32_t address = first; address <= last; ++address )
+      {
+        addTrap( type, (uint16_t)address, trap );
+      }
+      break;
+    }
+  }
+
+  void deleteRange( Type type, uint16_t first, uint16_t last )
+  {
+    switch ( type )
+    {
+    case Type::RAM_READ:
+      mRamReadRanges.remove( first, last );
+      break;
+    case Type::RAM_WRITE:
+      mRamWriteRanges.remove( first, last );
+      break;
+    case Type::RAM_EXECUTE:
+      mRamExecuteRanges.remove( first, last );
+      break;
+    default:
+      for ( uint32_t address = first; address <= last; ++address )
+      {
+        deleteTrap( type, (uint16_t)address );
+      }
+      break;
+    }
+  }
+
   void deleteTrap( Type type, uint16_t address )
   {
     switch ( type )
     {
     case Type::RAM_READ:
-      mRamReadMask[address] = 0;
-      mRamReadTraps[address] = nullptr;
+      mRamReadTraps.remove( address );
       break;
     case Type::RAM_WRITE:
-      mRamWriteMask[address] = 0;
-      mRamWriteTraps[address] = nullptr;
+      mRamWriteTraps.remove( address );
       break;
     case Type::RAM_EXECUTE:
-      mRamExecuteMask[address] = 0;
-      mRamExecuteTraps[address] = nullptr;
+      mRamExecuteTraps.remove( address );
       break;
     case Type::ROM_READ:
       mRomReadMask[address] = 0;
@@ -149,6 +365,12 @@ public:
       mSuzyWriteMask[address] = 0;
       mSuzyWriteTraps[address] = nullptr;
       break;
+    case Type::MAPCTL_READ:
+      mMapCtlReadTrap = nullptr;
+      break;
+    case Type::MAPCTL_WRITE:
+      mMapCtlWriteTrap = nullptr;
+      break;
     }
   }
 
@@ -157,13 +379,13 @@ public:
     switch ( type )
     {
     case Type::RAM_READ:
-      helper( { mRamReadTraps.data(), mRamReadTraps.size() }, mRamReadMask[address], address, std::move( trap ) );
+      mRamReadTraps.add( address, std::move( trap ) );
       break;
     case Type::RAM_WRITE:
-      helper( { mRamWriteTraps.data(), mRamWriteTraps.size() }, mRamWriteMask[address], address, std::move( trap ) );
+      mRamWriteTraps.add( address, std::move( trap ) );
       break;
     case Type::RAM_EXECUTE:
-      helper( { mRamExecuteTraps.data(), mRamExecuteTraps.size() }, mRamExecuteMask[address], address, std::move( trap ) );
+      mRamExecuteTraps.add( address, std::move( trap ) );
       break;
     case Type::ROM_READ:
       helper( { mRomReadTraps.data(), mRomReadTraps.size() }, mRomReadMask[address & 0x1ff], address & 0x1ff, std::move( trap ) );
@@ -195,40 +417,93 @@ public:
     }
   }
 
+  //callbacks are identified by id given by the caller, which deleteCallback takes to remove them.
+  //Callbacks may delete callbacks, so deleted ones are removed before the next call.
+  void addFrameCallback( int id, FrameCallback callback )
+  {
+    mFrameCallbacks.push_back( { id, std::move( callback ) } );
+  }
+
+  void addScanlineCallback( int id, ScanlineCallback callback )
+  {
+    mScanlineCallbacks.push_back( { id, std::move( callback ) } );
+  }
+
+  void deleteCallback( int id )
+  {
+    mDeletedCallbacks.push_back( id );
+  }
+
+  //whether access of RAM type to address calls a trap other than given one, so guest code doing it must not be skipped
+  bool isRAMTrapped( Type type, uint16_t address, IMemoryAccessTrap const* except = nullptr ) const
+  {
+    auto trapped = [&]( SparseTraps const& traps, RangeTraps const& ranges )
+    {
+      if ( traps.page( address ) )
+      {
+        auto trap = traps.find( address );
+        if ( trap && trap.get() != except )
+          return true;
+      }
+      return ranges.covers( address );
+    };
+
+    switch ( type )
+    {
+    case Type::RAM_READ:
+      return trapped( mRamReadTraps, mRamReadRanges );
+    case Type::RAM_WRITE:
+      return trapped( mRamWriteTraps, mRamWriteRanges );
+    case Type::RAM_EXECUTE:
+      return trapped( mRamExecuteTraps, mRamExecuteRanges );
+    default:
+      return false;
+    }
+  }
+
   uint8_t readRAM( Core& core, uint16_t address, uint8_t orgValue )
   {
-    if ( mRamReadMask( address ) )
+    uint8_t value = orgValue;
+    if ( mRamReadTraps.page( address ) )
     {
-      return mRamReadTraps[address]->trap( core, address, orgValue );
+      if ( auto trap = mRamReadTraps.find( address ) )
+        value = trap->trap( core, address, value );
     }
-    else
+    if ( mRamReadRanges.covers( address ) )
     {
-      return orgValue;
+      value = mRamReadRanges.trap( core, address, value );
     }
+    return value;
   }
 
   uint8_t writeRAM( Core& core, uint16_t address, uint8_t orgValue )
   {
-    if ( mRamWriteMask( address ) )
+    uint8_t value = orgValue;
+    if ( mRamWriteTraps.page( address ) )
     {
-      return mRamWriteTraps[address]->trap( core, address, orgValue );
+      if ( auto trap = mRamWriteTraps.find( address ) )
+        value = trap->trap( core, address, value );
     }
-    else
+    if ( mRamWriteRanges.covers( address ) )
     {
-      return orgValue;
+      value = mRamWriteRanges.trap( core, address, value );
     }
+    return value;
   }
 
   uint8_t executeRAM( Core& core, uint16_t address, uint8_t orgValue )
   {
-    if ( mRamExecuteMask( address ) )
+    uint8_t value = orgValue;
+    if ( mRamExecuteTraps.page( address ) )
     {
-      return mRamExecuteTraps[address]->trap( core, address, orgValue );
+      if ( auto trap = mRamExecuteTraps.find( address ) )
+        value = trap->trap( core, address, value );
     }
-    else
+    if ( mRamExecuteRanges.covers( address ) )
     {
-      return orgValue;
+      value = mRamExecuteRanges.trap( core, address, value );
     }
+    return value;
   }
 
   uint8_t readROM( Core& core, uint16_t address, uint8_t orgValue )
@@ -339,6 +614,28 @@ public:
     }
   }
 
+  void frame( Core& core )
+  {
+    if ( !mDeletedCallbacks.empty() )
+      removeDeletedCallbacks();
+
+    for ( auto const& [id, callback] : mFrameCallbacks )
+    {
+      callback( core );
+    }
+  }
+
+  void scanline( Core& core, int line )
+  {
+    if ( !mDeletedCallbacks.empty() )
+      removeDeletedCallbacks();
+
+    for ( auto const& [id, callback] : mScanlineCallbacks )
+    {
+      callback( core, line );
+    }
+  }
+
 private:
 
   struct Proxy
@@ -379,6 +676,17 @@ private:
     }
   };
 
+  void removeDeletedCallbacks()
+  {
+    auto deleted = [&]( auto const& entry )
+    {
+      return std::ranges::find( mDeletedCallbacks, entry.first ) != mDeletedCallbacks.end();
+    };
+    std::erase_if( mFrameCallbacks, deleted );
+    std::erase_if( mScanlineCallbacks, deleted );
+    mDeletedCallbacks.clear();
+  }
+
   void helper( std::span<std::shared_ptr<IMemoryAccessTrap>> dest, uint16_t address, std::shared_ptr<IMemoryAccessTrap> src )
   {
     if ( dest[address] )
@@ -408,12 +716,12 @@ private:
 
 
 private:
-  BitArray<65536> mRamReadMask;
-  std::array<std::shared_ptr<IMemoryAccessTrap>, 65536> mRamReadTraps;
-  BitArray<65536> mRamWriteMask;
-  std::array<std::shared_ptr<IMemoryAccessTrap>, 65536> mRamWriteTraps;
-  BitArray<65536> mRamExecuteMask;
-  std::array<std::shared_ptr<IMemoryAccessTrap>, 65536> mRamExecuteTraps;
+  SparseTraps mRamReadTraps;
+  SparseTraps mRamWriteTraps;
+  SparseTraps mRamExecuteTraps;
+  RangeTraps mRamReadRanges;
+  RangeTraps mRamWriteRanges;
+  RangeTraps mRamExecuteRanges;
 
   BitArray<512> mRomReadMask;
   std::array<std::shared_ptr<IMemoryAccessTrap>, 512> mRomReadTraps;
@@ -434,5 +742,8 @@ private:
 
   std::shared_ptr<IMemoryAccessTrap> mMapCtlReadTrap;
   std::shared_ptr<IMemoryAccessTrap> mMapCtlWriteTrap;
+  std::vector<std::pair<int, FrameCallback>> mFrameCallbacks;
+  std::vector<std::pair<int, ScanlineCallback>> mScanlineCallbacks;
+  std::vector<int> mDeletedCallbacks;
 };
 
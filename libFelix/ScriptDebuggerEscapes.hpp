@@ -10,6 +10,8 @@ class ScriptDebuggerEscapes
     std::shared_ptr<IMemoryAccessTrap> trap;
     ScriptDebugger::Type type;
     uint16_t address;
+    //last address of a range, or std::nullopt for a single address trap
+    std::optional<uint16_t> last;
   };
 
 public:
@@ -18,19 +20,65 @@ public:
 
   void addTrap( ScriptDebugger::Type type, uint16_t address, std::shared_ptr<IMemoryAccessTrap> trap )
   {
-    mEscapes.push_back( { std::move( trap ), type, address } );
+    mEscapes.push_back( { std::move( trap ), type, address, std::nullopt } );
+  }
+
+  void addRange( ScriptDebugger::Type type, uint16_t first, uint16_t last, std::shared_ptr<IMemoryAccessTrap> trap )
+  {
+    mEscapes.push_back( { std::move( trap ), type, first, last } );
+  }
+
+  void deleteRange( ScriptDebugger::Type type, uint16_t first, uint16_t last )
+  {
+    std::erase_if( mEscapes, [&]( Escape const& esc )
+    {
+      return esc.type == type && esc.address == first && esc.last == last;
+    } );
+  }
+
+  //returns id that deleteCallback takes
+  int addFrameCallback( ScriptDebugger::FrameCallback callback )
+  {
+    mFrameCallbacks.push_back( { ++mLastCallbackId, std::move( callback ) } );
+    return mLastCallbackId;
+  }
+
+  int addScanlineCallback( ScriptDebugger::ScanlineCallback callback )
+  {
+    mScanlineCallbacks.push_back( { ++mLastCallbackId, std::move( callback ) } );
+    return mLastCallbackId;
+  }
+
+  void deleteCallback( int id )
+  {
+    std::erase_if( mFrameCallbacks, [=]( auto const& entry ) { return entry.first == id; } );
+    std::erase_if( mScanlineCallbacks, [=]( auto const& entry ) { return entry.first == id; } );
   }
 
   void populateScriptDebugger( ScriptDebugger& scriptDebugger ) const
   {
     for ( auto& esc : mEscapes )
     {
-      scriptDebugger.addTrap( esc.type, esc.address, esc.trap );
+      if ( esc.last )
+        scriptDebugger.addRange( esc.type, esc.address, *esc.last, esc.trap );
+      else
+        scriptDebugger.addTrap( esc.type, esc.address, esc.trap );
+    }
+    for ( auto const& [id, callback] : mFrameCallbacks )
+    {
+      scriptDebugger.addFrameCallback( id, callback );
+    }
+    for ( auto const& [id, callback] : mScanlineCallbacks )
+    {
+      scriptDebugger.addScanlineCallback( id, callback );
     }
   }
 
 private:
 
   std::vector<Escape> mEscapes;
+  std::vector<std::pair<int, ScriptDebugger::FrameCallback>> mFrameCallbacks;
+  std::vector<std::pair<int, ScriptDebugger::ScanlineCallback>> mScanlineCallbacks;
+  int mLastCallbackId{};
 };
 
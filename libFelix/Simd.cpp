@@ -0,0 +1,73 @@
+#include "Simd.hpp"
+
+#if defined( FELIX_SSE2 )
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+
+namespace
+{
+
+struct Features
+{
+  bool ssse3;
+  bool avx2;
+};
+
+Features detect()
+{
+  int regs[4];
+  __cpuid( regs, 0 );
+  int const maxLeaf = regs[0];
+
+  __cpuid( regs, 1 );
+  bool const ssse3 = ( regs[2] & ( 1 << 9 ) ) != 0;
+  //AVX registers must be saved by the OS
+  bool const osAVX = ( regs[2] & ( 1 << 27 ) ) != 0 && ( regs[2] & ( 1 << 28 ) ) != 0 && ( _xgetbv( 0 ) & 6 ) == 6;
+
+  bool avx2 = false;
+  if ( maxLeaf >= 7 && osAVX )
+  {
+    __cpuidex( regs, 7, 0 );
+    avx2 = ( regs[1] & ( 1 << 5 ) ) != 0;
+  }
+
+  return { ssse3, avx2 };
+}
+
+Features const& features()
+{
+  static Features const result = detect();
+  return result;
+}
+
+}
+
+bool simd::ssse3()
+{
+  return features().ssse3;
+}
+
+bool simd::avx2()
+{
+  return features().avx2;
+}
+
+#else
+
+//GCC and Clang check OS support of AVX registers as well
+bool simd::ssse3()
+{
+  static bool const result = __builtin_cpu_supports( "ssse3" );
+  return result;
+}
+
+bool simd::avx2()
+{
+  static bool const result = __builtin_cpu_supports( "avx2" );
+  return result;
+}
+
+#endif
+
+#endif
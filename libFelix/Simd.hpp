@@ -0,0 +1,28 @@
+#pragma once
+
+//Vector instruction sets. SSE2 is the x64 baseline and is used when available at compile time.
+//Code using newer sets is compiled for them with FELIX_TARGET and called only when the CPU reports them at run time.
+//Code using them must provide a fallback
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define FELIX_SSE2 1
+#endif
+
+#if defined( FELIX_SSE2 )
+#include <immintrin.h>
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+//MSVC compiles any intrinsic without architecture switches
+#define FELIX_TARGET( isa )
+#else
+#define FELIX_TARGET( isa ) __attribute__(( target( isa ) ))
+#endif
+
+namespace simd
+{
+//whether the CPU and OS support the instruction set, detected once
+bool ssse3();
+bool avx2();
+}
+
+#endif
@@ -0,0 +1,39 @@
+#include "SpriteLineCache.hpp"
+
+SpriteLineCache::SpriteLineCache() : mEntries( ENTRIES ), mDecoder{}, mStats{}
+{
+}
+
+SpriteLineCache::Line SpriteLineCache::decode( uint16_t address, uint8_t const* data, int bpp, bool literal, int lineBytes, std::array<uint32_t, 2> generations )
+{
+  assert( lineBytes >= 0 && lineBytes <= SpriteLineDecoder::MAX_LINE_BYTES );
+
+  //consecutive lines of sprite data are placed in consecutive entries
+  auto & entry = mEntries[address % ENTRIES];
+
+  if ( entry.valid && entry.address == address && entry.lineBytes == lineBytes && entry.bpp == bpp && entry.literal == literal && entry.generations == generations )
+  {
+    mStats.hits += 1;
+  }
+  else
+  {
+    mStats.misses += 1;
+
+    mDecoder.decode( data, bpp, literal, lineBytes * 8 );
+    entry.pens.assign( mDecoder.pens().begin(), mDecoder.pens().end() );
+    entry.fetches.assign( mDecoder.fetches().begin(), mDecoder.fetches().end() );
+    entry.generations = generations;
+    entry.address = address;
+    entry.lineBytes = (uint8_t)lineBytes;
+    entry.bpp = (uint8_t)bpp;
+    entry.literal = literal;
+    entry.valid = true;
+  }
+
+  return { entry.pens, entry.fetches };
+}
+
+SpriteLineCache::Stats SpriteLineCache::stats() const
+{
+  return mStats;
+}
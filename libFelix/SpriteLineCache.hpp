@@ -0,0 +1,50 @@
+#pragma once
+
+#include "SpriteLineDecoder.hpp"
+
+//Keeps decoded pen indices of recently drawn sprite lines.
+//Entries are validated against write generations of RAM pages holding the line data, so lines modified since decoding are decoded again.
+//Pen indices are cached before the palette remap, so changing the palette does not invalidate them.
+class SpriteLineCache
+{
+public:
+  //enough to hold sprite data of a whole frame of a typical game
+  static constexpr size_t ENTRIES = 1024;
+
+  struct Line
+  {
+    std::span<uint8_t const> pens;
+    std::span<uint16_t const> fetches;
+  };
+
+  struct Stats
+  {
+    uint64_t hits;
+    uint64_t misses;
+  };
+
+  SpriteLineCache();
+
+  //data is the line as read from address and must be readable SpriteLineDecoder::PADDING bytes past its end.
+  //Generations are of the pages holding the first and the last byte of the line
+  Line decode( uint16_t address, uint8_t const* data, int bpp, bool literal, int lineBytes, std::array<uint32_t, 2> generations );
+
+  Stats stats() const;
+
+private:
+  struct Entry
+  {
+    std::vector<uint8_t> pens;
+    std::vector<uint16_t> fetches;
+    std::array<uint32_t, 2> generations;
+    uint16_t address;
+    uint8_t lineBytes;
+    uint8_t bpp;
+    bool literal;
+    bool valid;
+  };
+
+  std::vector<Entry> mEntries;
+  SpriteLineDecoder mDecoder;
+  Stats mStats;
+};
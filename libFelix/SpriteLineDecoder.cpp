@@ -0,0 +1,296 @@
+#include "SpriteLineDecoder.hpp"
+#include "Simd.hpp"
+
+namespace
+{
+
+//reads up to 9 bits starting at given bit position counting from MSB of the first byte
+int bits( uint8_t const* data, int pos, int count )
+{
+  uint32_t window = ( (uint32_t)data[pos >> 3] << 8 ) | data[( pos >> 3 ) + 1];
+  return ( window >> ( 16 - ( pos & 7 ) - count ) ) & ( ( 1 << count ) - 1 );
+}
+
+#if defined( FELIX_SSE2 )
+
+namespace avx2
+{
+
+//splits each byte into its high and low BITS bits and returns them interleaved in the original order
+template<int BITS>
+FELIX_TARGET( "avx2" )
+void split( __m256i v, __m256i & first, __m256i & second )
+{
+  const __m256i mask = _mm256_set1_epi8( ( 1 << BITS ) - 1 );
+  __m256i hi = _mm256_and_si256( _mm256_srli_epi16( v, BITS ), mask );
+  __m256i lo = _mm256_and_si256( v, mask );
+  //unpacking works within 128-bit lanes, so lanes need to be reordered
+  __m256i l = _mm256_unpacklo_epi8( hi, lo );
+  __m256i h = _mm256_unpackhi_epi8( hi, lo );
+  first = _mm256_permute2x128_si256( l, h, 0x20 );
+  second = _mm256_permute2x128_si256( l, h, 0x31 );
+}
+
+template<int BITS, int BPP>
+FELIX_TARGET( "avx2" )
+uint8_t * unpack( __m256i v, uint8_t * out )
+{
+  __m256i first, second;
+  split<BITS>( v, first, second );
+  if constexpr ( BITS == BPP )
+  {
+    _mm256_storeu_si256( (__m256i *)out, first );
+    _mm256_storeu_si256( (__m256i *)( out + 32 ), second );
+    return out + 64;
+  }
+  else
+  {
+    out = unpack<BITS / 2, BPP>( first, out );
+    return unpack<BITS / 2, BPP>( second, out );
+  }
+}
+
+template<int BPP>
+FELIX_TARGET( "avx2" )
+void unpackLine( uint8_t const* data, int bytes, uint8_t * out )
+{
+  for ( int i = 0; i < bytes; i += 32 )
+  {
+    out = unpack<4, BPP>( _mm256_loadu_si256( (__m256i const*)( data + i ) ), out );
+  }
+}
+
+}
+
+namespace sse2
+{
+
+//splits each byte into its high and low BITS bits and returns them interleaved in the original order
+template<int BITS>
+void split( __m128i v, __m128i & first, __m128i & second )
+{
+  const __m128i mask = _mm_set1_epi8( ( 1 << BITS ) - 1 );
+  __m128i hi = _mm_and_si128( _mm_srli_epi16( v, BITS ), mask );
+  __m128i lo = _mm_and_si128( v, mask );
+  first = _mm_unpacklo_epi8( hi, lo );
+  second = _mm_unpackhi_epi8( hi, lo );
+}
+
+template<int BITS, int BPP>
+uint8_t * unpack( __m128i v, uint8_t * out )
+{
+  __m128i first, second;
+  split<BITS>( v, first, second );
+  if constexpr ( BITS == BPP )
+  {
+    _mm_storeu_si128( (__m128i *)out, first );
+    _mm_storeu_si128( (__m128i *)( out + 16 ), second );
+    return out + 32;
+  }
+  else
+  {
+    out = unpack<BITS / 2, BPP>( first, out );
+    return unpack<BITS / 2, BPP>( second, out );
+  }
+}
+
+template<int BPP>
+void unpackLine( uint8_t const* data, int bytes, uint8_t * out )
+{
+  for ( int i = 0; i < bytes; i += 16 )
+  {
+    out = unpack<4, BPP>( _mm_loadu_si128( (__m128i const*)( data + i ) ), out );
+  }
+}
+
+}
+
+//AVX2 when the CPU has it, SSE2 otherwise
+template<int BPP>
+void unpackLine( uint8_t const* data, int bytes, uint8_t * out )
+{
+  if ( simd::avx2() )
+    avx2::unpackLine<BPP>( data, bytes, out );
+  else
+    sse2::unpackLine<BPP>( data, bytes, out );
+}
+
+#else
+
+template<int BPP>
+void unpackLine( uint8_t const* data, int bytes, uint8_t * out )
+{
+  for ( int i = 0; i < bytes; ++i )
+  {
+    uint8_t byte = data[i];
+    for ( int shift = 8 - BPP; shift >= 0; shift -= BPP )
+    {
+      *out++ = ( byte >> shift ) & ( ( 1 << BPP ) - 1 );
+    }
+  }
+}
+
+#endif
+
+//three bytes hold eight 3-bit pens, so there is no byte-wise split
+void unpackLine3( uint8_t const* data, int bytes, uint8_t * out )
+{
+  for ( int i = 0; i < bytes; i += 3 )
+  {
+    uint64_t group = ( (uint64_t)data[i] << 16 ) | ( (uint64_t)data[i + 1] << 8 ) | data[i + 2];
+    //first pen goes to the lowest address on little endian host
+    uint64_t pens =
+      ( ( group >> 21 ) & 7 ) << 0 |
+      ( ( group >> 18 ) & 7 ) << 8 |
+      ( ( group >> 15 ) & 7 ) << 16 |
+      ( ( group >> 12 ) & 7 ) << 24 |
+      ( ( group >> 9 ) & 7 ) << 32 |
+      ( ( group >> 6 ) & 7 ) << 40 |
+      ( ( group >> 3 ) & 7 ) << 48 |
+      ( ( group >> 0 ) & 7 ) << 56;
+    *(uint64_t *)out = pens;
+    out += 8;
+  }
+}
+
+}
+
+SpriteLineDecoder::SpriteLineDecoder() : mPens{}, mFetches{}, mPenCount{}, mFetchCount{}
+{
+}
+
+void SpriteLineDecoder::decode( uint8_t const* data, int bpp, bool literal, int totalBits )
+{
+  assert( bpp >= 1 && bpp <= 4 );
+  assert( totalBits <= MAX_LINE_BYTES * 8 );
+
+  mFetchCount = 0;
+
+  if ( literal )
+    decodeLiteral( data, bpp, totalBits );
+  else
+    decodeRLE( data, bpp, totalBits );
+}
+
+std::span<uint8_t const> SpriteLineDecoder::pens() const
+{
+  return { mPens.data(), (size_t)mPenCount };
+}
+
+std::span<uint16_t const> SpriteLineDecoder::fetches() const
+{
+  return { mFetches.data(), (size_t)mFetchCount };
+}
+
+void SpriteLineDecoder::decodeLiteral( uint8_t const* data, int bpp, int totalBits )
+{
+  //a pen is read only if there are more bits left than pen size, so the last one is dropped if it fits exactly
+  mPenCount = totalBits > 0 ? ( totalBits - 1 ) / bpp : 0;
+  int bytes = ( mPenCount * bpp + 7 ) / 8;
+
+  switch ( bpp )
+  {
+  case 1:
+    unpackLine<1>( data, bytes, mPens.data() );
+    break;
+  case 2:
+    unpackLine<2>( data, bytes, mPens.data() );
+    break;
+  case 3:
+    unpackLine3( data, bytes, mPens.data() );
+    break;
+  default:
+    unpackLine<4>( data, bytes, mPens.data() );
+    break;
+  }
+
+  //the shifter drops below 24 bits for the k-th time after pen (8 + 8k) / bpp and fetches as long as unread data remains.
+  //The quotient is tracked incrementally as the loop is otherwise dominated by divisions
+  int pen = SHIFTER_LOW / bpp;
+  int rem = SHIFTER_LOW % bpp;
+  int const step = 8 / bpp;
+  int const stepRem = 8 % bpp;
+  int fetches = std::max( 0, ( totalBits - SHIFTER_LOAD + 7 ) / 8 );
+  int count = 0;
+  for ( ; count < fetches && pen < mPenCount; ++count )
+  {
+    mFetches[count] = (uint16_t)pen;
+    pen += step;
+    rem += stepRem;
+    if ( rem >= bpp )
+    {
+      pen += 1;
+      rem -= bpp;
+    }
+  }
+  mFetchCount = count;
+}
+
+void SpriteLineDecoder::decodeRLE( uint8_t const* data, int bpp, int totalBits )
+{
+  int pos = 0;
+  int pen = 0;
+  int shifterSize = SHIFTER_LOAD;
+
+  //the shifter takes a byte after a pen if it holds less than 24 bits and there is unread data
+  auto consume = [&]( int bits )
+  {
+    shifterSize -= bits;
+    totalBits -= bits;
+    if ( shifterSize < SHIFTER_LOAD - SHIFTER_LOW && totalBits > shifterSize )
+    {
+      mFetches[mFetchCount++] = (uint16_t)pen;
+      shifterSize += 8;
+    }
+  };
+
+  while ( totalBits > 5 )
+  {
+    int header = bits( data, pos, 5 );
+    pos += 5;
+    int count = ( header & 0x0f ) + 1;
+
+    if ( ( header & 0x10 ) != 0 )
+    {
+      int available = ( totalBits - 5 - 1 ) / bpp;
+      int emitted = std::min( count, available );
+      if ( emitted == 0 )
+        break;
+
+      for ( int i = 0; i < emitted; ++i )
+      {
+        mPens[pen] = (uint8_t)bits( data, pos, bpp );
+        pos += bpp;
+        consume( i == 0 ? 5 + bpp : bpp );
+        pen += 1;
+      }
+
+      if ( emitted < count )
+        break;
+    }
+    else
+    {
+      //repeat packet of count zero ends the line
+      if ( count == 1 || totalBits - 5 <= bpp )
+        break;
+
+      uint8_t value = (uint8_t)bits( data, pos, bpp );
+      pos += bpp;
+      std::fill_n( mPens.data() + pen, count, value );
+      consume( 5 + bpp );
+      pen += 1;
+      //remaining pens of the packet do not consume bits, but the shifter may still need refilling
+      for ( int end = pen + count - 1; pen < end; ++pen )
+      {
+        if ( shifterSize >= SHIFTER_LOAD - SHIFTER_LOW || totalBits <= shifterSize )
+        {
+          pen = end;
+          break;
+        }
+        consume( 0 );
+      }
+    }
+  }
+
+  mPenCount = pen;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+//Decodes whole sprite data line into pen indices at once.
+//Produces the same pens as the hardware-like shifter fed byte by byte, together with the schedule of sprite data fetches
+//the shifter would have needed so that the bus timing can be preserved.
+class SpriteLineDecoder
+{
+public:
+  //sprite data offset is a byte, so the line has at most 254 bytes of data
+  static constexpr int MAX_LINE_BYTES = 254;
+  //decoders may read that many bytes past the end of the line data
+  static constexpr int PADDING = 32;
+  //the densest encoding is 1 bpp RLE line of repeat packets of 16 pens in 6 bits
+  static constexpr int MAX_PENS = MAX_LINE_BYTES * 8 / 6 * 16 + 16;
+
+  SpriteLineDecoder();
+
+  //data must be readable PADDING bytes past totalBits
+  void decode( uint8_t const* data, int bpp, bool literal, int totalBits );
+
+  std::span<uint8_t const> pens() const;
+  //indices of pens after which a byte of sprite data would be fetched
+  std::span<uint16_t const> fetches() const;
+
+private:
+  void decodeLiteral( uint8_t const* data, int bpp, int totalBits );
+  void decodeRLE( uint8_t const* data, int bpp, int totalBits );
+
+  //the shifter is loaded with 4 bytes on line start
+  static constexpr int SHIFTER_LOAD = 32;
+  //and takes one more byte after a pen if it holds less than 24 bits
+  static constexpr int SHIFTER_LOW = 8;
+
+private:
+  std::array<uint8_t, MAX_PENS + PADDING * 8> mPens;
+  std::array<uint16_t, MAX_LINE_BYTES> mFetches;
+  int mPenCount;
+  int mFetchCount;
+};
@@ -4,7 +4,7 @@
 #include "Cartridge.hpp"
 #include "Log.hpp"
 
-Suzy::Suzy( Core& core, std::shared_ptr<IInputSource> inputSource ) : mCore{ core }, mSCB{}, mMath{ mCore.getTraceHelper() }, mInputSource{ inputSource }, mSpriteDumper{}, mSpriteDumperPath{}, mSpriteDumperMutex{}, mAccessTick{},
+Suzy::Suzy( Core& core, std::shared_ptr<IInputSource> inputSource ) : mCore{ core }, mSCB{}, mMath{ mCore.getTraceHelper() }, mInputSource{ inputSource }, mSpriteDumper{}, mSpriteDumperPath{}, mSpriteDumperMutex{}, mSuzyProcess{}, mAccessTick{}, mLineCache{},
   mPalette{}, mBusEnable{}, mNoCollide{}, mVStretch{}, mLeftHand{ true }, mUnsafeAccess{}, mSpriteStop{},
   mSpriteWorking{}, mHFlip{}, mVFlip{}, mLiteral{}, mAlgo3{}, mReusePalette{}, mSkipSprite{}, mStartingQuadrant{}, mEveron{},
   mBpp{}, mSpriteType{}, mReload{}, mSprColl{}, mSprInit{}
@@ -446,6 +446,11 @@ uint16_t Suzy::debugCollBas() const
   return mSCB.collbas;
 }
 
+SpriteLineCache::Stats Suzy::debugSpriteLineCache() const
+{
+  return mLineCache.stats();
+}
+
 bool Suzy::isSpriteDumping() const
 {
   std::scoped_lock<std::mutex> lock{ mSpriteDumperMutex };
@@ -486,6 +491,16 @@ int Suzy::bpp() const
   return ( ( int )mBpp >> 6 ) + 1;
 }
 
+SpriteLineCache::Line Suzy::decodeLine( uint16_t address, uint8_t const* data, int lineBytes )
+{
+  std::array<uint32_t, 2> generations{
+    mCore.mRAMPageGenerations[address >> 8],
+    mCore.mRAMPageGenerations[( uint16_t )( address + lineBytes - 1 ) >> 8]
+  };
+
+  return mLineCache.decode( address, data, bpp(), mLiteral, lineBytes, generations );
+}
+
 uint8_t Suzy::noice( uint64_t tick )
 {
   //undefined registers (with address > $FC80) has some peculiar random noice characteristics that looks something like this
@@ -507,20 +522,32 @@ std::shared_ptr<ISuzyProcess> Suzy::suzyProcess()
   if ( mSpriteDumper && mSpriteDumperPath.empty() )
   {
     mSpriteDumper.reset();
+    mSuzyProcess.reset();
   }
   else if ( !mSpriteDumper && !mSpriteDumperPath.empty() )
   {
     mSpriteDumper = std::make_unique<SpriteDumper>( mSpriteDumperPath );
+    mSuzyProcess.reset();
   }
 
   if ( mSpriteDumper )
   {
     mSpriteDumper->setPalette( mCore.debugPalette() );
-    return std::make_shared<SuzyProcess<SpriteDumper>>( *this, *mSpriteDumper );
+  }
+
+  if ( mSuzyProcess )
+  {
+    mSuzyProcess->restart();
+  }
+  else if ( mSpriteDumper )
+  {
+    mSuzyProcess = std::make_shared<SuzyProcess<SpriteDumper>>( *this, *mSpriteDumper );
   }
   else
   {
-    DummyDumper sink;
-    return std::make_shared<SuzyProcess<DummyDumper>>( *this, sink );
+    static DummyDumper sink;
+    mSuzyProcess = std::make_shared<SuzyProcess<DummyDumper>>( *this, sink );
   }
+
+  return mSuzyProcess;
 }
@@ -3,6 +3,7 @@
 #include "IInputSource.hpp"
 #include "SuzyMath.hpp"
 #include "SpriteDumper.hpp"
+#include "SpriteLineCache.hpp"
 
 class Core;
 
@@ -20,11 +21,11 @@ public:
       FINISH,
       FETCHSCB,
       READ,
-      READ4,
+      READLINE,
       READPAL,
       WRITE,
       WRITEFRED,
-      COLRMW,
+      COLLINE,
       VIDRMW,
       XOR
     } type;
@@ -36,8 +37,18 @@ public:
 public:
 
   virtual ~ISuzyProcess() = default;
-  virtual Request const* advance() = 0;
+  //starts processing of a new sprite chain reusing the process
+  virtual void restart() = 0;
+  //resumes the process and returns a batch of requests to be executed in order. Only the last request of the batch can expect a response
+  virtual std::span<Request const> advance() = 0;
+  //response to the read request ending the batch
   virtual void respond( uint32_t value ) = 0;
+  //response to the READLINE request ending the batch
+  virtual void respondLine( std::span<uint8_t const> data ) = 0;
+  //nibble masks of the collision buffer line written by COLLINE request. Valid until the process is advanced
+  virtual std::span<uint32_t const> collisionMasks() const = 0;
+  //highest collision buffer value replaced by COLLINE request
+  virtual void respondCollision( uint32_t value ) = 0;
 };
 
 class Suzy
@@ -51,6 +62,7 @@ public:
   void write( uint16_t address, uint8_t value );
   uint16_t debugVidBas() const;
   uint16_t debugCollBas() const;
+  SpriteLineCache::Stats debugSpriteLineCache() const;
   bool isSpriteDumping() const;
   void dumpSprites( std::filesystem::path path );
 
@@ -286,6 +298,7 @@ private:
   void writeSPRCOLL( uint8_t value );
   int bpp() const;
   uint8_t noice( uint64_t tick );
+  SpriteLineCache::Line decodeLine( uint16_t address, uint8_t const* data, int lineBytes );
 
   void debugCollisions();
 
@@ -324,7 +337,10 @@ private:
   std::unique_ptr<SpriteDumper> mSpriteDumper;
   std::filesystem::path mSpriteDumperPath;
   mutable std::mutex mSpriteDumperMutex;
+  //process kept between sprite chains to avoid reallocating it on every SPRGO
+  std::shared_ptr<ISuzyProcess> mSuzyProcess;
   uint64_t mAccessTick;
+  SpriteLineCache mLineCache;
 
   std::array<uint8_t, 16> mPalette;
   bool mBusEnable;          //Suzy Bus Enable, 0 = disabled
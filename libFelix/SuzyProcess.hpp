@@ -1,11 +1,12 @@
 #pragma once
 #include "Suzy.hpp"
 #include "Utility.hpp"
+#include "CoroutineFramePool.hpp"
 #include "SuzyProcess.hpp"
 #include "VidOperator.hpp"
 #include "ColOperator.hpp"
 #include "Log.hpp"
-#include "SpriteLineParser.hpp"
+#include "SpriteLineDecoder.hpp"
 
 struct DummyDumper
 {
@@ -30,9 +31,11 @@ struct DummyDumper
 
 struct SuzyProcessResponse
 {
-  bool await_ready() { return false; }
+  bool await_ready() { return ready; }
   void await_suspend( std::coroutine_handle<> c ) {}
   uint32_t value;
+  //whether the coroutine can continue without draining the request buffer
+  bool ready;
 };
 
 template< typename SPRITEDUMPER>
@@ -41,20 +44,33 @@ class SuzyProcess : public ISuzyProcess
 
 public:
 
-  SuzyProcess( Suzy & suzy, SPRITEDUMPER& sink ) : mSuzy{ suzy }, mProcessCoroutine{ process() }, request{}, response{}, mSink{ sink }
+  //Enough for all writes of a full scanline. Reads needed by the process end the batch earlier
+  static constexpr size_t REQUEST_BUFFER_SIZE = 128;
+
+  SuzyProcess( Suzy & suzy, SPRITEDUMPER& sink ) : mProcessCoroutine{ process() }, mSuzy{ suzy }, mRequests{}, mRequestCount{}, response{}, mLine{}, mColOp{}, mSink{ sink }
   {
   }
 
   ~SuzyProcess() override = default;
 
-  Request const* advance() override
+  void restart() override
   {
+    mProcessCoroutine = process();
+    mRequestCount = 0;
+    mColOp = nullptr;
+  }
+
+  std::span<Request const> advance() override
+  {
+    //previous batch has been executed by now
+    mRequestCount = 0;
+
     if ( mSuzy.mSpriteWorking )
       mProcessCoroutine.resume();
     else
       setFinish();
 
-    return &request;
+    return { mRequests.data(), mRequestCount };
   }
 
   void respond( uint32_t value ) override
@@ -62,12 +78,38 @@ public:
     response.value = value;
   }
 
+  void respondLine( std::span<uint8_t const> data ) override
+  {
+    assert( data.size() <= SpriteLineDecoder::MAX_LINE_BYTES );
+    std::ranges::copy( data, mLine.begin() );
+  }
+
+  std::span<uint32_t const> collisionMasks() const override
+  {
+    assert( mColOp );
+    return mColOp->masks();
+  }
+
+  void respondCollision( uint32_t value ) override
+  {
+    assert( mColOp );
+    mColOp->receiveHiColl( value );
+  }
+
 private:
 
   void setFinish()
   {
     mSuzy.mSpriteWorking = false;
-    request = { Request::FINISH };
+    enqueue( { Request::FINISH } );
+  }
+
+  //queues request and returns whether there is still room for more
+  bool enqueue( Request req )
+  {
+    assert( mRequestCount < mRequests.size() );
+    mRequests[mRequestCount++] = req;
+    return mRequestCount < mRequests.size();
   }
 
   //reads one byte of sprite data
@@ -77,19 +119,32 @@ private:
     {
       uint8_t await_resume() { return (uint8_t)value; }
     };
-    request = { Request::READ, address };
+    enqueue( { Request::READ, address } );
+    response.ready = false;
     return static_cast<SuzyReadResponse &>( response );
   }
 
-  //reads four bytes of sprite data
-  auto& suzyRead4( uint16_t address )
+  //reads whole line of sprite data into mLine
+  auto& suzyReadLine( uint16_t address, int length )
   {
-    struct SuzyRead4Response : public SuzyProcessResponse
+    struct SuzyReadLineResponse : public SuzyProcessResponse
     {
-      uint32_t await_resume() { return value; }
+      void await_resume() {}
     };
-    request = { Request::READ4, address };
-    return static_cast< SuzyRead4Response& >( response );
+    enqueue( { Request::READLINE, address, ( uint16_t )length } );
+    response.ready = false;
+    return static_cast< SuzyReadLineResponse& >( response );
+  }
+
+  //reads one byte of sprite data that was already delivered by suzyReadLine. Keeps the bus timing of sprite data fetches
+  auto& suzyFetchLine( uint16_t address )
+  {
+    struct SuzyFetchLineResponse : public SuzyProcessResponse
+    {
+      void await_resume() {}
+    };
+    response.ready = enqueue( { Request::READ, address } );
+    return static_cast< SuzyFetchLineResponse& >( response );
   }
 
   //reads SCB data
@@ -99,7 +154,8 @@ private:
     {
       uint8_t await_resume() { return (uint8_t)value; }
     };
-    request = { Request::FETCHSCB, address };
+    enqueue( { Request::FETCHSCB, address } );
+    response.ready = false;
     return static_cast<SuzyFetchSCBResponse &>( response );
   }
 
@@ -110,7 +166,8 @@ private:
     {
       uint32_t await_resume() { return value; }
     };
-    request = { Request::READPAL, address };
+    enqueue( { Request::READPAL, address } );
+    response.ready = false;
     return static_cast<SuzyReadPalResponse &>( response );
   }
 
@@ -122,7 +179,7 @@ private:
     {
       void await_resume() {}
     };
-    request = { Request::WRITE, address, value };
+    response.ready = enqueue( { Request::WRITE, address, value } );
     return static_cast<SuzyWriteResponse &>( response );
   }
 
@@ -133,19 +190,19 @@ private:
     {
       void await_resume() {}
     };
-    request = { Request::WRITEFRED, address, value };
+    response.ready = enqueue( { Request::WRITEFRED, address, value } );
     return static_cast<SuzyWriteResponse &>( response );
   }
 
-  //performs collision data RMW
-  auto & suzyColRMW( uint32_t mask, uint16_t address, uint16_t value )
+  //performs collision data RMW of whole line. Masks are taken from mColOp
+  auto & suzyColLine( uint16_t address, uint16_t value, uint32_t groups )
   {
-    struct SuzyColRMWResponse : public SuzyProcessResponse
+    struct SuzyColLineResponse : public SuzyProcessResponse
     {
-      uint32_t await_resume() { return value; }
+      void await_resume() {}
     };
-    request = { Request::COLRMW, address, value, mask };
-    return static_cast<SuzyColRMWResponse &>( response );
+    response.ready = enqueue( { Request::COLLINE, address, value, groups } );
+    return static_cast<SuzyColLineResponse &>( response );
   }
 
   //performs color data RMW
@@ -156,10 +213,21 @@ private:
     {
       void await_resume() {}
     };
-    request = { Request::VIDRMW, address, value, mask };
+    response.ready = enqueue( { Request::VIDRMW, address, value, mask } );
     return static_cast<SuzyVidRMWResponse &>( response );
   }
 
+  //waits for all queued requests to be executed
+  auto & suzyFlush()
+  {
+    struct SuzyFlushResponse : public SuzyProcessResponse
+    {
+      void await_resume() {}
+    };
+    response.ready = mRequestCount == 0;
+    return static_cast<SuzyFlushResponse &>( response );
+  }
+
   //performs XOR RMW
   auto & suzyXOR( uint16_t address, uint8_t value )
   {
@@ -167,7 +235,7 @@ private:
     {
       void await_resume() {}
     };
-    request = { Request::XOR, address, value };
+    response.ready = enqueue( { Request::XOR, address, value } );
     return static_cast<SuzyXORResponse &>( response );
   }
 
@@ -177,7 +245,7 @@ private:
     struct promise_type;
     using handle = std::coroutine_handle<promise_type>;
 
-    struct promise_type
+    struct promise_type : PooledFrame
     {
       promise_type( SuzyProcess & suzyProcess ) : mSuzyProcess{ suzyProcess } {}
       auto get_return_object() { return ProcessCoroutine{ std::coroutine_handle<promise_type>::from_promise( *this ) }; }
@@ -196,6 +264,12 @@ private:
     };
 
     ProcessCoroutine( handle c ) : mCoro{ c } {}
+    ProcessCoroutine & operator=( ProcessCoroutine && other )
+    {
+      std::swap( mCoro, other.mCoro );
+      return *this;
+    }
+
     ~ProcessCoroutine()
     {
       if ( mCoro )
@@ -210,7 +284,7 @@ private:
 
   private:
     handle mCoro;
-  } const mProcessCoroutine;
+  } mProcessCoroutine;
 
 private:
   ProcessCoroutine process()
@@ -314,6 +388,7 @@ private:
 
         VidOperator vidOp{ suzy.mSpriteType };
         ColOperator colOp{ suzy.mSpriteType, ( uint8_t )( suzy.mSprColl & Suzy::SPRCOLL::NUMBER_MASK ) };
+        mColOp = &colOp;
 
         auto const& quadCycle = suzy.mQuadrantOrder[( size_t )suzy.mStartingQuadrant];
 
@@ -345,10 +420,10 @@ private:
             for ( int pixelRow = 0; pixelRow < pixelHeight; ++pixelRow )
             {
               scb.procadr = scb.sprdline;
-              Shifter shifter{};
-              shifter.push( mSink.fetch( co_await suzyRead4( scb.procadr ) ) );
+              const int lineBytes = scb.sprdoff - 1;
+              co_await suzyReadLine( scb.procadr, std::max( lineBytes, 4 ) );
+              mSink.fetch( *( (uint32_t const*)mLine.data() ) );
               scb.procadr += 4;
-              SpriteLineParser slp{ shifter, suzy.mLiteral, suzy.bpp(), ( scb.sprdoff - 1 ) * 8 };
               if ( !up && ( int16_t )scb.sprvpos >= SCREEN_HEIGHT || up && ( int16_t )scb.sprvpos < 0 )
                 break;
               if ( ( int16_t )scb.sprvpos < SCREEN_HEIGHT && ( int16_t )scb.sprvpos >= 0 )
@@ -366,12 +441,19 @@ private:
                 if ( ( ( uint8_t )quadCycle[quadrant] & Suzy::SPRCTL1::DRAW_LEFT ) != ( ( uint8_t )quadCycle[0] & Suzy::SPRCTL1::DRAW_LEFT ) )
                   sprhpos += dx;
 
-                while ( int const* penIndex = slp.getPenIndex() )
+                auto const line = suzy.decodeLine( scb.sprdline, mLine.data(), lineBytes );
+                auto const pens = line.pens;
+                auto const fetches = line.fetches;
+                auto fetch = fetches.begin();
+
+                for ( size_t pen = 0; pen < pens.size(); ++pen )
                 {
-                  if ( shifter.size() < 24 && slp.totalBits() > shifter.size() )
+                  if ( fetch != fetches.end() && *fetch == pen )
                   {
-                    shifter.push( mSink.fetch( co_await suzyRead( scb.procadr ) ) );
+                    mSink.fetch( mLine[( uint16_t )( scb.procadr - scb.sprdline )] );
+                    co_await suzyFetchLine( scb.procadr );
                     scb.procadr += 1;
+                    ++fetch;
                   }
 
                   hsizacum += scb.sprhsiz;
@@ -383,14 +465,11 @@ private:
                     // Stop horizontal loop if outside of screen bounds
                     if ( sprhpos >= 0 && sprhpos < SCREEN_WIDTH )
                     {
-                      const uint8_t penNumber = suzy.mPalette[*penIndex];
+                      const uint8_t penNumber = suzy.mPalette[pens[pen]];
 
                       if ( !disableCollisions )
                       {
-                        if ( auto memOp = colOp.process( sprhpos, penNumber ) )
-                        {
-                          colOp.receiveHiColl( co_await suzyColRMW( memOp.mask, memOp.addr, memOp.value ) );
-                        }
+                        colOp.process( sprhpos, penNumber );
                       }
 
                       switch ( auto memOp = vidOp.process( sprhpos, penNumber ) )
@@ -426,9 +505,9 @@ private:
                 }
                 if ( !disableCollisions )
                 {
-                  if ( auto memOp = colOp.flush() )
+                  if ( auto lineOp = colOp.flush() )
                   {
-                    colOp.receiveHiColl( co_await suzyColRMW( memOp.mask, memOp.addr, memOp.value ) );
+                    co_await suzyColLine( lineOp.addr, lineOp.value, lineOp.groups );
                   }
                 }
               }
@@ -448,11 +527,14 @@ private:
 
         if ( !disableCollisions )
         {
+          //collision responses of queued requests must reach colOp before reading it
+          co_await suzyFlush();
           if ( auto newFred = colOp.hiColl() )
           {
             fred = *newFred & 0x0f;
           }
         }
+        mColOp = nullptr;
       }
 
       if ( suzy.mEveron && everon )
@@ -474,7 +556,12 @@ private:
 private:
   Suzy & mSuzy;
 
-  Request request;
+  std::array<Request, REQUEST_BUFFER_SIZE> mRequests;
+  size_t mRequestCount;
   SuzyProcessResponse response;
+  //sprite data line with room for decoder over-reads
+  std::array<uint8_t, SpriteLineDecoder::MAX_LINE_BYTES + SpriteLineDecoder::PADDING> mLine;
+  //collision operator of the sprite being drawn
+  ColOperator * mColOp;
   SPRITEDUMPER & mSink;
 };
@@ -1,144 +1,321 @@
 #include "TimerCore.hpp"
 
-TimerCore::TimerCore( int number, std::function<void( uint64_t, bool )> trigger ) :
-  mBaseTick{}, mExpectedTick{}, mBorrowInTick{}, mBorrowOutTick{}, mTrigger{ std::move( trigger ) }, mNumber{ number },
-  mEnableInt{}, mResetDone{}, mEnableReload{}, mEnableCount{}, mLinking{}, mAudShift{},
-  mValue{},
-  mBackup{},
-  mTimerDone{}, mLastClock{}, mBorrowIn{}, mBorrowOut{}
+TimerCore::TimerCore() :
+  mBaseTick{}, mExpectedTick{}, mActionTick{}, mBorrowInTick{}, mBorrowOutTick{},
+  mAudShift{}, mValue{}, mBackup{},
+  mEnableInt{}, mResetDone{}, mEnableReload{}, mEnableCount{}, mLinking{},
+  mTimerDone{}, mLastClock{}, mBorrowIn{}, mBorrowOut{}, mLazy{}
 {
 }
 
-SequencedAction TimerCore::setBackup( uint64_t tick, uint8_t backup )
+SequencedAction TimerCore::setBackup( int timer, uint64_t tick, uint8_t backup )
 {
-  mBackup = backup;
+  mBackup[timer] = backup;
   return {};
 }
 
-SequencedAction TimerCore::setControlA( uint64_t tick, uint8_t controlA )
+SequencedAction TimerCore::setControlA( int timer, uint64_t tick, uint8_t controlA )
 {
-  mEnableInt    = ( controlA & CONTROLA::ENABLE_INT ) != 0;
-  mResetDone    = ( controlA & CONTROLA::RESET_DONE ) != 0;
-  mEnableReload = ( controlA & CONTROLA::ENABLE_RELOAD ) != 0;
-  mEnableCount  = ( controlA & CONTROLA::ENABLE_COUNT ) != 0;
-  mLinking      = ( controlA & CONTROLA::AUD_LINKING ) == CONTROLA::AUD_LINKING;
-  mAudShift     = controlA & CONTROLA::AUD_CLOCK_MASK;
+  mEnableInt[timer]    = ( controlA & CONTROLA::ENABLE_INT ) != 0;
+  mResetDone[timer]    = ( controlA & CONTROLA::RESET_DONE ) != 0;
+  mEnableReload[timer] = ( controlA & CONTROLA::ENABLE_RELOAD ) != 0;
+  mEnableCount[timer]  = ( controlA & CONTROLA::ENABLE_COUNT ) != 0;
+  mLinking[timer]      = ( controlA & CONTROLA::AUD_LINKING ) == CONTROLA::AUD_LINKING;
+  mAudShift[timer]     = controlA & CONTROLA::AUD_CLOCK_MASK;
 
-  if ( mResetDone )
-    mTimerDone = false;
+  if ( mResetDone[timer] )
+    mTimerDone[timer] = false;
 
   //updateValue( tick & ~0x0full); //TODO: investigate why it can't be here
-  mBaseTick = tick;
-  return computeAction();
+  mBaseTick[timer] = tick;
+  return computeAction( timer );
 }
 
-SequencedAction TimerCore::setCount( uint64_t tick, uint8_t value )
+SequencedAction TimerCore::setCount( int timer, uint64_t tick, uint8_t value )
 {
-  mValue = value;
-  mBaseTick = tick;
-  return computeAction();
+  mValue[timer] = value;
+  mBaseTick[timer] = tick;
+  return computeAction( timer );
 }
 
-SequencedAction TimerCore::setControlB( uint64_t tick, uint8_t controlB )
+SequencedAction TimerCore::setControlB( int timer, uint64_t tick, uint8_t controlB )
 {
-  mTimerDone  = ( controlB & CONTROLB::TIMER_DONE ) != 0;
-  mLastClock  = ( controlB & CONTROLB::LAST_CLOCK ) != 0;
-  mBorrowIn   = ( controlB & CONTROLB::BORROW_IN ) != 0;
-  mBorrowOut  = ( controlB & CONTROLB::BORROW_OUT ) != 0;
+  mTimerDone[timer]  = ( controlB & CONTROLB::TIMER_DONE ) != 0;
+  mLastClock[timer]  = ( controlB & CONTROLB::LAST_CLOCK ) != 0;
+  mBorrowIn[timer]   = ( controlB & CONTROLB::BORROW_IN ) != 0;
+  mBorrowOut[timer]  = ( controlB & CONTROLB::BORROW_OUT ) != 0;
 
   return {};
 }
 
-uint8_t TimerCore::getBackup( uint64_t tick )
+uint8_t TimerCore::getBackup( int timer, uint64_t tick )
 {
-  return mBackup;
+  return mBackup[timer];
 }
 
-uint8_t TimerCore::getControlA( uint64_t tick )
+uint8_t TimerCore::getControlA( int timer, uint64_t tick )
 {
   return
-    ( mEnableInt ? CONTROLA::ENABLE_INT : 0 ) |
-    ( mResetDone ? CONTROLA::RESET_DONE : 0 ) |
-    ( mEnableReload ? CONTROLA::ENABLE_RELOAD : 0 ) |
-    ( mEnableCount ? CONTROLA::ENABLE_COUNT : 0 ) |
-    mAudShift;
+    ( mEnableInt[timer] ? CONTROLA::ENABLE_INT : 0 ) |
+    ( mResetDone[timer] ? CONTROLA::RESET_DONE : 0 ) |
+    ( mEnableReload[timer] ? CONTROLA::ENABLE_RELOAD : 0 ) |
+    ( mEnableCount[timer] ? CONTROLA::ENABLE_COUNT : 0 ) |
+    mAudShift[timer];
 }
 
-uint8_t TimerCore::getCount( uint64_t tick )
+uint8_t TimerCore::getCount( int timer, uint64_t tick )
 {
-  updateValue( tick );
-  return mValue;
+  updateValue( timer, tick );
+  return mValue[timer];
 }
 
-void TimerCore::updateValue( uint64_t tick )
+void TimerCore::updateValue( int timer, uint64_t tick )
 {
-  if ( !mLinking )
+  if ( !mLinking[timer] )
   {
-    int64_t tmp = ( ( mExpectedTick - tick ) / ( ( 1ll << mAudShift ) * 16 ) - 1ll );
-    mValue = (uint8_t)( tmp >= 0 ? tmp : 0 );
+    int64_t tmp = (int64_t)( ( mExpectedTick[timer] - tick ) >> clockShift( timer ) ) - 1ll;
+    mValue[timer] = (uint8_t)( tmp >= 0 ? tmp : 0 );
   }
 }
 
-uint8_t TimerCore::getControlB( uint64_t tick )
+uint8_t TimerCore::getControlB( int timer, uint64_t tick )
 {
-  mBorrowIn = ( tick - mBorrowInTick ) < 16;
-  mBorrowOut = ( tick - mBorrowOutTick ) < 16;
-  mLastClock = getCount( tick ) == 0;
+  mBorrowIn[timer] = ( tick - mBorrowInTick[timer] ) < 16;
+  mBorrowOut[timer] = ( tick - mBorrowOutTick[timer] ) < 16;
+  mLastClock[timer] = getCount( timer, tick ) == 0;
 
   return
-    ( mTimerDone ? CONTROLB::TIMER_DONE : 0 ) |
-    ( mLastClock ? CONTROLB::LAST_CLOCK : 0 ) |
-    ( mBorrowIn ? CONTROLB::BORROW_IN : 0 ) |
-    ( mBorrowOut ? CONTROLB::BORROW_OUT : 0 );
+    ( mTimerDone[timer] ? CONTROLB::TIMER_DONE : 0 ) |
+    ( mLastClock[timer] ? CONTROLB::LAST_CLOCK : 0 ) |
+    ( mBorrowIn[timer] ? CONTROLB::BORROW_IN : 0 ) |
+    ( mBorrowOut[timer] ? CONTROLB::BORROW_OUT : 0 );
 }
 
-SequencedAction TimerCore::fireAction( uint64_t tick )
+TimerCore::Underflows TimerCore::fire( int timer, uint64_t tick )
 {
-  if ( tick != mExpectedTick )
-    return {};
+  Underflows result{};
 
-  mBorrowOutTick = tick;
-  mTrigger( tick, mEnableInt );
-  mBaseTick = tick;
-  if ( mEnableReload )
-  {
-    mValue = mBackup;
-  }
-  return computeAction();
+  if ( mLazy[timer] || tick != mActionTick[timer] )
+    return result;
+
+  advance( timer, tick, &result );
+  result.action = scheduleAction( timer );
+
+  return result;
 }
 
-void TimerCore::borrowIn( uint64_t tick )
+void TimerCore::sync( int timer, uint64_t tick )
 {
-  if ( !( mEnableCount && mLinking ) )
+  //Timer 4 ends every chain, so chains can't loop
+  while ( linked( timer ) && PREVIOUS[timer] != NONE )
+  {
+    timer = PREVIOUS[timer];
+  }
+
+  //lazy timers are skipped by their owner and underflow at scheduled action is evaluated when fired
+  if ( mLazy[timer] )
     return;
+  if ( mActionTick[timer] != 0 )
+    tick = std::min( tick, mActionTick[timer] - 1 );
 
-  mBorrowInTick = tick;
+  advance( timer, tick, nullptr );
+}
 
-  if ( mValue > 0 )
+void TimerCore::sync( uint64_t tick )
+{
+  for ( int timer = 0; timer < TIMERS; ++timer )
   {
-    mValue -= 1;
+    if ( !linked( timer ) )
+      sync( timer, tick );
   }
-  else
+}
+
+SequencedAction TimerCore::updateAction( int timer )
+{
+  uint64_t const actionTick = mActionTick[timer];
+  auto action = scheduleAction( timer );
+  return mActionTick[timer] != actionTick ? action : SequencedAction{};
+}
+
+void TimerCore::advance( int timer, uint64_t tick, Underflows* underflows )
+{
+  if ( mExpectedTick[timer] == 0 || tick < mExpectedTick[timer] )
+    return;
+
+  auto report = [&]( int underflowing, uint64_t at )
+  {
+    if ( underflows && at == tick )
+      underflows->timers[underflows->count++] = underflowing;
+  };
+
+  //borrows into next timer are count ticks starting at first spaced by spacing
+  uint64_t spacing = period( timer );
+  uint64_t count = ( tick - mExpectedTick[timer] ) / spacing + 1;
+  uint64_t first = mExpectedTick[timer];
+  uint64_t last = first + ( count - 1 ) * spacing;
+
+  underflow( timer, last );
+  mExpectedTick[timer] = last + spacing;
+  report( timer, last );
+
+  for ( int next = BORROW_TARGET[timer]; next != NONE && linked( next ); next = BORROW_TARGET[next] )
   {
-    mBorrowOutTick = tick;
-    mTrigger( tick, mEnableInt );
-    mBaseTick = tick;
-    if ( mEnableReload )
+    mBorrowInTick[next] = last;
+
+    uint64_t const value = mValue[next];
+    if ( count <= value )
     {
-      mValue = mBackup;
+      mValue[next] = ( uint8_t )( value - count );
+      break;
     }
+
+    //timer underflows on borrow at zero and then on every interval borrows
+    uint64_t const interval = mEnableReload[next] ? mBackup[next] + 1ull : 1ull;
+    uint64_t const underflowCount = 1 + ( count - value - 1 ) / interval;
+    uint64_t const rest = count - value - 1 - ( underflowCount - 1 ) * interval;
+
+    first += value * spacing;
+    spacing *= interval;
+    count = underflowCount;
+    last = first + ( count - 1 ) * spacing;
+
+    mValue[next] = 0;
+    underflow( next, last );
+    mValue[next] -= ( uint8_t )rest;
+    report( next, last );
+  }
+}
+
+bool TimerCore::interruptEnabled( int timer ) const
+{
+  return mEnableInt[timer];
+}
+
+void TimerCore::underflow( int timer, uint64_t tick )
+{
+  mBorrowOutTick[timer] = tick;
+  mBaseTick[timer] = tick;
+  if ( mEnableReload[timer] )
+  {
+    mValue[timer] = mBackup[timer];
+  }
+}
+
+bool TimerCore::linked( int timer ) const
+{
+  return mEnableCount[timer] && mLinking[timer];
+}
+
+bool TimerCore::periodic( int timer ) const
+{
+  return mEnableCount[timer] && !mLinking[timer];
+}
+
+SequencedAction TimerCore::setLazy( int timer, bool lazy )
+{
+  if ( lazy == mLazy[timer] )
+    return {};
+
+  mLazy[timer] = lazy;
+  return computeAction( timer );
+}
+
+bool TimerCore::lazy( int timer ) const
+{
+  return mLazy[timer];
+}
+
+uint64_t TimerCore::nextUnderflow( int timer ) const
+{
+  return mExpectedTick[timer];
+}
+
+uint64_t TimerCore::period( int timer ) const
+{
+  uint8_t value = mEnableReload[timer] ? mBackup[timer] : mValue[timer];
+  return ( 1ull + value ) << clockShift( timer );
+}
+
+uint64_t TimerCore::skip( int timer, uint64_t tick )
+{
+  if ( !mLazy[timer] || mExpectedTick[timer] == 0 || tick < mExpectedTick[timer] )
+    return 0;
+
+  if ( mEnableReload[timer] )
+  {
+    mValue[timer] = mBackup[timer];
   }
+
+  uint64_t const period = this->period( timer );
+  uint64_t const count = ( tick - mExpectedTick[timer] ) / period + 1;
+  uint64_t const last = mExpectedTick[timer] + ( count - 1 ) * period;
+
+  mBorrowOutTick[timer] = last;
+  mBaseTick[timer] = last;
+  mExpectedTick[timer] = last + period;
+
+  return count;
 }
 
-SequencedAction TimerCore::computeAction()
+int TimerCore::clockShift( int timer ) const
 {
-  if ( !mEnableCount || mLinking )
+  //clock of 1us is 16 ticks
+  return mAudShift[timer] + 4;
+}
+
+SequencedAction TimerCore::computeAction( int timer )
+{
+  if ( !mEnableCount[timer] || mLinking[timer] )
   {
-    mExpectedTick = 0;
+    mExpectedTick[timer] = 0;
     return {};
   }
 
-  mExpectedTick = mBaseTick + ( 1ull + mValue ) * ( 1ull << mAudShift ) * 16;
+  mExpectedTick[timer] = mBaseTick[timer] + ( ( 1ull + mValue[timer] ) << clockShift( timer ) );
+
+  return scheduleAction( timer );
+}
+
+SequencedAction TimerCore::scheduleAction( int timer )
+{
+  mActionTick[timer] = 0;
+
+  if ( mExpectedTick[timer] == 0 || mLazy[timer] )
+    return {};
+
+  uint64_t const index = observableUnderflow( timer );
+  if ( index == 0 )
+    return {};
+
+  mActionTick[timer] = mExpectedTick[timer] + ( index - 1 ) * period( timer );
+  return { (Action)( ( int )Action::FIRE_TIMER0 + timer ), mActionTick[timer] };
+}
 
-  return { (Action)( ( int )Action::FIRE_TIMER0 + mNumber ), mExpectedTick };
+uint64_t TimerCore::observableUnderflow( int timer ) const
+{
+  //without reload period follows count that can be changed by reads, so every underflow is scheduled
+  if ( !mEnableReload[timer] || observable( timer ) )
+    return 1;
+
+  //underflow of timer with given index is the first one of next timer, following ones are step underflows apart
+  uint64_t index = 1;
+  uint64_t step = 1;
+
+  for ( int next = BORROW_TARGET[timer]; next != NONE && linked( next ); next = BORROW_TARGET[next] )
+  {
+    index += mValue[next] * step;
+    if ( index > MAX_SKIP )
+      return MAX_SKIP;
+    if ( observable( next ) )
+      return index;
+
+    step = std::min<uint64_t>( step * ( mEnableReload[next] ? mBackup[next] + 1ull : 1ull ), MAX_SKIP );
+  }
+
+  return 0;
+}
+
+bool TimerCore::observable( int timer ) const
+{
+  return mEnableInt[timer] || ( EFFECTS >> timer & 1 ) != 0;
 }
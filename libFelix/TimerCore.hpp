@@ -2,29 +2,87 @@
 
 #include "ActionQueue.hpp"
 
+//Registers of Mikey timers 0-7 and audio timers 8-b stored as arrays indexed by timer number.
+//Timers are wired into fixed cascades: a linked timer counts borrows of the timer that has it in BORROW_TARGET.
+//A chain of linked timers is solved analytically from its periodic head. Only underflows that raise an interrupt or have
+//an effect on display, serial port or audio are scheduled, the rest are evaluated in bulk when the chain is synced or fired.
 class TimerCore
 {
 public:
-  TimerCore( int number, std::function<void( uint64_t, bool )> trigger );
+  static constexpr int TIMERS = 12;
+  static constexpr int NONE = -1;
+  //timer counting borrows of given timer
+  static constexpr std::array<int, TIMERS> BORROW_TARGET = { 0x2, 0x3, 0x4, 0x5, NONE, 0x7, NONE, 0x8, 0x9, 0xa, 0xb, 0x0 };
+  //timer whose borrows given timer counts
+  static constexpr std::array<int, TIMERS> PREVIOUS = { 0xb, NONE, 0x0, 0x1, 0x2, 0x3, NONE, 0x5, 0x7, 0x8, 0x9, 0xa };
 
-  SequencedAction setBackup( uint64_t tick, uint8_t );
-  SequencedAction setControlA( uint64_t tick, uint8_t );
-  SequencedAction setCount( uint64_t tick, uint8_t );
-  SequencedAction setControlB( uint64_t tick, uint8_t );
+  //timers underflowing at the same tick
+  struct Underflows
+  {
+    //fired timer followed by linked timers it cascaded into
+    std::array<int, TIMERS> timers;
+    int count;
+    //next scheduled underflow of fired timer
+    SequencedAction action;
+  };
+
+  TimerCore();
+
+  SequencedAction setBackup( int timer, uint64_t tick, uint8_t );
+  SequencedAction setControlA( int timer, uint64_t tick, uint8_t );
+  SequencedAction setCount( int timer, uint64_t tick, uint8_t );
+  SequencedAction setControlB( int timer, uint64_t tick, uint8_t );
 
-  uint8_t getBackup( uint64_t tick );
-  uint8_t getControlA( uint64_t tick );
-  uint8_t getCount( uint64_t tick );
-  uint8_t getControlB( uint64_t tick );
+  uint8_t getBackup( int timer, uint64_t tick );
+  uint8_t getControlA( int timer, uint64_t tick );
+  uint8_t getCount( int timer, uint64_t tick );
+  uint8_t getControlB( int timer, uint64_t tick );
 
-  SequencedAction fireAction( uint64_t tick );
-  void borrowIn( uint64_t tick );
+  //underflow of given timer with borrows cascaded through linked timers
+  Underflows fire( int timer, uint64_t tick );
+  //evaluates underflows of the chain containing given timer up to given tick, so that its registers can be accessed
+  void sync( int timer, uint64_t tick );
+  //evaluates underflows of all chains up to given tick
+  void sync( uint64_t tick );
+  //Reschedules underflow of given timer after registers of its chain changed.
+  //Returns the action if it moved, earlier one is then ignored by fire
+  SequencedAction updateAction( int timer );
+  bool interruptEnabled( int timer ) const;
+
+  //counting on borrows from previous timer
+  bool linked( int timer ) const;
+  //counting on its own clock with constant period after first underflow
+  bool periodic( int timer ) const;
+  //In lazy mode underflows are not scheduled nor triggered. Owner skips them in bulk with skip.
+  //Leaving lazy mode returns the action of next underflow
+  SequencedAction setLazy( int timer, bool lazy );
+  bool lazy( int timer ) const;
+  //tick of next underflow and period of following ones of periodic timer
+  uint64_t nextUnderflow( int timer ) const;
+  uint64_t period( int timer ) const;
+  //skips underflows up to given tick in lazy mode and returns their count
+  uint64_t skip( int timer, uint64_t tick );
 
 private:
-  SequencedAction computeAction();
-  void updateValue( uint64_t tick );
+  SequencedAction computeAction( int timer );
+  SequencedAction scheduleAction( int timer );
+  //index of first underflow of periodic timer that is observable directly or through its linked timers. 0 if none is
+  uint64_t observableUnderflow( int timer ) const;
+  bool observable( int timer ) const;
+  //evaluates underflows of periodic timer up to given tick with borrows they cascade into linked timers
+  //and reports timers underflowing at that tick
+  void advance( int timer, uint64_t tick, Underflows* underflows );
+  void updateValue( int timer, uint64_t tick );
+  void underflow( int timer, uint64_t tick );
+  //timer clock period is 1 << clockShift ticks
+  int clockShift( int timer ) const;
 
 private:
+  //timers underflows of which have effects besides interrupt: display, serial port and audio
+  static constexpr uint32_t EFFECTS = 0b1111'0001'0101;
+  //limit of underflows skipped by an action, longer stretches are split by checkpoint actions
+  static constexpr uint64_t MAX_SKIP = 1ull << 32;
+
   struct CONTROLA
   {
     static constexpr uint8_t ENABLE_INT     = 0b10000000;
@@ -43,26 +101,27 @@ private:
   };
 
 private:
-  uint64_t mBaseTick;
-  uint64_t mExpectedTick;
-  uint64_t mBorrowInTick;
-  uint64_t mBorrowOutTick;
-  std::function<void( uint64_t, bool )> mTrigger;
+  std::array<uint64_t, TIMERS> mBaseTick;
+  //tick of next underflow of periodic timer
+  std::array<uint64_t, TIMERS> mExpectedTick;
+  //tick of scheduled action of periodic timer or 0
+  std::array<uint64_t, TIMERS> mActionTick;
+  std::array<uint64_t, TIMERS> mBorrowInTick;
+  std::array<uint64_t, TIMERS> mBorrowOutTick;
 
-  int mNumber;
+  std::array<uint8_t, TIMERS> mAudShift;
+  std::array<uint8_t, TIMERS> mValue;
+  std::array<uint8_t, TIMERS> mBackup;
 
-  bool mEnableInt;
-  bool mResetDone;
-  bool mEnableReload;
-  bool mEnableCount;
-  bool mLinking;
-  int mAudShift;
-  uint8_t mValue;
-  uint8_t mBackup;
-  bool mTimerDone;
-  bool mLastClock;
-  bool mBorrowIn;
-  bool mBorrowOut;
+  std::bitset<TIMERS> mEnableInt;
+  std::bitset<TIMERS> mResetDone;
+  std::bitset<TIMERS> mEnableReload;
+  std::bitset<TIMERS> mEnableCount;
+  std::bitset<TIMERS> mLinking;
+  std::bitset<TIMERS> mTimerDone;
+  std::bitset<TIMERS> mLastClock;
+  std::bitset<TIMERS> mBorrowIn;
+  std::bitset<TIMERS> mBorrowOut;
+  std::bitset<TIMERS> mLazy;
 
 };
-
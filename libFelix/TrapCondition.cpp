@@ -0,0 +1,388 @@
+#include "TrapCondition.hpp"
+#include "Core.hpp"
+#include "CPU.hpp"
+#include "CPUState.hpp"
+
+namespace
+{
+
+using Op = TrapCondition::Op;
+using Instruction = TrapCondition::Instruction;
+
+struct Operand
+{
+  std::string_view name;
+  Op op;
+};
+
+static constexpr std::array<Operand, 14> OPERANDS{ {
+  { "a", Op::A }, { "x", Op::X }, { "y", Op::Y }, { "s", Op::S }, { "p", Op::P }, { "pc", Op::PC },
+  { "n", Op::N }, { "v", Op::V }, { "d", Op::D }, { "i", Op::I }, { "z", Op::Z }, { "c", Op::C },
+  { "value", Op::VALUE }, { "address", Op::ADDRESS }
+} };
+
+static constexpr std::array<Operand, 3> MEMORIES{ {
+  { "ram", Op::RAM }, { "mikey", Op::MIKEY }, { "suzy", Op::SUZY }
+} };
+
+struct Binary
+{
+  std::string_view token;
+  Op op;
+  int precedence;
+};
+
+//Lua precedence without concatenation and exponentiation
+static constexpr std::array<Binary, 22> BINARIES{ {
+  { "or", Op::OR_JUMP, 1 }, { "||", Op::OR_JUMP, 1 },
+  { "and", Op::AND_JUMP, 2 }, { "&&", Op::AND_JUMP, 2 },
+  { "==", Op::EQ, 3 }, { "~=", Op::NE, 3 }, { "!=", Op::NE, 3 }, { "<", Op::LT, 3 }, { "<=", Op::LE, 3 }, { ">", Op::GT, 3 }, { ">=", Op::GE, 3 },
+  { "|", Op::OR, 4 },
+  { "~", Op::XOR, 5 },
+  { "&", Op::AND, 6 },
+  { "<<", Op::SHL, 7 }, { ">>", Op::SHR, 7 },
+  { "+", Op::ADD, 8 }, { "-", Op::SUB, 8 },
+  { "*", Op::MUL, 9 }, { "/", Op::DIV, 9 }, { "//", Op::DIV, 9 }, { "%", Op::MOD, 9 }
+} };
+
+class Compiler
+{
+public:
+  Compiler( std::string_view source ) : mSource{ source }, mPos{}, mTokenPos{}, mToken{}, mCode{}, mDepth{}, mMaxDepth{}, mError{}
+  {
+    next();
+  }
+
+  std::vector<Instruction> compile( std::string& error )
+  {
+    expression( 1 );
+    if ( !mToken.empty() )
+      fail( "unexpected" );
+    if ( mError.empty() && mMaxDepth > (int)TrapCondition::MAX_STACK )
+      mError = "expression too complex";
+
+    error = mError;
+    return mError.empty() ? std::move( mCode ) : std::vector<Instruction>{};
+  }
+
+private:
+  void next()
+  {
+    while ( mPos < mSource.size() && std::isspace( (unsigned char)mSource[mPos] ) )
+      mPos += 1;
+
+    mTokenPos = mPos;
+    if ( mPos == mSource.size() )
+    {
+      mToken = {};
+      return;
+    }
+
+    auto isWord = []( char c )
+    {
+      return std::isalnum( (unsigned char)c ) || c == '_';
+    };
+
+    size_t end = mPos;
+    if ( isWord( mSource[mPos] ) )
+    {
+      while ( end < mSource.size() && isWord( mSource[end] ) )
+        end += 1;
+    }
+    else if ( mSource[mPos] == '$' )
+    {
+      end += 1;
+      while ( end < mSource.size() && std::isxdigit( (unsigned char)mSource[end] ) )
+        end += 1;
+    }
+    else
+    {
+      static constexpr std::array<std::string_view, 10> pairs{ "==", "~=", "!=", "<=", ">=", "<<", ">>", "//", "&&", "||" };
+      auto rest = mSource.substr( mPos );
+      end += std::ranges::any_of( pairs, [&]( std::string_view pair ) { return rest.starts_with( pair ); } ) ? 2 : 1;
+    }
+
+    mToken = mSource.substr( mPos, end - mPos );
+    mPos = end;
+  }
+
+  void fail( std::string_view what )
+  {
+    if ( mError.empty() )
+    {
+      mError = std::string{ what } + ( mToken.empty() ? std::string{ " end" } : " '" + std::string{ mToken } + "'" ) + " at column " + std::to_string( mTokenPos + 1 );
+    }
+  }
+
+  bool accept( std::string_view token )
+  {
+    if ( mToken == token )
+    {
+      next();
+      return true;
+    }
+    return false;
+  }
+
+  void expect( std::string_view token )
+  {
+    if ( !accept( token ) )
+      fail( std::string{ "expected '" } + std::string{ token } + "' instead of" );
+  }
+
+  void emit( Op op, int32_t arg, int depthChange )
+  {
+    mCode.push_back( { op, arg } );
+    mDepth += depthChange;
+    mMaxDepth = std::max( mMaxDepth, mDepth );
+  }
+
+  std::optional<int32_t> number( std::string_view token )
+  {
+    int base = 10;
+    if ( token.starts_with( "$" ) )
+    {
+      token.remove_prefix( 1 );
+      base = 16;
+    }
+    else if ( token.starts_with( "0x" ) || token.starts_with( "0X" ) )
+    {
+      token.remove_prefix( 2 );
+      base = 16;
+    }
+
+    int32_t value{};
+    auto [ptr, ec] = std::from_chars( token.data(), token.data() + token.size(), value, base );
+    if ( token.empty() || ec != std::errc{} || ptr != token.data() + token.size() )
+      return std::nullopt;
+    return value;
+  }
+
+  void primary()
+  {
+    if ( !mError.empty() )
+      return;
+
+    if ( accept( "(" ) )
+    {
+      expression( 1 );
+      expect( ")" );
+      return;
+    }
+
+    if ( !mToken.empty() && ( mToken[0] == '$' || std::isdigit( (unsigned char)mToken[0] ) ) )
+    {
+      if ( auto value = number( mToken ) )
+      {
+        emit( Op::PUSH, *value, 1 );
+        next();
+      }
+      else
+      {
+        fail( "bad number" );
+      }
+      return;
+    }
+
+    for ( auto const& operand : OPERANDS )
+    {
+      if ( accept( operand.name ) )
+      {
+        emit( operand.op, 0, 1 );
+        return;
+      }
+    }
+
+    for ( auto const& memory : MEMORIES )
+    {
+      if ( accept( memory.name ) )
+      {
+        expect( "[" );
+        expression( 1 );
+        expect( "]" );
+        emit( memory.op, 0, 0 );
+        return;
+      }
+    }
+
+    fail( "unexpected" );
+  }
+
+  void unary()
+  {
+    if ( accept( "not" ) || accept( "!" ) )
+    {
+      unary();
+      emit( Op::NOT, 0, 0 );
+    }
+    else if ( accept( "-" ) )
+    {
+      unary();
+      emit( Op::NEG, 0, 0 );
+    }
+    else if ( accept( "~" ) )
+    {
+      unary();
+      emit( Op::BNOT, 0, 0 );
+    }
+    else
+    {
+      primary();
+    }
+  }
+
+  void expression( int minPrecedence )
+  {
+    unary();
+
+    while ( mError.empty() )
+    {
+      auto it = std::ranges::find( BINARIES, mToken, &Binary::token );
+      if ( it == BINARIES.end() || it->precedence < minPrecedence )
+        return;
+      next();
+
+      if ( it->op == Op::AND_JUMP || it->op == Op::OR_JUMP )
+      {
+        size_t const jump = mCode.size();
+        emit( it->op, 0, -1 );
+        expression( it->precedence + 1 );
+        emit( Op::BOOL, 0, 0 );
+        mCode[jump].arg = (int32_t)( mCode.size() - jump - 1 );
+      }
+      else
+      {
+        expression( it->precedence + 1 );
+        emit( it->op, 0, -1 );
+      }
+    }
+  }
+
+  std::string_view mSource;
+  size_t mPos;
+  size_t mTokenPos;
+  std::string_view mToken;
+  std::vector<Instruction> mCode;
+  int mDepth;
+  int mMaxDepth;
+  std::string mError;
+};
+
+}
+
+std::optional<TrapCondition> TrapCondition::compile( std::string_view source, std::string& error )
+{
+  auto code = Compiler{ source }.compile( error );
+  if ( code.empty() )
+    return std::nullopt;
+
+  return TrapCondition{ std::move( code ) };
+}
+
+TrapCondition::TrapCondition( std::vector<Instruction> code ) : mCode{ std::move( code ) }
+{
+}
+
+bool TrapCondition::operator()( Core& core, uint16_t address, uint8_t value ) const
+{
+  std::array<int32_t, MAX_STACK> stack;
+  size_t sp = 0;
+  auto const& cpu = core.debugState();
+
+  for ( size_t pc = 0; pc < mCode.size(); ++pc )
+  {
+    auto const& ins = mCode[pc];
+    switch ( ins.op )
+    {
+    case Op::PUSH:    stack[sp++] = ins.arg; break;
+    case Op::A:       stack[sp++] = cpu.a; break;
+    case Op::X:       stack[sp++] = cpu.x; break;
+    case Op::Y:       stack[sp++] = cpu.y; break;
+    case Op::S:       stack[sp++] = cpu.sl; break;
+    case Op::P:       stack[sp++] = cpu.getP(); break;
+    case Op::PC:      stack[sp++] = cpu.pc; break;
+    case Op::N:       stack[sp++] = cpu.n ? 1 : 0; break;
+    case Op::V:       stack[sp++] = cpu.v ? 1 : 0; break;
+    case Op::D:       stack[sp++] = cpu.d ? 1 : 0; break;
+    case Op::I:       stack[sp++] = cpu.i ? 1 : 0; break;
+    case Op::Z:       stack[sp++] = cpu.z ? 1 : 0; break;
+    case Op::C:       stack[sp++] = cpu.c ? 1 : 0; break;
+    case Op::VALUE:   stack[sp++] = value; break;
+    case Op::ADDRESS: stack[sp++] = address; break;
+    case Op::RAM:     stack[sp - 1] = core.debugReadRAM( (uint16_t)stack[sp - 1] ); break;
+    case Op::MIKEY:   stack[sp - 1] = core.debugReadMikey( (uint16_t)( stack[sp - 1] & 0xff ) ); break;
+    case Op::SUZY:    stack[sp - 1] = core.debugReadSuzy( (uint16_t)( stack[sp - 1] & 0xff ) ); break;
+    case Op::NEG:     stack[sp - 1] = (int32_t)( 0u - (uint32_t)stack[sp - 1] ); break;
+    case Op::NOT:     stack[sp - 1] = stack[sp - 1] == 0 ? 1 : 0; break;
+    case Op::BNOT:    stack[sp - 1] = ~stack[sp - 1]; break;
+    case Op::BOOL:    stack[sp - 1] = stack[sp - 1] != 0 ? 1 : 0; break;
+    case Op::AND_JUMP:
+      if ( stack[sp - 1] == 0 )
+        pc += ins.arg;
+      else
+        sp -= 1;
+      break;
+    case Op::OR_JUMP:
+      if ( stack[sp - 1] != 0 )
+      {
+        stack[sp - 1] = 1;
+        pc += ins.arg;
+      }
+      else
+      {
+        sp -= 1;
+      }
+      break;
+    default:
+    {
+      int32_t const r = stack[--sp];
+      int32_t& l = stack[sp - 1];
+      switch ( ins.op )
+      {
+      //arithmetic wraps around in unsigned, and the only quotient that does not fit, INT32_MIN / -1, is negation
+      case Op::MUL: l = (int32_t)( (uint32_t)l * (uint32_t)r ); break;
+      case Op::DIV: l = r == 0 ? 0 : r == -1 ? (int32_t)( 0u - (uint32_t)l ) : l / r; break;
+      case Op::MOD: l = r == 0 || r == -1 ? 0 : l % r; break;
+      case Op::ADD: l = (int32_t)( (uint32_t)l + (uint32_t)r ); break;
+      case Op::SUB: l = (int32_t)( (uint32_t)l - (uint32_t)r ); break;
+      case Op::SHL: l = r >= 0 && r < 32 ? (int32_t)( (uint32_t)l << r ) : 0; break;
+      case Op::SHR: l = r >= 0 && r < 32 ? (int32_t)( (uint32_t)l >> r ) : 0; break;
+      case Op::AND: l = l & r; break;
+      case Op::XOR: l = l ^ r; break;
+      case Op::OR:  l = l | r; break;
+      case Op::EQ:  l = l == r; break;
+      case Op::NE:  l = l != r; break;
+      case Op::LT:  l = l < r; break;
+      case Op::LE:  l = l <= r; break;
+      case Op::GT:  l = l > r; break;
+      case Op::GE:  l = l >= r; break;
+      default: break;
+      }
+      break;
+    }
+    }
+  }
+
+  return sp > 0 && stack[sp - 1] != 0;
+}
+
+ConditionalTrap::ConditionalTrap( TrapCondition condition, std::shared_ptr<IMemoryAccessTrap> trap, Kind kind ) : mCondition{ std::move( condition ) }, mTrap{ std::move( trap ) }, mKind{ kind }
+{
+}
+
+uint8_t ConditionalTrap::trap( Core& core, uint16_t address, uint8_t orgValue )
+{
+  if ( !mCondition( core, address, orgValue ) )
+    return orgValue;
+
+  if ( mTrap )
+    return mTrap->trap( core, address, orgValue );
+
+  core.debugCPU().breakFromTrap();
+  return orgValue;
+}
+
+IMemoryAccessTrap::Kind ConditionalTrap::getKind() const
+{
+  return mKind;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "IMemoryAccessTrap.hpp"
+
+//Condition of a trap compiled to bytecode evaluated without leaving C++.
+//Expressions follow Lua syntax and operator precedence on integers, where zero is false:
+//  a == 0x42 and ram[0x80] > 3
+//  not z and ( mikey[$fd0a] & 0x80 ) ~= 0 or value >= 10
+//Operands are numbers (decimal, 0x or $ hexadecimal), CPU registers a, x, y, s, p and pc, flags n, v, d, i, z and c,
+//value and address of the trapped access and ram[], mikey[] and suzy[] read with debug reads.
+//Arithmetic is done on 32-bit integers that wrap around on overflow, division and modulo by zero give zero.
+class TrapCondition
+{
+public:
+  //returns std::nullopt and describes the problem in error if source is not a valid condition
+  static std::optional<TrapCondition> compile( std::string_view source, std::string& error );
+
+  bool operator()( Core& core, uint16_t address, uint8_t value ) const;
+
+  static constexpr size_t MAX_STACK = 16;
+
+  enum class Op : uint8_t
+  {
+    PUSH,
+    A, X, Y, S, P, PC,
+    N, V, D, I, Z, C,
+    VALUE, ADDRESS,
+    RAM, MIKEY, SUZY,
+    NEG, NOT, BNOT, BOOL,
+    MUL, DIV, MOD, ADD, SUB, SHL, SHR, AND, XOR, OR,
+    EQ, NE, LT, LE, GT, GE,
+    //short circuit: leaves result and jumps by arg if it is decided by top of stack, otherwise pops it
+    AND_JUMP, OR_JUMP
+  };
+
+  struct Instruction
+  {
+    Op op;
+    int32_t arg;
+  };
+
+private:
+  explicit TrapCondition( std::vector<Instruction> code );
+
+  std::vector<Instruction> mCode;
+};
+
+//Trap calling another trap only when condition holds. Without a trap to call it breaks the CPU.
+class ConditionalTrap : public IMemoryAccessTrap
+{
+public:
+  ConditionalTrap( TrapCondition condition, std::shared_ptr<IMemoryAccessTrap> trap, Kind kind );
+  ~ConditionalTrap() override = default;
+
+  uint8_t trap( Core& core, uint16_t address, uint8_t orgValue ) override;
+  Kind getKind() const override;
+
+private:
+  TrapCondition mCondition;
+  std::shared_ptr<IMemoryAccessTrap> mTrap;
+  Kind mKind;
+};
@@ -0,0 +1,222 @@
+#include "VGMPlayer.hpp"
+#include "VGMWriter.hpp"
+
+namespace
+{
+
+static constexpr size_t DATA_OFFSET_POS = 0x34;
+static constexpr uint32_t VERSION_DATA_OFFSET = 0x150;
+
+uint64_t sampleToTick( uint64_t sample )
+{
+  //first tick VGMWriter converts to this sample
+  return ( sample * VGMWriter::MIKEY_CLOCK + VGMWriter::SAMPLE_RATE - 1 ) / VGMWriter::SAMPLE_RATE;
+}
+
+//operand bytes of commands of other chips and of data blocks, which are skipped. Negative for unknown commands
+int operandSize( uint8_t cmd )
+{
+  if ( cmd >= 0x30 && cmd <= 0x3f )
+    return 1;
+  if ( cmd == 0x4f || cmd == 0x50 )
+    return 1;
+  if ( cmd >= 0x40 && cmd <= 0x5f )
+    return 2;
+  if ( cmd == 0x68 )
+    return 11;
+  if ( cmd >= 0x90 && cmd <= 0x95 )
+  {
+    static constexpr std::array<int, 6> sizes = { 4, 4, 5, 10, 1, 4 };
+    return sizes[cmd - 0x90];
+  }
+  if ( cmd >= 0xa0 && cmd <= 0xbf )
+    return 2;
+  if ( cmd >= 0xc0 && cmd <= 0xdf )
+    return 3;
+  if ( cmd >= 0xe0 )
+    return 4;
+  return -1;
+}
+
+}
+
+std::unique_ptr<VGMPlayer> VGMPlayer::create( std::vector<uint8_t> & data )
+{
+  auto u32 = [&]( size_t pos )
+  {
+    return pos + 4 <= data.size() ? ( uint32_t )data[pos] | ( uint32_t )data[pos + 1] << 8 | ( uint32_t )data[pos + 2] << 16 | ( uint32_t )data[pos + 3] << 24 : 0;
+  };
+
+  if ( data.size() < 0x40 || data[0] != 'V' || data[1] != 'g' || data[2] != 'm' || data[3] != ' ' )
+    return {};
+
+  size_t dataOffset = 0x40;
+  if ( u32( 0x08 ) >= VERSION_DATA_OFFSET && u32( DATA_OFFSET_POS ) != 0 )
+    dataOffset = DATA_OFFSET_POS + u32( DATA_OFFSET_POS );
+
+  //Mikey clock is in extended header
+  if ( dataOffset < VGMWriter::MIKEY_CLOCK_OFFSET + 4 || dataOffset > data.size() || u32( VGMWriter::MIKEY_CLOCK_OFFSET ) == 0 )
+    return {};
+
+  return std::make_unique<VGMPlayer>( std::move( data ), dataOffset );
+}
+
+VGMPlayer::VGMPlayer( std::vector<uint8_t> data, size_t dataOffset ) : mData{ std::move( data ) }, mPos{ dataOffset }, mSample{}, mCommandTick{}, mEnd{}, mTick{},
+  mActions{}, mTimers{}, mAudio{ mTimers }
+{
+}
+
+VGMPlayer::~VGMPlayer()
+{
+}
+
+size_t VGMPlayer::render( int sps, std::span<AudioSample> out )
+{
+  uint64_t tick = mAudio.endTick( mTick, sps, out.size() );
+  run( tick );
+  //samples past the end of data are not rendered
+  if ( mEnd )
+    tick = std::clamp( mCommandTick, mTick, tick );
+
+  mAudio.sync( tick );
+  mTick = tick;
+  return mAudio.render( tick, out );
+}
+
+bool VGMPlayer::finished() const
+{
+  return mEnd && mTick >= mCommandTick;
+}
+
+uint32_t VGMPlayer::totalSamples() const
+{
+  return u32( offsetof( VGMWriter::VGMHeader, Total_samples ) );
+}
+
+void VGMPlayer::run( uint64_t tick )
+{
+  while ( !mEnd && mCommandTick <= tick )
+  {
+    fireActions( mCommandTick );
+    step();
+  }
+  fireActions( tick );
+}
+
+void VGMPlayer::step()
+{
+  uint64_t const sample = mSample;
+
+  while ( mSample == sample && !mEnd )
+  {
+    if ( mPos >= mData.size() )
+    {
+      mEnd = true;
+      break;
+    }
+
+    uint8_t const cmd = mData[mPos];
+    auto operand = [&]( size_t i ) -> uint8_t
+    {
+      return mPos + i < mData.size() ? mData[mPos + i] : 0;
+    };
+
+    switch ( cmd )
+    {
+    case ( uint8_t )VGMWriter::CMD_MIKEY:
+      write( mCommandTick, operand( 1 ), operand( 2 ) );
+      mPos += 3;
+      break;
+    case ( uint8_t )VGMWriter::CMD_LONG_WAIT:
+      mSample += operand( 1 ) | operand( 2 ) << 8;
+      mPos += 3;
+      break;
+    case 0x62:
+      mSample += 735;
+      mPos += 1;
+      break;
+    case 0x63:
+      mSample += 882;
+      mPos += 1;
+      break;
+    case ( uint8_t )VGMWriter::CMD_END_OF_SOUND_DATA:
+      mEnd = true;
+      break;
+    case 0x67:
+      //data block
+      mPos += 7 + ( size_t )u32( mPos + 3 );
+      break;
+    default:
+      if ( cmd >= ( uint8_t )VGMWriter::CMD_SHORT_WAIT && cmd < ( uint8_t )VGMWriter::CMD_SHORT_WAIT + VGMWriter::CMD_SHORT_WAIT_MAX )
+      {
+        mSample += cmd - VGMWriter::CMD_SHORT_WAIT + 1;
+        mPos += 1;
+      }
+      else if ( cmd >= 0x80 && cmd <= 0x8f )
+      {
+        //YM2612 DAC write followed by a wait
+        mSample += cmd & 0x0f;
+        mPos += 1;
+      }
+      else if ( int size = operandSize( cmd ); size >= 0 )
+      {
+        mPos += 1 + size;
+      }
+      else
+      {
+        mEnd = true;
+      }
+      break;
+    }
+  }
+
+  mCommandTick = sampleToTick( mSample );
+}
+
+void VGMPlayer::write( uint64_t tick, uint8_t reg, uint8_t value )
+{
+  //same order as Mikey::write. Files hold writes to audio registers only, others are ignored
+  mAudio.sync( tick );
+  mTimers.sync( tick );
+
+  if ( auto action = mAudio.write( tick, reg, value ) )
+    mActions.push( action );
+
+  for ( int i = 0; i < MikeyAudio::CHANNELS; ++i )
+  {
+    if ( auto lazy = mAudio.updateLazy( i ) )
+      mActions.push( lazy );
+  }
+
+  for ( int timer = 0; timer < TimerCore::TIMERS; ++timer )
+  {
+    if ( auto timerAction = mTimers.updateAction( timer ) )
+      mActions.push( timerAction );
+  }
+}
+
+void VGMPlayer::fireActions( uint64_t tick )
+{
+  while ( !mActions.empty() && mActions.headTick() <= tick )
+  {
+    auto const seqAction = mActions.pop();
+    int const timer = ( int )seqAction.getAction() - ( int )Action::FIRE_TIMER0;
+    if ( timer < 0 || timer >= TimerCore::TIMERS )
+      continue;
+
+    auto underflows = mTimers.fire( timer, seqAction.getTick() );
+    //only audio timers are programmed, other underflows have no effect here
+    for ( int i = underflows.count - 1; i >= 0; --i )
+    {
+      if ( underflows.timers[i] >= 0x8 )
+        mAudio.trigger( underflows.timers[i] - 0x8, seqAction.getTick() );
+    }
+    if ( underflows.action )
+      mActions.push( underflows.action );
+  }
+}
+
+uint32_t VGMPlayer::u32( size_t pos ) const
+{
+  return pos + 4 <= mData.size() ? ( uint32_t )mData[pos] | ( uint32_t )mData[pos + 1] << 8 | ( uint32_t )mData[pos + 2] << 16 | ( uint32_t )mData[pos + 3] << 24 : 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ActionQueue.hpp"
+#include "MikeyAudio.hpp"
+#include "TimerCore.hpp"
+#include "Utility.hpp"
+
+//Plays VGM files of Mikey audio register writes without CPU, Suzy or display.
+//Writes are applied to Mikey audio timers and channels at their sample time and timer underflows are run from
+//an action queue like Core runs them, so rendering takes a fraction of time of emulation.
+class VGMPlayer
+{
+public:
+  //player of VGM data with Mikey clock, empty for other data. Compressed .vgz files are not supported
+  static std::unique_ptr<VGMPlayer> create( std::vector<uint8_t> & data );
+  VGMPlayer( std::vector<uint8_t> data, size_t dataOffset );
+  ~VGMPlayer();
+
+  //renders next samples at given rate and returns their count, which is less than out.size() only at the end of data
+  size_t render( int sps, std::span<AudioSample> out );
+  bool finished() const;
+  //length in samples at 44100 Hz declared in header
+  uint32_t totalSamples() const;
+
+private:
+  //runs commands and timer underflows up to given tick
+  void run( uint64_t tick );
+  //runs commands at current command tick up to next wait
+  void step();
+  void write( uint64_t tick, uint8_t reg, uint8_t value );
+  void fireActions( uint64_t tick );
+  uint32_t u32( size_t pos ) const;
+
+private:
+  std::vector<uint8_t> const mData;
+  size_t mPos;
+  //sample of next command at 44100 Hz and its tick
+  uint64_t mSample;
+  uint64_t mCommandTick;
+  bool mEnd;
+  //tick up to which audio is rendered
+  uint64_t mTick;
+
+  ActionQueue mActions;
+  TimerCore mTimers;
+  MikeyAudio mAudio;
+};
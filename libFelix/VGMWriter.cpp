@@ -1,17 +1,32 @@
 #include "VGMWriter.hpp"
 
-VGMWriter::VGMWriter( std::filesystem::path path ) : mHeader{}, mFout { path, std::ios::binary }, mLastTick{}
+VGMWriter::VGMWriter( std::filesystem::path path ) : mHeader{}, mFout{ path, std::ios::binary }, mStartTick{}, mLastTick{}, mBuffer{}, mMutex{}, mCondition{},
+  mPending{}, mSpare{}, mStop{}, mThread{}
 {
   mFout.seekp( sizeof( VGMHeader ) );
+  mBuffer.reserve( BUFFER_SIZE );
+  mThread = std::thread{ [this]
+  {
+    flushLoop();
+  } };
 }
 
 VGMWriter::~VGMWriter()
 {
-  mFout.put( CMD_END_OF_SOUND_DATA );
+  put( CMD_END_OF_SOUND_DATA );
+  submit();
+
+  {
+    std::unique_lock lock{ mMutex };
+    mStop = true;
+  }
+  mCondition.notify_one();
+  mThread.join();
+
   uint64_t size = mFout.tellp();
 
   mHeader.EofOffset = (uint32_t)( size - offsetof( VGMHeader, EofOffset ) );
-  mHeader.Total_samples = tickToSample( mLastTick );
+  mHeader.Total_samples = tickToSample( mLastTick ) - tickToSample( mStartTick );
 
   mFout.seekp( 0 );
   mFout.write( (char const*)&mHeader, sizeof( VGMHeader ) );
@@ -19,6 +34,7 @@ VGMWriter::~VGMWriter()
 
 void VGMWriter::init( uint64_t tick )
 {
+  mStartTick = tick;
   mLastTick = tick;
 }
 
@@ -32,27 +48,84 @@ void VGMWriter::write( uint64_t tick, uint8_t reg, uint8_t val )
   {
     if ( samplesDiff <= CMD_SHORT_WAIT_MAX )
     {
-      mFout.put( CMD_SHORT_WAIT + samplesDiff - 1 );
+      put( CMD_SHORT_WAIT + samplesDiff - 1 );
       samplesDiff = 0;
     }
     else
     {
       uint16_t wait = (uint16_t)std::min( CMD_LONG_WAIT_MAX, samplesDiff );
-      mFout.put( CMD_LONG_WAIT );
-      mFout.put( wait & 0xff );
-      mFout.put( wait >> 8 );
+      put( CMD_LONG_WAIT );
+      put( wait & 0xff );
+      put( wait >> 8 );
       samplesDiff -= wait;
     }
   }
 
-  mFout.put( CMD_MIKEY );
-  mFout.put( std::bit_cast<char>( reg ) );
-  mFout.put( std::bit_cast<char>( val ) );
+  put( CMD_MIKEY );
+  put( std::bit_cast<char>( reg ) );
+  put( std::bit_cast<char>( val ) );
 
   mLastTick = tick;
+
+  if ( mBuffer.size() >= BUFFER_SIZE )
+    submit();
 }
 
 uint32_t VGMWriter::tickToSample( uint64_t tick ) const
 {
   return (uint32_t)( tick * SAMPLE_RATE / MIKEY_CLOCK );
 }
+
+void VGMWriter::put( char c )
+{
+  mBuffer.push_back( c );
+}
+
+void VGMWriter::submit()
+{
+  if ( mBuffer.empty() )
+    return;
+
+  std::vector<char> next;
+  {
+    std::unique_lock lock{ mMutex };
+    mPending.push_back( std::move( mBuffer ) );
+    if ( !mSpare.empty() )
+    {
+      next = std::move( mSpare.back() );
+      mSpare.pop_back();
+    }
+  }
+  mCondition.notify_one();
+
+  mBuffer = std::move( next );
+  mBuffer.clear();
+  mBuffer.reserve( BUFFER_SIZE );
+}
+
+void VGMWriter::flushLoop()
+{
+  std::vector<std::vector<char>> buffers;
+
+  for ( ;; )
+  {
+    {
+      std::unique_lock lock{ mMutex };
+      //written buffers go back for reuse
+      for ( auto& buffer : buffers )
+      {
+        mSpare.push_back( std::move( buffer ) );
+      }
+      buffers.clear();
+      mCondition.wait( lock, [this] { return mStop || !mPending.empty(); } );
+      if ( mPending.empty() )
+        return;
+      std::swap( buffers, mPending );
+    }
+
+    for ( auto const& buffer : buffers )
+    {
+      mFout.write( buffer.data(), buffer.size() );
+    }
+  }
+}
@@ -1,9 +1,13 @@
 #pragma once
 
+//Writes Mikey audio register writes to VGM file.
+//Commands are appended to a buffer in memory on emulation thread. Full buffers are written to file by a background thread,
+//so emulation never waits for the file.
 class VGMWriter
 {
 public:
   VGMWriter( std::filesystem::path path );
+  //writes remaining commands and header, waits for background thread
   ~VGMWriter();
 
   void init( uint64_t tick );
@@ -11,9 +15,13 @@ public:
 
 private:
   uint32_t tickToSample( uint64_t tick ) const;
+  void put( char c );
+  //hands current buffer to background thread
+  void submit();
+  void flushLoop();
 
-private:
-
+public:
+  //format constants and header are shared with VGMPlayer
   static constexpr uint64_t MIKEY_CLOCK = 16000000;
   static constexpr uint64_t SAMPLE_RATE = 44100;
   static constexpr uint64_t MIKEY_CLOCK_OFFSET = 0xe4;
@@ -99,10 +107,25 @@ private:
     uint32_t C352_clock = 0;
     uint32_t GA20_clock = 0;
     uint32_t Mikey_clock = MIKEY_CLOCK;
-  } mHeader;
+  };
 
   static_assert( sizeof( VGMHeader ) == 0xe8 );
 
+private:
+  static constexpr size_t BUFFER_SIZE = 0x10000;
+
+  VGMHeader mHeader;
   std::ofstream mFout;
+  uint64_t mStartTick;
   uint64_t mLastTick;
+  //filled on emulation thread
+  std::vector<char> mBuffer;
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  //buffers waiting to be written and written buffers for reuse
+  std::vector<std::vector<char>> mPending;
+  std::vector<std::vector<char>> mSpare;
+  bool mStop;
+  std::thread mThread;
 };
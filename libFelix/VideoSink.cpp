@@ -0,0 +1,46 @@
+#include "VideoSink.hpp"
+#include <cstring>
+
+VideoSink::VideoSink() : mFrames{}, mReady{ 1 }, mBack{ 2 }, mPublished{ 1 }, mSequence{}, mFront{}
+{
+}
+
+void VideoSink::newFrame()
+{
+  Frame& back = mFrames[mBack];
+  Frame const& published = mFrames[mPublished];
+
+  //published frame is either waiting for the consumer or is being read by it, so it is safe to read here too
+  for ( int row = 0; row < SCREEN_HEIGHT; ++row )
+  {
+    back.dirty[row] = std::memcmp(
+ back.pixels.data() + row * ROW_BYTES, published.pixels.data() + row * ROW_BYTES, ROW_BYTES * sizeof( Doublet ) ) != 0;
+  }
+  back.sequence = ++mSequence;
+
+  mPublished = mBack;
+  mBack = mReady.exchange( mBack | FRESH, std::memory_order_acq_rel ) & ~FRESH;
+
+  //rows not written in next frame keep their content
+  mFrames[mBack].pixels = back.pixels;
+}
+
+Doublet* VideoSink::getRow( int row )
+{
+  assert( row >= 0 && row < SCREEN_HEIGHT );
+  return mFrames[mBack].pixels.data() + row * ROW_BYTES;
+}
+
+VideoSink::Frame const* VideoSink::nextFrame()
+{
+  if ( ( mReady.load( std::memory_order_relaxed ) & FRESH ) == 0 )
+    return nullptr;
+
+  mFront = mReady.exchange( mFront, std::memory_order_acq_rel ) & ~FRESH;
+  return &mFrames[mFront];
+}
+
+VideoSink::Frame const& VideoSink::currentFrame() const
+{
+  return mFrames[mFront];
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "IVideoSink.hpp"
+
+//Triple buffered video sink. Rows are written by emulation thread and whole frames are handed to the renderer at newFrame.
+//Producer and consumer never wait for each other. Frames published while the consumer was busy are skipped.
+class VideoSink : public IVideoSink
+{
+public:
+  struct Frame
+  {
+    std::array<Doublet, ROW_BYTES * SCREEN_HEIGHT> pixels;
+    //rows that differ from previous published frame
+    std::bitset<SCREEN_HEIGHT> dirty;
+    //number of published frames including this one. Frames are consecutive if sequence differs by one
+    uint64_t sequence;
+  };
+
+  VideoSink();
+  ~VideoSink() override = default;
+
+  //producer side
+  void newFrame() override;
+  Doublet* getRow( int row ) override;
+
+  //Consumer side. Returns latest published frame or nullptr if nothing was published since last call
+  Frame const* nextFrame();
+  //Consumer side. Last frame returned by nextFrame
+  Frame const& currentFrame() const;
+
+private:
+  static constexpr uint32_t FRESH = 0x80000000;
+
+  std::array<Frame, 3> mFrames;
+  //index of frame waiting for the consumer with FRESH flag set if it was not taken yet
+  std::atomic<uint32_t> mReady;
+  //producer owned
+  uint32_t mBack;
+  uint32_t mPublished;
+  uint64_t mSequence;
+  //consumer owned
+  uint32_t mFront;
+};